@@ -1,6 +1,14 @@
 #include <math.h>
+#ifdef CCMOTION_STANDALONE
+// Built without MATLAB (e.g. by CCMotion_benchmark.cpp); no mexFunction.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+typedef size_t mwSize;
+#else
 #include "matrix.h"
 #include "mex.h"   //--This one is required
+#endif
 
 #define PI 3.1415926535
 #define SQRT2 1.414213562373
@@ -12,6 +20,18 @@
 #define sgn(a) (a>=0 ? 1 : -1)
 #define MAXVAL 999999
 
+// Solver counters, reset by the caller; used for benchmarking.
+struct ccmCounters {
+	long heapAdds;
+	long heapUpdates;
+	long heapRemoves;
+	int numIter;
+};
+struct ccmCounters ccmStats = {0, 0, 0, 0};
+
+// Set to 0 to silence progress messages.
+int ccmVerbose = 1;
+
 struct quadruple {
 	int x;
 	int y;
@@ -133,6 +153,7 @@ void add(int i,int j,int th,double value,struct heapAugmented *h){
         newQuadruple.th=th;
         
         newQuadruple.value = value;
+        ccmStats.heapAdds++;
         h->numOfElements = h->numOfElements + 1;
         int currentPosition=h->numOfElements;
 		
@@ -150,6 +171,7 @@ void add(int i,int j,int th,double value,struct heapAugmented *h){
 }
 
 double removeMin(struct heapAugmented *h){
+	ccmStats.heapRemoves++;
 	if(h->numOfElements == 1){
 		double minValue = (h->heap)[1].value;
 		h->numOfElements = 0;
@@ -226,6 +248,7 @@ void update(int i,int j,int th,double newValue,struct heapAugmented *h,int***  N
 	else{
 		double oldValue = (h->heap)[position].value;
 		(h->heap)[position].value = newValue;
+		ccmStats.heapUpdates++;
 		if(newValue < oldValue){
 			//you bubble the updated element up, if necessary
 			struct quadruple newQuadruple = (h->heap)[position];
@@ -1317,7 +1340,7 @@ void updateNeighborAll(int i, int j,int k, const mwSize* N, double L, double***
 
 
 void CCM_sweepPDE(double*** unext, double*** v, double*** p, int*** sc, const mwSize* N, double L, double numInfty, int dubin) {
-	printf("Fast sweeping with finite difference update \n");
+	if (ccmVerbose) { printf("Fast sweeping with finite difference update \n"); }
 	
 	// Fast sweeping, using finite difference update
 	int Ni,Nj,Nk,n;
@@ -1340,7 +1363,7 @@ void CCM_sweepPDE(double*** unext, double*** v, double*** p, int*** sc, const mw
 }
 
 void CCM_sweep(double*** unext, double*** v, double*** p, int*** sc, const mwSize* N, double L, double numInfty, int dubin) {
-	printf("Fast sweeping with semi-Lagrangian update \n");
+	if (ccmVerbose) { printf("Fast sweeping with semi-Lagrangian update \n"); }
 
 	// fast sweeping, using semi-Lagrangian update
 	int Ni,Nj,Nk,n;
@@ -1362,7 +1385,7 @@ void CCM_sweep(double*** unext, double*** v, double*** p, int*** sc, const mwSiz
 }
 
 void CCM_sweepAll(double*** unext, double*** v, double*** p, int*** sc, const mwSize* N, double L, double numInfty, int dubin) {
-	printf("Fast sweeping with semi-Lagrangian and finite difference update \n");
+	if (ccmVerbose) { printf("Fast sweeping with semi-Lagrangian and finite difference update \n"); }
 	
 	// fast sweeping, using both semi-Lagrangian and finite difference updating schemes
 	int Ni,Nj,Nk,n;
@@ -1385,7 +1408,7 @@ void CCM_sweepAll(double*** unext, double*** v, double*** p, int*** sc, const mw
 
 void CCM(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc, const mwSize* N, double L, double numInfty, int dubin) { 
     // fast marching, using semi-Lagrangian update
-	printf("Fast marching with semi-Lagrangian update \n");
+	if (ccmVerbose) { printf("Fast marching with semi-Lagrangian update \n"); }
 
 	int Ni,Nj,Nk;
     int i,j,k;
@@ -1457,7 +1480,7 @@ void CCM(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc, co
 		//printf("numAlive = %d\n",numAlive);
 		
 		if (h->numOfElements == 0) {
-			printf("empty heap! numAlive = %d\n",numAlive);
+			if (ccmVerbose) { printf("empty heap! numAlive = %d\n",numAlive); }
 			return;
 		}
 		
@@ -1514,7 +1537,7 @@ void CCM(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc, co
 }
 
 void CCM_PDE(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc, const mwSize* N, double L, double numInfty, int dubin) { 
-	printf("Fast marching with finite difference update \n");
+	if (ccmVerbose) { printf("Fast marching with finite difference update \n"); }
 	// fast marching, using finite difference update
     int Ni,Nj,Nk;
     int i,j,k;
@@ -1591,7 +1614,7 @@ void CCM_PDE(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc
 		//printf("numAlive = %d\n",numAlive);
 		
 		if (h->numOfElements == 0) {
-			printf("empty heap! numAlive = %d\n",numAlive);
+			if (ccmVerbose) { printf("empty heap! numAlive = %d\n",numAlive); }
 			return;
 		}
 		
@@ -1653,7 +1676,7 @@ void CCM_PDE(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc
 }
 
 void CCM_all(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc, const mwSize* N, double L, double numInfty, int dubin) { 
-    printf("Fast marching with semi-Lagrangian and finite difference update \n");
+    if (ccmVerbose) { printf("Fast marching with semi-Lagrangian and finite difference update \n"); }
 
 	// fast marching, using both finite difference and semi-Lagrangian updating schemes
 	int Ni,Nj,Nk;
@@ -1726,7 +1749,7 @@ void CCM_all(double*** unext, double*** v, double*** p, int***  Nodes, int*** sc
 		//printf("numAlive = %d\n",numAlive);
 		
 		if (h->numOfElements == 0) {
-			printf("empty heap! numAlive = %d\n",numAlive);
+			if (ccmVerbose) { printf("empty heap! numAlive = %d\n",numAlive); }
 			return;
 		}
 		
@@ -1822,6 +1845,98 @@ double fndiff(double*** fold, double*** fnew, const mwSize* N, double numInfty )
 	return maxdiff;
 }
 
+int CCM_solve(double*** u, double*** unext, double*** v, double*** p, int*** Nodes, int*** sc, 
+				const mwSize* N, double L, double numInfty, int dubin, int march, int sweep, 
+				int march_method, int sweep_method) {
+	// Runs fast marching and/or fast sweeping on u (with unext as the working copy).
+	// Both hold the solution on return. Returns the number of sweep iterations.
+	int Ni,Nj,Nk;
+	int i,j,k;
+	int numIter, minIter, maxIter;
+	double difference;
+
+    Ni        = N[0];
+    Nj        = N[1];
+    Nk        = N[2];
+
+	numIter = 0;
+
+	// initialize all nodes as far away
+	for (i=0; i < Ni; i++) {
+        for (j=0; j < Nj; j++) {
+            for (k=0; k < Nk; k++) {
+				// if value is currently 0, it is the b.c., so it is accepted
+				if (u[i][j][k] <= 0) {
+					Nodes[i][j][k] = 1; // accepted
+				} else {
+					Nodes[i][j][k] = -1; // otherwise, far away
+				}
+                
+                //initialize switching control to zeros
+                sc[i][j][k] = 0;
+            }
+        }
+	}
+    
+	// ========= MARCH =========
+	// CCM_all(unext, v, p, Nodes, sc, N, L, numInfty, dubin);
+	if (march) {
+		if (march_method == 0) { CCM(unext, v, p, Nodes, sc, N, L, numInfty, dubin); }
+		else if (march_method == 1) { CCM_PDE(unext, v, p, Nodes, sc, N, L, numInfty, dubin); } 
+		else if (march_method == 2) { CCM_all(unext, v, p, Nodes, sc, N, L, numInfty, dubin); }
+		else { printf("Warning: unknown march_method!"); }
+
+		// CCM(unext, v, p, Nodes, sc, N, L, numInfty, dubin);
+		// Update u
+		for (i=0; i < Ni; i++) {
+			for (j=0; j < Nj; j++) {
+				for (k=0; k < Nk; k++) {
+					u[i][j][k] = unext[i][j][k];
+				}
+			}
+		}
+	}
+	// ==========================
+
+	// ========== SWEEP =========
+	if (sweep) {
+	difference = numInfty;
+	
+	numIter = 0;
+	minIter = 2;
+	maxIter = numInfty;
+	// for (numIter = 0; numIter<10; numIter+=0) {
+	//while (difference > 0.01*Ni*Nj*Nk && numIter < maxIter) {
+	while (numIter < minIter || (difference > 0.01 && numIter < maxIter) ) {
+		numIter++;
+		if (ccmVerbose) { printf("numIter = %d\n", numIter); }
+
+		if (sweep_method == 0) { CCM_sweep(unext, v, p, sc, N, L, numInfty, dubin); }
+		else if (sweep_method == 1) { CCM_sweepPDE(unext, v, p, sc, N, L, numInfty, dubin); } 
+		else if (sweep_method == 2) { CCM_sweepAll(unext, v, p, sc, N, L, numInfty, dubin); }
+		else { printf("Warning: unknown sweep_method!"); }
+
+		//CCM_sweepAll(unext, v, p, sc, N, L, numInfty, dubin); 
+		
+		difference = fndiff(u, unext, N, numInfty );	// calculate difference
+		if (ccmVerbose) { printf("difference is %f\n", difference); }
+		
+		// Update u
+		for (i=0; i < Ni; i++) {
+			for (j=0; j < Nj; j++) {
+				for (k=0; k < Nk; k++) {
+					u[i][j][k] = unext[i][j][k];
+				}
+			}
+		}
+	}
+	}
+
+	ccmStats.numIter = numIter;
+	return numIter;
+}
+
+#ifndef CCMOTION_STANDALONE
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
 	// Main function
 	// MatLab function call: [uf,sc] = CCMotion(u,v,p,L,numInfty);
@@ -1837,7 +1952,6 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     double L,numInfty; 
 	int Ni,Nj,Nk;
     int i,j,k;
-    int numIter, minIter, maxIter;
 	int dubin; // 1 for Dubins car, -1 for RS car
 	int march; // 1 to enable fast marching, 0 to disable
 	int sweep; // 1 to enable fast sweeping, 0 to disable
@@ -1850,7 +1964,6 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     int K = mxGetNumberOfDimensions(prhs[0]); 
     const mwSize *N = mxGetDimensions(prhs[0]);
 	
-	double difference; 
 	
     // ========= INPUTS ===========
     uValues			= mxGetPr(prhs[0]); // first LHS variable
@@ -1914,76 +2027,9 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
 	}
 	
 	
-	// initialize all nodes as far away
-	for (i=0; i < Ni; i++) {
-        for (j=0; j < Nj; j++) {
-            for (k=0; k < Nk; k++) {
-				// if value is currently 0, it is the b.c., so it is accepted
-				if (u[i][j][k] <= 0) {
-					Nodes[i][j][k] = 1; // accepted
-				} else {
-					Nodes[i][j][k] = -1; // otherwise, far away
-				}
-                
-                //initialize switching control to zeros
-                sc[i][j][k] = 0;
-            }
-        }
-	}
-    
-	// ========= MARCH =========
-	// CCM_all(unext, v, p, Nodes, sc, N, L, numInfty, dubin);
-	if (march) {
-		if (march_method == 0) { CCM(unext, v, p, Nodes, sc, N, L, numInfty, dubin); }
-		else if (march_method == 1) { CCM_PDE(unext, v, p, Nodes, sc, N, L, numInfty, dubin); } 
-		else if (march_method == 2) { CCM_all(unext, v, p, Nodes, sc, N, L, numInfty, dubin); }
-		else { printf("Warning: unknown march_method!"); }
-
-		// CCM(unext, v, p, Nodes, sc, N, L, numInfty, dubin);
-		// Update u
-		for (i=0; i < Ni; i++) {
-			for (j=0; j < Nj; j++) {
-				for (k=0; k < Nk; k++) {
-					u[i][j][k] = unext[i][j][k];
-				}
-			}
-		}
-	}
-	// ==========================
-
-	// ========== SWEEP =========
-	if (sweep) {
-	difference = numInfty;
-	
-	numIter = 0;
-	minIter = 2;
-	maxIter = numInfty;
-	// for (numIter = 0; numIter<10; numIter+=0) {
-	//while (difference > 0.01*Ni*Nj*Nk && numIter < maxIter) {
-	while (numIter < minIter || (difference > 0.01 && numIter < maxIter) ) {
-		numIter++;
-		printf("numIter = %d\n", numIter);
-
-		if (sweep_method == 0) { CCM_sweep(unext, v, p, sc, N, L, numInfty, dubin); }
-		else if (sweep_method == 1) { CCM_sweepPDE(unext, v, p, sc, N, L, numInfty, dubin); } 
-		else if (sweep_method == 2) { CCM_sweepAll(unext, v, p, sc, N, L, numInfty, dubin); }
-		else { printf("Warning: unknown sweep_method!"); }
-
-		//CCM_sweepAll(unext, v, p, sc, N, L, numInfty, dubin); 
-		
-		difference = fndiff(u, unext, N, numInfty );	// calculate difference
-		printf("difference is %f\n", difference);
-		
-		// Update u
-		for (i=0; i < Ni; i++) {
-			for (j=0; j < Nj; j++) {
-				for (k=0; k < Nk; k++) {
-					u[i][j][k] = unext[i][j][k];
-				}
-			}
-		}
-	}
-	}
+	// ========= SOLVE =========
+	CCM_solve(u, unext, v, p, Nodes, sc, N, L, numInfty, dubin, march, sweep,
+		march_method, sweep_method);
 	// ===========================
 
 	// ======= OUTPUT =======
@@ -2026,3 +2072,4 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
 	free(sc);
     
 }
+#endif
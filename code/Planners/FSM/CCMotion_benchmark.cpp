@@ -0,0 +1,307 @@
+// Benchmark and validation harness for the CCMotion solver variants.
+//
+// Runs every fast marching / fast sweeping combination (march_method and
+// sweep_method in {semi-Lagrangian, finite difference, both}) on generated
+// Dubins car problems at several grid sizes, and compares each result with a
+// high-resolution reference solution (fast marching followed by fast sweeping,
+// both schemes). Results are written as CSV, one row per (map, N, variant):
+//
+//   map,N,march,march_method,sweep,sweep_method,wall_time_s,iterations,
+//   heap_adds,heap_updates,heap_removes,max_error,mean_error,num_compared,
+//   reach_mismatch
+//
+// Errors are taken over interior nodes where both the variant and the
+// (trilinearly interpolated) reference are reached (below BENCH_REACHED);
+// reach_mismatch counts the nodes where only one of them is.
+//
+// Build (no MATLAB needed):
+//   g++ -O3 -o CCMotion_benchmark CCMotion_benchmark.cpp
+// Usage:
+//   ./CCMotion_benchmark [output.csv] [reference N] [N ...]
+// Defaults: ccmotion_benchmark.csv, 81, 21 31 41.
+
+// Standard headers go first: CCMotion.cpp defines min/max/abs macros.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#define CCMOTION_STANDALONE
+#include "CCMotion.cpp"
+
+// Problem parameters, as in fsmNextState.m.
+#define BENCH_L 1.0
+#define BENCH_NUM_INFTY 1e6
+#define BENCH_SPEED 1.0
+#define BENCH_TURN_RADIUS 0.2
+#define BENCH_GOAL_X 0.5
+#define BENCH_GOAL_Y 0.5
+#define BENCH_GOAL_TH (PI/6)
+#define BENCH_GOAL_AX 0.2
+#define BENCH_GOAL_AY 0.2
+#define BENCH_GOAL_ATH (PI/4)
+
+// Values at or above this are taken as unreachable. Interpolating between
+// numInfty and finite neighbours leaves values well below numInfty near the
+// edge of the reachable set, so a travel time cut-off is used instead. The
+// longest obstacle-free Dubins path on [-L,L]^2 takes about 4 time units.
+#define BENCH_REACHED 10.0
+
+#define NUM_MAPS 3
+#define NUM_RANDOM_OBS 8
+
+const char* mapNames[NUM_MAPS] = {"empty", "example", "random"};
+
+// Random circular obstacles, generated once with a fixed seed so that every
+// grid size sees the same map.
+double randomObs[NUM_RANDOM_OBS][3];
+
+// Small portable LCG, so maps are identical across platforms.
+double benchRandom(unsigned long* state) {
+	*state = (*state * 1103515245UL + 12345UL) % 2147483648UL;
+	return (double)(*state) / 2147483648.0;
+}
+
+void generateRandomObs() {
+	unsigned long state = 42;
+	int n = 0;
+	while (n < NUM_RANDOM_OBS) {
+		double cx = -0.8 + 1.6*benchRandom(&state);
+		double cy = -0.8 + 1.6*benchRandom(&state);
+		double r  = 0.05 + 0.1*benchRandom(&state);
+
+		// keep the goal region free
+		double gx = cx - BENCH_GOAL_X, gy = cy - BENCH_GOAL_Y;
+		if (sqrt(gx*gx + gy*gy) < r + 0.2) { continue; }
+
+		randomObs[n][0] = cx; randomObs[n][1] = cy; randomObs[n][2] = r;
+		n++;
+	}
+}
+
+int inRect(double x, double y, double x0, double y0, double x1, double y1) {
+	return (x >= x0 && x <= x1 && y >= y0 && y <= y1);
+}
+
+int inCircle(double x, double y, double cx, double cy, double r) {
+	return ((x-cx)*(x-cx) + (y-cy)*(y-cy) <= r*r);
+}
+
+// Is (x,y) inside an obstacle of the given map?
+int isObstacle(int map, double x, double y) {
+	int n;
+	if (map == 1) {
+		// generate_example_obstacles_FSM.m
+		return inRect(x, y, -0.5, -0.1, 0.0, 0.0) || inRect(x, y, -0.1, -0.5, 0.0, 0.0) ||
+			inRect(x, y, 0.2, -0.1, 0.5, 0.0) || inRect(x, y, -0.1, 0.2, 0.0, 0.5) ||
+			inCircle(x, y, 0.5, -0.1, 0.1) || inCircle(x, y, -0.1, 0.5, 0.1);
+	}
+	if (map == 2) {
+		for (n=0; n<NUM_RANDOM_OBS; n++) {
+			if (inCircle(x, y, randomObs[n][0], randomObs[n][1], randomObs[n][2])) { return 1; }
+		}
+	}
+	return 0;
+}
+
+double*** alloc3(int Ni, int Nj, int Nk) {
+	int i,j;
+	double*** a = (double ***) malloc (Ni * sizeof(double**));
+	for (i=0;i<Ni;i++) {
+		a[i] = (double **) malloc (Nj * sizeof(double*));
+		for (j=0;j<Nj;j++) { a[i][j] = (double *) malloc (Nk * sizeof(double)); }
+	}
+	return a;
+}
+
+int*** alloc3i(int Ni, int Nj, int Nk) {
+	int i,j;
+	int*** a = (int ***) malloc (Ni * sizeof(int**));
+	for (i=0;i<Ni;i++) {
+		a[i] = (int **) malloc (Nj * sizeof(int*));
+		for (j=0;j<Nj;j++) { a[i][j] = (int *) malloc (Nk * sizeof(int)); }
+	}
+	return a;
+}
+
+template <typename T>
+void free3(T*** a, int Ni, int Nj) {
+	int i,j;
+	for (i=0;i<Ni;i++) {
+		for (j=0;j<Nj;j++) { free(a[i][j]); }
+		free(a[i]);
+	}
+	free(a);
+}
+
+// One solved problem: the value function and its grid size.
+struct benchResult {
+	int N;
+	double*** u;
+	double seconds;
+	struct ccmCounters stats;
+};
+
+// Set up and solve one problem on an N x N x N grid.
+struct benchResult runProblem(int map, int N, int march, int sweep, int march_method, int sweep_method) {
+	struct benchResult result;
+	mwSize dims[3];
+	double ***u, ***unext, ***v, ***p;
+	int ***Nodes, ***sc;
+	int i,j,k;
+	double x, y, th, dth, ex, ey, eth;
+
+	dims[0] = N; dims[1] = N; dims[2] = N;
+	u = alloc3(N, N, N); unext = alloc3(N, N, N);
+	v = alloc3(N, N, N); p = alloc3(N, N, N);
+	Nodes = alloc3i(N, N, N); sc = alloc3i(N, N, N);
+
+	// grid as createGrid([-L;-L;0], [L;L;2*pi], N, 3) with periodic theta
+	dth = 2.0*PI/(double)N;
+	for (i=0; i<N; i++) {
+		x = -BENCH_L + 2.0*BENCH_L*i/(double)(N-1);
+		for (j=0; j<N; j++) {
+			y = -BENCH_L + 2.0*BENCH_L*j/(double)(N-1);
+			for (k=0; k<N; k++) {
+				th = k*dth;
+
+				// ellipsoidal target around the goal
+				ex  = (x - BENCH_GOAL_X)/BENCH_GOAL_AX;
+				ey  = (y - BENCH_GOAL_Y)/BENCH_GOAL_AY;
+				eth = remainder(th - BENCH_GOAL_TH, 2.0*PI)/BENCH_GOAL_ATH;
+
+				u[i][j][k] = (ex*ex + ey*ey + eth*eth < 1.0) ? 0.0 : BENCH_NUM_INFTY;
+				unext[i][j][k] = u[i][j][k];
+				v[i][j][k] = isObstacle(map, x, y) ? 0.0 : BENCH_SPEED;
+				p[i][j][k] = BENCH_TURN_RADIUS;
+			}
+		}
+	}
+
+	memset(&ccmStats, 0, sizeof(ccmStats));
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	CCM_solve(u, unext, v, p, Nodes, sc, dims, BENCH_L, BENCH_NUM_INFTY, 1,
+		march, sweep, march_method, sweep_method);
+	std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+	result.N = N;
+	result.u = u;
+	result.seconds = std::chrono::duration<double>(stop - start).count();
+	result.stats = ccmStats;
+
+	free3(unext, N, N); free3(v, N, N); free3(p, N, N);
+	free3(Nodes, N, N); free3(sc, N, N);
+	return result;
+}
+
+// Trilinear interpolation of the reference at (x,y,th), periodic in theta.
+// Returns numInfty if any corner is unreachable.
+double interpReference(struct benchResult* ref, double x, double y, double th) {
+	int N = ref->N;
+	double h = 2.0*BENCH_L/(double)(N-1), dth = 2.0*PI/(double)N;
+	double fx = (x + BENCH_L)/h, fy = (y + BENCH_L)/h, fth = th/dth;
+	int i0 = (int)floor(fx), j0 = (int)floor(fy), k0 = (int)floor(fth);
+	double a, b, c, value, corner;
+	int di, dj, dk;
+
+	if (i0 >= N-1) { i0 = N-2; }
+	if (j0 >= N-1) { j0 = N-2; }
+	a = fx - i0; b = fy - j0; c = fth - k0;
+	k0 = ((k0 % N) + N) % N;
+
+	value = 0;
+	for (di=0; di<2; di++) {
+	for (dj=0; dj<2; dj++) {
+	for (dk=0; dk<2; dk++) {
+		corner = ref->u[i0+di][j0+dj][(k0+dk) % N];
+		if (corner >= BENCH_REACHED) { return BENCH_NUM_INFTY; }
+		value += (di ? a : 1-a)*(dj ? b : 1-b)*(dk ? c : 1-c)*corner;
+	}}}
+	return value;
+}
+
+int main(int argc, char** argv) {
+	const char* filename = "ccmotion_benchmark.csv";
+	int refN = 81;
+	int defaultSizes[3] = {21, 31, 41};
+	int* sizes = defaultSizes;
+	int numSizes = 3;
+	int map, s, march, sweep, mm, sm, i, j, k, N, numCompared, mismatch;
+	double value, reference, err, maxErr, totalErr;
+	struct benchResult ref, result;
+	FILE* fp;
+
+	if (argc >= 2) { filename = argv[1]; }
+	if (argc >= 3) { refN = atoi(argv[2]); }
+	if (argc >= 4) {
+		numSizes = argc - 3;
+		sizes = (int*) malloc (numSizes * sizeof(int));
+		for (s=0; s<numSizes; s++) { sizes[s] = atoi(argv[s+3]); }
+	}
+
+	fp = fopen(filename, "w");
+	if (fp == NULL) {
+		printf("Could not open %s\n", filename);
+		return 1;
+	}
+	fprintf(fp, "map,N,march,march_method,sweep,sweep_method,wall_time_s,iterations,"
+		"heap_adds,heap_updates,heap_removes,max_error,mean_error,num_compared,reach_mismatch\n");
+
+	ccmVerbose = 0;
+	generateRandomObs();
+
+	for (map=0; map<NUM_MAPS; map++) {
+		printf("%s: computing reference at N = %d\n", mapNames[map], refN);
+		ref = runProblem(map, refN, 1, 1, 2, 2);
+
+		for (s=0; s<numSizes; s++) {
+			N = sizes[s];
+			for (march=0; march<=1; march++) {
+			for (sweep=0; sweep<=1; sweep++) {
+				if (!march && !sweep) { continue; }
+				for (mm=0; mm<=(march ? 2 : 0); mm++) {
+				for (sm=0; sm<=(sweep ? 2 : 0); sm++) {
+					result = runProblem(map, N, march, sweep, mm, sm);
+
+					// compare interior nodes against the reference
+					maxErr = 0; totalErr = 0; numCompared = 0; mismatch = 0;
+					for (i=1; i<N-1; i++) {
+					for (j=1; j<N-1; j++) {
+					for (k=0; k<N; k++) {
+						value = result.u[i][j][k];
+						reference = interpReference(&ref,
+							-BENCH_L + 2.0*BENCH_L*i/(double)(N-1),
+							-BENCH_L + 2.0*BENCH_L*j/(double)(N-1),
+							k*2.0*PI/(double)N);
+						if ((value >= BENCH_REACHED) != (reference >= BENCH_REACHED)) {
+							mismatch++;
+						} else if (value < BENCH_REACHED) {
+							err = fabs(value - reference);
+							if (err > maxErr) { maxErr = err; }
+							totalErr += err;
+							numCompared++;
+						}
+					}}}
+
+					fprintf(fp, "%s,%d,%d,%d,%d,%d,%.6f,%d,%ld,%ld,%ld,%.6g,%.6g,%d,%d\n",
+						mapNames[map], N, march, march ? mm : -1, sweep, sweep ? sm : -1,
+						result.seconds, result.stats.numIter, result.stats.heapAdds,
+						result.stats.heapUpdates, result.stats.heapRemoves, maxErr,
+						numCompared ? totalErr/numCompared : 0.0, numCompared, mismatch);
+					fflush(fp);
+					printf("%s N=%d march=%d/%d sweep=%d/%d: %.3f s, max error %.4g\n",
+						mapNames[map], N, march, mm, sweep, sm, result.seconds, maxErr);
+
+					free3(result.u, N, N);
+				}}
+			}}
+		}
+
+		free3(ref.u, refN, refN);
+	}
+
+	fclose(fp);
+	if (sizes != defaultSizes) { free(sizes); }
+	return 0;
+}
@@ -142,14 +142,18 @@ if visualize
     extraArgs.deleteLastPlot = false;
 end
 
-extraArgs.keepLast = 1;
+% Keep every time slice: the value function server reads switching times
+% off the slices (see the time-varying export below).
 
 % solve backwards reachable set
 data_switch = cell(1,length(sD_switch));
+data_switch_slices = cell(1,length(sD_switch));
+tau_switch = cell(1,length(sD_switch));
 for ii = 1:length(sD_switch)
     extraArgs.stopSetInclude = dataF{ii};
-    [data_switch{ii}, ~] = HJIPDE_solve(data0{ii}, tau, ...
+    [data_switch_slices{ii}, tau_switch{ii}] = HJIPDE_solve(data0{ii}, tau, ...
         sD_switch{ii}, 'min_data0', extraArgs);
+    data_switch{ii} = data_switch_slices{ii}(:,:,end);
 end
 
 if visualize
@@ -290,6 +294,47 @@ for ii = 1:length(sD_switch)
         'data','grid_min','grid_max', 'grid_N', 'teb','x_dims','u_dims',...
         'u_min','u_max', 'max_planner_speed', 'deriv0','deriv1')
 end
+
+% Time-varying export of every slice, for tv_value_function_converter. Kept
+% out of switchFolder, where every .mat is loaded as a subsystem:
+%   tv_value_function_converter <tvFolder>/subsystem_x.mat \
+%     <switchFolder>/subsystem_x.tvvf
+% The value function server reads the switching tracking bound off the final
+% slice and the guaranteed switching time off the first slice whose zero
+% level set covers the bigger planner's tracking error bound.
+tvFolder = [switchFolder '_tv'];
+if ~exist(tvFolder, 'dir')
+  mkdir(tvFolder);
+end
+
+for ii = 1:length(sD_switch)
+    tv = struct();
+    tv.tau = tau_switch{ii};
+    tv.data = data_switch_slices{ii};
+    tv.grid_min = sD_switch{ii}.grid.min';
+    tv.grid_max = sD_switch{ii}.grid.max';
+    tv.grid_N = uint64(sD_switch{ii}.grid.N)';
+    tv.x_dims = uint64(sD_switch{ii}.dynSys.dims-1)'; %0-index
+    tv.u_dims = (uint64(ii)-1)';
+    tv.max_planner_speed = planner_speed_small;
+    tv.priority_lower = S.priority_lower_bound{ii};
+    tv.priority_upper = S.priority_upper_bound{ii};
+
+    % tracking error bound of each slice (slice-major)
+    idx = find(sD_switch{ii}.dynSys.dims==sD_switch{ii}.dynSys.pdim(ii));
+    tv.teb = zeros(length(sD_switch{ii}.grid.N), length(tv.tau));
+    for kk = 1:length(tv.tau)
+        [g_proj, data_proj] = proj(sD_switch{ii}.grid, tv.data(:,:,kk), ...
+            [0 1], 'min');
+        k = find(data_proj <= 0);
+        if ~isempty(k)
+            tv.teb(idx,kk) = max(abs(g_proj.xs{1}(k([1 end])))) + small;
+        end
+    end
+
+    save([tvFolder '/subsystem_' subDimNames(ii) '.mat'], '-struct', 'tv')
+end
+
     save([plannerFolderMatlab '/speed_' num2str(10*planner_speed_big) ...
         '_tenths_to_' num2str(10*planner_speed_small) '_tenths.mat'], ...
         'data_switch','tau','sD_switch','teb_switch');
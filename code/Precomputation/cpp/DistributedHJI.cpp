@@ -0,0 +1,869 @@
+#include "DistributedHJI.hpp"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <sstream>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace helperOC;
+
+/*
+	@brief One slab of the grid, solved in its own process.
+
+	Local storage for a value array is (num_of_planes + 2 * halo) planes:
+	halo planes below the slab, the slab itself, and halo planes above, as
+	many as the spatial stencil reaches on either side. Value
+	arrays are held in memory, or in memory-mapped scratch files when out of
+	core, in which case the slab is processed tile_planes planes at a time.
+*/
+class DistributedHJI::Worker {
+public:
+	Worker(
+		const DistributedHJI& solver,
+		const size_t rank,
+		const size_t num_of_processes,
+		char* shared,
+		const int result_fd);
+	~Worker();
+
+	bool run(
+		const beacls::FloatVec& tau,
+		const Target_Type& target,
+		const bool minWithTarget,
+		const std::string& scratch_prefix,
+		const size_t memoryBudget);
+
+	//! Halo planes needed on each side of a slab at an accuracy.
+	static size_t halo_width(
+		const helperOC::ApproximationAccuracy_Type accuracy) {
+		return (accuracy == helperOC::ApproximationAccuracy_veryHigh) ? 3 : 1;
+	}
+
+	//! Byte offsets of the pieces of the shared region.
+	static size_t alphas_offset();
+	static size_t mailbox_offset(const size_t num_of_processes,
+		const size_t num_dim);
+	static size_t shared_size(const size_t num_of_processes,
+		const size_t num_dim, const size_t plane_size, const size_t halo);
+
+private:
+	bool allocate(const bool minWithTarget, const std::string& scratch_prefix,
+		const size_t memoryBudget);
+	FLOAT_TYPE* map_scratch(const std::string& filename, const size_t size);
+	bool stage(beacls::FloatVec& alphas, FLOAT_TYPE& dt,
+		const FLOAT_TYPE t, const FLOAT_TYPE t_end, const size_t s);
+	void exchange(FLOAT_TYPE* V);
+	void reduce(beacls::FloatVec& alphas);
+	bool evaluate(beacls::FloatVec* alphas, const bool compute_rhs,
+		const FLOAT_TYPE* V, const FLOAT_TYPE t,
+		const size_t p_begin, const size_t p_end);
+	bool evaluate_dynamics(std::vector<beacls::FloatVec>& dx,
+		const std::vector<const FLOAT_TYPE*>& deriv_ptrs, const FLOAT_TYPE t);
+	bool write_slice(const FLOAT_TYPE* V, const size_t slice);
+
+	//! Prefetch or release storage planes [first, last) of an array. Does
+	//! nothing in core.
+	void advise(const FLOAT_TYPE* V, const size_t first, const size_t last,
+		const int advice) const;
+
+	//! Extrapolate distance points past the edge value v0 (next to v1),
+	//! away from the zero level set, as addGhostExtrapolate.
+	static FLOAT_TYPE extrapolate(const FLOAT_TYPE v0, const FLOAT_TYPE v1,
+		const size_t distance = 1) {
+		const FLOAT_TYPE slope = (FLOAT_TYPE)distance * std::abs(v0 - v1);
+		return (v0 >= 0) ? v0 + slope : v0 - slope;
+	}
+
+	//! Fifth order WENO derivative from the five one sided differences
+	//! v1..v5 ordered along the upwind direction, as upwindFirstWENO5a with
+	//! its default epsilon.
+	static FLOAT_TYPE weno5(const double v1, const double v2, const double v3,
+		const double v4, const double v5);
+
+	const DistributedHJI& solver;
+	const size_t rank;
+	const size_t num_of_processes;
+	const size_t num_dim;
+	const size_t last_dim;
+	const size_t halo;
+	size_t plane_size;
+	size_t plane_begin;
+	size_t num_of_planes;
+	size_t tile_planes;
+	beacls::IntegerVec strides;
+
+	pthread_barrier_t* barrier;
+	double* shared_alphas;
+	FLOAT_TYPE* mailbox;
+	const int result_fd;
+
+	//! Value arrays, and their storage in core or out of core.
+	FLOAT_TYPE* V0;
+	FLOAT_TYPE* V1;
+	FLOAT_TYPE* V2;
+	FLOAT_TYPE* targets;
+	std::vector<beacls::FloatVec> storages;
+	std::vector<std::pair<void*, size_t> > maps;
+	bool out_of_core;
+
+	//! Per tile buffers.
+	beacls::FloatVec rhs;
+	std::vector<beacls::FloatVec> diffs;
+
+	//! Per plane buffers.
+	std::vector<beacls::FloatVec> xs;
+	std::vector<beacls::FloatVec::const_iterator> x_ites;
+	beacls::IntegerVec x_sizes;
+	std::vector<beacls::FloatVec> derivLs;
+	std::vector<beacls::FloatVec> derivRs;
+	std::vector<beacls::FloatVec> derivCs;
+	std::vector<beacls::FloatVec> uOpts;
+	std::vector<beacls::FloatVec> dOpts;
+	std::vector<beacls::FloatVec> dx;
+};
+
+DistributedHJI::DistributedHJI(
+		const beacls::FloatVec& mins,
+		const beacls::FloatVec& maxs,
+		const beacls::IntegerVec& Ns,
+		const DynSys* dynSys,
+		const helperOC::DynSys_UMode_Type uMode,
+		const helperOC::DynSys_DMode_Type dMode) :
+		mins(mins), maxs(maxs), Ns(Ns), numel(1), dynSys(dynSys),
+		uMode(uMode), dMode(dMode), factorCFL((FLOAT_TYPE)0.8),
+		memoryBudget(0), accuracy(helperOC::ApproximationAccuracy_veryHigh) {
+	dxs.resize(Ns.size());
+	for (size_t dim = 0; dim < Ns.size(); ++dim) {
+		dxs[dim] = (Ns[dim] > 1) ?
+			(maxs[dim] - mins[dim]) / (FLOAT_TYPE)(Ns[dim] - 1) : (FLOAT_TYPE)1;
+		numel *= Ns[dim];
+	}
+}
+
+DistributedHJI::~DistributedHJI() {
+}
+
+bool DistributedHJI::solve(
+		const std::string& result_filename,
+		const beacls::FloatVec& tau,
+		const Target_Type& target,
+		const size_t num_of_processes,
+		const bool minWithTarget) const {
+	const size_t num_dim = Ns.size();
+	if (num_dim == 0 || mins.size() != num_dim || maxs.size() != num_dim ||
+			tau.empty() || dynSys == NULL) {
+		std::cerr << "Error: " << __func__ << " : Invalid arguments." << std::endl;
+		return false;
+	}
+	for (size_t dim = 0; dim < num_dim; ++dim) {
+		if (Ns[dim] < 2) {
+			std::cerr << "Error: " << __func__
+				<< " : Need at least 2 grid points in each dimension." << std::endl;
+			return false;
+		}
+	}
+	if (accuracy != helperOC::ApproximationAccuracy_low &&
+			accuracy != helperOC::ApproximationAccuracy_veryHigh) {
+		std::cerr << "Error: " << __func__
+			<< " : Only low and veryHigh accuracy are supported." << std::endl;
+		return false;
+	}
+
+	// Every worker needs at least as many planes of the last dimension as
+	// its neighbours' halos reach into it.
+	const size_t halo = Worker::halo_width(accuracy);
+	const size_t modified_num_of_processes = std::max<size_t>(1,
+		std::min<size_t>(num_of_processes, Ns[num_dim - 1] / halo));
+	if (modified_num_of_processes != num_of_processes) {
+		std::cerr << "Warning: " << __func__ << " : Using "
+			<< modified_num_of_processes << " processes." << std::endl;
+	}
+
+	// Allocate the result file up front so workers can write their slabs
+	// directly at fixed offsets.
+	const int result_fd = open(result_filename.c_str(),
+		O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (result_fd < 0) {
+		std::cerr << "Error: " << __func__ << " : Cannot open "
+			<< result_filename << std::endl;
+		return false;
+	}
+	if (ftruncate(result_fd,
+			(off_t)(tau.size() * numel * sizeof(FLOAT_TYPE))) != 0) {
+		std::cerr << "Error: " << __func__ << " : Cannot allocate "
+			<< result_filename << std::endl;
+		close(result_fd);
+		return false;
+	}
+
+	// Shared region for the barrier, reductions and halo mailbox. Created
+	// before forking so every worker maps the same pages.
+	const size_t plane_size = numel / Ns[num_dim - 1];
+	const size_t shared_size = Worker::shared_size(modified_num_of_processes,
+		num_dim, plane_size, halo);
+	void* shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED) {
+		std::cerr << "Error: " << __func__ << " : Cannot map shared memory."
+			<< std::endl;
+		close(result_fd);
+		return false;
+	}
+
+	pthread_barrier_t* barrier = static_cast<pthread_barrier_t*>(shared);
+	pthread_barrierattr_t attr;
+	pthread_barrierattr_init(&attr);
+	pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	pthread_barrier_init(barrier, &attr, (unsigned)modified_num_of_processes);
+	pthread_barrierattr_destroy(&attr);
+
+	// Fork the workers.
+	std::vector<pid_t> pids;
+	bool result = true;
+	for (size_t rank = 0; rank < modified_num_of_processes; ++rank) {
+		const pid_t pid = fork();
+		if (pid < 0) {
+			std::cerr << "Error: " << __func__ << " : fork failed." << std::endl;
+			result = false;
+			break;
+		}
+		if (pid == 0) {
+			bool worker_result = false;
+			{
+				Worker worker(*this, rank, modified_num_of_processes,
+					static_cast<char*>(shared), result_fd);
+				worker_result = worker.run(tau, target, minWithTarget,
+					result_filename, memoryBudget / modified_num_of_processes);
+			}
+			_exit(worker_result ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+		pids.push_back(pid);
+	}
+
+	// A failed worker leaves the others blocked on the barrier, so stop
+	// them all as soon as one fails.
+	if (!result) {
+		std::for_each(pids.cbegin(), pids.cend(),
+			[](const auto& pid) { kill(pid, SIGKILL); });
+	}
+	size_t remaining = pids.size();
+	while (remaining > 0) {
+		int status = 0;
+		const pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (std::find(pids.cbegin(), pids.cend(), pid) == pids.cend()) continue;
+		--remaining;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+			if (result) {
+				std::cerr << "Error: " << __func__ << " : Worker " << pid
+					<< " failed." << std::endl;
+				std::for_each(pids.cbegin(), pids.cend(),
+					[](const auto& p) { kill(p, SIGKILL); });
+			}
+			result = false;
+		}
+	}
+
+	pthread_barrier_destroy(barrier);
+	munmap(shared, shared_size);
+	close(result_fd);
+	return result;
+}
+
+bool DistributedHJI::load(
+		std::vector<beacls::FloatVec>& datas,
+		const std::string& result_filename,
+		const size_t num_of_slices) const {
+	datas.resize(num_of_slices);
+	for (size_t slice = 0; slice < num_of_slices; ++slice) {
+		if (!loadSlice(datas[slice], result_filename, slice)) return false;
+	}
+	return true;
+}
+
+bool DistributedHJI::loadSlice(
+		beacls::FloatVec& data,
+		const std::string& result_filename,
+		const size_t slice) const {
+	const int fd = open(result_filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Error: " << __func__ << " : Cannot open "
+			<< result_filename << std::endl;
+		return false;
+	}
+
+	bool result = true;
+	data.resize(numel);
+	char* ptr = reinterpret_cast<char*>(data.data());
+	size_t remaining = numel * sizeof(FLOAT_TYPE);
+	off_t offset = (off_t)(slice * numel * sizeof(FLOAT_TYPE));
+	while (remaining > 0) {
+		const ssize_t n = pread(fd, ptr, remaining, offset);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR) continue;
+			std::cerr << "Error: " << __func__ << " : Cannot read slice "
+				<< slice << " of " << result_filename << std::endl;
+			result = false;
+			break;
+		}
+		ptr += n;
+		offset += n;
+		remaining -= (size_t)n;
+	}
+
+	close(fd);
+	return result;
+}
+
+size_t DistributedHJI::Worker::alphas_offset() {
+	// Keep every piece on its own cache line.
+	return ((sizeof(pthread_barrier_t) + 63) / 64) * 64;
+}
+
+size_t DistributedHJI::Worker::mailbox_offset(
+		const size_t num_of_processes,
+		const size_t num_dim) {
+	return alphas_offset() +
+		((num_of_processes * num_dim * sizeof(double) + 63) / 64) * 64;
+}
+
+size_t DistributedHJI::Worker::shared_size(
+		const size_t num_of_processes,
+		const size_t num_dim,
+		const size_t plane_size,
+		const size_t halo) {
+	return mailbox_offset(num_of_processes, num_dim) +
+		num_of_processes * 2 * halo * plane_size * sizeof(FLOAT_TYPE);
+}
+
+
+DistributedHJI::Worker::Worker(
+		const DistributedHJI& solver,
+		const size_t rank,
+		const size_t num_of_processes,
+		char* shared,
+		const int result_fd) :
+		solver(solver), rank(rank), num_of_processes(num_of_processes),
+		num_dim(solver.Ns.size()), last_dim(solver.Ns.size() - 1),
+		halo(halo_width(solver.accuracy)),
+		result_fd(result_fd), V0(NULL), V1(NULL), V2(NULL), targets(NULL),
+		out_of_core(false) {
+	const beacls::IntegerVec& Ns = solver.Ns;
+	plane_size = solver.numel / Ns[last_dim];
+
+	// Balanced split of the last dimension.
+	const size_t base = Ns[last_dim] / num_of_processes;
+	const size_t extra = Ns[last_dim] % num_of_processes;
+	plane_begin = rank * base + std::min(rank, extra);
+	num_of_planes = base + ((rank < extra) ? 1 : 0);
+	tile_planes = num_of_planes;
+
+	strides.resize(num_dim);
+	strides[0] = 1;
+	for (size_t dim = 1; dim < num_dim; ++dim)
+		strides[dim] = strides[dim - 1] * Ns[dim - 1];
+
+	barrier = reinterpret_cast<pthread_barrier_t*>(shared);
+	shared_alphas = reinterpret_cast<double*>(shared + alphas_offset());
+	mailbox = reinterpret_cast<FLOAT_TYPE*>(
+		shared + mailbox_offset(num_of_processes, num_dim));
+
+	// Grid coordinates of one plane; the last dimension is set per plane.
+	xs.resize(num_dim);
+	x_ites.resize(num_dim);
+	x_sizes.assign(num_dim, plane_size);
+	for (size_t dim = 0; dim < num_dim; ++dim) {
+		xs[dim].resize(plane_size);
+		if (dim == last_dim) continue;
+		for (size_t j = 0; j < plane_size; ++j) {
+			const size_t i = (j / strides[dim]) % Ns[dim];
+			xs[dim][j] = solver.mins[dim] + (FLOAT_TYPE)i * solver.dxs[dim];
+		}
+	}
+
+	derivLs.resize(num_dim);
+	derivRs.resize(num_dim);
+	derivCs.resize(num_dim);
+	dx.resize(num_dim);
+	for (size_t dim = 0; dim < num_dim; ++dim) {
+		derivLs[dim].resize(plane_size);
+		derivRs[dim].resize(plane_size);
+		derivCs[dim].resize(plane_size);
+	}
+}
+
+DistributedHJI::Worker::~Worker() {
+	std::for_each(maps.cbegin(), maps.cend(),
+		[](const auto& map) { munmap(map.first, map.second); });
+}
+
+bool DistributedHJI::Worker::allocate(
+		const bool minWithTarget,
+		const std::string& scratch_prefix,
+		const size_t memoryBudget) {
+	const size_t array_size = (num_of_planes + 2 * halo) * plane_size;
+	const bool rk3 = solver.accuracy == helperOC::ApproximationAccuracy_veryHigh;
+	const size_t num_of_arrays = (rk3 ? 3 : 2) + (minWithTarget ? 1 : 0);
+
+	if (memoryBudget == 0) {
+		storages.resize(num_of_arrays);
+		std::for_each(storages.begin(), storages.end(),
+			[array_size](auto& storage) { storage.resize(array_size); });
+		V0 = storages[0].data();
+		V1 = storages[1].data();
+		if (rk3) V2 = storages[2].data();
+		if (minWithTarget) targets = storages[num_of_arrays - 1].data();
+	}
+	else {
+		// Resident memory per tile plane: the right hand side and differences,
+		// plus pages of the value arrays for the current and the prefetched
+		// tile. On top of that the per plane buffers and halos are fixed.
+		const size_t plane_bytes = plane_size * sizeof(FLOAT_TYPE);
+		const size_t per_tile_plane = plane_bytes *
+			((num_dim + 1) + 2 * num_of_arrays);
+		const size_t fixed = plane_bytes *
+			(4 * num_dim + solver.dynSys->get_nu() + solver.dynSys->get_nd() +
+			num_dim + 2 * 2 * halo * num_of_arrays);
+		tile_planes = (memoryBudget > fixed + per_tile_plane) ?
+			(memoryBudget - fixed) / per_tile_plane : 1;
+		if (memoryBudget < fixed + per_tile_plane) {
+			std::cerr << "Warning: " << __func__ << " : Memory budget "
+				<< memoryBudget << " is below the minimum of "
+				<< fixed + per_tile_plane << " bytes per worker." << std::endl;
+		}
+		tile_planes = std::min(tile_planes, num_of_planes);
+		out_of_core = tile_planes < num_of_planes;
+
+		if (out_of_core) {
+			std::stringstream prefix;
+			prefix << scratch_prefix << ".worker" << rank;
+			V0 = map_scratch(prefix.str() + ".v0", array_size);
+			V1 = map_scratch(prefix.str() + ".v1", array_size);
+			if (rk3) V2 = map_scratch(prefix.str() + ".v2", array_size);
+			if (minWithTarget) targets = map_scratch(prefix.str() + ".target",
+				array_size);
+			if (V0 == NULL || V1 == NULL || (rk3 && V2 == NULL) ||
+					(minWithTarget && targets == NULL))
+				return false;
+		}
+		else {
+			return allocate(minWithTarget, scratch_prefix, 0);
+		}
+	}
+
+	rhs.resize(tile_planes * plane_size);
+	diffs.resize(num_dim);
+	std::for_each(diffs.begin(), diffs.end(),
+		[this](auto& diff) { diff.resize(tile_planes * plane_size); });
+	return true;
+}
+
+FLOAT_TYPE* DistributedHJI::Worker::map_scratch(
+		const std::string& filename,
+		const size_t size) {
+	const int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		std::cerr << "Error: " << __func__ << " : Cannot open " << filename
+			<< std::endl;
+		return NULL;
+	}
+
+	const size_t bytes = size * sizeof(FLOAT_TYPE);
+	void* map = MAP_FAILED;
+	if (ftruncate(fd, (off_t)bytes) == 0)
+		map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	// The mapping keeps the file alive; nothing is left behind on exit.
+	close(fd);
+	unlink(filename.c_str());
+
+	if (map == MAP_FAILED) {
+		std::cerr << "Error: " << __func__ << " : Cannot map " << filename
+			<< std::endl;
+		return NULL;
+	}
+
+	// Tiles are swept in order, so let the kernel read ahead.
+	madvise(map, bytes, MADV_SEQUENTIAL);
+	maps.push_back(std::make_pair(map, bytes));
+	return static_cast<FLOAT_TYPE*>(map);
+}
+
+void DistributedHJI::Worker::advise(
+		const FLOAT_TYPE* V,
+		const size_t first,
+		const size_t last,
+		const int advice) const {
+	if (!out_of_core || last <= first) return;
+
+	const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t begin = ((size_t)(V + first * plane_size) / page_size) *
+		page_size;
+	const size_t end = (size_t)(V + last * plane_size);
+	madvise((void*)begin, end - begin, advice);
+}
+
+bool DistributedHJI::Worker::run(
+		const beacls::FloatVec& tau,
+		const Target_Type& target,
+		const bool minWithTarget,
+		const std::string& scratch_prefix,
+		const size_t memoryBudget) {
+	if (!allocate(minWithTarget, scratch_prefix, memoryBudget)) return false;
+
+	// Initial data is the target.
+	beacls::FloatVec x(num_dim);
+	for (size_t p = 0; p < num_of_planes; ++p) {
+		x[last_dim] = solver.mins[last_dim] +
+			(FLOAT_TYPE)(plane_begin + p) * solver.dxs[last_dim];
+		FLOAT_TYPE* plane = V0 + (p + halo) * plane_size;
+		for (size_t j = 0; j < plane_size; ++j) {
+			for (size_t dim = 0; dim < last_dim; ++dim) x[dim] = xs[dim][j];
+			plane[j] = target(x);
+		}
+		if (minWithTarget) {
+			std::copy(plane, plane + plane_size,
+				targets + (p + halo) * plane_size);
+			advise(targets, p + halo, p + halo + 1, MADV_DONTNEED);
+		}
+		advise(V0, p + halo, p + halo + 1, MADV_DONTNEED);
+	}
+
+	if (!write_slice(V0, 0)) return false;
+
+	const size_t num_of_stages = (V2 != NULL) ? 3 : 2;
+	beacls::FloatVec alphas(num_dim);
+	for (size_t slice = 1; slice < tau.size(); ++slice) {
+		FLOAT_TYPE t = tau[slice - 1];
+		const FLOAT_TYPE t_end = tau[slice];
+		while (t < t_end) {
+			// The first stage sets the step for all stages.
+			FLOAT_TYPE dt = 0;
+			for (size_t s = 0; s < num_of_stages; ++s) {
+				if (!stage(alphas, dt, t, t_end, s)) return false;
+			}
+			t = (dt >= t_end - t) ? t_end : t + dt;
+		}
+
+		if (!write_slice(V0, slice)) return false;
+	}
+
+	return true;
+}
+
+bool DistributedHJI::Worker::stage(
+		beacls::FloatVec& alphas,
+		FLOAT_TYPE& dt,
+		const FLOAT_TYPE t,
+		const FLOAT_TYPE t_end,
+		const size_t s) {
+	// TVD Runge-Kutta in Shu-Osher form, as odeCFL2 and odeCFL3: stage s
+	// sets dst = a V0 + b (src + dt L(src)), evaluating L at t + c dt.
+	static const FLOAT_TYPE rk2[2][3] = { { 0, 1, 0 }, { 0.5, 0.5, 1 } };
+	static const FLOAT_TYPE rk3[3][3] = {
+		{ 0, 1, 0 }, { 0.75, 0.25, 1 }, { (FLOAT_TYPE)1 / 3, (FLOAT_TYPE)2 / 3, 0.5 } };
+	const bool third_order = V2 != NULL;
+	const FLOAT_TYPE* coefficients = third_order ? rk3[s] : rk2[s];
+	const FLOAT_TYPE a = coefficients[0];
+	const FLOAT_TYPE b = coefficients[1];
+	const bool last = s + 1 == (third_order ? 3 : 2);
+	FLOAT_TYPE* src = (s == 0) ? V0 : (s == 1) ? V1 : V2;
+	FLOAT_TYPE* dst = last ? V0 : (s == 0) ? V1 : V2;
+	exchange(src);
+
+	// Dissipation coefficients. In core this pass also computes the right
+	// hand side; out of core the tiles are swept again below.
+	const FLOAT_TYPE t_stage = t + coefficients[2] * dt;
+	std::fill(alphas.begin(), alphas.end(), (FLOAT_TYPE)0);
+	for (size_t p = 0; p < num_of_planes; p += tile_planes) {
+		const size_t e = std::min(p + tile_planes, num_of_planes);
+		advise(src, e, std::min(e + tile_planes, num_of_planes) + 2 * halo,
+			MADV_WILLNEED);
+		if (!evaluate(&alphas, !out_of_core, src, t_stage, p, e)) return false;
+		advise(src, p, e, MADV_DONTNEED);
+	}
+	reduce(alphas);
+
+	if (s == 0) {
+		FLOAT_TYPE rate = 0;
+		for (size_t dim = 0; dim < num_dim; ++dim)
+			rate += alphas[dim] / solver.dxs[dim];
+		dt = t_end - t;
+		if (rate > 0) dt = std::min<FLOAT_TYPE>(dt, solver.factorCFL / rate);
+	}
+
+	for (size_t p = 0; p < num_of_planes; p += tile_planes) {
+		const size_t e = std::min(p + tile_planes, num_of_planes);
+		const size_t next = std::min(e + tile_planes, num_of_planes);
+		if (out_of_core) {
+			advise(src, e, next + 2 * halo, MADV_WILLNEED);
+			if (a != 0) advise(V0, e + halo, next + halo, MADV_WILLNEED);
+			if (last && targets != NULL)
+				advise(targets, e + halo, next + halo, MADV_WILLNEED);
+			if (!evaluate(NULL, true, src, t_stage, p, e)) return false;
+		}
+
+		const size_t offset = (p + halo) * plane_size;
+		const size_t size = (e - p) * plane_size;
+		for (size_t i = 0; i < size; ++i) {
+			FLOAT_TYPE ydot = rhs[i];
+			for (size_t dim = 0; dim < num_dim; ++dim)
+				ydot += alphas[dim] * diffs[dim][i];
+			const FLOAT_TYPE euler = src[offset + i] + dt * ydot;
+			dst[offset + i] = (a == 0) ? euler : a * V0[offset + i] + b * euler;
+			if (last && targets != NULL)
+				V0[offset + i] = std::min(V0[offset + i], targets[offset + i]);
+		}
+
+		advise(src, p, e, MADV_DONTNEED);
+		advise(dst, p + halo, e + halo, MADV_DONTNEED);
+		if (a != 0) advise(V0, p + halo, e + halo, MADV_DONTNEED);
+		if (last && targets != NULL)
+			advise(targets, p + halo, e + halo, MADV_DONTNEED);
+	}
+
+	return true;
+}
+
+void DistributedHJI::Worker::exchange(FLOAT_TYPE* V) {
+	// Publish our edge planes.
+	const size_t halo_size = halo * plane_size;
+	FLOAT_TYPE* own = mailbox + rank * 2 * halo_size;
+	std::copy(V + halo_size, V + 2 * halo_size, own);
+	std::copy(V + num_of_planes * plane_size,
+		V + num_of_planes * plane_size + halo_size, own + halo_size);
+	pthread_barrier_wait(barrier);
+
+	// Collect the neighbours' edges into our halos.
+	if (rank > 0) {
+		const FLOAT_TYPE* below = mailbox + (rank - 1) * 2 * halo_size;
+		std::copy(below + halo_size, below + 2 * halo_size, V);
+	}
+	if (rank + 1 < num_of_processes) {
+		const FLOAT_TYPE* above = mailbox + (rank + 1) * 2 * halo_size;
+		std::copy(above, above + halo_size,
+			V + num_of_planes * plane_size + halo_size);
+	}
+
+	// Nobody may overwrite the mailbox until everyone has read it.
+	pthread_barrier_wait(barrier);
+
+	// Ghost planes at the domain boundary. These may read a neighbour's halo
+	// when the slab is a single plane thick, so fill them last.
+	if (rank == 0) {
+		const FLOAT_TYPE* edge = V + halo_size;
+		for (size_t k = 1; k <= halo; ++k) {
+			FLOAT_TYPE* ghost = V + halo_size - k * plane_size;
+			for (size_t j = 0; j < plane_size; ++j)
+				ghost[j] = extrapolate(edge[j], edge[plane_size + j], k);
+		}
+	}
+	if (rank + 1 == num_of_processes) {
+		const FLOAT_TYPE* edge = V + (num_of_planes + halo - 1) * plane_size;
+		for (size_t k = 1; k <= halo; ++k) {
+			FLOAT_TYPE* ghost = V + (num_of_planes + halo - 1 + k) * plane_size;
+			for (size_t j = 0; j < plane_size; ++j)
+				ghost[j] = extrapolate(edge[j], (edge - plane_size)[j], k);
+		}
+	}
+}
+
+void DistributedHJI::Worker::reduce(beacls::FloatVec& alphas) {
+	std::copy(alphas.cbegin(), alphas.cend(), shared_alphas + rank * num_dim);
+	pthread_barrier_wait(barrier);
+
+	// Every worker takes the max in the same order, so all agree exactly.
+	// The next write happens after the next exchange's barrier.
+	for (size_t dim = 0; dim < num_dim; ++dim) {
+		double alpha = 0;
+		for (size_t r = 0; r < num_of_processes; ++r)
+			alpha = std::max(alpha, shared_alphas[r * num_dim + dim]);
+		alphas[dim] = (FLOAT_TYPE)alpha;
+	}
+}
+
+FLOAT_TYPE DistributedHJI::Worker::weno5(
+		const double v1,
+		const double v2,
+		const double v3,
+		const double v4,
+		const double v5) {
+	// Candidate third order approximations and their smoothness.
+	const double phi1 = v1 / 3 - 7 * v2 / 6 + 11 * v3 / 6;
+	const double phi2 = -v2 / 6 + 5 * v3 / 6 + v4 / 3;
+	const double phi3 = v3 / 3 + 5 * v4 / 6 - v5 / 6;
+	const auto sq = [](const double a) { return a * a; };
+	const double s1 = 13. / 12 * sq(v1 - 2 * v2 + v3) +
+		0.25 * sq(v1 - 4 * v2 + 3 * v3);
+	const double s2 = 13. / 12 * sq(v2 - 2 * v3 + v4) + 0.25 * sq(v2 - v4);
+	const double s3 = 13. / 12 * sq(v3 - 2 * v4 + v5) +
+		0.25 * sq(3 * v3 - 4 * v4 + v5);
+
+	// Epsilon scaled by the largest difference, as maxOverNeighbor. Kept
+	// in double so that it cannot underflow.
+	const double epsilon = 1e-6 * std::max({ sq(v1), sq(v2), sq(v3),
+		sq(v4), sq(v5) }) + 1e-99;
+	const double a1 = 0.1 / sq(s1 + epsilon);
+	const double a2 = 0.6 / sq(s2 + epsilon);
+	const double a3 = 0.3 / sq(s3 + epsilon);
+	return (FLOAT_TYPE)((a1 * phi1 + a2 * phi2 + a3 * phi3) / (a1 + a2 + a3));
+}
+
+bool DistributedHJI::Worker::evaluate_dynamics(
+		std::vector<beacls::FloatVec>& dx,
+		const std::vector<const FLOAT_TYPE*>& deriv_ptrs,
+		const FLOAT_TYPE t) {
+	const DynSys* dynSys = solver.dynSys;
+	if (!dynSys->optCtrl(uOpts, t, x_ites, deriv_ptrs, x_sizes, x_sizes,
+			solver.uMode)) return false;
+	if (!dynSys->optDstb(dOpts, t, x_ites, deriv_ptrs, x_sizes, x_sizes,
+			solver.dMode)) return false;
+	return dynSys->dynamics(dx, t, x_ites, uOpts, dOpts, x_sizes,
+		std::numeric_limits<size_t>::max());
+}
+
+bool DistributedHJI::Worker::evaluate(
+		beacls::FloatVec* alphas,
+		const bool compute_rhs,
+		const FLOAT_TYPE* V,
+		const FLOAT_TYPE t,
+		const size_t p_begin,
+		const size_t p_end) {
+	const beacls::IntegerVec& Ns = solver.Ns;
+
+	std::vector<const FLOAT_TYPE*> derivL_ptrs(num_dim);
+	std::vector<const FLOAT_TYPE*> derivR_ptrs(num_dim);
+	std::vector<const FLOAT_TYPE*> derivC_ptrs(num_dim);
+	for (size_t dim = 0; dim < num_dim; ++dim) {
+		derivL_ptrs[dim] = derivLs[dim].data();
+		derivR_ptrs[dim] = derivRs[dim].data();
+		derivC_ptrs[dim] = derivCs[dim].data();
+	}
+
+	const bool weno = halo == 3;
+	FLOAT_TYPE stencil[7];
+	for (size_t p = p_begin; p < p_end; ++p) {
+		const size_t base = (p + halo) * plane_size;
+		const size_t tile_base = (p - p_begin) * plane_size;
+		std::fill(xs[last_dim].begin(), xs[last_dim].end(),
+			solver.mins[last_dim] +
+			(FLOAT_TYPE)(plane_begin + p) * solver.dxs[last_dim]);
+		for (size_t dim = 0; dim < num_dim; ++dim) x_ites[dim] = xs[dim].cbegin();
+
+		// Upwind derivatives, first order or WENO5.
+		for (size_t dim = 0; dim < num_dim; ++dim) {
+			const FLOAT_TYPE dx_inv = (FLOAT_TYPE)1 / solver.dxs[dim];
+			const size_t stride = (dim == last_dim) ? plane_size : strides[dim];
+			beacls::FloatVec& derivL = derivLs[dim];
+			beacls::FloatVec& derivR = derivRs[dim];
+			beacls::FloatVec& derivC = derivCs[dim];
+			for (size_t j = 0; j < plane_size; ++j) {
+				// stencil[halo + k] is the value k points along dim, from the
+				// halo planes in the last dimension and extrapolated past the
+				// grid edges in the others.
+				const FLOAT_TYPE* v = V + base + j;
+				const auto at = [v, stride, this](const size_t k) {
+					return v[((ptrdiff_t)k - (ptrdiff_t)halo) * (ptrdiff_t)stride];
+				};
+				if (dim == last_dim) {
+					for (size_t k = 0; k <= 2 * halo; ++k) stencil[k] = at(k);
+				}
+				else {
+					const size_t i = (j / stride) % Ns[dim];
+					const FLOAT_TYPE* lo = v - i * stride;
+					const FLOAT_TYPE* hi = v + (Ns[dim] - 1 - i) * stride;
+					for (size_t k = 0; k <= 2 * halo; ++k) {
+						if (i + k < halo)
+							stencil[k] = extrapolate(lo[0], lo[stride], halo - i - k);
+						else if (i + k - halo >= Ns[dim])
+							stencil[k] = extrapolate(hi[0], *(hi - stride),
+								i + k - halo - (Ns[dim] - 1));
+						else
+							stencil[k] = at(k);
+					}
+				}
+
+				if (weno) {
+					FLOAT_TYPE D[6];
+					for (size_t k = 0; k < 6; ++k)
+						D[k] = (stencil[k + 1] - stencil[k]) * dx_inv;
+					derivL[j] = weno5(D[0], D[1], D[2], D[3], D[4]);
+					derivR[j] = weno5(D[5], D[4], D[3], D[2], D[1]);
+				}
+				else {
+					derivL[j] = (stencil[1] - stencil[0]) * dx_inv;
+					derivR[j] = (stencil[2] - stencil[1]) * dx_inv;
+				}
+				derivC[j] = (FLOAT_TYPE)0.5 * (derivL[j] + derivR[j]);
+			}
+			if (compute_rhs) {
+				for (size_t j = 0; j < plane_size; ++j)
+					diffs[dim][tile_base + j] =
+						(FLOAT_TYPE)0.5 * (derivR[j] - derivL[j]);
+			}
+		}
+
+		// Hamiltonian at the averaged derivative.
+		if (!evaluate_dynamics(dx, derivC_ptrs, t)) return false;
+		if (compute_rhs) {
+			for (size_t j = 0; j < plane_size; ++j) {
+				FLOAT_TYPE ham = 0;
+				for (size_t dim = 0; dim < num_dim; ++dim)
+					ham += derivCs[dim][j] * dx[dim][j];
+				rhs[tile_base + j] = ham;
+			}
+		}
+		if (alphas == NULL) continue;
+
+		// Dissipation coefficients: largest speed over the controls and
+		// disturbances optimal for any of the derivatives seen here.
+		for (const auto* deriv_ptrs : { &derivC_ptrs, &derivL_ptrs, &derivR_ptrs }) {
+			if (deriv_ptrs != &derivC_ptrs &&
+					!evaluate_dynamics(dx, *deriv_ptrs, t)) return false;
+			for (size_t dim = 0; dim < num_dim; ++dim) {
+				const auto minmax = std::minmax_element(dx[dim].cbegin(),
+					dx[dim].cend());
+				(*alphas)[dim] = std::max((*alphas)[dim],
+					std::max(std::abs(*minmax.first), std::abs(*minmax.second)));
+			}
+		}
+	}
+
+	return true;
+}
+
+bool DistributedHJI::Worker::write_slice(
+		const FLOAT_TYPE* V,
+		const size_t slice) {
+	const char* ptr = reinterpret_cast<const char*>(V + halo * plane_size);
+	size_t remaining = num_of_planes * plane_size * sizeof(FLOAT_TYPE);
+	off_t offset = (off_t)((slice * solver.numel + plane_begin * plane_size) *
+		sizeof(FLOAT_TYPE));
+	while (remaining > 0) {
+		const ssize_t n = pwrite(result_fd, ptr, remaining, offset);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			std::cerr << "Error: " << __func__ << " : Cannot write slice "
+				<< slice << std::endl;
+			return false;
+		}
+		ptr += n;
+		offset += n;
+		remaining -= (size_t)n;
+	}
+
+	// Written pages are clean, so they can go straight away.
+	advise(V, halo, num_of_planes + halo, MADV_DONTNEED);
+	return true;
+}
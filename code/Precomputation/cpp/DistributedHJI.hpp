@@ -0,0 +1,166 @@
+#ifndef __DistributedHJI_hpp__
+#define __DistributedHJI_hpp__
+
+//! Prefix to generate Visual C++ DLL
+#ifdef _MAKE_VC_DLL
+#define PREFIX_VC_DLL __declspec(dllexport)
+
+//! Don't add prefix, except dll generating
+#else
+#define PREFIX_VC_DLL
+#endif
+
+#include <helperOC/helperOC_type.hpp>
+#include <helperOC/DynSys/DynSys/DynSys.hpp>
+#include <typedef.hpp>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <functional>
+
+namespace helperOC {
+	/*
+		@brief Domain-decomposed HJI PDE solver.
+
+		Splits the grid into slabs along the last (slowest varying) dimension
+		and solves each slab in its own worker process, so that the memory
+		and cores of one process no longer bound the grid resolution. Each
+		step the workers exchange halo planes with their neighbours through
+		a shared memory mailbox, and agree on the global Lax-Friedrichs
+		dissipation and CFL time step through a shared reduction.
+
+		The numerical Hamiltonian is global Lax-Friedrichs with extrapolated
+		boundaries, as in HJIPDE::solve. Two accuracies are supported:
+		ApproximationAccuracy_low, first order upwind in space and second
+		order TVD Runge-Kutta in time with one halo plane, and
+		ApproximationAccuracy_veryHigh (the default), fifth order WENO in
+		space and third order TVD Runge-Kutta in time with three halo planes,
+		the same schemes HJIPDE::solve uses at that accuracy. Only the dynSys
+		interface (optCtrl, optDstb, dynamics) is used, so any DynSys can be
+		solved.
+
+		Each worker writes its slab of every output time slice straight into
+		the result file, which holds numel values per slice, slice after
+		slice, in the usual column-major grid order.
+
+		With a memory budget set, workers run out of core: their value
+		arrays live in memory-mapped scratch files next to the result file,
+		and each step is processed in tiles of planes sized to fit the
+		budget. The next tile (with its halo planes) is prefetched while the
+		current one is computed, and finished tiles are released, so peak
+		resident memory stays near the budget however large the grid. Two
+		passes are made over the tiles per stage (dissipation coefficients,
+		then update), which costs some recomputation but gives results
+		identical to the in-core mode.
+	*/
+	class DistributedHJI {
+	public:
+		//! Target function, evaluated at each grid point's coordinates.
+		typedef std::function<FLOAT_TYPE(const beacls::FloatVec&)> Target_Type;
+
+		/*
+		@param	[in]		mins	grid lower bounds
+		@param	[in]		maxs	grid upper bounds
+		@param	[in]		Ns	number of grid points in each dimension
+		@param	[in]		dynSys	dynamical system (not owned)
+		@param	[in]		uMode	control mode
+		@param	[in]		dMode	disturbance mode
+		*/
+		PREFIX_VC_DLL
+			DistributedHJI(
+				const beacls::FloatVec& mins,
+				const beacls::FloatVec& maxs,
+				const beacls::IntegerVec& Ns,
+				const DynSys* dynSys,
+				const helperOC::DynSys_UMode_Type uMode,
+				const helperOC::DynSys_DMode_Type dMode);
+
+		PREFIX_VC_DLL
+			~DistributedHJI();
+
+		/*
+		@brief Solve over the time points tau, writing one slice per time
+		point (including the first, which is the target) to result_filename.
+		@param	[in]		result_filename	raw output file
+		@param	[in]		tau	output time points, increasing
+		@param	[in]		target	target function
+		@param	[in]		num_of_processes	number of worker processes
+		@param	[in]		minWithTarget	take min with the target each step
+		@return	true if every worker succeeded
+		*/
+		PREFIX_VC_DLL
+			bool solve(
+				const std::string& result_filename,
+				const beacls::FloatVec& tau,
+				const Target_Type& target,
+				const size_t num_of_processes,
+				const bool minWithTarget = false) const;
+
+		/*
+		@brief Read time slices written by solve. This holds every slice in
+		memory at once; use loadSlice to go through large results one slice
+		at a time.
+		*/
+		PREFIX_VC_DLL
+			bool load(
+				std::vector<beacls::FloatVec>& datas,
+				const std::string& result_filename,
+				const size_t num_of_slices) const;
+
+		/*
+		@brief Read one time slice written by solve.
+		*/
+		PREFIX_VC_DLL
+			bool loadSlice(
+				beacls::FloatVec& data,
+				const std::string& result_filename,
+				const size_t slice) const;
+
+		PREFIX_VC_DLL
+			void set_factorCFL(const FLOAT_TYPE factorCFL) {
+				this->factorCFL = factorCFL;
+			}
+
+		/*
+		@brief Total resident memory budget in bytes over all workers, for
+		out-of-core solving. Zero (the default) keeps everything in memory.
+		*/
+		PREFIX_VC_DLL
+			void set_memoryBudget(const size_t memoryBudget) {
+				this->memoryBudget = memoryBudget;
+			}
+
+		/*
+		@brief Spatial and temporal accuracy, ApproximationAccuracy_low or
+		ApproximationAccuracy_veryHigh.
+		*/
+		PREFIX_VC_DLL
+			void set_accuracy(const helperOC::ApproximationAccuracy_Type accuracy) {
+				this->accuracy = accuracy;
+			}
+
+		size_t get_numel() const { return numel; }
+
+	private:
+		class Worker;
+
+		beacls::FloatVec mins;
+		beacls::FloatVec maxs;
+		beacls::IntegerVec Ns;
+		beacls::FloatVec dxs;
+		size_t numel;
+		const DynSys* dynSys;
+		helperOC::DynSys_UMode_Type uMode;
+		helperOC::DynSys_DMode_Type dMode;
+		FLOAT_TYPE factorCFL;
+		size_t memoryBudget;
+		helperOC::ApproximationAccuracy_Type accuracy;
+
+		/** @overload
+		Disable copy constructor and operator=
+		*/
+		DistributedHJI(const DistributedHJI& rhs);
+		DistributedHJI& operator=(const DistributedHJI& rhs);
+	};
+};
+#endif	/* __DistributedHJI_hpp__ */
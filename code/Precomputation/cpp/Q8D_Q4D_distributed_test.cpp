@@ -0,0 +1,209 @@
+#define _USE_MATH_DEFINES
+#include <levelset/levelset.hpp>
+#include <helperOC/helperOC.hpp>
+#include <helperOC/DynSys/DynSys/DynSysSchemeData.hpp>
+#include "Q8D_Q4D.hpp"
+#include "Q8D_Q4D.cpp"
+#include "DistributedHJI.hpp"
+#include "DistributedHJI.cpp"
+#include <cmath>
+#include <numeric>
+#include <functional>
+#include <cfloat>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+
+/**
+  @brief Computes the Q8D_Q4D reachable set with the domain-decomposed
+  solver, splitting the grid across several worker processes.
+
+  Arguments: dump_file num_of_processes check memory_budget_mb low_accuracy
+  With check != 0 a coarse grid is solved with one process and with
+  num_of_processes processes, and the two results are compared. Both are
+  then compared with HJIPDE::solve at the same accuracy.
+  With memory_budget_mb > 0 the workers run out of core within that total
+  budget.
+  With low_accuracy != 0 the scheme is first order instead of WENO5.
+  */
+int main(int argc, char *argv[])
+{
+  bool dump_file = false;
+  if (argc >= 2) {
+    dump_file = (atoi(argv[1]) == 0) ? false : true;
+  }
+  size_t num_of_processes = 4;
+  if (argc >= 3) {
+    num_of_processes = atoi(argv[2]);
+  }
+  bool check = false;
+  if (argc >= 4) {
+    check = (atoi(argv[3]) == 0) ? false : true;
+  }
+  size_t memory_budget_mb = 0;
+  if (argc >= 5) {
+    memory_budget_mb = atoi(argv[4]);
+  }
+  helperOC::ApproximationAccuracy_Type accuracy =
+      helperOC::ApproximationAccuracy_veryHigh;
+  if (argc >= 6) {
+    accuracy = (atoi(argv[5]) == 0) ?
+        helperOC::ApproximationAccuracy_veryHigh :
+        helperOC::ApproximationAccuracy_low;
+  }
+
+  //!< Q8D_Q4D parameters
+  const beacls::FloatVec initState{
+      (FLOAT_TYPE)0, (FLOAT_TYPE)0, (FLOAT_TYPE)0, (FLOAT_TYPE)0 };
+  const beacls::FloatVec uRange{
+      (FLOAT_TYPE)(-20./180.*M_PI), (FLOAT_TYPE)(20./180.*M_PI)};
+  const beacls::FloatVec aRange{ (FLOAT_TYPE)(-1.), (FLOAT_TYPE)1. };
+  const beacls::FloatVec dRange{ (FLOAT_TYPE)(-0.2), (FLOAT_TYPE)0.2 };
+  helperOC::Q8D_Q4D* q8d_q4d =
+      new helperOC::Q8D_Q4D(initState, uRange, aRange, dRange);
+
+  // Grid
+  const beacls::FloatVec gMin{(FLOAT_TYPE)-4, (FLOAT_TYPE)-4,
+      (FLOAT_TYPE)(-60.*M_PI/180.), (FLOAT_TYPE)(-2*M_PI)};
+  const beacls::FloatVec gMax{(FLOAT_TYPE)4, (FLOAT_TYPE)4,
+      (FLOAT_TYPE)(60.*M_PI/180.), (FLOAT_TYPE)(2*M_PI)};
+  const beacls::IntegerVec Ns = check ?
+      beacls::IntegerVec{21,21,17,17} : beacls::IntegerVec{81,81,65,65};
+
+  // Target: negative distance from the origin in position.
+  const helperOC::DistributedHJI::Target_Type target =
+      [](const beacls::FloatVec& x) {
+      return -std::sqrt(x[0] * x[0] + x[1] * x[1]); };
+
+  // Time
+  const FLOAT_TYPE tMax = check ? 1 : 15;
+  const FLOAT_TYPE dt = 0.2;
+  beacls::FloatVec tau = generateArithmeticSequence<FLOAT_TYPE>(0., dt, tMax);
+
+  helperOC::DistributedHJI* solver = new helperOC::DistributedHJI(gMin, gMax,
+      Ns, q8d_q4d, helperOC::DynSys_UMode_Max, helperOC::DynSys_DMode_Min);
+
+  solver->set_memoryBudget(memory_budget_mb * 1024 * 1024);
+  solver->set_accuracy(accuracy);
+
+  const std::string result_filename("Q8D_Q4D_distributed_test.raw");
+  if (!solver->solve(result_filename, tau, target, num_of_processes)) {
+    std::cerr << "Error: distributed solve failed." << std::endl;
+    return -1;
+  }
+
+  // Results are only read back to compare or dump them, and then one slice
+  // at a time, since all slices of the full grid do not fit in memory.
+  beacls::FloatVec data;
+
+  int result = 0;
+  if (check) {
+    // Same grid in one process, in memory. The arithmetic per grid point
+    // is the same in both, so the results should agree exactly.
+    const std::string reference_filename("Q8D_Q4D_distributed_ref.raw");
+    solver->set_memoryBudget(0);
+    if (!solver->solve(reference_filename, tau, target, 1)) return -1;
+
+    beacls::FloatVec reference;
+    FLOAT_TYPE max_error = 0;
+    for (size_t slice = 0; slice < tau.size(); ++slice) {
+      if (!solver->loadSlice(data, result_filename, slice) ||
+          !solver->loadSlice(reference, reference_filename, slice))
+        return -1;
+
+      for (size_t i = 0; i < data.size(); ++i) {
+        max_error = std::max<FLOAT_TYPE>(max_error,
+            std::abs(data[i] - reference[i]));
+      }
+    }
+    std::cout << "Max difference between 1 and " << num_of_processes
+        << " processes: " << max_error << std::endl;
+    result = (max_error == 0) ? 0 : -1;
+    std::remove(reference_filename.c_str());
+
+    // Same problem with the single-process HJIPDE solver. Dissipation and
+    // time steps are chosen differently, so the two only agree to within
+    // the discretization error, which should stay under a grid cell in
+    // position. The tracking error bound of a slice is the smallest level
+    // with a nonempty sublevel set of the negated value, -max V.
+    levelset::HJI_Grid* g = helperOC::createGrid(gMin, gMax, Ns);
+    std::vector<beacls::FloatVec> targets(1);
+    targets[0].resize(g->get_numel());
+    beacls::FloatVec x(Ns.size());
+    for (size_t i = 0; i < targets[0].size(); ++i) {
+      for (size_t dim = 0; dim < Ns.size(); ++dim) x[dim] = g->get_xs(dim)[i];
+      targets[0][i] = target(x);
+    }
+
+    helperOC::DynSysSchemeData* schemeData = new helperOC::DynSysSchemeData;
+    schemeData->set_grid(g);
+    schemeData->dynSys = q8d_q4d;
+    schemeData->uMode = helperOC::DynSys_UMode_Max;
+    schemeData->dMode = helperOC::DynSys_DMode_Min;
+    schemeData->accuracy = accuracy;
+
+    helperOC::HJIPDE_extraArgs extraArgs;
+    helperOC::HJIPDE_extraOuts extraOuts;
+    extraArgs.targets = targets;
+    helperOC::HJIPDE* hjipde = new helperOC::HJIPDE();
+    beacls::FloatVec tau2;
+    std::vector<beacls::FloatVec> datas;
+    hjipde->solve(datas, tau2, extraOuts, targets, tau, schemeData,
+        helperOC::HJIPDE::MinWithType_None, extraArgs);
+
+    FLOAT_TYPE max_value_error = 0;
+    FLOAT_TYPE max_teb_error = 0;
+    for (size_t slice = 0; slice < datas.size(); ++slice) {
+      if (!solver->loadSlice(data, result_filename, slice)) return -1;
+      for (size_t i = 0; i < data.size(); ++i) {
+        max_value_error = std::max<FLOAT_TYPE>(max_value_error,
+            std::abs(data[i] - datas[slice][i]));
+      }
+      const FLOAT_TYPE teb =
+          -*std::max_element(data.cbegin(), data.cend());
+      const FLOAT_TYPE hjipde_teb =
+          -*std::max_element(datas[slice].cbegin(), datas[slice].cend());
+      max_teb_error = std::max<FLOAT_TYPE>(max_teb_error,
+          std::abs(teb - hjipde_teb));
+    }
+    const FLOAT_TYPE dx = (gMax[0] - gMin[0]) / (FLOAT_TYPE)(Ns[0] - 1);
+    std::cout << "Max difference from HJIPDE: value " << max_value_error
+        << ", tracking error bound " << max_teb_error
+        << " (grid spacing " << dx << ")" << std::endl;
+    if (datas.size() != tau.size() || max_value_error > dx ||
+        max_teb_error > dx) result = -1;
+
+    if (hjipde) delete hjipde;
+    if (schemeData) delete schemeData;
+    if (g) delete g;
+  }
+
+  // save mat file, one variable per slice (data_1, data_2, ...) so that
+  // each is written and freed before the next is read
+  if (dump_file) {
+    std::string Q8D_Q4D_test_filename("Q8D_Q4D_distributed_test.mat");
+    beacls::MatFStream* fs = beacls::openMatFStream(Q8D_Q4D_test_filename,
+        beacls::MatOpenMode_Write);
+
+    levelset::HJI_Grid* g = helperOC::createGrid(gMin, gMax, Ns);
+    g->save_grid(std::string("g"), fs);
+    for (size_t slice = 0; slice < tau.size(); ++slice) {
+      if (!solver->loadSlice(data, result_filename, slice)) {
+        result = -1;
+        break;
+      }
+      std::ostringstream name;
+      name << "data_" << (slice + 1);
+      save_vector(data, name.str(), Ns, false, fs);
+    }
+    save_vector(tau, std::string("tau2"), Ns, false, fs);
+    beacls::closeMatFStream(fs);
+    if (g) delete g;
+  }
+  std::remove(result_filename.c_str());
+
+  if (solver) delete solver;
+  if (q8d_q4d) delete q8d_q4d;
+  return result;
+}
@@ -0,0 +1,305 @@
+#ifndef __RelDynSys_hpp__
+#define __RelDynSys_hpp__
+
+//! Prefix to generate Visual C++ DLL
+#ifdef _MAKE_VC_DLL
+#define PREFIX_VC_DLL __declspec(dllexport)
+
+//! Don't add prefix, except dll generating
+#else
+#define PREFIX_VC_DLL
+#endif
+
+#include <helperOC/DynSys/DynSys/DynSys.hpp>
+#include <typedef.hpp>
+#include <cstddef>
+#include <vector>
+#include <iostream>
+#include <limits>
+#include <typeinfo>
+#include <algorithm>
+#include <numeric>
+
+namespace helperOC {
+	/*
+		@brief Base of the point-wise relative (tracker minus planner) models
+		in RelModels.hpp.
+
+		A model only describes its dynamics at one state,
+			void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const;
+		and the box bounds of its inputs. The tracker's controls are u, and
+		everything it plays against (planner inputs and disturbances) is d.
+	*/
+	struct RelModel {
+		size_t nx;
+		size_t nu;
+		size_t nd;
+		beacls::IntegerVec pdim;	// Position dimensions
+		beacls::IntegerVec vdim;	// Velocity dimensions
+		beacls::FloatVec uMin;
+		beacls::FloatVec uMax;
+		beacls::FloatVec dMin;
+		beacls::FloatVec dMax;
+
+		bool operator==(const RelModel& rhs) const {
+			return nx == rhs.nx && nu == rhs.nu && nd == rhs.nd &&
+				pdim == rhs.pdim && vdim == rhs.vdim &&
+				uMin == rhs.uMin && uMax == rhs.uMax &&
+				dMin == rhs.dMin && dMax == rhs.dMax;
+		}
+	};
+
+	/*
+		@brief DynSys for any RelModel.
+
+		optCtrl and optDstb need no per-model code: each input is set to
+		whichever of its two bounds extremizes deriv . f, with the other
+		inputs at the middle of their ranges. This is exact whenever every
+		input enters the dynamics through its own monotone term, which holds
+		for all the relative models (including tan(angle) and state-dependent
+		coefficients such as the other vehicle's turn rate). Ties go to the
+		upper bound for max and the lower bound for min, as in the MATLAB
+		classes.
+
+		Vectors of length one (scalar derivatives, constant inputs) are
+		broadcast against the others.
+	*/
+	template <typename Model>
+	class RelDynSys : public DynSys {
+	protected:
+		Model model;
+	public:
+		PREFIX_VC_DLL
+			RelDynSys(const beacls::FloatVec& x, const Model& model) :
+			DynSys(model.nx, model.nu, model.nd, model.pdim, model.vdim),
+			model(model) {
+			if (x.size() != model.nx) {
+				std::cerr << "Error: " << __func__ << " : Initial state does not have right dimension!" << std::endl;
+			}
+
+			DynSys::set_x(x);
+			DynSys::push_back_xhist(x);
+		}
+
+		PREFIX_VC_DLL
+			virtual ~RelDynSys() {}
+
+		PREFIX_VC_DLL
+			virtual bool operator==(const RelDynSys& rhs) const {
+			if (this == &rhs) return true;
+			else if (!DynSys::operator==(rhs)) return false;
+			else return model == rhs.model;
+		}
+
+		PREFIX_VC_DLL
+			virtual bool operator==(const DynSys& rhs) const {
+			if (this == &rhs) return true;
+			else if (typeid(*this) != typeid(rhs)) return false;
+			else return operator==(dynamic_cast<const RelDynSys&>(rhs));
+		}
+
+		virtual RelDynSys* clone() const {
+			return new RelDynSys(*this);
+		}
+
+		const Model& get_model() const { return model; }
+
+		PREFIX_VC_DLL
+			bool optCtrl(
+				std::vector<beacls::FloatVec >& uOpts,
+				const FLOAT_TYPE,
+				const std::vector<beacls::FloatVec::const_iterator >& y_ites,
+				const std::vector<const FLOAT_TYPE*>& deriv_ptrs,
+				const beacls::IntegerVec& y_sizes,
+				const beacls::IntegerVec& deriv_sizes,
+				const helperOC::DynSys_UMode_Type uMode
+			) const {
+			const helperOC::DynSys_UMode_Type modified_uMode =
+				(uMode == helperOC::DynSys_UMode_Default) ?
+				helperOC::DynSys_UMode_Max : uMode;
+			if ((modified_uMode != helperOC::DynSys_UMode_Max) &&
+				(modified_uMode != helperOC::DynSys_UMode_Min)) {
+				std::cerr << "Unknown uMode!: " << uMode << std::endl;
+				return false;
+			}
+			return optInputs(uOpts, true,
+				modified_uMode == helperOC::DynSys_UMode_Max,
+				y_ites, deriv_ptrs, y_sizes, deriv_sizes);
+		}
+
+		PREFIX_VC_DLL
+			bool optDstb(
+				std::vector<beacls::FloatVec >& dOpts,
+				const FLOAT_TYPE,
+				const std::vector<beacls::FloatVec::const_iterator >& y_ites,
+				const std::vector<const FLOAT_TYPE*>& deriv_ptrs,
+				const beacls::IntegerVec& y_sizes,
+				const beacls::IntegerVec& deriv_sizes,
+				const helperOC::DynSys_DMode_Type dMode
+			) const {
+			const helperOC::DynSys_DMode_Type modified_dMode =
+				(dMode == helperOC::DynSys_DMode_Default) ?
+				helperOC::DynSys_DMode_Min : dMode;
+			if ((modified_dMode != helperOC::DynSys_DMode_Max) &&
+				(modified_dMode != helperOC::DynSys_DMode_Min)) {
+				std::cerr << "Unknown dMode!: " << dMode << std::endl;
+				return false;
+			}
+			return optInputs(dOpts, false,
+				modified_dMode == helperOC::DynSys_DMode_Max,
+				y_ites, deriv_ptrs, y_sizes, deriv_sizes);
+		}
+
+		PREFIX_VC_DLL
+			bool dynamics(
+				std::vector<beacls::FloatVec >& dxs,
+				const FLOAT_TYPE,
+				const std::vector<beacls::FloatVec::const_iterator >& x_ites,
+				const std::vector<beacls::FloatVec >& us,
+				const std::vector<beacls::FloatVec >& ds,
+				const beacls::IntegerVec& x_sizes,
+				const size_t dst_target_dim
+			) const {
+			const bool all_dims =
+				(dst_target_dim == std::numeric_limits<size_t>::max());
+			if (!all_dims && dst_target_dim >= model.nx) {
+				std::cerr << "Invalid target dimension for dynamics: " << dst_target_dim
+					<< std::endl;
+				return false;
+			}
+			if (us.size() < model.nu || (!ds.empty() && ds.size() < model.nd)) {
+				std::cerr << "Too few inputs for dynamics!" << std::endl;
+				return false;
+			}
+
+			// Missing disturbances are zero.
+			size_t length = 1;
+			for (size_t j = 0; j < model.nu; ++j)
+				length = std::max(length, us[j].size());
+			for (size_t j = 0; j < ds.size(); ++j)
+				length = std::max(length, ds[j].size());
+			if (length == 1) length = max_size(x_sizes);
+
+			if (dxs.size() < model.nx) dxs.resize(model.nx);
+			for (size_t dim = 0; dim < model.nx; ++dim)
+				if (all_dims || dim == dst_target_dim) dxs[dim].resize(length);
+
+			beacls::FloatVec x(model.nx), u(model.nu), d(model.nd, 0), dx(model.nx);
+			for (size_t i = 0; i < length; ++i) {
+				gather_state(x, x_ites, x_sizes, i);
+				for (size_t j = 0; j < model.nu; ++j) u[j] = at(us[j], i);
+				for (size_t j = 0; j < ds.size() && j < model.nd; ++j) d[j] = at(ds[j], i);
+				model.dynamics(x.data(), u.data(), d.data(), dx.data());
+				for (size_t dim = 0; dim < model.nx; ++dim)
+					if (all_dims || dim == dst_target_dim) dxs[dim][i] = dx[dim];
+			}
+			return true;
+		}
+
+	protected:
+		/** @overload
+		Disable copy constructor
+		*/
+		PREFIX_VC_DLL
+			RelDynSys(const RelDynSys& rhs) :
+			DynSys(rhs),
+			model(rhs.model)
+		{}
+	private:
+		/** @overload
+		Disable operator=
+		*/
+		RelDynSys& operator=(const RelDynSys& rhs);
+
+		static FLOAT_TYPE at(const beacls::FloatVec& v, const size_t i) {
+			return (v.size() == 1) ? v[0] : v[i];
+		}
+
+		static size_t max_size(const beacls::IntegerVec& sizes) {
+			size_t length = 1;
+			for (size_t dim = 0; dim < sizes.size(); ++dim)
+				length = std::max(length, (size_t)sizes[dim]);
+			return length;
+		}
+
+		void gather_state(beacls::FloatVec& x,
+				const std::vector<beacls::FloatVec::const_iterator >& x_ites,
+				const beacls::IntegerVec& x_sizes,
+				const size_t i) const {
+			for (size_t dim = 0; dim < model.nx; ++dim) {
+				if (dim >= x_ites.size() || dim >= x_sizes.size() || x_sizes[dim] == 0)
+					x[dim] = 0;
+				else
+					x[dim] = (x_sizes[dim] == 1) ? x_ites[dim][0] : x_ites[dim][i];
+			}
+		}
+
+		/*
+		@brief Extremize deriv . f over the controls (is_ctrl) or the
+		disturbances, one input at a time.
+		*/
+		bool optInputs(
+				std::vector<beacls::FloatVec >& opts,
+				const bool is_ctrl,
+				const bool maximize,
+				const std::vector<beacls::FloatVec::const_iterator >& y_ites,
+				const std::vector<const FLOAT_TYPE*>& deriv_ptrs,
+				const beacls::IntegerVec& y_sizes,
+				const beacls::IntegerVec& deriv_sizes) const {
+			if (deriv_ptrs.size() < model.nx || deriv_sizes.size() < model.nx)
+				return false;
+
+			size_t length = 1;
+			for (size_t dim = 0; dim < model.nx; ++dim)
+				length = std::max(length, (size_t)deriv_sizes[dim]);
+			if (length == 1) length = max_size(y_sizes);
+
+			const beacls::FloatVec& lo = is_ctrl ? model.uMin : model.dMin;
+			const beacls::FloatVec& hi = is_ctrl ? model.uMax : model.dMax;
+			const size_t n = is_ctrl ? model.nu : model.nd;
+
+			opts.resize(n);
+			std::for_each(opts.begin(), opts.end(), [length](auto& rhs)
+				{ rhs.resize(length); });
+
+			beacls::FloatVec x(model.nx), p(model.nx), dx(model.nx);
+			beacls::FloatVec u(model.nu), d(model.nd);
+			for (size_t j = 0; j < model.nu; ++j)
+				u[j] = (model.uMin[j] + model.uMax[j]) / 2;
+			for (size_t j = 0; j < model.nd; ++j)
+				d[j] = (model.dMin[j] + model.dMax[j]) / 2;
+			beacls::FloatVec& w = is_ctrl ? u : d;
+
+			for (size_t i = 0; i < length; ++i) {
+				gather_state(x, y_ites, y_sizes, i);
+				for (size_t dim = 0; dim < model.nx; ++dim) {
+					const FLOAT_TYPE* deriv = deriv_ptrs[dim];
+					p[dim] = (deriv == NULL || deriv_sizes[dim] == 0) ? 0 :
+						(deriv_sizes[dim] == 1) ? deriv[0] : deriv[i];
+				}
+
+				for (size_t j = 0; j < n; ++j) {
+					const FLOAT_TYPE mid = w[j];
+
+					w[j] = lo[j];
+					model.dynamics(x.data(), u.data(), d.data(), dx.data());
+					const FLOAT_TYPE h_lo = std::inner_product(p.cbegin(), p.cend(),
+						dx.cbegin(), (FLOAT_TYPE)0);
+
+					w[j] = hi[j];
+					model.dynamics(x.data(), u.data(), d.data(), dx.data());
+					const FLOAT_TYPE h_hi = std::inner_product(p.cbegin(), p.cend(),
+						dx.cbegin(), (FLOAT_TYPE)0);
+
+					w[j] = mid;
+					opts[j][i] = maximize ?
+						((h_hi >= h_lo) ? hi[j] : lo[j]) :
+						((h_lo <= h_hi) ? lo[j] : hi[j]);
+				}
+			}
+			return true;
+		}
+	};
+};
+#endif	/* __RelDynSys_hpp__ */
@@ -0,0 +1,254 @@
+#ifndef __RelModels_hpp__
+#define __RelModels_hpp__
+
+#include "RelDynSys.hpp"
+#include <cmath>
+
+/*
+	Point-wise C++ versions of the relative dynSys classes in code/dynSys,
+	for use with RelDynSys. Each is the subsystem actually solved by the
+	corresponding MATLAB *_RS script; decoupled models take the axis they
+	describe. In every model the tracker's controls are u, and the planner's
+	inputs and the disturbances are d.
+*/
+namespace helperOC {
+	/*
+		@brief P3D_Q2D_Rel: constant speed Dubins car tracking a 2D point.
+		x = [x, y, theta], u = [w], d = [dx, px, dy, py]
+			\dot x_1 = v*cos(x_3) + d{1} + d{2}
+			\dot x_2 = v*sin(x_3) + d{3} + d{4}
+			\dot x_3 = u{1}
+	*/
+	struct P3D_Q2D_Rel : public RelModel {
+		FLOAT_TYPE v;
+
+		P3D_Q2D_Rel(const FLOAT_TYPE wMax, const FLOAT_TYPE pMax,
+				const FLOAT_TYPE dBound, const FLOAT_TYPE v) : v(v) {
+			nx = 3; nu = 1; nd = 4;
+			pdim = beacls::IntegerVec{0, 1};
+			vdim = beacls::IntegerVec{2};
+			uMin = beacls::FloatVec{-wMax};
+			uMax = beacls::FloatVec{wMax};
+			dMin = beacls::FloatVec{-dBound, -pMax, -dBound, -pMax};
+			dMax = beacls::FloatVec{dBound, pMax, dBound, pMax};
+		}
+
+		void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			dx[0] = v * std::cos(x[2]) + d[0] + d[1];
+			dx[1] = v * std::sin(x[2]) + d[2] + d[3];
+			dx[2] = u[0];
+		}
+
+		bool operator==(const P3D_Q2D_Rel& rhs) const {
+			return RelModel::operator==(rhs) && v == rhs.v;
+		}
+	};
+
+	/*
+		@brief P4D_Q2D_Rel: Dubins car with acceleration tracking a 2D point.
+		x = [x, y, theta, v], u = [w, a], d = [dx, px, dy, py]
+			\dot x_1 = x_4*cos(x_3) - d{1} - d{2}
+			\dot x_2 = x_4*sin(x_3) - d{3} - d{4}
+			\dot x_3 = u{1}
+			\dot x_4 = u{2}
+	*/
+	struct P4D_Q2D_Rel : public RelModel {
+		P4D_Q2D_Rel(const FLOAT_TYPE wMax, const FLOAT_TYPE aMin,
+				const FLOAT_TYPE aMax, const FLOAT_TYPE pMax, const FLOAT_TYPE dBound) {
+			nx = 4; nu = 2; nd = 4;
+			pdim = beacls::IntegerVec{0, 1};
+			vdim = beacls::IntegerVec{3};
+			uMin = beacls::FloatVec{-wMax, aMin};
+			uMax = beacls::FloatVec{wMax, aMax};
+			dMin = beacls::FloatVec{-dBound, -pMax, -dBound, -pMax};
+			dMax = beacls::FloatVec{dBound, pMax, dBound, pMax};
+		}
+
+		void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			dx[0] = x[3] * std::cos(x[2]) - d[0] - d[1];
+			dx[1] = x[3] * std::sin(x[2]) - d[2] - d[3];
+			dx[2] = u[0];
+			dx[3] = u[1];
+		}
+	};
+
+	/*
+		@brief P5D_Dubins_Rel: 5D car relative to a Dubins car planner.
+		x = [xr, yr, thetar, v, w], u = [a, alpha],
+		d = [d1, d2, d3, d4, wOther]
+			\dot x_1 = -vOther + x_4*cos(x_3) + d{5}*x_2 + d{1}
+			\dot x_2 = x_4*sin(x_3) - d{5}*x_1 + d{2}
+			\dot x_3 = x_5 - d{5}
+			\dot x_4 = u{1} + d{3}
+			\dot x_5 = u{2} + d{4}
+	*/
+	struct P5D_Dubins_Rel : public RelModel {
+		FLOAT_TYPE vOther;
+
+		P5D_Dubins_Rel(const beacls::FloatVec& aRange, const FLOAT_TYPE alphaMax,
+				const FLOAT_TYPE vOther, const FLOAT_TYPE wMax,
+				const beacls::FloatVec& dMaxs) : vOther(vOther) {
+			nx = 5; nu = 2; nd = 5;
+			pdim = beacls::IntegerVec{0, 1};
+			vdim = beacls::IntegerVec{3};
+			uMin = beacls::FloatVec{aRange[0], -alphaMax};
+			uMax = beacls::FloatVec{aRange[1], alphaMax};
+			dMin = beacls::FloatVec{-dMaxs[0], -dMaxs[1], -dMaxs[2], -dMaxs[3], -wMax};
+			dMax = beacls::FloatVec{dMaxs[0], dMaxs[1], dMaxs[2], dMaxs[3], wMax};
+		}
+
+		void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			dx[0] = -vOther + x[3] * std::cos(x[2]) + d[4] * x[1] + d[0];
+			dx[1] = x[3] * std::sin(x[2]) - d[4] * x[0] + d[1];
+			dx[2] = x[4] - d[4];
+			dx[3] = u[0] + d[2];
+			dx[4] = u[1] + d[3];
+		}
+
+		bool operator==(const P5D_Dubins_Rel& rhs) const {
+			return RelModel::operator==(rhs) && vOther == rhs.vOther;
+		}
+	};
+
+	/*
+		@brief Point_3D_3D_Rel, one axis: velocity-controlled point tracking a
+		velocity-controlled point.
+		x = [p], u = [v], d = [p_planner]
+			\dot x_1 = u{1} - d{1}
+	*/
+	struct Point_3D_3D_Rel : public RelModel {
+		Point_3D_3D_Rel(const FLOAT_TYPE vTracker, const FLOAT_TYPE vPlanner) {
+			nx = 1; nu = 1; nd = 1;
+			pdim = beacls::IntegerVec{0};
+			vdim = beacls::IntegerVec();
+			uMin = beacls::FloatVec{-vTracker};
+			uMax = beacls::FloatVec{vTracker};
+			dMin = beacls::FloatVec{-vPlanner};
+			dMax = beacls::FloatVec{vPlanner};
+		}
+
+		void dynamics(const FLOAT_TYPE*, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			dx[0] = u[0] - d[0];
+		}
+	};
+
+	/*
+		@brief Q6D_Q3D_Rel, one axis: near-hover quadrotor (angles and thrust
+		as inputs) tracking a velocity-controlled point.
+		x = [p, v], u = [theta], [phi] or [thrust] for axis 0, 1 or 2,
+		d = [d_vel, p_planner, d_acc]
+			\dot x_1 = x_2 - d{1} - d{2}
+			\dot x_2 =  g*tan(u{1}) - d{3}        (x)
+			\dot x_2 = -g*tan(u{1}) - d{3}        (y)
+			\dot x_2 = u{1} - g - d{3}            (z)
+	*/
+	struct Q6D_Q3D_Rel : public RelModel {
+		size_t axis;
+		FLOAT_TYPE g;
+
+		Q6D_Q3D_Rel(const size_t axis, const FLOAT_TYPE uMinAxis,
+				const FLOAT_TYPE uMaxAxis, const FLOAT_TYPE pMax,
+				const FLOAT_TYPE dMaxV, const FLOAT_TYPE dMaxA) :
+				axis(axis), g(9.81) {
+			nx = 2; nu = 1; nd = 3;
+			pdim = beacls::IntegerVec{0};
+			vdim = beacls::IntegerVec{1};
+			uMin = beacls::FloatVec{uMinAxis};
+			uMax = beacls::FloatVec{uMaxAxis};
+			dMin = beacls::FloatVec{-dMaxV, -pMax, -dMaxA};
+			dMax = beacls::FloatVec{dMaxV, pMax, dMaxA};
+		}
+
+		void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			dx[0] = x[1] - d[0] - d[1];
+			switch (axis) {
+				case 0: dx[1] = g * std::tan(u[0]) - d[2]; break;
+				case 1: dx[1] = -g * std::tan(u[0]) - d[2]; break;
+				default: dx[1] = u[0] - g - d[2]; break;
+			}
+		}
+
+		bool operator==(const Q6D_Q3D_Rel& rhs) const {
+			return RelModel::operator==(rhs) && axis == rhs.axis;
+		}
+	};
+
+	/*
+		@brief Q8D_Q2D_Rel, one horizontal axis: quadrotor with angular
+		dynamics tracking a velocity-controlled point.
+		x = [p, v, angle, angular rate], u = [angle command],
+		d = [d_vel, p_planner]
+			\dot x_1 = x_2 + d{1} - d{2}
+			\dot x_2 = g*tan(x_3)
+			\dot x_3 = -d1*x_3 + x_4
+			\dot x_4 = -d0*x_3 + n0*u{1}
+	*/
+	struct Q8D_Q2D_Rel : public RelModel {
+		FLOAT_TYPE n0;
+		FLOAT_TYPE d1;
+		FLOAT_TYPE d0;
+		FLOAT_TYPE g;
+
+		Q8D_Q2D_Rel(const FLOAT_TYPE angleMax, const FLOAT_TYPE pMax,
+				const FLOAT_TYPE dBound) : n0(10), d1(8), d0(10), g(9.81) {
+			nx = 4; nu = 1; nd = 2;
+			pdim = beacls::IntegerVec{0};
+			vdim = beacls::IntegerVec{1};
+			uMin = beacls::FloatVec{-angleMax};
+			uMax = beacls::FloatVec{angleMax};
+			dMin = beacls::FloatVec{-dBound, -pMax};
+			dMax = beacls::FloatVec{dBound, pMax};
+		}
+
+		void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			dx[0] = x[1] + d[0] - d[1];
+			dx[1] = g * std::tan(x[2]);
+			dx[2] = -d1 * x[2] + x[3];
+			dx[3] = -d0 * x[2] + n0 * u[0];
+		}
+	};
+
+	/*
+		@brief Q10D_Q6D_Rel, one axis: the x and y axes are the angular chain
+		of Q8D_Q2D_Rel, and the z axis is thrust-controlled.
+		z: x = [p, v], u = [thrust], d = [d_vel, p_planner]
+			\dot x_1 = x_2 + d{1} - d{2}
+			\dot x_2 = kT*u{1} - g
+	*/
+	struct Q10D_Q6D_Rel : public Q8D_Q2D_Rel {
+		size_t axis;
+		FLOAT_TYPE kT;
+
+		Q10D_Q6D_Rel(const size_t axis, const FLOAT_TYPE angleMax,
+				const FLOAT_TYPE thrustMax, const FLOAT_TYPE pMax,
+				const FLOAT_TYPE dBound) :
+				Q8D_Q2D_Rel(angleMax, pMax, dBound), axis(axis), kT(0.91) {
+			if (axis == 2) {
+				nx = 2;
+				uMin = beacls::FloatVec{0};
+				uMax = beacls::FloatVec{thrustMax};
+			}
+		}
+
+		void dynamics(const FLOAT_TYPE* x, const FLOAT_TYPE* u,
+				const FLOAT_TYPE* d, FLOAT_TYPE* dx) const {
+			if (axis != 2) {
+				Q8D_Q2D_Rel::dynamics(x, u, d, dx);
+				return;
+			}
+			dx[0] = x[1] + d[0] - d[1];
+			dx[1] = kT * u[0] - g;
+		}
+
+		bool operator==(const Q10D_Q6D_Rel& rhs) const {
+			return RelModel::operator==(rhs) && axis == rhs.axis;
+		}
+	};
+};
+#endif	/* __RelModels_hpp__ */
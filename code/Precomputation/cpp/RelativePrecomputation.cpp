@@ -0,0 +1,534 @@
+#include "RelativePrecomputation.hpp"
+#include "DistributedHJI.hpp"
+#include "SparseGrid.hpp"
+#include <levelset/levelset.hpp>
+#include <helperOC/helperOC.hpp>
+#include <helperOC/DynSys/DynSys/DynSysSchemeData.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <iterator>
+using namespace helperOC;
+
+RelativePrecomputation::RelativePrecomputation(
+    const beacls::FloatVec& max_planner_speed,
+    const FLOAT_TYPE dt,
+    const FLOAT_TYPE tMax) :
+  max_planner_speed(max_planner_speed), dt(dt), tMax(tMax),
+  num_of_processes(1), margin(-1), memoryBudget(0), sparse_level(0) {
+}
+
+RelativePrecomputation::~RelativePrecomputation() {
+}
+
+beacls::FloatVec RelativePrecomputation::spacing(const Subsystem& subsystem) {
+  // createGrid drops the duplicate last point of periodic dimensions.
+  beacls::FloatVec dxs(subsystem.Ns.size());
+  for (size_t dim = 0; dim < dxs.size(); ++dim) {
+    const bool periodic = std::find(subsystem.pdDims.cbegin(),
+        subsystem.pdDims.cend(), dim) != subsystem.pdDims.cend();
+    const size_t intervals = periodic ? subsystem.Ns[dim] :
+        std::max<size_t>(subsystem.Ns[dim] - 1, 1);
+    dxs[dim] = (subsystem.maxs[dim] - subsystem.mins[dim]) / intervals;
+  }
+  return dxs;
+}
+
+std::vector<std::vector<double> > RelativePrecomputation::gradients(
+    const Subsystem& subsystem, const beacls::FloatVec& data) {
+  const size_t num_dim = subsystem.Ns.size();
+  const size_t numel = data.size();
+  const beacls::FloatVec dxs = spacing(subsystem);
+
+  // Strides of the column-major grid order.
+  std::vector<size_t> strides(num_dim, 1);
+  for (size_t dim = 1; dim < num_dim; ++dim)
+    strides[dim] = strides[dim - 1] * subsystem.Ns[dim - 1];
+
+  std::vector<std::vector<double> > derivs(num_dim,
+      std::vector<double>(numel));
+  for (size_t dim = 0; dim < num_dim; ++dim) {
+    const size_t N = subsystem.Ns[dim];
+    const size_t stride = strides[dim];
+    const bool periodic = std::find(subsystem.pdDims.cbegin(),
+        subsystem.pdDims.cend(), dim) != subsystem.pdDims.cend();
+    for (size_t i = 0; i < numel; ++i) {
+      const size_t k = (i / stride) % N;
+      if (N < 2) {
+        derivs[dim][i] = 0;
+      } else if (periodic || (k > 0 && k + 1 < N)) {
+        const size_t lo = (k > 0) ? i - stride : i + (N - 1) * stride;
+        const size_t hi = (k + 1 < N) ? i + stride : i - (N - 1) * stride;
+        derivs[dim][i] = (data[hi] - data[lo]) / (2 * dxs[dim]);
+      } else if (k == 0) {
+        derivs[dim][i] = (data[i + stride] - data[i]) / dxs[dim];
+      } else {
+        derivs[dim][i] = (data[i] - data[i - stride]) / dxs[dim];
+      }
+    }
+  }
+  return derivs;
+}
+
+double RelativePrecomputation::bounds(const Subsystem& subsystem,
+    const std::vector<double>& values, const beacls::FloatVec& dxs,
+    std::vector<double>& teb, double& priority_lower,
+    double& priority_upper) const {
+  // Tracking error bound, on the position dimensions.
+  FLOAT_TYPE bound_margin = margin;
+  if (bound_margin < 0) {
+    FLOAT_TYPE sum = 0;
+    for (size_t ii = 0; ii < subsystem.target_dims.size(); ++ii)
+      sum += std::pow(dxs[subsystem.target_dims[ii]] / 2, 2);
+    bound_margin = std::sqrt(sum);
+  }
+  const double bound =
+      *std::min_element(values.cbegin(), values.cend()) + bound_margin;
+  teb.assign(subsystem.Ns.size(), 0);
+  for (size_t ii = 0; ii < subsystem.target_dims.size(); ++ii)
+    teb[subsystem.target_dims[ii]] = bound;
+
+  // Priority levels: the median and 95th percentile of the value inside
+  // the bound.
+  std::vector<double> inside;
+  std::copy_if(values.cbegin(), values.cend(), std::back_inserter(inside),
+      [bound](const auto& v) { return v <= bound; });
+  std::sort(inside.begin(), inside.end());
+  priority_lower = inside.empty() ? bound :
+      inside[(size_t)(0.50 * (inside.size() - 1))];
+  priority_upper = inside.empty() ? bound :
+      inside[(size_t)(0.95 * (inside.size() - 1))];
+  return bound;
+}
+
+bool RelativePrecomputation::solve(beacls::FloatVec& data,
+    const Subsystem& subsystem) const {
+  const size_t num_dim = subsystem.Ns.size();
+  if (subsystem.dynSys == NULL || subsystem.mins.size() != num_dim ||
+      subsystem.maxs.size() != num_dim) {
+    std::cerr << "Error: " << __func__ << " : Invalid subsystem "
+        << subsystem.name << "." << std::endl;
+    return false;
+  }
+
+  const beacls::FloatVec tau =
+      generateArithmeticSequence<FLOAT_TYPE>(0., dt, tMax);
+  const beacls::IntegerVec& target_dims = subsystem.target_dims;
+
+  if (num_of_processes <= 1) {
+    levelset::HJI_Grid* g = helperOC::createGrid(subsystem.mins,
+        subsystem.maxs, subsystem.Ns, subsystem.pdDims);
+    const size_t numel = g->get_numel();
+
+    // Target: negative distance from the origin in position.
+    std::vector<beacls::FloatVec> targets(1);
+    targets[0].assign(numel, 0);
+    for (size_t ii = 0; ii < target_dims.size(); ++ii) {
+      const beacls::FloatVec &xs = g->get_xs(target_dims[ii]);
+      std::transform(xs.cbegin(), xs.cend(), targets[0].begin(),
+          targets[0].begin(), [](const auto &xs_i, const auto &t_i) {
+          return t_i + std::pow(xs_i, 2); });
+    }
+    std::transform(targets[0].cbegin(), targets[0].cend(), targets[0].begin(),
+        [](const auto &t_i) { return -std::sqrt(t_i); });
+
+    helperOC::DynSysSchemeData* schemeData = new helperOC::DynSysSchemeData;
+    schemeData->set_grid(g);
+    schemeData->dynSys = subsystem.dynSys->clone();
+    schemeData->uMode = helperOC::DynSys_UMode_Max;
+    schemeData->dMode = helperOC::DynSys_DMode_Min;
+
+    // Stop once the value changes by less than half a time step per step,
+    // as the MATLAB scripts do.
+    helperOC::HJIPDE_extraArgs extraArgs;
+    helperOC::HJIPDE_extraOuts extraOuts;
+    extraArgs.targets = targets;
+    extraArgs.keepLast = true;
+    extraArgs.stopConverge = true;
+    extraArgs.convergeThreshold = dt / 2;
+
+    helperOC::HJIPDE* hjipde = new helperOC::HJIPDE();
+
+    beacls::FloatVec tau2;
+    std::vector<beacls::FloatVec> datas;
+    hjipde->solve(datas, tau2, extraOuts, targets, tau, schemeData,
+        helperOC::HJIPDE::MinWithType_None, extraArgs);
+
+    const bool result = !datas.empty() && datas.back().size() == numel;
+    if (result) data = datas.back();
+
+    if (hjipde) delete hjipde;
+    if (schemeData->dynSys) delete schemeData->dynSys;
+    if (schemeData) delete schemeData;
+    if (g) delete g;
+    if (!result) {
+      std::cerr << "Error: " << __func__ << " : HJIPDE failed for subsystem "
+          << subsystem.name << "." << std::endl;
+      return false;
+    }
+  } else {
+    if (!subsystem.pdDims.empty()) {
+      std::cerr << "Warning: " << __func__ << " : DistributedHJI does not "
+          << "wrap periodic dimensions; subsystem " << subsystem.name
+          << " is solved with extrapolated boundaries." << std::endl;
+    }
+
+    const helperOC::DistributedHJI::Target_Type target =
+        [&target_dims](const beacls::FloatVec& x) {
+        FLOAT_TYPE sum = 0;
+        for (size_t ii = 0; ii < target_dims.size(); ++ii)
+          sum += x[target_dims[ii]] * x[target_dims[ii]];
+        return -std::sqrt(sum); };
+
+    helperOC::DistributedHJI* solver = new helperOC::DistributedHJI(
+        subsystem.mins, subsystem.maxs, subsystem.Ns, subsystem.dynSys,
+        helperOC::DynSys_UMode_Max, helperOC::DynSys_DMode_Min);
+    solver->set_memoryBudget(memoryBudget);
+    const size_t numel = solver->get_numel();
+
+    const std::string result_filename =
+        "RelativePrecomputation_" + subsystem.name + ".raw";
+    bool result = solver->solve(result_filename, tau, target,
+        num_of_processes, true);
+
+    // Only the last slice is needed, so don't load them all.
+    if (result) {
+      std::ifstream ifs(result_filename.c_str(), std::ios::binary);
+      data.resize(numel);
+      ifs.seekg((std::streamoff)((tau.size() - 1) * numel * sizeof(FLOAT_TYPE)));
+      ifs.read(reinterpret_cast<char*>(data.data()),
+          numel * sizeof(FLOAT_TYPE));
+      result = (bool)ifs;
+    }
+    std::remove(result_filename.c_str());
+
+    if (solver) delete solver;
+    if (!result) {
+      std::cerr << "Error: " << __func__ << " : DistributedHJI failed for "
+          << "subsystem " << subsystem.name << "." << std::endl;
+      return false;
+    }
+  }
+
+  // Back to a (nonnegative) distance.
+  std::transform(data.cbegin(), data.cend(), data.begin(),
+      std::negate<FLOAT_TYPE>());
+  return true;
+}
+
+bool RelativePrecomputation::save(const std::string& filename,
+    const Subsystem& subsystem, const beacls::FloatVec& data) const {
+  const size_t num_dim = subsystem.Ns.size();
+  const size_t numel = std::accumulate(subsystem.Ns.cbegin(),
+      subsystem.Ns.cend(), (size_t)1, std::multiplies<size_t>());
+  if (data.size() != numel) {
+    std::cerr << "Error: " << __func__ << " : Data does not match the grid of "
+        << "subsystem " << subsystem.name << "." << std::endl;
+    return false;
+  }
+
+  const beacls::FloatVec dxs = spacing(subsystem);
+
+  // SubsystemValueFunction quantizes into cells of width (max - min) / N,
+  // so put a cell around every grid point.
+  std::vector<double> grid_min(num_dim), grid_max(num_dim);
+  for (size_t dim = 0; dim < num_dim; ++dim) {
+    grid_min[dim] = subsystem.mins[dim] - dxs[dim] / 2;
+    grid_max[dim] = subsystem.mins[dim] +
+        ((double)subsystem.Ns[dim] - 0.5) * dxs[dim];
+  }
+
+  std::vector<double> teb;
+  double priority_lower, priority_upper;
+  const double bound = bounds(subsystem, std::vector<double>(data.cbegin(), data.cend()), dxs,
+      teb, priority_lower, priority_upper);
+
+  // Strides of the column-major grid order.
+  std::vector<size_t> strides(num_dim, 1);
+  for (size_t dim = 1; dim < num_dim; ++dim)
+    strides[dim] = strides[dim - 1] * subsystem.Ns[dim - 1];
+
+  const std::vector<std::vector<double> > derivs = gradients(subsystem, data);
+
+  // SubsystemValueFunction indexes row-major (last dimension fastest).
+  // The .mat dimensions are reversed to match, so MATLAB sees the grid
+  // with its dimensions permuted.
+  std::vector<size_t> order(numel);
+  for (size_t r = 0; r < numel; ++r) {
+    size_t rest = r;
+    size_t c = 0;
+    for (size_t ii = 0; ii < num_dim; ++ii) {
+      const size_t dim = num_dim - 1 - ii;
+      c += (rest % subsystem.Ns[dim]) * strides[dim];
+      rest /= subsystem.Ns[dim];
+    }
+    order[r] = c;
+  }
+
+  std::vector<size_t> data_dims;
+  for (size_t ii = 0; ii < num_dim; ++ii)
+    data_dims.push_back(subsystem.Ns[num_dim - 1 - ii]);
+  if (data_dims.size() < 2) data_dims.push_back(1);
+
+  std::vector<double> values(numel);
+  for (size_t r = 0; r < numel; ++r) values[r] = data[order[r]];
+
+  mat_t* matfp = Mat_CreateVer(filename.c_str(), NULL, MAT_FT_MAT5);
+  if (matfp == NULL) {
+    std::cerr << "Error: " << __func__ << " : Could not create "
+        << filename << "." << std::endl;
+    return false;
+  }
+
+  const std::vector<size_t> vector_dims{num_dim, 1};
+  const std::vector<size_t> scalar_dims{1, 1};
+  std::vector<double> speeds(max_planner_speed.cbegin(),
+      max_planner_speed.cend());
+
+  bool result = write_double(matfp, "data", values, data_dims) &&
+      write_double(matfp, "grid_min", grid_min, vector_dims) &&
+      write_double(matfp, "grid_max", grid_max, vector_dims) &&
+      write_uint64(matfp, "grid_N", subsystem.Ns) &&
+      write_double(matfp, "teb", teb, vector_dims) &&
+      write_uint64(matfp, "x_dims", subsystem.x_dims) &&
+      write_uint64(matfp, "u_dims", subsystem.u_dims) &&
+      write_double(matfp, "max_planner_speed", speeds,
+          std::vector<size_t>{speeds.size(), 1}) &&
+      write_double(matfp, "priority_lower",
+          std::vector<double>{priority_lower}, scalar_dims) &&
+      write_double(matfp, "priority_upper",
+          std::vector<double>{priority_upper}, scalar_dims);
+
+  for (size_t dim = 0; dim < num_dim && result; ++dim) {
+    for (size_t r = 0; r < numel; ++r) values[r] = derivs[dim][order[r]];
+    std::stringstream name;
+    name << "deriv" << dim;
+    result = write_double(matfp, name.str(), values, data_dims);
+  }
+
+  Mat_Close(matfp);
+  if (!result) {
+    std::cerr << "Error: " << __func__ << " : Could not write "
+        << filename << "." << std::endl;
+    return false;
+  }
+
+  std::cout << "Subsystem " << subsystem.name << ": tracking error bound "
+      << bound << ", saved to " << filename << std::endl;
+  return true;
+}
+
+bool RelativePrecomputation::solveSparse(std::vector<double>& surpluses,
+    const Subsystem& subsystem) const {
+  const size_t num_dim = subsystem.Ns.size();
+  const size_t num_fields = num_dim + 1;
+  if (sparse_level == 0 || num_dim == 0) {
+    std::cerr << "Error: " << __func__ << " : No sparse grid for subsystem "
+        << subsystem.name << "." << std::endl;
+    return false;
+  }
+  const SparseGrid sparse(num_dim, sparse_level);
+  surpluses.assign(sparse.get_numPoints() * num_fields, 0);
+
+  // Combination technique: the full grids with levels L, sum(L - 1) =
+  // level - 1 - q, weighted by (-1)^q binom(d - 1, q). Each is hierarchized
+  // on its own and its surpluses added to the matching subspaces.
+  size_t num_solved = 0;
+  for (size_t q = 0; q < num_dim && q < sparse_level; ++q) {
+    double coefficient = (q % 2 == 0) ? 1 : -1;
+    for (size_t ii = 0; ii < q; ++ii)
+      coefficient = coefficient * (num_dim - 1 - ii) / (ii + 1);
+
+    const std::vector<std::vector<size_t> > levels =
+        SparseGrid::levelVectors(num_dim, sparse_level - 1 - q);
+    for (size_t jj = 0; jj < levels.size(); ++jj) {
+      const std::vector<size_t>& L = levels[jj];
+
+      // 2^L intervals over [min, max]; createGrid drops the duplicate end
+      // of periodic dimensions.
+      Subsystem component(subsystem);
+      std::stringstream name;
+      name << subsystem.name << "_" << num_solved;
+      component.name = name.str();
+      for (size_t dim = 0; dim < num_dim; ++dim) {
+        const bool periodic = std::find(subsystem.pdDims.cbegin(),
+            subsystem.pdDims.cend(), dim) != subsystem.pdDims.cend();
+        component.Ns[dim] = ((size_t)1 << L[dim]) + (periodic ? 0 : 1);
+      }
+
+      beacls::FloatVec data;
+      if (!solve(data, component)) return false;
+      const std::vector<std::vector<double> > derivs =
+          gradients(component, data);
+
+      // The interior nodes 1 .. 2^L - 1 of every dimension, still
+      // column-major.
+      std::vector<size_t> strides(num_dim, 1), interior(num_dim);
+      size_t num_interior = 1;
+      for (size_t dim = 0; dim < num_dim; ++dim) {
+        if (dim > 0)
+          strides[dim] = strides[dim - 1] * component.Ns[dim - 1];
+        interior[dim] = ((size_t)1 << L[dim]) - 1;
+        num_interior *= interior[dim];
+      }
+      std::vector<double> values(num_interior * num_fields);
+      for (size_t i = 0; i < num_interior; ++i) {
+        size_t rest = i;
+        size_t g = 0;
+        for (size_t dim = 0; dim < num_dim; ++dim) {
+          g += (rest % interior[dim] + 1) * strides[dim];
+          rest /= interior[dim];
+        }
+        values[i * num_fields] = data[g];
+        for (size_t dim = 0; dim < num_dim; ++dim)
+          values[i * num_fields + 1 + dim] = derivs[dim][g];
+      }
+      SparseGrid::hierarchizeFull(values, L, num_fields);
+
+      // Node j of level L is the basis function of level L - tz and
+      // position j >> (tz + 1), where tz counts the trailing zeros of j.
+      std::vector<size_t> node_levels(num_dim);
+      std::vector<uint64_t> positions(num_dim);
+      for (size_t i = 0; i < num_interior; ++i) {
+        size_t rest = i;
+        for (size_t dim = 0; dim < num_dim; ++dim) {
+          uint64_t j = rest % interior[dim] + 1;
+          rest /= interior[dim];
+          size_t tz = 0;
+          while ((j & 1) == 0) {
+            j >>= 1;
+            ++tz;
+          }
+          node_levels[dim] = L[dim] - tz;
+          positions[dim] = j >> 1;
+        }
+        const size_t index = sparse.index(node_levels, positions) * num_fields;
+        for (size_t field = 0; field < num_fields; ++field)
+          surpluses[index + field] +=
+              coefficient * values[i * num_fields + field];
+      }
+      ++num_solved;
+    }
+  }
+
+  std::cout << "Subsystem " << subsystem.name << ": combined " << num_solved
+      << " grids into a level " << sparse_level << " sparse grid of "
+      << sparse.get_numPoints() << " points." << std::endl;
+  return true;
+}
+
+bool RelativePrecomputation::saveSparse(const std::string& filename,
+    const Subsystem& subsystem, const std::vector<double>& surpluses) const {
+  const size_t num_dim = subsystem.Ns.size();
+  const size_t num_fields = num_dim + 1;
+  const SparseGrid sparse(num_dim, sparse_level);
+  if (surpluses.size() != sparse.get_numPoints() * num_fields ||
+      max_planner_speed.size() != 3) {
+    std::cerr << "Error: " << __func__ << " : Data does not match the sparse "
+        << "grid of subsystem " << subsystem.name << "." << std::endl;
+    return false;
+  }
+
+  // Values at the sparse grid points, for the bound and priority levels,
+  // with the finest spacing of the sparse grid.
+  std::vector<double> values(sparse.get_numPoints());
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = surpluses[i * num_fields];
+  sparse.dehierarchize(values, 1);
+
+  beacls::FloatVec dxs(num_dim);
+  for (size_t dim = 0; dim < num_dim; ++dim)
+    dxs[dim] = (subsystem.maxs[dim] - subsystem.mins[dim]) /
+        (FLOAT_TYPE)((uint64_t)1 << sparse_level);
+  std::vector<double> teb;
+  double priority_lower, priority_upper;
+  const double bound = bounds(subsystem, values, dxs,
+      teb, priority_lower, priority_upper);
+
+  // Layout read by SubsystemValueFunction::LoadSparseGrid. The grid spans
+  // [min, max] itself: its boundary is at z = 0 and z = 1.
+  std::vector<uint64_t> header{num_dim, subsystem.u_dims.size(), sparse_level};
+  header.insert(header.end(), subsystem.x_dims.cbegin(),
+      subsystem.x_dims.cend());
+  header.insert(header.end(), subsystem.u_dims.cbegin(),
+      subsystem.u_dims.cend());
+  std::vector<double> parameters(subsystem.mins.cbegin(),
+      subsystem.mins.cend());
+  parameters.insert(parameters.end(), subsystem.maxs.cbegin(),
+      subsystem.maxs.cend());
+  parameters.insert(parameters.end(), max_planner_speed.cbegin(),
+      max_planner_speed.cend());
+  parameters.push_back(priority_lower);
+  parameters.push_back(priority_upper);
+  parameters.insert(parameters.end(), teb.cbegin(), teb.cend());
+
+  std::ofstream ofs(filename.c_str(), std::ios::binary);
+  ofs.write("METASGVF", 8);
+  ofs.write(reinterpret_cast<const char*>(header.data()),
+      header.size() * sizeof(uint64_t));
+  ofs.write(reinterpret_cast<const char*>(parameters.data()),
+      parameters.size() * sizeof(double));
+  ofs.write(reinterpret_cast<const char*>(surpluses.data()),
+      surpluses.size() * sizeof(double));
+  if (!ofs) {
+    std::cerr << "Error: " << __func__ << " : Could not write "
+        << filename << "." << std::endl;
+    return false;
+  }
+
+  std::cout << "Subsystem " << subsystem.name << ": tracking error bound "
+      << bound << ", saved to " << filename << std::endl;
+  return true;
+}
+
+bool RelativePrecomputation::run(const std::string& prefix,
+    const std::vector<Subsystem>& subsystems) const {
+  for (size_t ii = 0; ii < subsystems.size(); ++ii) {
+    const std::string filename = prefix + "subsystem_" + subsystems[ii].name;
+    if (sparse_level > 0) {
+      std::vector<double> surpluses;
+      if (!solveSparse(surpluses, subsystems[ii]) ||
+          !saveSparse(filename + ".sgvf", subsystems[ii], surpluses))
+        return false;
+    } else {
+      beacls::FloatVec data;
+      if (!solve(data, subsystems[ii]) ||
+          !save(filename + ".mat", subsystems[ii], data)) return false;
+    }
+  }
+  return true;
+}
+
+bool RelativePrecomputation::write_double(mat_t* matfp,
+    const std::string& name, const std::vector<double>& values,
+    const std::vector<size_t>& dims) {
+  std::vector<size_t> mat_dims(dims);
+  matvar_t* matvar = Mat_VarCreate(name.c_str(), MAT_C_DOUBLE, MAT_T_DOUBLE,
+      (int)mat_dims.size(), mat_dims.data(),
+      const_cast<double*>(values.data()), MAT_F_DONT_COPY_DATA);
+  if (matvar == NULL) return false;
+
+  // Uncompressed: SubsystemValueFunction reads with plain Mat_VarRead.
+  const bool result = (Mat_VarWrite(matfp, matvar, MAT_COMPRESSION_NONE) == 0);
+  Mat_VarFree(matvar);
+  return result;
+}
+
+bool RelativePrecomputation::write_uint64(mat_t* matfp,
+    const std::string& name, const beacls::IntegerVec& values) {
+  std::vector<uint64_t> data(values.cbegin(), values.cend());
+  size_t mat_dims[2] = {data.size(), 1};
+  matvar_t* matvar = Mat_VarCreate(name.c_str(), MAT_C_UINT64, MAT_T_UINT64,
+      2, mat_dims, data.data(), MAT_F_DONT_COPY_DATA);
+  if (matvar == NULL) return false;
+
+  const bool result = (Mat_VarWrite(matfp, matvar, MAT_COMPRESSION_NONE) == 0);
+  Mat_VarFree(matvar);
+  return result;
+}
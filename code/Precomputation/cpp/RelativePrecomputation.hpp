@@ -0,0 +1,194 @@
+#ifndef __RelativePrecomputation_hpp__
+#define __RelativePrecomputation_hpp__
+
+//! Prefix to generate Visual C++ DLL
+#ifdef _MAKE_VC_DLL
+#define PREFIX_VC_DLL __declspec(dllexport)
+
+//! Don't add prefix, except dll generating
+#else
+#define PREFIX_VC_DLL
+#endif
+
+#include <helperOC/DynSys/DynSys/DynSys.hpp>
+#include <typedef.hpp>
+#include <matio.h>
+#include <cstddef>
+#include <vector>
+#include <string>
+
+namespace helperOC {
+	/*
+		@brief Tracking error bound precomputation for relative dynamics.
+
+		For each subsystem of a relative (tracker minus planner) model this
+		solves the same game as the MATLAB *_RS scripts: the tracker
+		minimizes, and the planner and disturbances maximize, the largest
+		distance between the two over time. As in Q8D_Q4D_test this is posed
+		with the negated distance as target, uMode max and dMode min, and
+		the value is kept below the target at every step.
+
+		The solve runs in process with HJIPDE::solve until the value
+		converges, or with DistributedHJI over several processes for grids
+		too large for one. The result is written as a .mat file that
+		SubsystemValueFunction loads directly: value and gradients in the
+		row-major order it indexes, cell-centred grid bounds, the tracking
+		error bound, and the priority levels.
+
+		Subsystems with too many dimensions for a full grid can instead be
+		solved with the sparse grid combination technique: the game is
+		solved on every anisotropic full grid with 2^L_i intervals in
+		dimension i and sum_i (L_i - 1) = level - 1 - q, q < d, and the
+		solutions (with their gradients) are combined with weights
+		(-1)^q binom(d - 1, q) into a level 'level' sparse grid (see
+		SparseGrid), written as a .sgvf file. Each of these grids is small,
+		so a 6D subsystem costs a few thousand small solves instead of one
+		infeasible one.
+	*/
+	class RelativePrecomputation {
+	public:
+		/*
+			@brief One decoupled subsystem of a relative model.
+		*/
+		struct Subsystem {
+			std::string name;	//!< file suffix, e.g. "x"
+			const DynSys* dynSys;	//!< subsystem dynamics (not owned)
+			beacls::FloatVec mins;	//!< grid lower bounds
+			beacls::FloatVec maxs;	//!< grid upper bounds
+			beacls::IntegerVec Ns;	//!< number of grid points per dimension
+			beacls::IntegerVec pdDims;	//!< periodic dimensions
+			beacls::IntegerVec x_dims;	//!< tracker state dimensions (0-indexed)
+			beacls::IntegerVec u_dims;	//!< tracker control dimensions (0-indexed)
+			beacls::IntegerVec target_dims;	//!< position dimensions of the subsystem
+		};
+
+		/*
+		@param	[in]		max_planner_speed	planner speed bound per axis
+		@param	[in]		dt	output time step
+		@param	[in]		tMax	time horizon
+		*/
+		PREFIX_VC_DLL
+			RelativePrecomputation(
+				const beacls::FloatVec& max_planner_speed,
+				const FLOAT_TYPE dt,
+				const FLOAT_TYPE tMax);
+
+		PREFIX_VC_DLL
+			~RelativePrecomputation();
+
+		/*
+		@brief Solve for the value (distance) function of a subsystem, on
+		its grid in the usual column-major order.
+		*/
+		PREFIX_VC_DLL
+			bool solve(
+				beacls::FloatVec& data,
+				const Subsystem& subsystem) const;
+
+		/*
+		@brief Write a solved subsystem in the SubsystemValueFunction format.
+		*/
+		PREFIX_VC_DLL
+			bool save(
+				const std::string& filename,
+				const Subsystem& subsystem,
+				const beacls::FloatVec& data) const;
+
+		/*
+		@brief Solve for the value of a subsystem on a sparse grid with the
+		combination technique. Fills hierarchical surpluses of the value and
+		its gradient, in SparseGrid order.
+		*/
+		PREFIX_VC_DLL
+			bool solveSparse(
+				std::vector<double>& surpluses,
+				const Subsystem& subsystem) const;
+
+		/*
+		@brief Write a subsystem solved on a sparse grid in the .sgvf format
+		SubsystemValueFunction loads.
+		*/
+		PREFIX_VC_DLL
+			bool saveSparse(
+				const std::string& filename,
+				const Subsystem& subsystem,
+				const std::vector<double>& surpluses) const;
+
+		/*
+		@brief Solve and save every subsystem, to
+		<prefix>subsystem_<name>.mat, or .sgvf with a sparse level set.
+		*/
+		PREFIX_VC_DLL
+			bool run(
+				const std::string& prefix,
+				const std::vector<Subsystem>& subsystems) const;
+
+		//! Number of worker processes. One solves in process.
+		PREFIX_VC_DLL
+			void set_numOfProcesses(const size_t num_of_processes) {
+				this->num_of_processes = num_of_processes;
+			}
+
+		/*
+		@brief Margin added to the smallest value to get the tracking error
+		bound. Negative (the default) uses half a voxel diagonal in position,
+		which covers SubsystemValueFunction's voxel lookup.
+		*/
+		PREFIX_VC_DLL
+			void set_margin(const FLOAT_TYPE margin) {
+				this->margin = margin;
+			}
+
+		//! Sparse grid level (0: full grids).
+		PREFIX_VC_DLL
+			void set_sparseLevel(const size_t sparse_level) {
+				this->sparse_level = sparse_level;
+			}
+
+		//! Total memory budget in bytes for DistributedHJI (0: in core).
+		PREFIX_VC_DLL
+			void set_memoryBudget(const size_t memoryBudget) {
+				this->memoryBudget = memoryBudget;
+			}
+
+	private:
+		beacls::FloatVec max_planner_speed;
+		FLOAT_TYPE dt;
+		FLOAT_TYPE tMax;
+		size_t num_of_processes;
+		FLOAT_TYPE margin;
+		size_t memoryBudget;
+		size_t sparse_level;
+
+		//! Node spacing of the grid in each dimension.
+		static beacls::FloatVec spacing(const Subsystem& subsystem);
+
+		/*
+		@brief Gradients of solved data: central differences inside,
+		one-sided at the edges, and wrapped around periodic dimensions.
+		*/
+		static std::vector<std::vector<double> > gradients(
+			const Subsystem& subsystem, const beacls::FloatVec& data);
+
+		/*
+		@brief Tracking error bound and priority levels from values over the
+		grid, whose spacing is dxs. Returns the bound.
+		*/
+		double bounds(const Subsystem& subsystem,
+			const std::vector<double>& values, const beacls::FloatVec& dxs,
+			std::vector<double>& teb, double& priority_lower,
+			double& priority_upper) const;
+
+		static bool write_double(mat_t* matfp, const std::string& name,
+			const std::vector<double>& values, const std::vector<size_t>& dims);
+		static bool write_uint64(mat_t* matfp, const std::string& name,
+			const beacls::IntegerVec& values);
+
+		/** @overload
+		Disable copy constructor and operator=
+		*/
+		RelativePrecomputation(const RelativePrecomputation& rhs);
+		RelativePrecomputation& operator=(const RelativePrecomputation& rhs);
+	};
+};
+#endif	/* __RelativePrecomputation_hpp__ */
@@ -0,0 +1,199 @@
+#define _USE_MATH_DEFINES
+#include <levelset/levelset.hpp>
+#include <helperOC/helperOC.hpp>
+#include <helperOC/DynSys/DynSys/DynSysSchemeData.hpp>
+#include "Q8D_Q4D.hpp"
+#include "Q8D_Q4D.cpp"
+#include "DistributedHJI.hpp"
+#include "DistributedHJI.cpp"
+#include "RelModels.hpp"
+#include "SparseGrid.hpp"
+#include "SparseGrid.cpp"
+#include "RelativePrecomputation.hpp"
+#include "RelativePrecomputation.cpp"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+  @brief Computes the tracking error bound and value function of every
+  subsystem of a relative model, written as subsystem_<name>.mat files
+  that SubsystemValueFunction loads.
+
+  Arguments: model output_prefix planner_speed num_of_processes memory_budget_mb
+  sparse_level
+  model is one of P3D_Q2D, P4D_Q2D, P5D_Dubins, Point_3D_3D, Q6D_Q3D,
+  Q8D_Q2D, Q8D_Q4D, Q10D_Q6D. planner_speed <= 0 uses the model's default
+  planner bound (an acceleration for Q8D_Q4D, the other car's speed for
+  P5D_Dubins). Grids and input bounds are the defaults of the MATLAB
+  *_RS scripts. max_planner_speed always has three entries, as ValueFunction
+  expects, with zero for the vertical axis of planar planners. A nonzero
+  sparse_level solves every subsystem on a sparse grid of that level with
+  the combination technique instead, written as subsystem_<name>.sgvf.
+  */
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " model [output_prefix] "
+        << "[planner_speed] [num_of_processes] [memory_budget_mb] "
+        << "[sparse_level]" << std::endl;
+    return -1;
+  }
+  const std::string model(argv[1]);
+  std::string prefix;
+  if (argc >= 3) {
+    prefix = argv[2];
+  }
+  FLOAT_TYPE pMax = 0;
+  if (argc >= 4) {
+    pMax = (FLOAT_TYPE)atof(argv[3]);
+  }
+  size_t num_of_processes = 1;
+  if (argc >= 5) {
+    num_of_processes = atoi(argv[4]);
+  }
+  size_t memory_budget_mb = 0;
+  if (argc >= 6) {
+    memory_budget_mb = atoi(argv[5]);
+  }
+  size_t sparse_level = 0;
+  if (argc >= 7) {
+    sparse_level = atoi(argv[6]);
+  }
+
+  const FLOAT_TYPE pi = (FLOAT_TYPE)M_PI;
+  const FLOAT_TYPE deg = pi / 180;
+  const FLOAT_TYPE g = (FLOAT_TYPE)9.81;
+  std::vector<helperOC::DynSys*> dynSyss;
+  std::vector<helperOC::RelativePrecomputation::Subsystem> subsystems;
+  beacls::FloatVec max_planner_speed;
+  FLOAT_TYPE dt = 0.1;
+  FLOAT_TYPE tMax = 10;
+
+  if (model == "P3D_Q2D") {
+    if (pMax <= 0) pMax = 0.1;
+    dynSyss.push_back(new helperOC::RelDynSys<helperOC::P3D_Q2D_Rel>(
+        beacls::FloatVec(3, 0), helperOC::P3D_Q2D_Rel(1, pMax, 0, 5)));
+    subsystems.push_back({"xy", dynSyss.back(),
+        {-5, -5, -pi}, {5, 5, pi}, {51, 51, 31}, {2},
+        {0, 1, 2}, {0}, {0, 1}});
+    max_planner_speed = beacls::FloatVec{pMax, pMax, 0};
+    dt = 0.01;
+    tMax = 1;
+  } else if (model == "P4D_Q2D") {
+    if (pMax <= 0) pMax = 0.1;
+    dynSyss.push_back(new helperOC::RelDynSys<helperOC::P4D_Q2D_Rel>(
+        beacls::FloatVec(4, 0), helperOC::P4D_Q2D_Rel(pi, -6, 4, pMax, 0)));
+    subsystems.push_back({"xy", dynSyss.back(),
+        {-0.5, -0.5, -pi, -5}, {0.5, 0.5, pi, 5}, {31, 31, 31, 31}, {2},
+        {0, 1, 2, 3}, {0, 1}, {0, 1}});
+    max_planner_speed = beacls::FloatVec{pMax, pMax, 0};
+    dt = 0.1;
+    tMax = 0.75;
+  } else if (model == "P5D_Dubins") {
+    if (pMax <= 0) pMax = 0.1;
+    dynSyss.push_back(new helperOC::RelDynSys<helperOC::P5D_Dubins_Rel>(
+        beacls::FloatVec(5, 0), helperOC::P5D_Dubins_Rel(
+            beacls::FloatVec{-0.5, 0.5}, 6, pMax, 1.5,
+            beacls::FloatVec{0.02, 0.02, 0.2, 0.02})));
+    subsystems.push_back({"xy", dynSyss.back(),
+        {-0.35, -0.35, -pi, -0.25, -3.75}, {0.35, 0.35, pi, 0.25, 3.75},
+        {11, 11, 15, 9, 15}, {2},
+        {0, 1, 2, 3, 4}, {0, 1}, {0, 1}});
+    max_planner_speed = beacls::FloatVec{pMax, pMax, 0};
+    dt = 0.1;
+    tMax = 15;
+  } else if (model == "Point_3D_3D") {
+    if (pMax <= 0) pMax = 0.75;
+    const char* names[] = {"x", "y", "z"};
+    for (size_t ii = 0; ii < 3; ++ii) {
+      dynSyss.push_back(new helperOC::RelDynSys<helperOC::Point_3D_3D_Rel>(
+          beacls::FloatVec(1, 0), helperOC::Point_3D_3D_Rel(1, pMax)));
+      subsystems.push_back({names[ii], dynSyss.back(),
+          {-1}, {1}, {201}, {},
+          {ii}, {ii}, {0}});
+    }
+    max_planner_speed = beacls::FloatVec{pMax, pMax, pMax};
+    dt = 0.01;
+    tMax = 0.75;
+  } else if (model == "Q6D_Q3D") {
+    if (pMax <= 0) pMax = 0.6;
+    const FLOAT_TYPE dMaxV = std::max<FLOAT_TYPE>(0.2, pMax / 2);
+    const FLOAT_TYPE uMins[] = {-0.1, -0.1, g - 2};
+    const FLOAT_TYPE uMaxs[] = {0.1, 0.1, g + 2};
+    const char* names[] = {"x", "y", "z"};
+    for (size_t ii = 0; ii < 3; ++ii) {
+      dynSyss.push_back(new helperOC::RelDynSys<helperOC::Q6D_Q3D_Rel>(
+          beacls::FloatVec(2, 0), helperOC::Q6D_Q3D_Rel(ii, uMins[ii],
+              uMaxs[ii], pMax, dMaxV, 0.1)));
+      subsystems.push_back({names[ii], dynSyss.back(),
+          {-3, -3}, {3, 3}, {51, 51}, {},
+          {ii, ii + 3}, {ii}, {0}});
+    }
+    max_planner_speed = beacls::FloatVec{pMax, pMax, pMax};
+    dt = 0.01;
+    tMax = 10;
+  } else if (model == "Q8D_Q2D" || model == "Q10D_Q6D") {
+    if (pMax <= 0) pMax = (model == "Q8D_Q2D") ? 1 : 0.5;
+    const FLOAT_TYPE angleMax = 20 * deg;
+    const size_t num_axes = (model == "Q8D_Q2D") ? 2 : 3;
+    const char* names[] = {"x", "y", "z"};
+    for (size_t ii = 0; ii < num_axes; ++ii) {
+      if (model == "Q8D_Q2D") {
+        dynSyss.push_back(new helperOC::RelDynSys<helperOC::Q8D_Q2D_Rel>(
+            beacls::FloatVec(4, 0),
+            helperOC::Q8D_Q2D_Rel(angleMax, pMax, 0.1)));
+      } else {
+        const helperOC::Q10D_Q6D_Rel rel(ii, angleMax, 1.5 * g, pMax, 0.1);
+        dynSyss.push_back(new helperOC::RelDynSys<helperOC::Q10D_Q6D_Rel>(
+            beacls::FloatVec(rel.nx, 0), rel));
+      }
+      if (ii < 2) {
+        subsystems.push_back({names[ii], dynSyss.back(),
+            {-4, -4, -35 * deg, -2 * pi},
+            {4, 4, 35 * deg, 2 * pi}, {41, 41, 25, 21}, {},
+            {4 * ii, 4 * ii + 1, 4 * ii + 2, 4 * ii + 3}, {ii}, {0}});
+      } else {
+        subsystems.push_back({names[ii], dynSyss.back(),
+            {-4, -4}, {4, 4}, {81, 81}, {},
+            {8, 9}, {ii}, {0}});
+      }
+    }
+    max_planner_speed = beacls::FloatVec{pMax, pMax, (num_axes == 3) ? pMax : 0};
+    dt = 0.1;
+    tMax = 10;
+  } else if (model == "Q8D_Q4D") {
+    if (pMax <= 0) pMax = 1;
+    const char* names[] = {"x", "y"};
+    for (size_t ii = 0; ii < 2; ++ii) {
+      dynSyss.push_back(new helperOC::Q8D_Q4D(beacls::FloatVec(4, 0),
+          beacls::FloatVec{-20 * deg, 20 * deg},
+          beacls::FloatVec{-pMax, pMax}, beacls::FloatVec{-0.2, 0.2}));
+      subsystems.push_back({names[ii], dynSyss.back(),
+          {-4, -4, -60 * deg, -2 * pi},
+          {4, 4, 60 * deg, 2 * pi}, {81, 81, 65, 65}, {},
+          {4 * ii, 4 * ii + 1, 4 * ii + 2, 4 * ii + 3}, {ii}, {0}});
+    }
+    max_planner_speed = beacls::FloatVec{pMax, pMax, 0};
+    dt = 0.2;
+    tMax = 15;
+  } else {
+    std::cerr << "Error: Unknown model " << model << "." << std::endl;
+    return -1;
+  }
+
+  helperOC::RelativePrecomputation* precomputation =
+      new helperOC::RelativePrecomputation(max_planner_speed, dt, tMax);
+  precomputation->set_numOfProcesses(num_of_processes);
+  precomputation->set_memoryBudget(memory_budget_mb * 1024 * 1024);
+  precomputation->set_sparseLevel(sparse_level);
+
+  const int result = precomputation->run(prefix, subsystems) ? 0 : -1;
+
+  if (precomputation) delete precomputation;
+  for (size_t ii = 0; ii < dynSyss.size(); ++ii) {
+    if (dynSyss[ii]) delete dynSyss[ii];
+  }
+  return result;
+}
@@ -0,0 +1,186 @@
+#include "SparseGrid.hpp"
+#include <algorithm>
+#include <cmath>
+using namespace helperOC;
+
+namespace {
+  // Append all level vectors over dimensions [dim, num_dims) whose
+  // sum_i (l_i - 1) is exactly 'remaining'.
+  void appendLevelVectors(std::vector<std::vector<size_t> >& result,
+      std::vector<size_t>& levels, const size_t dim,
+      const size_t remaining) {
+    if (dim + 1 == levels.size()) {
+      levels[dim] = remaining + 1;
+      result.push_back(levels);
+      return;
+    }
+    for (size_t excess = 0; excess <= remaining; ++excess) {
+      levels[dim] = excess + 1;
+      appendLevelVectors(result, levels, dim + 1, remaining - excess);
+    }
+  }
+}
+
+SparseGrid::SparseGrid(const size_t num_dims, const size_t level) :
+  num_dims(num_dims), level(std::max<size_t>(level, 1)) {
+  // Subspace counts, from the last dimension back.
+  counts.assign((num_dims + 1) * this->level, 0);
+  for (size_t b = 0; b < this->level; ++b)
+    counts[num_dims * this->level + b] = 1;
+  for (size_t dim = num_dims; dim-- > 0;) {
+    for (size_t b = 0; b < this->level; ++b) {
+      size_t c = 0;
+      for (size_t excess = 0; excess <= b; ++excess)
+        c += count(dim + 1, b - excess);
+      counts[dim * this->level + b] = c;
+    }
+  }
+
+  offsets.push_back(0);
+  std::vector<size_t> levels(num_dims, 1);
+  do {
+    size_t bits = 0;
+    for (size_t dim = 0; dim < num_dims; ++dim) bits += levels[dim] - 1;
+    offsets.push_back(offsets.back() + ((size_t)1 << bits));
+    subspaces.push_back(levels);
+  } while (num_dims > 0 && nextSubspace(levels));
+}
+
+size_t SparseGrid::index(const std::vector<size_t>& levels,
+    const std::vector<uint64_t>& positions) const {
+  uint64_t bits = 0;
+  for (size_t dim = 0; dim < num_dims; ++dim)
+    bits = (bits << (levels[dim] - 1)) | positions[dim];
+  return offsets[subspaceIndex(levels)] + (size_t)bits;
+}
+
+size_t SparseGrid::subspaceIndex(const std::vector<size_t>& levels) const {
+  size_t result = 0;
+  size_t budget = level - 1;
+  for (size_t dim = 0; dim < num_dims; ++dim) {
+    for (size_t l = 1; l < levels[dim]; ++l)
+      result += count(dim + 1, budget - (l - 1));
+    budget -= levels[dim] - 1;
+  }
+  return result;
+}
+
+bool SparseGrid::nextSubspace(std::vector<size_t>& levels) const {
+  size_t used = 0;
+  for (size_t dim = 0; dim < num_dims; ++dim) used += levels[dim] - 1;
+  for (size_t dim = num_dims; dim-- > 0;) {
+    if (used + 1 < level) {
+      ++levels[dim];
+      return true;
+    }
+    used -= levels[dim] - 1;
+    levels[dim] = 1;
+  }
+  return false;
+}
+
+void SparseGrid::dehierarchize(std::vector<double>& values,
+    const size_t num_fields) const {
+  // Along each dimension every point gains the interpolant of its
+  // ancestors, which come earlier in storage order. Going backwards, they
+  // still hold their surpluses when they are read.
+  std::vector<size_t> ancestor_offsets(level + 1, 0);
+  for (size_t dim = 0; dim < num_dims; ++dim) {
+    for (size_t s = subspaces.size(); s-- > 0;) {
+      const std::vector<size_t>& levels = subspaces[s];
+      const size_t l = levels[dim];
+      if (l == 1) continue;
+
+      size_t shift = 0;
+      for (size_t other = dim + 1; other < num_dims; ++other)
+        shift += levels[other] - 1;
+      const uint64_t low_mask = ((uint64_t)1 << shift) - 1;
+      const uint64_t position_mask = ((uint64_t)1 << (l - 1)) - 1;
+
+      std::vector<size_t> ancestor(levels);
+      for (size_t al = 1; al < l; ++al) {
+        ancestor[dim] = al;
+        ancestor_offsets[al] = offsets[subspaceIndex(ancestor)];
+      }
+
+      for (size_t pp = 0; pp < offsets[s + 1] - offsets[s]; ++pp) {
+        const uint64_t low = pp & low_mask;
+        const uint64_t position = (pp >> shift) & position_mask;
+        const uint64_t high = pp >> (shift + l - 1);
+        const double z = (2.0 * position + 1.0) / (double)((uint64_t)1 << l);
+        double* target = &values[(offsets[s] + pp) * num_fields];
+        for (size_t al = 1; al < l; ++al) {
+          const uint64_t ancestor_position = position >> (l - al);
+          const double phi = basis(al, ancestor_position, z);
+          if (phi == 0) continue;
+          const uint64_t ancestor_bits =
+              (((high << (al - 1)) | ancestor_position) << shift) | low;
+          const double* source =
+              &values[(ancestor_offsets[al] + ancestor_bits) * num_fields];
+          for (size_t f = 0; f < num_fields; ++f)
+            target[f] += phi * source[f];
+        }
+      }
+    }
+  }
+}
+
+std::vector<std::vector<size_t> > SparseGrid::levelVectors(
+    const size_t num_dims, const size_t sum) {
+  std::vector<std::vector<size_t> > result;
+  if (num_dims == 0) return result;
+  std::vector<size_t> levels(num_dims, 1);
+  appendLevelVectors(result, levels, 0, sum);
+  return result;
+}
+
+void SparseGrid::hierarchizeFull(std::vector<double>& values,
+    const std::vector<size_t>& levels, const size_t num_fields) {
+  const size_t num_dims = levels.size();
+  std::vector<size_t> strides(num_dims, 1);
+  size_t numel = 1;
+  for (size_t dim = 0; dim < num_dims; ++dim) {
+    strides[dim] = numel;
+    numel *= ((size_t)1 << levels[dim]) - 1;
+  }
+
+  // Coarse levels first, so ancestors already hold their surpluses.
+  for (size_t dim = 0; dim < num_dims; ++dim) {
+    const size_t L = levels[dim];
+    const size_t n = ((size_t)1 << L) - 1;
+    for (size_t l = 2; l <= L; ++l) {
+      for (size_t i = 0; i < numel; ++i) {
+        const uint64_t node = (i / strides[dim]) % n + 1;
+        const uint64_t step = (uint64_t)1 << (L - l);
+        if ((node & (2 * step - 1)) != step) continue;
+
+        const uint64_t position = node >> (L - l + 1);
+        const double z = (double)node / (double)((uint64_t)1 << L);
+        double* target = &values[i * num_fields];
+        for (size_t al = 1; al < l; ++al) {
+          const uint64_t ancestor_position = position >> (l - al);
+          const double phi = basis(al, ancestor_position, z);
+          if (phi == 0) continue;
+          const uint64_t ancestor_node =
+              (2 * ancestor_position + 1) << (L - al);
+          const size_t ancestor_i =
+              i - node * strides[dim] + ancestor_node * strides[dim];
+          const double* source = &values[ancestor_i * num_fields];
+          for (size_t f = 0; f < num_fields; ++f)
+            target[f] -= phi * source[f];
+        }
+      }
+    }
+  }
+}
+
+double SparseGrid::basis(const size_t level, const uint64_t position,
+    const double z) {
+  if (level == 1) return 1;
+  const double scale = (double)((uint64_t)1 << level);
+  const double index = 2.0 * position + 1.0;
+  const double scaled = scale * z;
+  if (position == 0) return std::max(0.0, 2.0 - scaled);
+  if (index == scale - 1) return std::max(0.0, scaled - index + 1);
+  return std::max(0.0, 1.0 - std::abs(scaled - index));
+}
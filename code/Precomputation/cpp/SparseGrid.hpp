@@ -0,0 +1,103 @@
+#ifndef __SparseGrid_hpp__
+#define __SparseGrid_hpp__
+
+//! Prefix to generate Visual C++ DLL
+#ifdef _MAKE_VC_DLL
+#define PREFIX_VC_DLL __declspec(dllexport)
+
+//! Don't add prefix, except dll generating
+#else
+#define PREFIX_VC_DLL
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace helperOC {
+	/*
+		@brief Layout of a regular sparse grid over the unit cube, as stored
+		by meta::SparseGrid (ros/src/value_function) in .sgvf files.
+
+		Subspaces are the level vectors l with l_i >= 1 and
+		sum_i (l_i - 1) <= level - 1, in lexicographic order (last dimension
+		fastest). Subspace l holds the points z_i = (2 p_i + 1) / 2^l_i,
+		in row-major order of p, so a point's index within its subspace is
+		the concatenation of the bits of p_0, ..., p_{d-1}. There are no
+		boundary points; the modified linear basis (constant on level 1, and
+		extrapolating linearly to the boundary from the outermost points of
+		finer levels) covers the boundary instead.
+
+		Values are stored num_fields per point.
+	*/
+	class SparseGrid {
+	public:
+		PREFIX_VC_DLL
+			SparseGrid(
+				const size_t num_dims,
+				const size_t level);
+
+		size_t get_numDims() const { return num_dims; }
+		size_t get_level() const { return level; }
+		size_t get_numPoints() const { return offsets.back(); }
+
+		/*
+		@brief Index of the point with these levels and positions.
+		*/
+		PREFIX_VC_DLL
+			size_t index(
+				const std::vector<size_t>& levels,
+				const std::vector<uint64_t>& positions) const;
+
+		/*
+		@brief Convert hierarchical surpluses to values at the grid points,
+		in place.
+		*/
+		PREFIX_VC_DLL
+			void dehierarchize(
+				std::vector<double>& values,
+				const size_t num_fields) const;
+
+		/*
+		@brief All level vectors of a given total sum_i (l_i - 1).
+		*/
+		PREFIX_VC_DLL
+			static std::vector<std::vector<size_t> > levelVectors(
+				const size_t num_dims,
+				const size_t sum);
+
+		/*
+		@brief Convert values at the interior nodes of a full grid with
+		2^levels[i] intervals per dimension (column-major, first dimension
+		fastest, 2^levels[i] - 1 nodes per dimension) to surpluses of the
+		same basis, in place.
+		*/
+		PREFIX_VC_DLL
+			static void hierarchizeFull(
+				std::vector<double>& values,
+				const std::vector<size_t>& levels,
+				const size_t num_fields);
+
+		//! Modified linear basis function of a level and position.
+		static double basis(const size_t level, const uint64_t position,
+			const double z);
+
+	private:
+		size_t num_dims;
+		size_t level;
+
+		//! Subspaces over dimensions [dim, num_dims) within a budget.
+		std::vector<size_t> counts;
+		//! First point of each subspace, and the total at the end.
+		std::vector<size_t> offsets;
+		//! Levels of each subspace.
+		std::vector<std::vector<size_t> > subspaces;
+
+		size_t count(const size_t dim, const size_t budget) const {
+			return counts[dim * level + budget];
+		}
+		size_t subspaceIndex(const std::vector<size_t>& levels) const;
+		bool nextSubspace(std::vector<size_t>& levels) const;
+	};
+};
+#endif	/* __SparseGrid_hpp__ */
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Control loop timing benchmark. Runs a Tracker and a TrajectoryInterpreter
+// in this process, drives them with a hovering state, and measures tick start
+// jitter, compute time, and deadline misses of both loops while a
+// configurable SyntheticLoad runs in the background. Reads the same
+// parameters as the tracker and trajectory interpreter nodes, plus those
+// under 'benchmark/'. Run it against a value function server (see
+// control_loop_benchmark.launch).
+//
+// If /use_sim_time is set, this node also publishes /clock in steps of
+// 'benchmark/clock_step' at real-time rate, so jitter is measured on the
+// simulated clock. Compute times are always wall clock.
+//
+// Exits with failure if either loop misses more than
+// 'benchmark/max_miss_fraction' of its deadlines, so it can be used as a
+// gate for changes that affect real-time behavior.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/tracker.h>
+#include <meta_planner/trajectory_interpreter.h>
+#include <meta_planner/loop_timing.h>
+#include <meta_planner/synthetic_load.h>
+
+#include <crazyflie_msgs/PositionStateStamped.h>
+#include <rosgraph_msgs/Clock.h>
+#include <std_msgs/Empty.h>
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdio.h>
+
+// Print a summary and both histograms for one loop.
+void PrintTiming(const std::string& name,
+                 const meta::LoopTiming::ConstPtr& timing) {
+  const size_t ticks = timing->NumTicks();
+  const size_t misses = timing->NumDeadlineMisses();
+
+  printf("\n%s: %zu ticks at %.1f Hz, %zu deadline misses (%.3f%%)\n",
+         name.c_str(), ticks, 1.0 / timing->Period(), misses,
+         (ticks > 0) ? 100.0 * misses / ticks : 0.0);
+  printf("  %-8s %10s %10s %10s %10s\n", "(us)", "mean", "p50", "p99", "max");
+  printf("  %-8s %10.1f %10.1f %10.1f %10.1f\n", "jitter",
+         1e6 * timing->MeanJitter(), 1e6 * timing->JitterQuantile(0.5),
+         1e6 * timing->JitterQuantile(0.99), 1e6 * timing->MaxJitter());
+  printf("  %-8s %10.1f %10.1f %10.1f %10.1f\n", "compute",
+         1e6 * timing->MeanCompute(), 1e6 * timing->ComputeQuantile(0.5),
+         1e6 * timing->ComputeQuantile(0.99), 1e6 * timing->MaxCompute());
+
+  printf("  %12s %10s %10s\n", "< us", "jitter", "compute");
+  for (size_t ii = 0; ii < meta::LoopTiming::kNumBuckets; ii++) {
+    const size_t jitter = timing->JitterBucket(ii);
+    const size_t compute = timing->ComputeBucket(ii);
+    if (jitter == 0 && compute == 0)
+      continue;
+
+    printf("  %12.0f %10zu %10zu\n",
+           1e6 * meta::LoopTiming::BucketUpperEdge(ii), jitter, compute);
+  }
+}
+
+// Fraction of ticks that missed their deadline.
+double MissFraction(const meta::LoopTiming::ConstPtr& timing) {
+  const size_t ticks = timing->NumTicks();
+  return (ticks > 0) ?
+    static_cast<double>(timing->NumDeadlineMisses()) / ticks : 0.0;
+}
+
+// Process callbacks until the given wall clock duration has passed.
+void SpinFor(double seconds) {
+  const ros::WallTime stop = ros::WallTime::now() + ros::WallDuration(seconds);
+  while (ros::ok() && ros::WallTime::now() < stop)
+    ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.01));
+}
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "control_loop_benchmark");
+  ros::NodeHandle n("~");
+  const std::string name = ros::this_node::getName();
+
+  // Benchmark parameters.
+  double duration = 10.0;
+  double warmup = 1.0;
+  double state_rate = 100.0;
+  double clock_step = 0.001;
+  double max_miss_fraction = 1.0;
+  int planner_threads = 0;
+  int planner_tree_size = 2000;
+  double flood_rate = 0.0;
+  int flood_points = 10000;
+  std::string flood_topic;
+  int memory_hogs = 0;
+  int memory_hog_mb = 256;
+
+  n.param("benchmark/duration", duration, 10.0);
+  n.param("benchmark/warmup", warmup, 1.0);
+  n.param("benchmark/state_rate", state_rate, 100.0);
+  n.param("benchmark/clock_step", clock_step, 0.001);
+  n.param("benchmark/max_miss_fraction", max_miss_fraction, 1.0);
+  n.param("benchmark/load/planner_threads", planner_threads, 0);
+  n.param("benchmark/load/planner_tree_size", planner_tree_size, 2000);
+  n.param("benchmark/load/flood_rate", flood_rate, 0.0);
+  n.param("benchmark/load/flood_points", flood_points, 10000);
+  n.param("benchmark/load/flood_topic", flood_topic,
+          std::string("/vis/load"));
+  n.param("benchmark/load/memory_hogs", memory_hogs, 0);
+  n.param("benchmark/load/memory_hog_mb", memory_hog_mb, 256);
+
+  std::string state_topic, in_flight_topic;
+  if (!n.getParam("topics/state", state_topic) ||
+      !n.getParam("topics/in_flight", in_flight_topic)) {
+    ROS_ERROR("%s: Missing state or in flight topic.", name.c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Drive the simulated clock ourselves, in real time.
+  bool sim_time = false;
+  ros::param::get("/use_sim_time", sim_time);
+
+  std::atomic<bool> clock_running(true);
+  std::thread clock_thread;
+  if (sim_time) {
+    ros::Publisher clock_pub = n.advertise<rosgraph_msgs::Clock>(
+      "/clock", 1, false);
+
+    clock_thread = std::thread([&clock_running, clock_pub, clock_step]() {
+        const std::chrono::nanoseconds period(
+          static_cast<int64_t>(1e9 * clock_step));
+        std::chrono::steady_clock::time_point next =
+          std::chrono::steady_clock::now();
+
+        rosgraph_msgs::Clock clock;
+        clock.clock = ros::Time(1.0);
+        while (clock_running) {
+          clock_pub.publish(clock);
+          clock.clock += ros::Duration(clock_step);
+
+          next += period;
+          std::this_thread::sleep_until(next);
+        }
+      });
+  }
+
+  // Control loops under test, with timing enabled.
+  n.setParam("timing/enabled", true);
+
+  meta::Tracker tracker;
+  meta::TrajectoryInterpreter interpreter;
+  if (!tracker.Initialize(n) || !interpreter.Initialize(n)) {
+    ROS_ERROR("%s: Failed to initialize control loops.", name.c_str());
+    clock_running = false;
+    if (clock_thread.joinable())
+      clock_thread.join();
+    return EXIT_FAILURE;
+  }
+
+  // Feed a hovering state, and declare we are in flight.
+  ros::Publisher state_pub =
+    n.advertise<crazyflie_msgs::PositionStateStamped>(
+      state_topic.c_str(), 1, false);
+  ros::Publisher in_flight_pub =
+    n.advertise<std_msgs::Empty>(in_flight_topic.c_str(), 1, true);
+  in_flight_pub.publish(std_msgs::Empty());
+
+  const ros::WallTimer state_timer = n.createWallTimer(
+    ros::WallDuration(1.0 / state_rate),
+    [&state_pub](const ros::WallTimerEvent& e) {
+      crazyflie_msgs::PositionStateStamped msg;
+      msg.header.stamp = ros::Time::now();
+      msg.state.z = 1.0;
+      state_pub.publish(msg);
+    });
+
+  SpinFor(warmup);
+
+  // Measure under load.
+  meta::SyntheticLoad::Ptr load = meta::SyntheticLoad::Create();
+  load->StartPlannerThreads(static_cast<size_t>(std::max(planner_threads, 0)),
+                            static_cast<size_t>(std::max(planner_tree_size, 1)));
+  load->StartPublisherFlood(n, flood_topic, flood_rate,
+                            static_cast<size_t>(std::max(flood_points, 0)));
+  load->StartMemoryHogs(static_cast<size_t>(std::max(memory_hogs, 0)),
+                        static_cast<size_t>(std::max(memory_hog_mb, 1)));
+
+  const meta::LoopTiming::Ptr tracker_timing = tracker.Timing();
+  const meta::LoopTiming::Ptr interpreter_timing = interpreter.Timing();
+  tracker_timing->Reset();
+  interpreter_timing->Reset();
+
+  SpinFor(duration);
+
+  load->Stop();
+  clock_running = false;
+  if (clock_thread.joinable())
+    clock_thread.join();
+
+  // Report.
+  printf("\nLoad: %d planner threads (%zu queries), "
+         "%.1f Hz flood (%zu messages), %d memory hogs (%.1f GB copied), "
+         "%s clock\n", planner_threads, load->PlannerQueries(),
+         flood_rate, load->PublishedMessages(), memory_hogs,
+         1e-9 * load->CopiedBytes(), sim_time ? "simulated" : "wall");
+
+  PrintTiming("tracker", tracker_timing);
+  PrintTiming("trajectory_interpreter", interpreter_timing);
+
+  const double worst_miss_fraction = std::max(
+    MissFraction(tracker_timing), MissFraction(interpreter_timing));
+  if (worst_miss_fraction > max_miss_fraction) {
+    ROS_ERROR("%s: Missed %f of deadlines (allowed %f).", name.c_str(),
+              worst_miss_fraction, max_miss_fraction);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Converts a FlightRecorder log to CSV or .mat, depending on the extension
+// of the output file. In .mat files each column is stored as its own
+// column vector variable.
+//
+// Usage: flight_log_converter <log file> <output.csv | output.mat>
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/flight_recorder.h>
+
+#include <matio.h>
+#include <stdio.h>
+#include <fstream>
+#include <iomanip>
+
+// Write columns to a CSV file with a header row.
+bool WriteCsv(const std::string& file_name,
+              const std::vector<std::string>& names,
+              const std::vector< std::vector<double> >& columns) {
+  std::ofstream file(file_name.c_str());
+  if (!file.is_open())
+    return false;
+
+  for (size_t ii = 0; ii < names.size(); ii++)
+    file << names[ii] << ((ii + 1 < names.size()) ? "," : "\n");
+
+  const size_t num_rows = columns.empty() ? 0 : columns[0].size();
+  file << std::setprecision(12);
+  for (size_t jj = 0; jj < num_rows; jj++) {
+    for (size_t ii = 0; ii < columns.size(); ii++)
+      file << columns[ii][jj] << ((ii + 1 < columns.size()) ? "," : "\n");
+  }
+
+  return true;
+}
+
+// Write columns to a .mat file, one variable per column.
+bool WriteMat(const std::string& file_name,
+              const std::vector<std::string>& names,
+              std::vector< std::vector<double> >& columns) {
+  mat_t* matfp = Mat_CreateVer(file_name.c_str(), NULL, MAT_FT_MAT5);
+  if (matfp == NULL)
+    return false;
+
+  bool success = true;
+  for (size_t ii = 0; ii < names.size(); ii++) {
+    size_t dims[2] = { columns[ii].size(), 1 };
+    matvar_t* var = Mat_VarCreate(names[ii].c_str(), MAT_C_DOUBLE,
+                                  MAT_T_DOUBLE, 2, dims,
+                                  columns[ii].data(), 0);
+    if (var == NULL) {
+      success = false;
+      continue;
+    }
+
+    success &= (Mat_VarWrite(matfp, var, MAT_COMPRESSION_ZLIB) == 0);
+    Mat_VarFree(var);
+  }
+
+  Mat_Close(matfp);
+  return success;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <log file> <output.csv | output.mat>\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const std::string input(argv[1]);
+  const std::string output(argv[2]);
+
+  std::vector<std::string> names;
+  std::vector< std::vector<double> > columns;
+  if (!meta::FlightRecorder::Read(input, names, columns))
+    return EXIT_FAILURE;
+
+  const bool mat = output.size() > 4 &&
+    output.compare(output.size() - 4, 4, ".mat") == 0;
+
+  const bool success = mat ?
+    WriteMat(output, names, columns) : WriteCsv(output, names, columns);
+
+  if (!success) {
+    fprintf(stderr, "Failed to write %s.\n", output.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
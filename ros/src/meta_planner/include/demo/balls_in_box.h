@@ -40,14 +40,22 @@
 // does not bother with a kdtree index to speed up collision queries, since
 // it is only for a simulated demo.
 //
+// Moving obstacles are kept separately in a DynamicObstacles index and only
+// affect IsValidAt. They can change without bumping the environment epoch,
+// so static validity results stay cached.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef DEMO_BALLS_IN_BOX_H
 #define DEMO_BALLS_IN_BOX_H
 
 #include <meta_planner/box.h>
+#include <meta_planner/dynamic_obstacles.h>
 #include <utils/types.h>
 
+#include <map>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 namespace meta {
@@ -69,12 +77,40 @@ public:
                ValueFunctionId incoming_value,
                ValueFunctionId outgoing_value) const;
 
+  // Time-aware collision checker. Also checks moving obstacles.
+  bool IsValidAt(const Vector3d& position, double time,
+                 ValueFunctionId incoming_value,
+                 ValueFunctionId outgoing_value) const;
+
+  // Speed of the fastest moving obstacle.
+  inline double MaxObstacleSpeed() const {
+    return dynamic_obstacles_->MaxSpeed();
+  }
+
+  // Same as IsValid, but with a known tracking bound instead of querying the
+  // switching bound server.
+  bool IsFree(const Vector3d& position, const Vector3d& bound) const;
+
   // Check for obstacles within a sensing radius. Returns true if at least
   // one obstacle was sensed.
   bool SenseObstacles(const Vector3d& position, double sensor_radius,
                       std::vector<Vector3d>& obstacle_positions,
                       std::vector<double>& obstacle_radii) const;
 
+  // Cast rays from the origin along the given unit directions (one per row)
+  // against the obstacles and the box walls. Returns the range to the first
+  // hit along each ray (max_range if nothing is hit within range) and the
+  // index of the obstacle hit (-1 for a wall or no hit). Rows are stored
+  // contiguously per axis, so each obstacle is tested against all rays in
+  // a single vectorized pass.
+  void CastRays(const Vector3d& origin, const Eigen::MatrixX3d& directions,
+                double max_range, VectorXd& ranges,
+                Eigen::VectorXi& obstacles) const;
+
+  // Get the position and radius of the obstacle with the given index, as
+  // returned by CastRays. Returns false if there is no such obstacle.
+  bool GetObstacle(size_t idx, Vector3d& position, double& radius) const;
+
   // Check if a given obstacle is in the environment.
   bool IsObstacle(const Vector3d& obstacle_position,
                   double obstacle_radius) const;
@@ -85,12 +121,48 @@ public:
   // Add a spherical obstacle of the given radius to the environment.
   void AddObstacle(const Vector3d& point, double r);
 
+  // Add a moving spherical obstacle, either at constant velocity between
+  // two times or along a predicted track. See dynamic_obstacles.h.
+  bool AddDynamicObstacle(const Vector3d& point, const Vector3d& velocity,
+                          double r, double start_time, double end_time);
+  bool AddDynamicObstacle(const std::vector<double>& times,
+                          const std::vector<Vector3d>& points, double r);
+
+  // Remove all moving obstacles.
+  void ClearDynamicObstacles();
+
+  // Set the cell size and time resolution of the moving obstacle index.
+  // Removes all moving obstacles.
+  bool SetDynamicObstacleResolution(double cell_size, double time_resolution);
+
+  // Get the moving obstacles.
+  inline DynamicObstacles::ConstPtr GetDynamicObstacles() const {
+    return dynamic_obstacles_;
+  }
+
 private:
   BallsInBox();
 
+  // Switching tracking bound for a planner pair. Bounds are memoized until
+  // the epoch changes. Returns false if the server could not be reached.
+  bool SwitchingBound(ValueFunctionId incoming_value,
+                      ValueFunctionId outgoing_value, size_t epoch,
+                      Vector3d& bound) const;
+
   // List of obstacle locations and radii.
   std::vector<VectorXd> points_;
   std::vector<double> radii_;
+
+  // Moving obstacles, and how many moving obstacle markers were last
+  // published, so that markers for removed ones can be deleted.
+  DynamicObstacles::Ptr dynamic_obstacles_;
+  mutable size_t num_moving_markers_;
+
+  // Memoized switching bounds and the epoch they were fetched in.
+  mutable std::map<std::pair<ValueFunctionId, ValueFunctionId>,
+                   Vector3d> bounds_;
+  mutable size_t bounds_epoch_;
+  mutable std::mutex bounds_mutex_;
 };
 
 } //\namespace meta
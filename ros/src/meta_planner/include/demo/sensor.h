@@ -38,6 +38,13 @@
 //
 // Defines the Simulator class. Holds a BallsInBox environment and sends
 // simulated sensor measurements consisting of detected balls in range.
+// Optionally simulates a depth/LiDAR sensor instead: a fan of rays is cast
+// against the true environment each time step, the hit points are
+// published, and only balls actually hit by some ray are reported.
+//
+// Optionally some balls move at constant speed, bouncing off the walls.
+// These are reported with their velocities whenever they are within the
+// sensor radius, in either mode.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -50,6 +57,7 @@
 #include <utils/uncopyable.h>
 
 #include <meta_planner_msgs/SensorMeasurement.h>
+#include <meta_planner_msgs/DepthMeasurement.h>
 
 #include <ros/ros.h>
 #include <tf2_ros/transform_listener.h>
@@ -80,9 +88,25 @@ private:
   // state based on last received control signal.
   void TimerCallback(const ros::TimerEvent& e);
 
+  // Cast the ray fan from this pose, publish the hit points, and collect
+  // the obstacles that were hit.
+  void SenseDepth(const Vector3d& position, const Quaterniond& orientation,
+                  std::vector<Vector3d>& obstacle_positions,
+                  std::vector<double>& obstacle_radii);
+
+  // Move the moving obstacles forward one time step to the given time,
+  // bouncing them off the walls.
+  void MoveObstacles(double time);
+
   // Sensor radius.
   double sensor_radius_;
 
+  // Depth sensor mode: ray directions in the robot frame (one per row),
+  // and the max range.
+  bool depth_mode_;
+  Eigen::MatrixX3d ray_directions_;
+  double max_range_;
+
   // State space.
   BallsInBox::Ptr space_;
   unsigned int seed_;
@@ -98,6 +122,15 @@ private:
   double max_obstacle_radius_;
   double min_obstacle_radius_;
 
+  // Moving obstacles, and the box they bounce around in.
+  size_t num_moving_obstacles_;
+  double moving_obstacle_speed_;
+  std::vector<Vector3d> moving_positions_;
+  std::vector<Vector3d> moving_velocities_;
+  std::vector<double> moving_radii_;
+  Vector3d lower_;
+  Vector3d upper_;
+
   // Set a recurring timer for a discrete-time controller.
   ros::Timer timer_;
   double time_step_;
@@ -106,11 +139,13 @@ private:
   ros::Publisher sensor_radius_pub_;
   ros::Publisher environment_pub_;
   ros::Publisher sensor_pub_;
+  ros::Publisher depth_pub_;
   ros::Subscriber in_flight_sub_;
 
   std::string sensor_radius_topic_;
   std::string environment_topic_;
   std::string sensor_topic_;
+  std::string depth_topic_;
   std::string in_flight_topic_;
 
   /// Don't start sensing until we are in flight.
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ArrivalTimeField class, which computes the minimum time for a
+// Dubins car (constant speed, bounded turning radius) to reach a disc
+// around a target point, over a square window of the plane centered on the
+// target and all headings. The field is computed by the CCMotion fast
+// marching / fast sweeping solver (code/Planners/FSM/CCMotion.cpp), the
+// same solver used by fsmNextState.m through MATLAB.
+//
+// Once computed, paths from any start in the window to the target are
+// extracted by descending the field: the car drives forward at full speed
+// and turns in whichever direction decreases arrival time, as in
+// fsmNextState.m. Extraction is cheap, so queries sharing a target can
+// share one field.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_ARRIVAL_TIME_FIELD_H
+#define META_PLANNER_ARRIVAL_TIME_FIELD_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace meta {
+
+class ArrivalTimeField : private Uncopyable {
+public:
+  typedef std::shared_ptr<ArrivalTimeField> Ptr;
+  typedef std::shared_ptr<const ArrivalTimeField> ConstPtr;
+
+  ~ArrivalTimeField() {}
+
+  // Factory method. Use this instead of the constructor. The window spans
+  // 'half_width' on either side of the target in x and y, with 'num_cells'
+  // grid nodes per side and 'num_headings' headings. Only x and y of the
+  // target are used.
+  static Ptr Create(const Vector3d& target, double half_width,
+                    size_t num_cells, size_t num_headings);
+
+  // Compute arrival times for a car with the given speed and turning
+  // radius, to within 'target_radius' of the target. 'free' holds one flag
+  // per (x, y) grid node, x-major (see Point), false in obstacles. Optional
+  // fast marching before sweeping, and the update scheme (0 semi-Lagrangian,
+  // 1 finite difference, 2 both) are as in CCMotion. Returns false if the
+  // target itself is blocked.
+  bool Solve(const std::vector<bool>& free, double speed,
+             double turning_radius, double target_radius,
+             bool march, int method);
+
+  // Arrival time from this state, trilinearly interpolated over reachable
+  // grid nodes. Infinite if outside the window, next to an obstacle node,
+  // or unreachable.
+  double Time(const Vector3d& position, double heading) const;
+
+  // Heading with the smallest arrival time from this position.
+  double BestHeading(const Vector3d& position) const;
+
+  // Descend the field from this state until within the target radius.
+  // Returns the positions (z unchanged) every 'dt' seconds, ending at the
+  // target. Returns false if the target is not reached.
+  bool ExtractPath(const Vector3d& start, double heading, double dt,
+                   std::vector<Vector3d>& positions) const;
+
+  // Grid node coordinates, for building the free space mask.
+  Vector3d Point(size_t ii, size_t jj) const;
+
+  // Accessors.
+  inline const Vector3d& Target() const { return target_; }
+  inline size_t NumCells() const { return num_cells_; }
+  inline size_t NumHeadings() const { return num_headings_; }
+  inline double Resolution() const {
+    return 2.0 * half_width_ / static_cast<double>(num_cells_ - 1);
+  }
+  inline double Speed() const { return speed_; }
+  inline size_t NumIterations() const { return num_iterations_; }
+
+private:
+  explicit ArrivalTimeField(const Vector3d& target, double half_width,
+                            size_t num_cells, size_t num_headings);
+
+  // Value at a grid node, wrapping heading.
+  double Value(size_t ii, size_t jj, long kk) const;
+
+  // Times at or above this are unreachable.
+  static const double kNumInfinity;
+  static const double kReachedTime;
+
+  // CCMotion keeps solver counters in globals, so solves are serialized.
+  static std::mutex solver_mutex_;
+
+  const Vector3d target_;
+  const double half_width_;
+  const size_t num_cells_;
+  const size_t num_headings_;
+
+  double speed_;
+  double turning_radius_;
+  double target_radius_;
+  size_t num_iterations_;
+
+  // Free space mask, one flag per (x, y) grid node.
+  std::vector<bool> free_;
+
+  // Arrival times, indexed ((ii * num_cells_) + jj) * num_headings_ + kk.
+  std::vector<double> times_;
+};
+
+} //\namespace meta
+
+#endif
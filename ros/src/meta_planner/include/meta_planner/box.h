@@ -79,8 +79,20 @@ public:
   virtual void Visualize(const ros::Publisher& pub,
                          const std::string& frame_id) const;
 
-  // Set bounds in each dimension.
-  void SetBounds(const Vector3d& lower, const Vector3d& upper);
+  // Set bounds in each dimension. Child classes which index obstacles
+  // relative to the bounds should overwrite this.
+  virtual void SetBounds(const Vector3d& lower, const Vector3d& upper);
+
+  // Same as IsValid, but with a known tracking bound instead of querying the
+  // switching bound server. Can be overwritten by child classes.
+  virtual bool IsFree(const Vector3d& position, const Vector3d& bound) const;
+
+  // Check if a given spherical obstacle is in the environment, and add one.
+  // The plain box has no obstacles, so child classes with obstacles should
+  // overwrite these.
+  virtual bool IsObstacle(const Vector3d& obstacle_position,
+                          double obstacle_radius) const;
+  virtual void AddObstacle(const Vector3d& point, double r);
 
   // Get the dimension and upper/lower bounds as const references.
   inline const Vector3d& LowerBounds() const { return lower_; }
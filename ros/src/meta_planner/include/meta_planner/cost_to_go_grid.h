@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the CostToGoGrid class, which computes the minimum travel time
+// from a single source point to every cell of a regular grid over a box,
+// avoiding blocked cells. Once computed, the time to any point is a
+// lookup, so many goals can share one computation.
+//
+// Travel time between neighboring cells (26-connected) is the same metric
+// as ValueFunction::BestPossibleTime, i.e. the max over dimensions of
+// distance divided by the max speed in that dimension, so the result is
+// never below BestPossibleTime and equals it in free space (up to grid
+// resolution).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_COST_TO_GO_GRID_H
+#define META_PLANNER_COST_TO_GO_GRID_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class CostToGoGrid : private Uncopyable {
+public:
+  typedef std::shared_ptr<CostToGoGrid> Ptr;
+  typedef std::shared_ptr<const CostToGoGrid> ConstPtr;
+
+  ~CostToGoGrid() {}
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create(const Vector3d& lower, const Vector3d& upper,
+                    double resolution);
+
+  // Compute times from the source to all cells, moving at most 'max_speed'
+  // in each dimension, only through cells whose centers satisfy 'is_free'.
+  // Cells are checked in parallel, so 'is_free' must be thread safe.
+  void Compute(const Vector3d& source, const Vector3d& max_speed,
+               const std::function<bool(const Vector3d&)>& is_free);
+
+  // Time from the source to this point. Infinite if the point is outside
+  // the grid, in a blocked cell, or unreachable.
+  double Cost(const Vector3d& point) const;
+
+  // Source of the last computation.
+  inline const Vector3d& Source() const { return source_; }
+
+  // Grid size.
+  inline size_t NumCells() const { return costs_.size(); }
+  inline double Resolution() const { return resolution_; }
+
+private:
+  explicit CostToGoGrid(const Vector3d& lower, const Vector3d& upper,
+                        double resolution);
+
+  // Index of the cell containing this point. Returns false if outside.
+  bool CellIndex(const Vector3d& point, size_t& idx) const;
+
+  // Center of a cell.
+  Vector3d CellCenter(size_t idx) const;
+
+  // Travel time along a displacement.
+  double Time(const Vector3d& displacement) const;
+
+  const Vector3d lower_;
+  const double resolution_;
+  size_t sizes_[3];
+
+  Vector3d source_;
+  Vector3d max_speed_;
+  std::vector<bool> free_;
+  std::vector<double> costs_;
+};
+
+} //\namespace meta
+
+#endif
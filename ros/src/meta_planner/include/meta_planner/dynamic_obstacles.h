@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the DynamicObstacles class, which holds spherical obstacles that
+// move over time and answers time-indexed collision queries against them.
+//
+// Each obstacle is either a sphere moving at constant velocity over a time
+// interval, or a short predicted track which is linearly interpolated
+// between its time stamps. Obstacles only exist over their time span, so
+// predictions should cover every time that will be queried.
+//
+// Motion is stored as linear segments in a spatio-temporal hash grid:
+// time is split into buckets of a fixed length, space into cubic cells,
+// and each segment is listed in every (cell, bucket) its sphere sweeps
+// through. A query only tests the segments listed in the cells its box
+// overlaps during its time bucket, so its cost depends on local obstacle
+// density rather than the total number of movers. Keys wrap around every
+// 2^16 cells or buckets; that only adds candidates, which are always
+// tested exactly.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_DYNAMIC_OBSTACLES_H
+#define META_PLANNER_DYNAMIC_OBSTACLES_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+namespace meta {
+
+class DynamicObstacles : private Uncopyable {
+public:
+  typedef std::shared_ptr<DynamicObstacles> Ptr;
+  typedef std::shared_ptr<const DynamicObstacles> ConstPtr;
+
+  ~DynamicObstacles() {}
+
+  // Factory method. Use this instead of the constructor. Cells should be
+  // about the size of obstacles, and buckets short enough that obstacles
+  // move about a cell in one.
+  static Ptr Create(double cell_size, double time_resolution);
+
+  // Add a sphere moving at constant velocity, at the given position at
+  // 'start_time' and existing until 'end_time'. Obstacles are indexed in
+  // the order they are added. Returns whether the obstacle was valid.
+  bool Add(const Vector3d& position, const Vector3d& velocity,
+             double radius, double start_time, double end_time);
+
+  // Add a sphere following a predicted track through the given positions
+  // at increasing times. Returns whether the track was valid.
+  bool Add(const std::vector<double>& times,
+           const std::vector<Vector3d>& positions, double radius);
+
+  // Remove all obstacles.
+  void Clear();
+
+  // Check if a box of the given half-widths centered at the position is
+  // clear of every obstacle at the given time.
+  bool IsFree(const Vector3d& position, const Vector3d& bound,
+              double time) const;
+
+  // Get the position of the obstacle with the given index at a time.
+  // Returns false if there is no such obstacle at that time.
+  bool GetObstacle(size_t idx, double time, Vector3d& position,
+                   double& radius) const;
+
+  // Accessors.
+  inline size_t NumObstacles() const { return first_segments_.size() - 1; }
+  inline size_t NumSegments() const { return segments_.size(); }
+  inline double MaxSpeed() const { return max_speed_; }
+  inline double CellSize() const { return cell_size_; }
+  inline double TimeResolution() const { return time_resolution_; }
+
+private:
+  explicit DynamicObstacles(double cell_size, double time_resolution);
+
+  // Linear motion of an obstacle between two times.
+  struct Segment {
+    double start_time;
+    double end_time;
+    Vector3d position;
+    Vector3d velocity;
+    double radius;
+  };
+
+  // Add a segment to the current obstacle and to every cell it sweeps.
+  void Insert(const Segment& segment);
+
+  // Cell or bucket containing a coordinate, and the key of a cell and
+  // bucket in the index.
+  static int64_t Quantize(double x, double size);
+  static uint64_t Key(int64_t ix, int64_t iy, int64_t iz, int64_t it);
+
+  const double cell_size_;
+  const double time_resolution_;
+
+  // Segments of all obstacles, with the first segment of each obstacle.
+  std::vector<Segment> segments_;
+  std::vector<size_t> first_segments_;
+  double max_speed_;
+
+  // Segments in each (cell, bucket).
+  std::unordered_map<uint64_t, std::vector<uint32_t> > index_;
+};
+
+} //\namespace meta
+
+#endif
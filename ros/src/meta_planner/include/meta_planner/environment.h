@@ -45,11 +45,13 @@
 
 #include <utils/types.h>
 #include <utils/uncopyable.h>
+#include <meta_planner/validity_cache.h>
 
 #include <value_function/SwitchingTrackingBoundBox.h>
 
 #include <ros/ros.h>
 #include <visualization_msgs/Marker.h>
+#include <atomic>
 #include <random>
 #include <string>
 
@@ -75,15 +77,67 @@ public:
                        ValueFunctionId incoming_value,
                        ValueFunctionId outgoing_value) const = 0;
 
+  // Time-aware collision checker, for environments with moving obstacles.
+  // Returns true if the position is valid at the given time. Without
+  // moving obstacles this is just IsValid.
+  virtual bool IsValidAt(const Vector3d& position, double time,
+                         ValueFunctionId incoming_value,
+                         ValueFunctionId outgoing_value) const {
+    return IsValid(position, incoming_value, outgoing_value);
+  }
+
+  // Speed of the fastest moving obstacle.
+  virtual double MaxObstacleSpeed() const { return 0.0; }
+
+  // Check straight-line motion between two positions over a time interval
+  // with IsValidAt, at points no more than 'resolution' apart relative to
+  // every moving obstacle. The starting point is not checked.
+  bool IsMotionValid(const Vector3d& from, const Vector3d& to,
+                     double from_time, double to_time, double resolution,
+                     ValueFunctionId incoming_value,
+                     ValueFunctionId outgoing_value) const;
+
   // Derived classes must have some sort of visualization through RVIZ.
   virtual void Visualize(const ros::Publisher& pub,
                          const std::string& frame_id) const = 0;
 
+  // Environment epoch. Bumped whenever the result of IsValid may have
+  // changed anywhere, e.g. on new obstacles or new tracking bounds.
+  inline size_t Epoch() const { return epoch_; }
+  inline void BumpEpoch() { epoch_++; }
+
+  // Memoize IsValid results at the given position resolution. Disabled
+  // unless set here or with the "validity_cache/enabled" parameter.
+  void EnableValidityCache(double resolution, size_t max_entries);
+
+  // Get the validity cache, e.g. for hit/miss counters. Null if disabled.
+  inline ValidityCache::ConstPtr GetValidityCache() const {
+    return validity_cache_;
+  }
+
 protected:
   explicit Environment()
     : rng_(rd_()),
+      epoch_(0),
       initialized_(false) {}
 
+  // Look up or store an IsValid result for the given epoch, which should be
+  // read once before checking so that a result computed while the
+  // environment changed is discarded. Lookups always miss when the cache
+  // is disabled.
+  bool LookupValidity(const Vector3d& position, ValueFunctionId incoming_value,
+                      ValueFunctionId outgoing_value, size_t epoch,
+                      bool& valid) const;
+  void StoreValidity(const Vector3d& position, ValueFunctionId incoming_value,
+                     ValueFunctionId outgoing_value, size_t epoch,
+                     bool valid) const;
+
+  // A stored result is shared by every position in its cache cell, so it
+  // must be checked over the whole cell. Moves the position to the center
+  // of its cell and grows the tracking bound by half a cell on each axis.
+  // Does nothing when the cache is disabled.
+  void CoverCacheCell(Vector3d& position, Vector3d& bound) const;
+
   // Server to query value functions for tracking bound.
   mutable ros::ServiceClient switching_bound_srv_;
   std::string switching_bound_name_;
@@ -92,6 +146,10 @@ protected:
   std::random_device rd_;
   mutable std::default_random_engine rng_;
 
+  // Memoized IsValid results, and the epoch they must match.
+  ValidityCache::Ptr validity_cache_;
+  std::atomic<size_t> epoch_;
+
   // Initialization and naming.
   bool initialized_;
   std::string name_;
@@ -52,6 +52,7 @@
 #include <flann/flann.h>
 #include <memory>
 #include <vector>
+#include <functional>
 #include <math.h>
 
 namespace meta {
@@ -70,7 +71,20 @@ public:
   // Radius search.
   std::vector<Waypoint::ConstPtr> RadiusSearch(Vector3d& query, double r) const;
 
+  // Remove all Waypoints for which the predicate is true, and rebuild the
+  // index from the rest. Returns the number removed.
+  size_t Remove(const std::function<bool(const Waypoint::ConstPtr&)>& predicate);
+
+  // All Waypoints in the tree, and how many there are.
+  inline const std::vector<Waypoint::ConstPtr>& Waypoints() const {
+    return registry_;
+  }
+  inline size_t Size() const { return registry_.size(); }
+
 private:
+  // Free the points held by the index.
+  void FreePoints();
+
   // A Flann kdtree. Searches in this tree return indices, which are then mapped
   // to Waypoint pointers in an array.
   // TODO: fix the distance metric to be something more intelligent.
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the FlightRecorder class, which logs fixed-size records at full
+// control rate without perturbing the control loop. Records are pushed into
+// a lock-free ring buffer on the control thread, and a background thread
+// periodically drains the buffer and writes it to disk.
+//
+// The tracker records one CONTROL record per tick. The meta planner records
+// EVENTS (replans and the waypoints of each published plan) in the same
+// format, using only the first NUM_EVENT_COLUMNS values of each record.
+//
+// File format (all little-endian, as written by the host):
+//   header: char[8] magic "METAFDR1", uint32 number of columns,
+//           then one char[32] name per column.
+//   blocks: uint32 number of records N, then each column in order as
+//           N contiguous doubles.
+//
+// Use the flight_log_converter executable to convert logs to CSV or .mat.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_FLIGHT_RECORDER_H
+#define META_PLANNER_FLIGHT_RECORDER_H
+
+#include <utils/ring_buffer.h>
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace meta {
+
+class FlightRecorder : private Uncopyable {
+public:
+  typedef std::unique_ptr<FlightRecorder> Ptr;
+
+  // Recorded columns. State and reference are [x, y, z, x_dot, y_dot, z_dot]
+  // and control is [pitch, roll, thrust].
+  enum Column {
+    TIME,
+    STATE_X, STATE_Y, STATE_Z, STATE_VX, STATE_VY, STATE_VZ,
+    REF_X, REF_Y, REF_Z, REF_VX, REF_VY, REF_VZ,
+    PITCH, ROLL, THRUST,
+    PRIORITY,
+    CONTROL_VALUE_ID,
+    BOUND_VALUE_ID,
+    NUM_COLUMNS
+  };
+
+  // Recorded columns for planner events. Position is the start of a replan
+  // or the waypoint itself, and duration is the wall time spent planning or
+  // the time to fly to the waypoint from its parent.
+  enum EventColumn {
+    EVENT_TIME,
+    EVENT_TYPE,
+    EVENT_X, EVENT_Y, EVENT_Z,
+    EVENT_VALUE_ID,
+    EVENT_DURATION,
+    NUM_EVENT_COLUMNS
+  };
+
+  // Planner event types.
+  enum Event { REPLAN, REPLAN_FAILED, WAYPOINT };
+
+  // Which set of columns is recorded.
+  enum Layout { CONTROL, EVENTS };
+
+  // A single fixed-size record.
+  struct Record {
+    double values[NUM_COLUMNS];
+  };
+
+  // File magic string and length of column names in the file header.
+  static const char kMagic[8];
+  static const size_t kColumnNameLength = 32;
+
+  // Destructor flushes everything still queued and closes the file.
+  ~FlightRecorder();
+
+  // Factory method. Opens the file and starts the background writer.
+  // Returns a null pointer if the file could not be opened.
+  static Ptr Create(const std::string& file_name,
+                    size_t capacity = 1 << 16,
+                    double flush_period = 0.05,
+                    Layout layout = CONTROL);
+
+  // Queue a record. Lock-free and wait-free; returns false if the buffer
+  // was full and the record was dropped.
+  inline bool Push(const Record& record) { return buffer_.Push(record); }
+
+  // Number of records dropped so far because the writer fell behind.
+  inline size_t Dropped() const { return buffer_.Dropped(); }
+
+  // Name of a column.
+  static const char* ColumnName(Column column);
+  static const char* ColumnName(EventColumn column);
+
+  // Read a log file back into memory, one vector per column.
+  static bool Read(const std::string& file_name,
+                   std::vector<std::string>& names,
+                   std::vector< std::vector<double> >& columns);
+
+private:
+  explicit FlightRecorder(const std::string& file_name,
+                          size_t capacity, double flush_period,
+                          Layout layout);
+
+  // Background writer loop.
+  void Run();
+
+  // Drain the ring buffer and write one block per batch.
+  void Flush();
+
+  // Ring buffer shared with the control thread.
+  RingBuffer<Record> buffer_;
+
+  // Number of columns written per record.
+  const size_t num_columns_;
+
+  // Output file and scratch space for transposing records into columns.
+  std::ofstream file_;
+  std::vector<Record> batch_;
+  std::vector<double> column_;
+
+  // Background writer.
+  const double flush_period_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_signal_;
+  bool stop_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the FsmPlanner class, which inherits from the Planner abstract
+// class and plans Dubins car paths (constant speed, bounded turning radius)
+// in the horizontal plane with the CCMotion fast marching / fast sweeping
+// solver (see ArrivalTimeField).
+//
+// Each query rasterizes the Environment over a square window centered on
+// the stop point, at the stop point's altitude, and computes the arrival
+// time to the stop point from every position and heading in the window.
+// The path is then extracted by descending that field from the start,
+// setting off in the best heading (waypoints carry no heading). Altitude is
+// interpolated linearly along the path.
+//
+// Fields are cached by stop point until the environment epoch changes, so
+// repeated queries to the same stop point (e.g. connecting many waypoints
+// to the goal) only pay for path extraction.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_FSM_PLANNER_H
+#define META_PLANNER_FSM_PLANNER_H
+
+#include <meta_planner/planner.h>
+#include <meta_planner/arrival_time_field.h>
+#include <meta_planner/box.h>
+#include <utils/types.h>
+
+#include <value_function/GeometricPlannerSpeed.h>
+#include <value_function/SwitchingTrackingBoundBox.h>
+
+#include <ros/ros.h>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace meta {
+
+class FsmPlanner : public Planner {
+public:
+  ~FsmPlanner() {}
+
+  // Factory method. Use this instead of the constructor.
+  static Planner::Ptr Create(ValueFunctionId incoming_value,
+                             ValueFunctionId outgoing_value,
+                             const Box::ConstPtr& space,
+                             const Dynamics::ConstPtr& dynamics);
+
+  // Plan a trajectory between two points.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time = 0.0,
+                       double budget = 1.0) const;
+
+private:
+  explicit FsmPlanner(ValueFunctionId incoming_value,
+                      ValueFunctionId outgoing_value,
+                      const Box::ConstPtr& space,
+                      const Dynamics::ConstPtr& dynamics);
+
+  // Load parameters and register callbacks.
+  bool LoadParameters(const ros::NodeHandle& n);
+  bool RegisterCallbacks(const ros::NodeHandle& n);
+
+  // Get the arrival time field to this stop point, from the cache if
+  // possible. Cells are checked against the environment with the given
+  // switching tracking bound. Returns null if the stop point is blocked, or
+  // if computing a new field would not fit in 'budget' seconds.
+  ArrivalTimeField::ConstPtr GetField(const Vector3d& stop,
+                                      const Vector3d& max_speed,
+                                      const Vector3d& bound,
+                                      double budget) const;
+
+  // Query this planner's max speed and switching tracking bound.
+  bool GetLimits(Vector3d& max_speed, Vector3d& bound) const;
+
+  // Solver settings.
+  double half_width_;
+  int num_cells_;
+  int num_headings_;
+  double turning_radius_;
+  double target_radius_;
+  bool march_;
+  int method_;
+
+  // Most recently used fields first, all computed in 'cache_epoch_'.
+  int cache_size_;
+  mutable std::list<ArrivalTimeField::ConstPtr> cache_;
+  mutable size_t cache_epoch_;
+  mutable std::mutex cache_mutex_;
+
+  // Duration of the most recent solve, to estimate the next one.
+  mutable double solve_time_;
+
+  // Servers for max speed and switching tracking bound.
+  mutable ros::ServiceClient max_speed_srv_;
+  std::string max_speed_name_;
+
+  mutable ros::ServiceClient switching_bound_srv_;
+  std::string switching_bound_name_;
+};
+
+} //\namespace meta
+
+#endif
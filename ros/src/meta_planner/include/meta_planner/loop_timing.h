@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the LoopTiming class, which records how well a periodic control
+// loop keeps to its schedule. Each tick contributes its start jitter (how
+// late the tick started relative to when it was scheduled, measured on the
+// ROS clock, which may be simulated) and its compute time (measured on the
+// wall clock). A tick misses its deadline if it has not finished by the
+// time the next one is due.
+//
+// Both quantities are binned into power-of-two histograms in microseconds,
+// i.e. bucket ii holds values in [2^(ii-1), 2^ii) us (bucket 0 is < 1 us,
+// and the last bucket holds everything larger). Counters are atomic, so
+// they may be read from another thread while the loop is running.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_LOOP_TIMING_H
+#define META_PLANNER_LOOP_TIMING_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <atomic>
+#include <stdint.h>
+#include <memory>
+
+namespace meta {
+
+class LoopTiming : private Uncopyable {
+public:
+  typedef std::shared_ptr<LoopTiming> Ptr;
+  typedef std::shared_ptr<const LoopTiming> ConstPtr;
+
+  // Histogram size.
+  static const size_t kNumBuckets = 20;
+
+  ~LoopTiming() {}
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create(double period);
+
+  // Record a tick which started 'jitter' seconds after it was scheduled and
+  // took 'compute' seconds to run.
+  void RecordTick(double jitter, double compute);
+
+  // Clear all counters.
+  void Reset();
+
+  // Accessors.
+  double Period() const { return period_; }
+  size_t NumTicks() const;
+  size_t NumDeadlineMisses() const;
+  size_t JitterBucket(size_t ii) const;
+  size_t ComputeBucket(size_t ii) const;
+
+  // Mean and max (seconds).
+  double MeanJitter() const;
+  double MaxJitter() const;
+  double MeanCompute() const;
+  double MaxCompute() const;
+
+  // Upper edge (seconds) of the bucket containing the given quantile in
+  // [0, 1], e.g. 0.99 for the 99th percentile.
+  double JitterQuantile(double quantile) const;
+  double ComputeQuantile(double quantile) const;
+
+  // Upper edge (seconds) of the given bucket.
+  static double BucketUpperEdge(size_t ii);
+
+private:
+  explicit LoopTiming(double period);
+
+  // Counters for one histogrammed quantity.
+  struct Histogram {
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<size_t> buckets[kNumBuckets];
+  };
+
+  // Add a value to a histogram, and read back quantiles.
+  static void Record(Histogram& histogram, double seconds);
+  double Quantile(const Histogram& histogram, double quantile) const;
+
+  // Desired loop period (seconds).
+  const double period_;
+
+  std::atomic<size_t> ticks_;
+  std::atomic<size_t> misses_;
+  Histogram jitter_;
+  Histogram compute_;
+};
+
+} //\namespace meta
+
+#endif
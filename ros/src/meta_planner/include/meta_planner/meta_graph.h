@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the MetaGraph class, which holds candidate connections between
+// sampled points for lazy meta planning. Each new point is connected to
+// its nearest neighbors within a radius by edges whose cost is an
+// optimistic (never overestimating) travel time, so no planner is run
+// when a point is added.
+//
+// Points which have actually been reached by a planned trajectory carry
+// their true cost-to-come. The search finds the path to the goal that
+// starts at any reached point and continues along unevaluated edges with
+// the lowest optimistic total time. Only the edges on that path are then
+// worth evaluating with a real planner. Edges are removed from the search
+// once evaluated, whether or not a trajectory was found.
+//
+// The goal is never marked reached, so better routes to it can still be
+// found after the first one. As in MetaPlanner::Plan, the start is never
+// connected directly to the goal.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_META_GRAPH_H
+#define META_PLANNER_META_GRAPH_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <functional>
+#include <vector>
+
+namespace meta {
+
+class MetaGraph : private Uncopyable {
+public:
+  typedef std::function<double(const Vector3d&, const Vector3d&)> CostFunction;
+
+  // Indices of the start and goal nodes.
+  static const size_t kStartNode;
+  static const size_t kGoalNode;
+
+  ~MetaGraph() {}
+
+  // The start is reached at time zero. Each added point is connected to at
+  // most 'max_neighbors' of the nearest existing nodes within 'radius'.
+  explicit MetaGraph(const Vector3d& start, const Vector3d& goal,
+                     double radius, size_t max_neighbors,
+                     const CostFunction& optimistic_cost);
+
+  // Add a node and connect it to its neighbors. Returns its index.
+  size_t AddNode(const Vector3d& point);
+
+  // Mark a node as reached at the given time from the start. Edges into a
+  // reached node are no longer searched.
+  void SetReached(size_t node, double cost_to_come);
+  bool IsReached(size_t node) const;
+
+  // Remove the edge between these nodes from the search.
+  void RemoveEdge(size_t from, size_t to);
+
+  // Find the best candidate path to the goal, from a reached node through
+  // unreached ones. Returns its optimistic total time, or infinity (and an
+  // empty path) if there is none.
+  double BestPath(std::vector<size_t>& path) const;
+
+  // Accessors.
+  inline const Vector3d& Point(size_t node) const { return points_[node]; }
+  inline size_t NumNodes() const { return points_.size(); }
+  size_t NumEdges() const;
+
+private:
+  struct Edge {
+    size_t to_;
+    double cost_;
+  };
+
+  // Add an edge in each direction, except into the start or out of the goal.
+  void Connect(size_t from, size_t to, double cost);
+
+  const double radius_;
+  const size_t max_neighbors_;
+  const CostFunction optimistic_cost_;
+
+  // Points, outgoing edges, and cost-to-come (infinite if not reached).
+  std::vector<Vector3d> points_;
+  std::vector< std::vector<Edge> > edges_;
+  std::vector<double> cost_to_come_;
+};
+
+} //\namespace meta
+
+#endif
@@ -46,9 +46,17 @@
 #define META_PLANNER_META_PLANNER_H
 
 #include <meta_planner/waypoint_tree.h>
+#include <meta_planner/meta_graph.h>
 #include <meta_planner/waypoint.h>
 #include <meta_planner/ompl_planner.h>
+#include <meta_planner/mpc_planner.h>
+#include <meta_planner/fsm_planner.h>
 #include <meta_planner/environment.h>
+#include <meta_planner/box.h>
+#include <meta_planner/voxel_box.h>
+#include <meta_planner/tiled_box.h>
+#include <meta_planner/cost_to_go_grid.h>
+#include <meta_planner/flight_recorder.h>
 #include <value_function/near_hover_quad_no_yaw.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
@@ -57,10 +65,13 @@
 #include <meta_planner_msgs/Trajectory.h>
 #include <meta_planner_msgs/TrajectoryRequest.h>
 #include <meta_planner_msgs/SensorMeasurement.h>
+#include <meta_planner_msgs/ValueFunctionsReloaded.h>
+#include <meta_planner_msgs/EstimateTimeToGoal.h>
 #include <crazyflie_msgs/PositionStateStamped.h>
 
 #include <value_function/TrackingBoundBox.h>
 #include <value_function/GeometricPlannerTime.h>
+#include <value_function/GeometricPlannerSpeed.h>
 #include <value_function/GuaranteedSwitchingTime.h>
 #include <value_function/GuaranteedSwitchingDistance.h>
 
@@ -78,6 +89,8 @@ public:
     : in_flight_(false),
       reached_goal_(false),
       been_updated_(false),
+      have_planner_limits_(false),
+      cost_to_go_valid_(false),
       initialized_(false) {}
 
   // Initialize this class from a ROS node.
@@ -91,7 +104,12 @@ private:
   // Callback for processing state updates.
   void StateCallback(const crazyflie_msgs::PositionStateStamped::ConstPtr& msg);
 
-  // Callback for processing sensor measurements.
+  // Update the active tiles of a TiledBox environment around the vehicle and
+  // along the corridor to the goal through the current trajectory.
+  void UpdateActiveTiles();
+
+  // Callback for processing sensor measurements. Obstacles reported with a
+  // nonzero velocity are moving, and replace the previous moving obstacles.
   void SensorCallback(const meta_planner_msgs::SensorMeasurement::ConstPtr& msg);
 
   // Callback for updating in flight status.
@@ -99,15 +117,60 @@ private:
     in_flight_ = true;
   }
 
+  // Callback for value function server reloads. Bounds and switching times
+  // of the current trajectory may have changed, so trigger a replan.
+  void ValueFunctionsReloadedCallback(
+    const meta_planner_msgs::ValueFunctionsReloaded::ConstPtr& msg);
+
   // Callback to handle requests for new trajectory.
   void RequestTrajectoryCallback(
     const meta_planner_msgs::TrajectoryRequest::ConstPtr& msg);
 
+  // Service callback estimating time to reach each of a batch of goals from
+  // the current position. Returns both a lower bound, ignoring obstacles,
+  // and an obstacle-aware estimate from a shared cost-to-go grid.
+  bool EstimateTimeToGoalCallback(
+    meta_planner_msgs::EstimateTimeToGoal::Request& req,
+    meta_planner_msgs::EstimateTimeToGoal::Response& res);
+
+  // Query max speeds and tracking bounds over all planners. Returns false if
+  // the value function server could not be reached.
+  bool UpdatePlannerLimits();
+
+  // Check the remainder of a trajectory after the given time, along its
+  // time stamps and up to the moving obstacle horizon, with the time-aware
+  // collision checker.
+  bool IsValid(const Trajectory::ConstPtr& traj, double start_time) const;
+
+  // Optimistic travel time between two points at the max planner speed, as
+  // in ValueFunction::BestPossibleTime. Requires planner limits.
+  double OptimisticTime(const Vector3d& start, const Vector3d& stop) const;
+
   // Plan a trajectory from the given start to stop points, beginning at the
   // specified start time. Auto-publishes the result and returns whether
   // meta planning was successful.
   bool Plan(const Vector3d& start, const Vector3d& stop, double start_time);
 
+  // Same as Plan, but only runs planners along the best candidate path in a
+  // graph of optimistic connections. See meta_graph.h for details.
+  bool PlanLazy(const Vector3d& start, const Vector3d& stop,
+                double start_time);
+
+  // Steps of Plan and PlanLazy: extend the tree from a waypoint to a new
+  // point, connect a waypoint to the goal, and publish the best trajectory.
+  bool Extend(WaypointTree& tree, Waypoint::ConstPtr neighbor,
+              const Vector3d& sample, double start_time,
+              Waypoint::ConstPtr& waypoint);
+  bool ConnectToGoal(WaypointTree& tree, const Waypoint::ConstPtr& waypoint,
+                     size_t neighbor_planner_id, bool allow_switch,
+                     const Vector3d& stop);
+  bool PublishBest(const WaypointTree& tree);
+
+  // Record a planner event, if recording.
+  void RecordEvent(FlightRecorder::Event event, double time,
+                   const Vector3d& position, ValueFunctionId value,
+                   double duration);
+
   // Dynamics.
   NearHoverQuadNoYaw::ConstPtr dynamics_;
 
@@ -118,6 +181,9 @@ private:
   std::vector<Planner::ConstPtr> planners_;
   size_t num_value_functions_;
 
+  // Planner type, one of "bitstar", "mpc" or "fsm".
+  std::string planner_type_;
+
   // Geometric goal point.
   Vector3d goal_;
 
@@ -128,9 +194,27 @@ private:
   // Spaces and dimensions.
   size_t state_dim_;
   size_t control_dim_;
-  BallsInBox::Ptr space_;
+  Box::Ptr space_;
   unsigned int seed_;
 
+  // Environment type, one of "balls_in_box", "voxel_box" or "tiled_box",
+  // and the voxel size for VoxelBox. Only BallsInBox tracks moving
+  // obstacles, so it is also kept separately and is null for other
+  // environments.
+  std::string environment_type_;
+  double voxel_resolution_;
+  BallsInBox::Ptr balls_;
+
+  // TiledBox file and radius of active tiles around the vehicle and the
+  // corridor. The TiledBox is kept separately, with the position and
+  // trajectory its active tiles were last updated for, and is null for
+  // other environments.
+  std::string tile_file_;
+  double tile_active_radius_;
+  TiledBox::Ptr tiles_;
+  Vector3d tiles_position_;
+  Trajectory::ConstPtr tiles_traj_;
+
   std::vector<double> state_upper_;
   std::vector<double> state_lower_;
   std::vector<double> control_upper_;
@@ -142,16 +226,54 @@ private:
   // Maximum distance between waypoints.
   double max_connection_radius_;
 
+  // Prune dominated waypoints from the tree every 'prune_interval_'
+  // iterations, and whenever it holds more than 'max_tree_size_' waypoints.
+  // Zero disables either.
+  size_t prune_interval_;
+  size_t max_tree_size_;
+
+  // Lazy meta planning, connecting each sample to at most this many
+  // neighbors in the graph.
+  bool lazy_;
+  size_t lazy_max_neighbors_;
+
+  // Moving obstacles are predicted at constant velocity over this horizon,
+  // indexed at this cell size and time resolution, and checked along
+  // trajectories at points this far apart.
+  double dynamic_horizon_;
+  double dynamic_cell_size_;
+  double dynamic_time_resolution_;
+  double dynamic_check_resolution_;
+
+  // Time to goal estimation. The fastest speed and tightest tracking bound
+  // over all planners are cached, as is the cost-to-go grid from the most
+  // recent position. Both are invalidated when obstacles or value
+  // functions change.
+  double eta_resolution_;
+  Vector3d max_planner_speed_;
+  Vector3d min_tracking_bound_;
+  bool have_planner_limits_;
+  CostToGoGrid::Ptr cost_to_go_;
+  bool cost_to_go_valid_;
+
+  // Optional recorder for replan and waypoint events.
+  FlightRecorder::Ptr recorder_;
+  std::string recorder_file_;
+
   // Services and names.
   ros::ServiceClient bound_srv_;
   ros::ServiceClient best_time_srv_;
   ros::ServiceClient switching_time_srv_;
   ros::ServiceClient switching_distance_srv_;
+  ros::ServiceClient max_speed_srv_;
+  ros::ServiceServer eta_srv_;
 
   std::string bound_name_;
   std::string best_time_name_;
   std::string switching_time_name_;
   std::string switching_distance_name_;
+  std::string max_speed_name_;
+  std::string eta_name_;
 
   // Publishers/subscribers and related topics.
   ros::Publisher traj_pub_;
@@ -161,6 +283,7 @@ private:
   ros::Subscriber sensor_sub_;
   ros::Subscriber request_traj_sub_;
   ros::Subscriber in_flight_sub_;
+  ros::Subscriber values_reloaded_sub_;
 
   std::string traj_topic_;
   std::string env_topic_;
@@ -169,6 +292,7 @@ private:
   std::string request_traj_topic_;
   std::string trigger_replan_topic_;
   std::string in_flight_topic_;
+  std::string values_reloaded_topic_;
 
   // Frames.
   std::string fixed_frame_id_;
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the MpcPlanner class, which inherits from the Planner abstract
+// class and plans with a short-horizon trajectory optimizer instead of a
+// sampling-based planner. Trajectories respect the speed of this planner's
+// value function and the acceleration limits of the dynamics, and keep the
+// switching tracking bound clear of the obstacles in a BallsInBox.
+//
+// Each call solves a sequence of convex programs (see TrajectoryOptimizer),
+// each warm-started from the last, so the planner returns a smooth,
+// dynamically feasible trajectory in a few milliseconds when one exists
+// near the straight line, and fails quickly otherwise so that the
+// MetaPlanner can try another sample.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_MPC_PLANNER_H
+#define META_PLANNER_MPC_PLANNER_H
+
+#include <meta_planner/planner.h>
+#include <meta_planner/trajectory_optimizer.h>
+#include <demo/balls_in_box.h>
+#include <utils/types.h>
+
+#include <value_function/GeometricPlannerSpeed.h>
+#include <value_function/SwitchingTrackingBoundBox.h>
+
+#include <ros/ros.h>
+#include <memory>
+
+namespace meta {
+
+class MpcPlanner : public Planner {
+public:
+  ~MpcPlanner() {}
+
+  // Factory method. Use this instead of the constructor.
+  static Planner::Ptr Create(ValueFunctionId incoming_value,
+                             ValueFunctionId outgoing_value,
+                             const BallsInBox::ConstPtr& space,
+                             const Dynamics::ConstPtr& dynamics);
+
+  // Plan a trajectory between two points.
+  Trajectory::Ptr Plan(const Vector3d& start,
+                       const Vector3d& stop,
+                       double start_time = 0.0,
+                       double budget = 1.0) const;
+
+private:
+  explicit MpcPlanner(ValueFunctionId incoming_value,
+                      ValueFunctionId outgoing_value,
+                      const BallsInBox::ConstPtr& space,
+                      const Dynamics::ConstPtr& dynamics);
+
+  // Load parameters and register callbacks.
+  bool LoadParameters(const ros::NodeHandle& n);
+  bool RegisterCallbacks(const ros::NodeHandle& n);
+
+  // Query this planner's speed and switching tracking bound. These do not
+  // change unless value functions are reloaded, but are cheap to look up.
+  bool GetLimits(Vector3d& max_speed, Vector3d& bound) const;
+
+  // Environment with obstacle geometry.
+  const BallsInBox::ConstPtr obstacles_;
+
+  // Optimizer settings.
+  int horizon_;
+  int max_iterations_;
+  double time_scale_;
+  double activation_distance_;
+  double acceleration_fraction_;
+
+  // Solutions are checked against the environment at points no more than
+  // this far apart.
+  double check_resolution_;
+
+  // Servers for speed and switching tracking bound.
+  mutable ros::ServiceClient max_speed_srv_;
+  std::string max_speed_name_;
+
+  mutable ros::ServiceClient switching_bound_srv_;
+  std::string switching_bound_name_;
+};
+
+} //\namespace meta
+
+#endif
@@ -44,6 +44,10 @@
 // We follow these ( http://ompl.kavrakilab.org/geometricPlanningSE3.html )
 // instructions for using OMPL geometric planners.
 //
+// OMPL plans geometrically, so states are checked against moving obstacles
+// at the earliest time they could be reached, and the solution is checked
+// again along its actual time stamps.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef META_PLANNER_OMPL_PLANNER_H
@@ -60,6 +64,8 @@
 #include <ompl/base/TypedSpaceInformation.h>
 #include <ompl/base/SpaceInformation.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <cmath>
+#include <limits>
 #include <memory>
 
 namespace meta {
@@ -119,8 +125,9 @@ template<typename PlannerType>
 Trajectory::Ptr OmplPlanner<PlannerType>::
 Plan(const Vector3d& start, const Vector3d& stop,
      double start_time, double budget) const {
-  // Check that both start and stop are in bounds.
-  if (!space_->IsValid(start, incoming_value_, outgoing_value_)) {
+  // Check that both start and stop are in bounds. The time we reach the
+  // stop is not known yet, so it is only checked against static obstacles.
+  if (!space_->IsValidAt(start, start_time, incoming_value_, outgoing_value_)) {
     ROS_WARN_THROTTLE(1.0, "Start point was in collision or out of bounds.");
     return nullptr;
   }
@@ -147,11 +154,21 @@ Plan(const Vector3d& start, const Vector3d& stop,
 
   ompl_space->setBounds(ompl_bounds);
 
+  // Going straight from the start at the speed needed to reach the stop in
+  // the best possible time, this is the earliest any state can be reached.
+  const double best_time = BestPossibleTime(start, stop);
+  const double distance = (stop - start).norm();
+  const double speed = (best_time > 0.0 && std::isfinite(best_time)) ?
+    distance / best_time : std::numeric_limits<double>::infinity();
+
   // Create a SimpleSetup instance and set the state validity checker function.
   og::SimpleSetup ompl_setup(ompl_space);
   ompl_setup.setStateValidityChecker([&](const ob::State* state) {
-      return space_->IsValid(FromOmplState(state),
-                             incoming_value_, outgoing_value_); });
+      const Vector3d position = FromOmplState(state);
+      const double time = (speed > 0.0) ?
+        start_time + (position - start).norm() / speed : start_time;
+      return space_->IsValidAt(position, time,
+                               incoming_value_, outgoing_value_); });
 
   // Set the start and stop states.
   ob::ScopedState<ob::RealVectorStateSpace> ompl_start(ompl_space);
@@ -194,6 +211,19 @@ Plan(const Vector3d& start, const Vector3d& stop,
       values.push_back(incoming_value_);
     }
 
+    // Check against moving obstacles along the actual time stamps, as
+    // finely as OMPL checks motions.
+    const double resolution = ompl_space->getLongestValidSegmentLength();
+    for (size_t ii = 1; ii < positions.size(); ii++) {
+      if (!space_->IsMotionValid(positions[ii - 1], positions[ii],
+                                 times[ii - 1], times[ii], resolution,
+                                 incoming_value_, outgoing_value_)) {
+        ROS_WARN_THROTTLE(1.0, "OMPL Planner solution collides with a "
+                          "moving obstacle.");
+        return nullptr;
+      }
+    }
+
     // Convert to full state space. Make sure to use the INCOMING VALUE!
     std::vector<VectorXd> full_states =
       dynamics_->LiftGeometricTrajectory(positions, times);
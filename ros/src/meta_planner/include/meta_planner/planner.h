@@ -139,10 +139,10 @@ protected:
   bool initialized_;
   std::string name_;
 
-private:
-  // Load parameters and register callbacks.
-  bool LoadParameters(const ros::NodeHandle& n);
-  bool RegisterCallbacks(const ros::NodeHandle& n);
+  // Load parameters and register callbacks. Derived classes with their own
+  // parameters should call these first.
+  virtual bool LoadParameters(const ros::NodeHandle& n);
+  virtual bool RegisterCallbacks(const ros::NodeHandle& n);
 };
 
 } //\namespace meta
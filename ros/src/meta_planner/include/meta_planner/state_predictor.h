@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the StatePredictor class, which compensates for latency in the
+// state estimate by forward-integrating the near-hover quadrotor dynamics
+// (see NearHoverQuadNoYaw) from the time the state was measured to the time
+// the next control will actually be applied.
+//
+// Recently applied controls are kept in a fixed-size history and treated as
+// zero-order hold. Accelerations are constant between control changes, so
+// each piece is integrated exactly. Nothing allocates after construction,
+// so this is cheap enough to run on every control tick.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_STATE_PREDICTOR_H
+#define META_PLANNER_STATE_PREDICTOR_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <array>
+#include <memory>
+
+namespace meta {
+
+class StatePredictor : private Uncopyable {
+public:
+  typedef std::unique_ptr<StatePredictor> Ptr;
+
+  // State is [x, y, z, x_dot, y_dot, z_dot] and control is
+  // [pitch, roll, thrust].
+  typedef Eigen::Matrix<double, 6, 1> State;
+
+  // Factory method. Use this instead of the constructor. Never predicts
+  // further ahead than 'max_horizon' seconds.
+  static Ptr Create(double max_horizon);
+
+  // Destructor.
+  ~StatePredictor() {}
+
+  // Record a control applied from this time onward.
+  void RecordControl(double time, const Vector3d& control);
+
+  // Record a measured latency between a state's time stamp and its arrival.
+  // Keeps an exponential moving average.
+  void RecordLatency(double latency);
+
+  // Predict the state at 'target_time' given the state measured at
+  // 'state_time'. Returns the horizon actually integrated over.
+  double Predict(const State& state, double state_time,
+                 double target_time, State& predicted) const;
+
+  // Current latency estimate.
+  inline double Latency() const { return latency_; }
+
+  // Max number of controls kept.
+  static const size_t kHistorySize = 64;
+
+private:
+  explicit StatePredictor(double max_horizon);
+
+  // Acceleration under a control.
+  static Vector3d Acceleration(const Vector3d& control);
+
+  // Controls applied, oldest first in a circular buffer.
+  std::array<double, kHistorySize> times_;
+  std::array<Vector3d, kHistorySize> controls_;
+  size_t first_;
+  size_t size_;
+
+  // Latency estimate and smoothing factor.
+  double latency_;
+  bool latency_initialized_;
+  static const double kLatencySmoothing;
+
+  // Max prediction horizon.
+  const double max_horizon_;
+};
+
+} //\namespace meta
+
+#endif
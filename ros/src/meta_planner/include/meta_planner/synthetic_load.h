@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SyntheticLoad class, which generates configurable background
+// load for timing benchmarks of the control loop (see the
+// control_loop_benchmark executable). Three kinds of load are supported:
+//
+// (1) Planner threads, which repeatedly build and query FlannTrees of random
+//     waypoints the way MetaPlanner does, saturating their cores.
+// (2) A publisher flood, which publishes large visualization markers at a
+//     fixed rate, like visualization subscribers connecting to a busy node.
+// (3) Memory-bandwidth hogs, which stream over buffers much larger than
+//     the last-level cache.
+//
+// All load runs on its own threads until Stop() is called.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_SYNTHETIC_LOAD_H
+#define META_PLANNER_SYNTHETIC_LOAD_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace meta {
+
+class SyntheticLoad : private Uncopyable {
+public:
+  typedef std::shared_ptr<SyntheticLoad> Ptr;
+  typedef std::shared_ptr<const SyntheticLoad> ConstPtr;
+
+  ~SyntheticLoad() { Stop(); }
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create();
+
+  // Start 'num_threads' planner threads. Each builds a tree of up to
+  // 'tree_size' random waypoints, querying it as it grows, then starts over.
+  void StartPlannerThreads(size_t num_threads, size_t tree_size);
+
+  // Publish markers with 'num_points' points each on the given topic at
+  // 'rate' Hz.
+  void StartPublisherFlood(const ros::NodeHandle& n, const std::string& topic,
+                           double rate, size_t num_points);
+
+  // Start 'num_threads' threads, each streaming over its own buffer of
+  // 'megabytes' MB.
+  void StartMemoryHogs(size_t num_threads, size_t megabytes);
+
+  // Stop and join all threads.
+  void Stop();
+
+  // Units of work done so far: tree queries, published messages, and
+  // bytes copied, summed over all threads.
+  size_t PlannerQueries() const { return planner_queries_.load(); }
+  size_t PublishedMessages() const { return published_messages_.load(); }
+  size_t CopiedBytes() const { return copied_bytes_.load(); }
+
+private:
+  explicit SyntheticLoad();
+
+  // Thread bodies.
+  void PlannerThread(size_t tree_size, unsigned int seed);
+  void FloodThread(ros::Publisher pub, double rate, size_t num_points);
+  void MemoryHogThread(size_t megabytes);
+
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_;
+
+  std::atomic<size_t> planner_queries_;
+  std::atomic<size_t> published_messages_;
+  std::atomic<size_t> copied_bytes_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TiledBox class, a Box for large worlds whose spherical
+// obstacles are partitioned into fixed-size cubic tiles and stored in a
+// memory-mapped file.
+//
+// Only the tiles around the vehicle and along the current meta-plan
+// corridor are active. Active tiles, plus a one-tile halo so that queries
+// near their edges see every nearby obstacle, are copied out of the file
+// into memory; all other tiles are evicted and their pages released with
+// madvise(MADV_DONTNEED). Sampling and collision checking are restricted to
+// active tiles, so their cost depends on the corridor and not on the size
+// of the world. Obstacles added at run time (e.g. sensed ones) are kept
+// separately and survive eviction.
+//
+// File layout (host byte order):
+//   char[8] magic "METATILE"
+//   uint64 num_tiles[3]
+//   double lower[3], tile_size, max_radius
+//   uint64 offsets[num_tiles + 1], the first obstacle of each tile
+//   double obstacles[num_obstacles][4], (x, y, z, radius) grouped by tile
+// Tiles are numbered x fastest, then y, then z, and each obstacle belongs
+// to the tile containing its center.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_TILED_BOX_H
+#define META_PLANNER_TILED_BOX_H
+
+#include <meta_planner/box.h>
+
+#include <ros/ros.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace meta {
+
+class TiledBox : public Box {
+public:
+  typedef std::shared_ptr<TiledBox> Ptr;
+  typedef std::shared_ptr<const TiledBox> ConstPtr;
+
+  // Factory method. Use this instead of the constructor. Tiles within
+  // 'active_radius' of the vehicle or of the corridor are active.
+  static Ptr Create(const std::string& file_name, double active_radius);
+
+  // Destructor unmaps the file.
+  ~TiledBox();
+
+  // Inherited collision checker from Box needs to be overwritten. Positions
+  // outside the active tiles are invalid.
+  // Takes in incoming and outgoing value functions. See planner.h for details.
+  bool IsValid(const Vector3d& position,
+               ValueFunctionId incoming_value,
+               ValueFunctionId outgoing_value) const;
+
+  // Inherited sampler from Box needs to be overwritten. Samples uniformly
+  // from the active tiles.
+  Vector3d Sample() const;
+
+  // Inherited visualizer from Box needs to be overwritten. Shows the
+  // obstacles in loaded tiles.
+  void Visualize(const ros::Publisher& pub, const std::string& frame_id) const;
+
+  // Update the active tiles around the vehicle position and along the
+  // corridor, a polyline through the current meta-plan. Loads newly needed
+  // tiles and evicts the rest. Returns the number of tiles loaded.
+  size_t UpdateActive(const Vector3d& position,
+                      const std::vector<Vector3d>& corridor);
+
+  // Same as IsValid, but with a known tracking bound.
+  bool IsFree(const Vector3d& position, const Vector3d& bound) const;
+
+  // Add a spherical obstacle of the given radius to the environment.
+  void AddObstacle(const Vector3d& point, double r);
+
+  // Check if a given obstacle is in the loaded part of the environment.
+  bool IsObstacle(const Vector3d& obstacle_position,
+                  double obstacle_radius) const;
+
+  // Accessors.
+  inline double TileSize() const { return tile_size_; }
+  inline size_t NumActiveTiles() const { return active_.size(); }
+  inline size_t NumLoadedTiles() const { return loaded_.size(); }
+  inline bool IsLoaded() const { return offsets_ != NULL; }
+
+  // Write a file in the format read by this class, assigning each
+  // obstacle to a tile. Returns whether it was successful.
+  static bool Write(const std::string& file_name,
+                    const Vector3d& lower, const Vector3d& upper,
+                    double tile_size,
+                    const std::vector<Vector3d>& points,
+                    const std::vector<double>& radii);
+
+private:
+  explicit TiledBox(double active_radius);
+
+  // Map the file and read its header. Returns whether it was successful.
+  bool Load(const std::string& file_name);
+
+  // Release the pages of the mapping holding this tile's obstacles.
+  void Release(size_t tile) const;
+
+  // Tile containing this point, clamped to the grid, and its index.
+  Eigen::Vector3i Tile(const Vector3d& point) const;
+  size_t Index(const Eigen::Vector3i& tile) const;
+
+  // Add all tiles within 'radius' of the segment [from, to] to the set.
+  void AddTiles(const Vector3d& from, const Vector3d& to, double radius,
+                std::unordered_set<size_t>& tiles) const;
+
+  // Check if a sphere overlaps the tracking bound around a position.
+  static bool Overlaps(const Vector3d& position, const Vector3d& bound,
+                       const Vector3d& center, double radius);
+
+  // Obstacles in a tile, as centers and radii.
+  struct Obstacles {
+    std::vector<Vector3d> points;
+    std::vector<double> radii;
+  };
+
+  // Tile grid.
+  Eigen::Vector3i num_tiles_;
+  double tile_size_;
+  double max_radius_;
+  const double active_radius_;
+
+  // Active tiles (by index) in a vector for sampling, and loaded tiles
+  // (active tiles and their halo) with their obstacles.
+  std::vector<size_t> active_;
+  std::unordered_set<size_t> active_set_;
+  std::unordered_map<size_t, Obstacles> loaded_;
+
+  // Obstacles added at run time, by tile.
+  std::unordered_map<size_t, Obstacles> added_;
+
+  // Memory-mapped file.
+  void* map_;
+  size_t map_size_;
+  const uint64_t* offsets_;
+  const double* obstacles_;
+
+  // File magic.
+  static const char kMagic[8];
+};
+
+} //\namespace meta
+
+#endif
@@ -44,6 +44,9 @@
 #define META_PLANNER_TRACKER_H
 
 #include <meta_planner/trajectory.h>
+#include <meta_planner/flight_recorder.h>
+#include <meta_planner/state_predictor.h>
+#include <meta_planner/loop_timing.h>
 #include <meta_planner/ompl_planner.h>
 #include <demo/balls_in_box.h>
 #include <utils/types.h>
@@ -80,6 +83,9 @@ public:
   // Initialize this class with all parameters and callbacks.
   bool Initialize(const ros::NodeHandle& n);
 
+  // Control loop timing, or null unless 'timing/enabled' is set.
+  inline LoopTiming::Ptr Timing() const { return timing_; }
+
 private:
   bool LoadParameters(const ros::NodeHandle& n);
   bool RegisterCallbacks(const ros::NodeHandle& n);
@@ -95,9 +101,22 @@ private:
   void ControllerIdCallback(
     const meta_planner_msgs::ControllerId::ConstPtr& msg);
 
-  // Callback for applying tracking controller.
+  // Timer callback. Runs one control tick and records its timing.
   void TimerCallback(const ros::TimerEvent& e);
 
+  // Apply the tracking controller once.
+  void Tick();
+
+  // Compute the LQR control for the given state and current reference, and
+  // combine it with the given optimal control according to the merge mode.
+  // Writes into 'merged', which must already have the control dimension.
+  void MergeControl(const VectorXd& state, const VectorXd& optimal_control,
+                    double priority, VectorXd& merged) const;
+
+  // Load a whitespace-delimited matrix of known size from a text file.
+  bool LoadMatrix(const std::string& file_name,
+                  size_t rows, size_t cols, MatrixXd& matrix) const;
+
   // Process in flight notifications.
   inline void InFlightCallback(const std_msgs::Empty::ConstPtr& msg) {
     in_flight_ = true;
@@ -107,18 +126,60 @@ private:
   VectorXd state_;
   VectorXd reference_;
 
+  // Optional latency compensation. The state is predicted forward from the
+  // time it was measured to the time the control is expected to be applied,
+  // 'actuation_delay_' after the tick.
+  StatePredictor::Ptr predictor_;
+  double state_time_;
+  double actuation_delay_;
+  StatePredictor::State measured_state_;
+  StatePredictor::State predicted_state_;
+  VectorXd compensated_state_;
+
+  // Per-tick buffers, preallocated so that ticks don't allocate.
+  VectorXd relative_state_;
+  mutable VectorXd tracking_error_;
+  VectorXd optimal_control_;
+  VectorXd applied_control_;
+
   // IDs of control/bound value functions.
   ValueFunctionId control_value_id_;
   ValueFunctionId bound_value_id_;
 
+  // When tracking with the control value function began, for time-varying
+  // value functions. Negative until the first controller ID arrives.
+  double control_start_time_;
+
   // Spaces and dimensions.
   size_t control_dim_;
   size_t state_dim_;
 
+  // Optionally merge LQR and optimal control in this node rather than
+  // relying on a separate merger node. LQR control is u_ref + K (ref - x).
+  // Modes match the merger node's: MERGE blends by priority, OPTIMAL and
+  // LQR apply only that control. With prediction but without in-process
+  // merging, the mode and gains are used to predict the merger's control.
+  enum MergeMode { MERGE, OPTIMAL, LQR };
+
+  bool merge_control_;
+  MergeMode merge_mode_;
+  MatrixXd lqr_K_;
+  VectorXd lqr_u_ref_;
+
+  std::string lqr_K_file_;
+  std::string lqr_u_ref_file_;
+
+  // Optional full-rate flight data recorder.
+  FlightRecorder::Ptr recorder_;
+  std::string recorder_file_;
+
   // Set a recurring timer for a discrete-time controller.
   ros::Timer timer_;
   double time_step_;
 
+  // Optional tick jitter/compute time/deadline miss statistics.
+  LoopTiming::Ptr timing_;
+
   // Service clients.
   ros::ServiceClient optimal_control_srv_;
   ros::ServiceClient priority_srv_;
@@ -128,12 +189,14 @@ private:
 
   // Publishers/subscribers and related topics.
   ros::Publisher control_pub_;
+  ros::Publisher merged_control_pub_;
   ros::Subscriber state_sub_;
   ros::Subscriber reference_sub_;
   ros::Subscriber controller_id_sub_;
   ros::Subscriber in_flight_sub_;
 
   std::string control_topic_;
+  std::string merged_control_topic_;
   std::string state_topic_;
   std::string reference_topic_;
   std::string controller_id_topic_;
@@ -128,6 +128,9 @@ public:
   ValueFunctionId LastBoundValueFunction() const;
   ValueFunctionId FirstBoundValueFunction() const;
 
+  // Time stamps of all states, in increasing order.
+  std::vector<double> Times() const;
+
   // Find the state corresponding to a particular time via linear interpolation.
   VectorXd GetState(double time) const;
 
@@ -46,6 +46,7 @@
 #define META_PLANNER_TRAJECTORY_INTERPRETER_H
 
 #include <meta_planner/trajectory.h>
+#include <meta_planner/loop_timing.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
 #include <utils/message_interfacing.h>
@@ -79,6 +80,9 @@ public:
   // Initialize this class with all parameters and callbacks.
   bool Initialize(const ros::NodeHandle& n);
 
+  // Control loop timing, or null unless 'timing/enabled' is set.
+  inline LoopTiming::Ptr Timing() const { return timing_; }
+
 private:
   bool LoadParameters(const ros::NodeHandle& n);
   bool RegisterCallbacks(const ros::NodeHandle& n);
@@ -89,9 +93,12 @@ private:
   // Callback for processing state updates.
   void StateCallback(const crazyflie_msgs::PositionStateStamped::ConstPtr& msg);
 
-  // Callback for applying tracking controller.
+  // Timer callback. Runs one tick and records its timing.
   void TimerCallback(const ros::TimerEvent& e);
 
+  // Publish the reference and controller IDs for the current time once.
+  void Tick();
+
   // Request a new trajectory from the meta planner.
   void RequestNewTrajectory() const;
 
@@ -121,6 +128,9 @@ private:
   ros::Timer timer_;
   double time_step_;
 
+  // Optional tick jitter/compute time/deadline miss statistics.
+  LoopTiming::Ptr timing_;
+
   // Spaces and dimensions.
   size_t control_dim_;
   size_t state_dim_;
@@ -161,6 +171,16 @@ private:
   // Are we in flight?
   bool in_flight_;
 
+  // Current control and bound value functions and when we started tracking
+  // with each of them.
+  bool have_control_value_id_;
+  ValueFunctionId control_value_id_;
+  double control_start_time_;
+
+  bool have_bound_value_id_;
+  ValueFunctionId bound_value_id_;
+  double bound_start_time_;
+
   // Is this class initialized?
   bool initialized_;
 
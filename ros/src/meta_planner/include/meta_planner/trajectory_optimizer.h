@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TrajectoryOptimizer class, which computes a smooth,
+// rest-to-rest trajectory between two points over a short horizon by
+// sequential convex programming.
+//
+// The model is a double integrator in each spatial dimension, discretized
+// exactly with a fixed time step, i.e. the linear system
+//     p_{k+1} = p_k + dt v_k + 0.5 dt^2 u_k,   v_{k+1} = v_k + dt u_k,
+// with the accelerations u_k as decision variables. The objective is the
+// total squared acceleration, subject to the terminal position and zero
+// terminal velocity, speed and acceleration limits, and the box bounds
+// shrunk by the tracking bound ("padding").
+//
+// Obstacles are spheres. Around the current iterate, each obstacle near a
+// knot point is replaced by the half-space through the sphere facing that
+// knot, shifted by the support of the padding box in that direction. This
+// is a conservative convex restriction, so the resulting quadratic program
+// is solved and the process repeated until the iterate stops changing. The
+// first iterate is the straight line, whose half-spaces face sideways so
+// that obstacles on the line are passed rather than blocking it. Padding
+// boxes also grow by the distance covered in half a step at top speed, so
+// the vehicle is clear between knots too.
+// Each QP is solved with a dense ADMM method (as in OSQP), warm-started
+// from the previous iterate, which is cheap at these problem sizes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_TRAJECTORY_OPTIMIZER_H
+#define META_PLANNER_TRAJECTORY_OPTIMIZER_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class TrajectoryOptimizer : private Uncopyable {
+public:
+  typedef std::shared_ptr<TrajectoryOptimizer> Ptr;
+  typedef std::shared_ptr<const TrajectoryOptimizer> ConstPtr;
+
+  ~TrajectoryOptimizer() {}
+
+  // Factory method. Use this instead of the constructor. 'horizon' is the
+  // number of time steps and 'time_scale' stretches the minimum time
+  // trajectory to leave room to go around obstacles.
+  static Ptr Create(size_t horizon, size_t max_iterations, double time_scale);
+
+  // Problem setup.
+  void SetBounds(const Vector3d& lower, const Vector3d& upper);
+  void SetLimits(const Vector3d& max_speed, const Vector3d& max_acceleration);
+  void SetPadding(const Vector3d& padding);
+  void SetObstacles(const std::vector<Vector3d>& centers,
+                    const std::vector<double>& radii);
+
+  // Obstacles only constrain knots whose padding box is closer than this.
+  void SetActivationDistance(double distance);
+
+  // Optimize a trajectory from start to stop, spending at most 'budget'
+  // seconds. On success, returns the horizon + 1 knot positions (starting
+  // at start and ending at stop) and the time step between them.
+  bool Optimize(const Vector3d& start, const Vector3d& stop, double budget,
+                std::vector<Vector3d>& positions, double& dt) const;
+
+private:
+  explicit TrajectoryOptimizer(size_t horizon, size_t max_iterations,
+                               double time_scale);
+
+  // Minimum time to go from rest to rest over this distance in the given
+  // dimension, under the speed and acceleration limits.
+  double MinimumTime(double distance, size_t dimension) const;
+
+  // Knot positions for the given accelerations.
+  std::vector<Vector3d> Positions(const Vector3d& start, const VectorXd& u,
+                                  double dt) const;
+
+  // Unit normal from the given obstacle's center towards this knot.
+  Vector3d KnotNormal(const Vector3d& position, size_t obstacle) const;
+
+  // Unit normal from the given obstacle towards this knot of a straight line
+  // with the given direction, perpendicular to the line. If the line runs
+  // through the center, picks a side.
+  Vector3d DetourNormal(const Vector3d& position, size_t obstacle,
+                        const Vector3d& direction) const;
+
+  // Distance from the given padding box around this point to the given
+  // obstacle (negative inside).
+  double Clearance(const Vector3d& position, size_t obstacle,
+                   const Vector3d& padding) const;
+
+  // Check that the given padding box around each knot clears every obstacle.
+  bool IsClear(const std::vector<Vector3d>& positions,
+               const Vector3d& padding) const;
+
+  // Solve min 0.5 x'Px + q'x s.t. l <= Ax <= u with ADMM, starting from
+  // (and returning in) x and y. Returns false if not converged.
+  static bool SolveQp(const MatrixXd& P, const VectorXd& q,
+                      const MatrixXd& A, const VectorXd& l,
+                      const VectorXd& u, VectorXd& x, VectorXd& y);
+
+  // Parameters.
+  const size_t horizon_;
+  const size_t max_iterations_;
+  const double time_scale_;
+  double activation_distance_;
+
+  // ADMM parameters.
+  static const size_t kMaxQpIterations;
+  static const double kQpTolerance;
+  static const double kRho;
+  static const double kSigma;
+  static const double kAlpha;
+
+  // Problem data.
+  Vector3d lower_;
+  Vector3d upper_;
+  Vector3d max_speed_;
+  Vector3d max_acceleration_;
+  Vector3d padding_;
+  std::vector<Vector3d> centers_;
+  std::vector<double> radii_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ValidityCache class, which memoizes Environment::IsValid
+// results keyed by (incoming, outgoing) value function pair and position
+// quantized to a fixed resolution. Every position in a quantization cell
+// shares one result, so callers must check the whole cell (see CellCenter)
+// for the result to be conservative. The resolution should be well below the
+// scale of obstacles and tracking bounds.
+//
+// Entries are tagged with the environment epoch they were computed in.
+// When the environment changes it bumps its epoch, and the next lookup or
+// insertion with the new epoch drops all old entries. The cache is also
+// dropped whenever it reaches its maximum size, which keeps memory bounded
+// without any bookkeeping on the lookup path.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_VALIDITY_CACHE_H
+#define META_PLANNER_VALIDITY_CACHE_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace meta {
+
+class ValidityCache : private Uncopyable {
+public:
+  typedef std::shared_ptr<ValidityCache> Ptr;
+  typedef std::shared_ptr<const ValidityCache> ConstPtr;
+
+  ~ValidityCache() {}
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create(double resolution, size_t max_entries);
+
+  // Look up the result for this position and planner pair computed during
+  // the given epoch. Returns false on a miss.
+  bool Lookup(const Vector3d& position, ValueFunctionId incoming_value,
+              ValueFunctionId outgoing_value, size_t epoch, bool& valid);
+
+  // Store a result computed during the given epoch.
+  void Insert(const Vector3d& position, ValueFunctionId incoming_value,
+              ValueFunctionId outgoing_value, size_t epoch, bool valid);
+
+  // Drop all entries and reset counters.
+  void Clear();
+
+  // Center of the quantization cell containing this position. Every
+  // position in the cell is within half the resolution of it on each axis.
+  Vector3d CellCenter(const Vector3d& position) const;
+
+  // Accessors.
+  size_t Size() const;
+  inline size_t NumHits() const { return hits_; }
+  inline size_t NumMisses() const { return misses_; }
+  inline double Resolution() const { return resolution_; }
+
+private:
+  explicit ValidityCache(double resolution, size_t max_entries);
+
+  // Key of a planner pair and quantized position.
+  struct Key {
+    ValueFunctionId incoming_value;
+    ValueFunctionId outgoing_value;
+    int64_t cell[3];
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  Key MakeKey(const Vector3d& position, ValueFunctionId incoming_value,
+              ValueFunctionId outgoing_value) const;
+
+  // Drop entries from an older epoch. Must hold the lock.
+  void SyncEpoch(size_t epoch);
+
+  const double resolution_;
+  const size_t max_entries_;
+
+  // Entries and the epoch they belong to, guarded by the mutex.
+  std::unordered_map<Key, bool, KeyHash> entries_;
+  size_t epoch_;
+  mutable std::mutex mutex_;
+
+  // Counters.
+  std::atomic<size_t> hits_;
+  std::atomic<size_t> misses_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the VoxelBox class, a Box whose obstacles are occupied voxels,
+// e.g. built up from depth measurements.
+//
+// Occupancy is stored in a sparse hierarchy of bit-packed 4 x 4 x 4 blocks.
+// A level 0 word holds one bit per voxel in its block. A level k word holds
+// one bit per level k-1 block, set iff that block has any occupied voxel,
+// so each level is a precomputed occupancy summary of the one below. Only
+// nonempty words are stored, so memory grows with the occupied volume and
+// not with the size of the box. A region query walks down from the single
+// root word and only visits blocks that intersect the region and are
+// occupied.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef META_PLANNER_VOXEL_BOX_H
+#define META_PLANNER_VOXEL_BOX_H
+
+#include <meta_planner/box.h>
+
+#include <ros/ros.h>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace meta {
+
+class VoxelBox : public Box {
+public:
+  typedef std::shared_ptr<VoxelBox> Ptr;
+  typedef std::shared_ptr<const VoxelBox> ConstPtr;
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create(double resolution);
+
+  // Destructor.
+  ~VoxelBox() {}
+
+  // Inherited collision checker from Box needs to be overwritten. The
+  // position is valid if the tracking bound around it is inside the box
+  // and does not touch any occupied voxel.
+  // Takes in incoming and outgoing value functions. See planner.h for details.
+  bool IsValid(const Vector3d& position,
+               ValueFunctionId incoming_value,
+               ValueFunctionId outgoing_value) const;
+
+  // Same as IsValid, but with a known tracking bound.
+  bool IsFree(const Vector3d& position, const Vector3d& bound) const;
+
+  // Check if the voxel containing the center of this spherical obstacle is
+  // occupied, and occupy every voxel the obstacle touches.
+  bool IsObstacle(const Vector3d& obstacle_position,
+                  double obstacle_radius) const;
+  void AddObstacle(const Vector3d& point, double r);
+
+  // Inherited visualizer from Box needs to be overwritten.
+  void Visualize(const ros::Publisher& pub, const std::string& frame_id) const;
+
+  // Set bounds in each dimension. Clears the occupancy grid, since voxel
+  // indices are relative to the lower bound.
+  void SetBounds(const Vector3d& lower, const Vector3d& upper);
+
+  // Mark the voxel containing this point as occupied. Returns true if the
+  // voxel was not already occupied. Points outside the box are ignored.
+  bool Insert(const Vector3d& point);
+
+  // Insert a whole point cloud. Returns the number of newly occupied voxels.
+  size_t Insert(const std::vector<Vector3d>& points);
+
+  // Check if any occupied voxel intersects the axis-aligned box
+  // [lower, upper].
+  bool IsOccupied(const Vector3d& lower, const Vector3d& upper) const;
+
+  // Clear all occupied voxels.
+  void Clear();
+
+  // Accessors.
+  inline double Resolution() const { return resolution_; }
+  inline size_t NumOccupied() const { return num_occupied_; }
+  size_t NumWords() const;
+
+private:
+  explicit VoxelBox(double resolution);
+
+  // Voxel containing this point, clamped to the grid.
+  Eigen::Vector3i Voxel(const Vector3d& point) const;
+
+  // Check if any occupied voxel in [lo, hi] (voxel indices) lies under the
+  // given node at the given level.
+  bool IsOccupied(size_t level, const Eigen::Vector3i& node,
+                  const Eigen::Vector3i& lo, const Eigen::Vector3i& hi) const;
+
+  // Hash key for a node and back, and bit for a child within its parent's
+  // word.
+  static uint64_t Key(const Eigen::Vector3i& node);
+  static Eigen::Vector3i Node(uint64_t key);
+  static uint64_t Bit(const Eigen::Vector3i& child);
+
+  // Mask of the children in [first, last] (coordinates within the block).
+  static uint64_t Mask(const Eigen::Vector3i& first,
+                       const Eigen::Vector3i& last);
+
+  // Voxel side length and number of voxels along each dimension.
+  const double resolution_;
+  Eigen::Vector3i num_voxels_;
+
+  // One map per level from node key to occupancy word. The top level has
+  // a single node covering the whole grid.
+  std::vector< std::unordered_map<uint64_t, uint64_t> > levels_;
+  size_t num_occupied_;
+
+  // Max number of voxels along a dimension, set by the key packing.
+  static const int kMaxVoxels;
+};
+
+} //\namespace meta
+
+#endif
@@ -40,6 +40,10 @@
 // finding the nearest k points, as well as the length (in time) of the
 // shortest path to the goal.
 //
+// To bound memory and nearest neighbor cost, the tree can be pruned of
+// dominated waypoints, i.e. those whose cost-to-come plus an optimistic
+// cost-to-go cannot beat the best trajectory found so far.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef META_PLANNER_WAYPOINT_TREE_H
@@ -53,6 +57,7 @@
 #include <iostream>
 #include <list>
 #include <limits>
+#include <functional>
 
 namespace meta {
 
@@ -84,7 +89,27 @@ public:
   // NOTE! Returns positive infinity if no valid trajectory exists.
   double BestTime() const;
 
+  // Remove dominated subtrees, given an optimistic (never overestimating)
+  // cost-to-go from any point to the goal. If 'max_size' is nonzero, also
+  // remove the least promising subtrees until at most 'max_size' waypoints
+  // remain. The root and the best trajectory are always kept. Returns the
+  // number of waypoints removed.
+  size_t Prune(const std::function<double(const Vector3d&)>& cost_to_go,
+               size_t max_size = 0);
+
+  // Root of the tree.
+  inline const Waypoint::ConstPtr& Root() const { return root_; }
+
+  // Best terminal waypoint, or null if the goal has not been reached.
+  inline const Waypoint::ConstPtr& Terminus() const { return terminus_; }
+
+  // Number of waypoints in the tree.
+  inline size_t Size() const { return kdtree_.Size(); }
+
 private:
+  // Time from the root to this waypoint.
+  double CostToCome(const Waypoint::ConstPtr& waypoint) const;
+
   // Root of the tree.
   Waypoint::ConstPtr root_;
 
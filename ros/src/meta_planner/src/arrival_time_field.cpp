@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ArrivalTimeField class, which computes the minimum time for a
+// Dubins car to reach a disc around a target point with the CCMotion fast
+// marching / fast sweeping solver.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/arrival_time_field.h>
+
+#include <ros/ros.h>
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+// CCMotion.cpp is a MATLAB MEX source. Build it without MATLAB, as the
+// benchmark does, and keep its C-style globals and helper macros out of the
+// global namespace. Standard headers must be included above this.
+namespace ccmotion {
+#define CCMOTION_STANDALONE
+#include "CCMotion.cpp"
+#undef CCMOTION_STANDALONE
+#undef min
+#undef max
+#undef abs
+#undef sgn
+} //\namespace ccmotion
+
+namespace meta {
+
+const double ArrivalTimeField::kNumInfinity = 1e6;
+const double ArrivalTimeField::kReachedTime = 0.5e6;
+
+std::mutex ArrivalTimeField::solver_mutex_;
+
+// Factory method. Use this instead of the constructor.
+ArrivalTimeField::Ptr ArrivalTimeField::Create(const Vector3d& target,
+                                               double half_width,
+                                               size_t num_cells,
+                                               size_t num_headings) {
+  ArrivalTimeField::Ptr ptr(
+    new ArrivalTimeField(target, half_width, num_cells, num_headings));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+ArrivalTimeField::ArrivalTimeField(const Vector3d& target, double half_width,
+                                   size_t num_cells, size_t num_headings)
+  : target_(target),
+    half_width_(half_width),
+    num_cells_(std::max<size_t>(3, num_cells)),
+    num_headings_(std::max<size_t>(4, num_headings)),
+    speed_(1.0),
+    turning_radius_(1.0),
+    target_radius_(0.0),
+    num_iterations_(0),
+    times_(num_cells_ * num_cells_ * num_headings_, kNumInfinity) {}
+
+// Compute arrival times for a car with the given speed and turning radius.
+bool ArrivalTimeField::Solve(const std::vector<bool>& free, double speed,
+                             double turning_radius, double target_radius,
+                             bool march, int method) {
+  if (free.size() != num_cells_ * num_cells_) {
+    ROS_ERROR("ArrivalTimeField: Free space mask has the wrong size.");
+    return false;
+  }
+
+  if (speed <= 0.0 || turning_radius <= 0.0) {
+    ROS_ERROR("ArrivalTimeField: Speed and turning radius must be positive.");
+    return false;
+  }
+
+  speed_ = speed;
+  turning_radius_ = turning_radius;
+  free_ = free;
+
+  // Make sure the target disc contains at least one node.
+  target_radius_ = std::max(target_radius, Resolution());
+
+  // Boundary condition, speed profile (zero in obstacles) and turning radius
+  // profile, in CCMotion's layout: arrays of pointers into our storage.
+  const size_t num_nodes = times_.size();
+  std::vector<double> next(num_nodes);
+  std::vector<double> speeds(num_nodes);
+  std::vector<double> radii(num_nodes, turning_radius_);
+  std::vector<int> nodes(num_nodes);
+  std::vector<int> controls(num_nodes);
+
+  bool target_free = false;
+  for (size_t ii = 0; ii < num_cells_; ii++) {
+    for (size_t jj = 0; jj < num_cells_; jj++) {
+      const size_t cell = ii * num_cells_ + jj;
+      const bool in_target =
+        (Point(ii, jj) - target_).head<2>().norm() <= target_radius_;
+      target_free |= in_target && free[cell];
+
+      for (size_t kk = 0; kk < num_headings_; kk++) {
+        const size_t idx = cell * num_headings_ + kk;
+        times_[idx] = (in_target && free[cell]) ? 0.0 : kNumInfinity;
+        next[idx] = times_[idx];
+        speeds[idx] = free[cell] ? speed_ : 0.0;
+      }
+    }
+  }
+
+  if (!target_free)
+    return false;
+
+  std::vector<double*> u_rows, next_rows, speed_rows, radius_rows;
+  std::vector<int*> node_rows, control_rows;
+  for (size_t cell = 0; cell < num_cells_ * num_cells_; cell++) {
+    const size_t idx = cell * num_headings_;
+    u_rows.push_back(&times_[idx]);
+    next_rows.push_back(&next[idx]);
+    speed_rows.push_back(&speeds[idx]);
+    radius_rows.push_back(&radii[idx]);
+    node_rows.push_back(&nodes[idx]);
+    control_rows.push_back(&controls[idx]);
+  }
+
+  std::vector<double**> u_planes, next_planes, speed_planes, radius_planes;
+  std::vector<int**> node_planes, control_planes;
+  for (size_t ii = 0; ii < num_cells_; ii++) {
+    const size_t row = ii * num_cells_;
+    u_planes.push_back(&u_rows[row]);
+    next_planes.push_back(&next_rows[row]);
+    speed_planes.push_back(&speed_rows[row]);
+    radius_planes.push_back(&radius_rows[row]);
+    node_planes.push_back(&node_rows[row]);
+    control_planes.push_back(&control_rows[row]);
+  }
+
+  const ccmotion::mwSize dims[3] = { num_cells_, num_cells_, num_headings_ };
+
+  std::lock_guard<std::mutex> lock(solver_mutex_);
+  ccmotion::ccmVerbose = 0;
+  num_iterations_ = static_cast<size_t>(ccmotion::CCM_solve(
+    u_planes.data(), next_planes.data(), speed_planes.data(),
+    radius_planes.data(), node_planes.data(), control_planes.data(), dims,
+    half_width_, kNumInfinity, 1, march ? 1 : 0, 1, method, method));
+
+  return true;
+}
+
+// Arrival time from this state, trilinearly interpolated over the reachable
+// corners. Infinite if outside the window, next to an obstacle node, or
+// unreachable.
+double ArrivalTimeField::Time(const Vector3d& position, double heading) const {
+  const double resolution = Resolution();
+  const double fi = (position(0) - target_(0) + half_width_) / resolution;
+  const double fj = (position(1) - target_(1) + half_width_) / resolution;
+  const double max_index = static_cast<double>(num_cells_ - 1);
+  if (fi < 0.0 || fj < 0.0 || fi > max_index || fj > max_index)
+    return std::numeric_limits<double>::infinity();
+
+  const double dth = 2.0 * M_PI / static_cast<double>(num_headings_);
+  double wrapped = std::fmod(heading, 2.0 * M_PI);
+  if (wrapped < 0.0)
+    wrapped += 2.0 * M_PI;
+  const double fk = wrapped / dth;
+
+  const size_t i0 = std::min(static_cast<size_t>(fi), num_cells_ - 2);
+  const size_t j0 = std::min(static_cast<size_t>(fj), num_cells_ - 2);
+  const long k0 = static_cast<long>(fk);
+  const double wi = fi - static_cast<double>(i0);
+  const double wj = fj - static_cast<double>(j0);
+  const double wk = fk - static_cast<double>(k0);
+
+  double total = 0.0;
+  double weight = 0.0;
+  for (size_t di = 0; di < 2; di++) {
+    for (size_t dj = 0; dj < 2; dj++) {
+      // Never interpolate across an obstacle.
+      if (!free_.empty() && !free_[(i0 + di) * num_cells_ + j0 + dj])
+        return std::numeric_limits<double>::infinity();
+
+      for (long dk = 0; dk < 2; dk++) {
+        const double value = Value(i0 + di, j0 + dj, k0 + dk);
+        if (value >= kReachedTime)
+          continue;
+
+        const double w = (di ? wi : 1.0 - wi) * (dj ? wj : 1.0 - wj) *
+          (dk ? wk : 1.0 - wk);
+        total += w * value;
+        weight += w;
+      }
+    }
+  }
+
+  if (weight <= 1e-12)
+    return std::numeric_limits<double>::infinity();
+
+  return total / weight;
+}
+
+// Heading with the smallest arrival time from this position.
+double ArrivalTimeField::BestHeading(const Vector3d& position) const {
+  const double dth = 2.0 * M_PI / static_cast<double>(num_headings_);
+
+  double best_heading = 0.0;
+  double best_time = std::numeric_limits<double>::infinity();
+  for (size_t kk = 0; kk < num_headings_; kk++) {
+    const double heading = static_cast<double>(kk) * dth;
+    const double time = Time(position, heading);
+    if (time < best_time) {
+      best_time = time;
+      best_heading = heading;
+    }
+  }
+
+  return best_heading;
+}
+
+// Descend the field from this state until within the target radius. At each
+// step, try turning either way or going straight for one step, and keep
+// whichever leaves the least time to go.
+bool ArrivalTimeField::ExtractPath(const Vector3d& start, double heading,
+                                   double dt,
+                                   std::vector<Vector3d>& positions) const {
+  positions.clear();
+  positions.push_back(start);
+
+  const double start_time = Time(start, heading);
+  if (std::isinf(start_time) || dt <= 0.0)
+    return false;
+
+  // Generous step limit, in case the path is longer than the field says.
+  const size_t max_steps =
+    static_cast<size_t>(std::ceil(2.0 * start_time / dt)) + 10;
+  const double turn = speed_ / turning_radius_ * dt;
+
+  Vector3d position = start;
+  for (size_t step = 0; step < max_steps; step++) {
+    if ((position - target_).head<2>().norm() <= target_radius_) {
+      positions.push_back(Vector3d(target_(0), target_(1), start(2)));
+      return true;
+    }
+
+    double best_time = std::numeric_limits<double>::infinity();
+    Vector3d best_position = position;
+    double best_heading = heading;
+    for (int direction = -1; direction <= 1; direction++) {
+      const double change = static_cast<double>(direction) * turn;
+      const double mid = heading + 0.5 * change;
+
+      const Vector3d next = position + speed_ * dt *
+        Vector3d(std::cos(mid), std::sin(mid), 0.0);
+      const double time = Time(next, heading + change);
+
+      // Prefer going straight on ties.
+      if (time < best_time - 1e-9 || (direction == 0 && time <= best_time)) {
+        best_time = time;
+        best_position = next;
+        best_heading = heading + change;
+      }
+    }
+
+    if (std::isinf(best_time))
+      return false;
+
+    position = best_position;
+    heading = best_heading;
+    positions.push_back(position);
+  }
+
+  return false;
+}
+
+// Grid node coordinates.
+Vector3d ArrivalTimeField::Point(size_t ii, size_t jj) const {
+  const double resolution = Resolution();
+  return Vector3d(target_(0) - half_width_ + resolution * ii,
+                  target_(1) - half_width_ + resolution * jj,
+                  target_(2));
+}
+
+// Value at a grid node, wrapping heading.
+double ArrivalTimeField::Value(size_t ii, size_t jj, long kk) const {
+  const long num_headings = static_cast<long>(num_headings_);
+  const size_t wrapped =
+    static_cast<size_t>(((kk % num_headings) + num_headings) % num_headings);
+  return times_[(ii * num_cells_ + jj) * num_headings_ + wrapped];
+}
+
+} //\namespace meta
@@ -38,7 +38,8 @@
 //
 // Defines a Box environment with spherical obstacles. For simplicity, this
 // does not bother with a kdtree index to speed up collision queries, since
-// it is only for a simulated demo.
+// it is only for a simulated demo. Moving obstacles are indexed, since
+// they are checked along every trajectory.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -54,7 +55,10 @@ BallsInBox::Ptr BallsInBox::Create() {
 
 // Constructor. Don't use this. Use the factory method instead.
 BallsInBox::BallsInBox()
-  : Box() {}
+  : Box(),
+    dynamic_obstacles_(DynamicObstacles::Create(1.0, 0.25)),
+    num_moving_markers_(0),
+    bounds_epoch_(0) {}
 
 // Inherited collision checker from Box needs to be overwritten.
 // Takes in incoming and outgoing value functions. See planner.h for details.
@@ -69,6 +73,64 @@ bool BallsInBox::IsValid(const Vector3d& position,
   }
 #endif
 
+  // Reuse the result of a recent check near this position.
+  const size_t epoch = Epoch();
+  bool valid = false;
+  if (LookupValidity(position, incoming_value, outgoing_value, epoch, valid))
+    return valid;
+
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, epoch, bound))
+    return false;
+
+  Vector3d checked_position = position;
+  CoverCacheCell(checked_position, bound);
+
+  valid = IsFree(checked_position, bound);
+  StoreValidity(position, incoming_value, outgoing_value, epoch, valid);
+
+  return valid;
+}
+
+// Time-aware collision checker. Also checks moving obstacles.
+bool BallsInBox::IsValidAt(const Vector3d& position, double time,
+                           ValueFunctionId incoming_value,
+                           ValueFunctionId outgoing_value) const {
+  if (!IsValid(position, incoming_value, outgoing_value))
+    return false;
+
+  if (dynamic_obstacles_->NumObstacles() == 0)
+    return true;
+
+  // IsValid has usually memoized the bound already.
+  Vector3d bound;
+  if (!SwitchingBound(incoming_value, outgoing_value, Epoch(), bound))
+    return false;
+
+  return dynamic_obstacles_->IsFree(position, bound, time);
+}
+
+// Switching tracking bound for a planner pair, memoized for the epoch.
+bool BallsInBox::SwitchingBound(ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value,
+                                size_t epoch, Vector3d& bound) const {
+  const std::pair<ValueFunctionId, ValueFunctionId> key(
+    incoming_value, outgoing_value);
+
+  {
+    std::lock_guard<std::mutex> lock(bounds_mutex_);
+    if (bounds_epoch_ != epoch) {
+      bounds_.clear();
+      bounds_epoch_ = epoch;
+    }
+
+    const auto iter = bounds_.find(key);
+    if (iter != bounds_.end()) {
+      bound = iter->second;
+      return true;
+    }
+  }
+
   // Make sure server is up.
   if (!switching_bound_srv_) {
     ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
@@ -80,27 +142,37 @@ bool BallsInBox::IsValid(const Vector3d& position,
     return false;
   }
 
-  // No obstacles. Just check bounds.
-  value_function::SwitchingTrackingBoundBox bound;
-  bound.request.from_id = incoming_value;
-  bound.request.to_id = outgoing_value;
-  if (!switching_bound_srv_.call(bound)) {
+  value_function::SwitchingTrackingBoundBox srv;
+  srv.request.from_id = incoming_value;
+  srv.request.to_id = outgoing_value;
+  if (!switching_bound_srv_.call(srv)) {
     ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
     return false;
   }
 
-  if (position(0) < lower_(0) + bound.response.x ||
-      position(0) > upper_(0) - bound.response.x ||
-      position(1) < lower_(1) + bound.response.y ||
-      position(1) > upper_(1) - bound.response.y ||
-      position(2) < lower_(2) + bound.response.z ||
-      position(2) > upper_(2) - bound.response.z)
+  bound = Vector3d(srv.response.x, srv.response.y, srv.response.z);
+
+  std::lock_guard<std::mutex> lock(bounds_mutex_);
+  if (bounds_epoch_ == epoch)
+    bounds_.insert({ key, bound });
+
+  return true;
+}
+
+// Check if a box of the given half-widths centered at the position lies
+// inside the bounds and clear of every obstacle. This is IsValid with the
+// tracking bound supplied by the caller, so it does not call any services.
+bool BallsInBox::IsFree(const Vector3d& position,
+                        const Vector3d& bound_vector) const {
+  if (position(0) < lower_(0) + bound_vector(0) ||
+      position(0) > upper_(0) - bound_vector(0) ||
+      position(1) < lower_(1) + bound_vector(1) ||
+      position(1) > upper_(1) - bound_vector(1) ||
+      position(2) < lower_(2) + bound_vector(2) ||
+      position(2) > upper_(2) - bound_vector(2))
     return false;
 
   // Check against each obstacle.
-  const Vector3d bound_vector(
-    bound.response.x, bound.response.y, bound.response.z);
-
   for (size_t ii = 0; ii < points_.size(); ii++) {
     const Vector3d& p = points_[ii];
 
@@ -150,6 +222,76 @@ bool BallsInBox::SenseObstacles(const Vector3d& position, double sensor_radius,
   return obstacle_positions.size() > 0;
 }
 
+// Cast rays from the origin along the given unit directions (one per row)
+// against the obstacles and the box walls.
+void BallsInBox::CastRays(const Vector3d& origin,
+                          const Eigen::MatrixX3d& directions,
+                          double max_range, VectorXd& ranges,
+                          Eigen::VectorXi& obstacles) const {
+  const Eigen::Index num_rays = directions.rows();
+  Eigen::ArrayXd range = Eigen::ArrayXd::Constant(num_rays, max_range);
+  Eigen::ArrayXi obstacle = Eigen::ArrayXi::Constant(num_rays, -1);
+
+  // Box walls. Rays start inside the box, so each ray leaves through the
+  // upper or lower slab in each dimension depending on its direction.
+  for (size_t jj = 0; jj < 3; jj++) {
+    const auto d = directions.col(jj).array();
+    const Eigen::ArrayXd exit = (d > 0.0).select(
+      (upper_(jj) - origin(jj)) / d,
+      (d < 0.0).select((lower_(jj) - origin(jj)) / d, max_range));
+
+    range = range.min(exit.max(0.0));
+  }
+
+  // Obstacles. For unit direction d and offset oc = origin - center, the
+  // nearest intersection is at t = -b - sqrt(b^2 - c), with b = d . oc and
+  // c = |oc|^2 - r^2.
+  const auto dx = directions.col(0).array();
+  const auto dy = directions.col(1).array();
+  const auto dz = directions.col(2).array();
+
+  Eigen::ArrayXd b(num_rays), discriminant(num_rays), t(num_rays);
+  Eigen::Array<bool, Eigen::Dynamic, 1> hit(num_rays);
+  for (size_t ii = 0; ii < points_.size(); ii++) {
+    const Vector3d oc = origin - points_[ii].head<3>();
+    const double distance = oc.norm();
+
+    // Skip obstacles out of range.
+    if (distance - radii_[ii] > max_range)
+      continue;
+
+    // Inside an obstacle, every ray hits immediately.
+    const double c = distance * distance - radii_[ii] * radii_[ii];
+    if (c <= 0.0) {
+      range.setZero();
+      obstacle.setConstant(static_cast<int>(ii));
+      break;
+    }
+
+    b = dx * oc(0) + dy * oc(1) + dz * oc(2);
+    discriminant = b.square() - c;
+    t = -b - discriminant.max(0.0).sqrt();
+    hit = (discriminant >= 0.0) && (t >= 0.0) && (t < range);
+
+    range = hit.select(t, range);
+    obstacle = hit.select(static_cast<int>(ii), obstacle);
+  }
+
+  ranges = range.matrix();
+  obstacles = obstacle.matrix();
+}
+
+// Get the position and radius of the obstacle with the given index.
+bool BallsInBox::GetObstacle(size_t idx, Vector3d& position,
+                             double& radius) const {
+  if (idx >= points_.size())
+    return false;
+
+  position = points_[idx];
+  radius = radii_[idx];
+  return true;
+}
+
 // Checks if a given obstacle is in the environment.
 bool BallsInBox::IsObstacle(const Vector3d& obstacle_position,
                             double obstacle_radius) const {
@@ -233,6 +375,59 @@ void BallsInBox::Visualize(const ros::Publisher& pub,
     pub.publish(sphere);
   }
 
+  // Visualize moving obstacles where they are now.
+  const double now = ros::Time::now().toSec();
+  for (size_t ii = 0; ii < dynamic_obstacles_->NumObstacles(); ii++) {
+    visualization_msgs::Marker sphere;
+    sphere.ns = "moving_sphere";
+    sphere.header.frame_id = frame_id;
+    sphere.header.stamp = ros::Time::now();
+    sphere.id = static_cast<int>(ii);
+    sphere.type = visualization_msgs::Marker::SPHERE;
+
+    Vector3d point;
+    double radius = 0.0;
+    if (dynamic_obstacles_->GetObstacle(ii, now, point, radius)) {
+      sphere.action = visualization_msgs::Marker::ADD;
+    } else {
+      sphere.action = visualization_msgs::Marker::DELETE;
+      point = Vector3d::Zero();
+    }
+
+    sphere.scale.x = 2.0 * radius;
+    sphere.scale.y = 2.0 * radius;
+    sphere.scale.z = 2.0 * radius;
+
+    sphere.color.a = 0.9;
+    sphere.color.r = 0.9;
+    sphere.color.g = 0.3;
+    sphere.color.b = 0.3;
+
+    geometry_msgs::Point p;
+    p.x = point(0);
+    p.y = point(1);
+    p.z = point(2);
+
+    sphere.pose.position = p;
+
+    // Publish sphere marker.
+    pub.publish(sphere);
+  }
+
+  // Delete markers of moving obstacles which have since been removed.
+  for (size_t ii = dynamic_obstacles_->NumObstacles();
+       ii < num_moving_markers_; ii++) {
+    visualization_msgs::Marker sphere;
+    sphere.ns = "moving_sphere";
+    sphere.header.frame_id = frame_id;
+    sphere.header.stamp = ros::Time::now();
+    sphere.id = static_cast<int>(ii);
+    sphere.action = visualization_msgs::Marker::DELETE;
+
+    pub.publish(sphere);
+  }
+
+  num_moving_markers_ = dynamic_obstacles_->NumObstacles();
 }
 
 // Add a spherical obstacle of the given radius to the environment.
@@ -246,6 +441,40 @@ void BallsInBox::AddObstacle(const Vector3d& point, double r) {
 
   points_.push_back(point);
   radii_.push_back(std::max(r, kSmallNumber));
+
+  BumpEpoch();
+}
+
+// Add a moving spherical obstacle at constant velocity. This does not
+// change the static environment, so the epoch is left alone.
+bool BallsInBox::AddDynamicObstacle(const Vector3d& point,
+                                    const Vector3d& velocity, double r,
+                                    double start_time, double end_time) {
+  return dynamic_obstacles_->Add(point, velocity, r, start_time, end_time);
+}
+
+// Add a moving spherical obstacle along a predicted track.
+bool BallsInBox::AddDynamicObstacle(const std::vector<double>& times,
+                                    const std::vector<Vector3d>& points,
+                                    double r) {
+  return dynamic_obstacles_->Add(times, points, r);
+}
+
+// Remove all moving obstacles.
+void BallsInBox::ClearDynamicObstacles() {
+  dynamic_obstacles_->Clear();
+}
+
+// Set the cell size and time resolution of the moving obstacle index.
+bool BallsInBox::SetDynamicObstacleResolution(double cell_size,
+                                              double time_resolution) {
+  const DynamicObstacles::Ptr obstacles =
+    DynamicObstacles::Create(cell_size, time_resolution);
+  if (obstacles == nullptr)
+    return false;
+
+  dynamic_obstacles_ = obstacles;
+  return true;
 }
 
 } //\namespace meta
@@ -84,6 +84,12 @@ bool Box::IsValid(const Vector3d& position,
   }
 #endif
 
+  // Reuse the result of a recent check near this position.
+  const size_t epoch = Epoch();
+  bool valid = false;
+  if (LookupValidity(position, incoming_value, outgoing_value, epoch, valid))
+    return valid;
+
   // Make sure server is up.
   if (!switching_bound_srv_) {
     ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
@@ -103,15 +109,37 @@ bool Box::IsValid(const Vector3d& position,
     return false;
   }
 
-  if (position(0) < lower_(0) + bound.response.x ||
-      position(0) > upper_(0) - bound.response.x ||
-      position(1) < lower_(1) + bound.response.y ||
-      position(1) > upper_(1) - bound.response.y ||
-      position(2) < lower_(2) + bound.response.z ||
-      position(2) > upper_(2) - bound.response.z)
-      return false;
+  Vector3d checked_position = position;
+  Vector3d bound_vector(bound.response.x, bound.response.y, bound.response.z);
+  CoverCacheCell(checked_position, bound_vector);
+
+  valid = IsFree(checked_position, bound_vector);
+  StoreValidity(position, incoming_value, outgoing_value, epoch, valid);
 
-  return true;
+  return valid;
+}
+
+// Same as IsValid, but with a known tracking bound. No obstacles, so just
+// check that the tracking bound around the position is inside the box.
+bool Box::IsFree(const Vector3d& position, const Vector3d& bound) const {
+  return !(position(0) < lower_(0) + bound(0) ||
+           position(0) > upper_(0) - bound(0) ||
+           position(1) < lower_(1) + bound(1) ||
+           position(1) > upper_(1) - bound(1) ||
+           position(2) < lower_(2) + bound(2) ||
+           position(2) > upper_(2) - bound(2));
+}
+
+// The plain box has no obstacles.
+bool Box::IsObstacle(const Vector3d& obstacle_position,
+                     double obstacle_radius) const {
+  return false;
+}
+
+// The plain box has no obstacles, so it cannot add any.
+void Box::AddObstacle(const Vector3d& point, double r) {
+  ROS_WARN_THROTTLE(1.0, "%s: This environment does not support obstacles.",
+                    name_.c_str());
 }
 
 // Inherited by Environment, but can be overwritten by child classes.
@@ -160,6 +188,8 @@ void Box::Visualize(const ros::Publisher& pub,
 void Box::SetBounds(const Vector3d& lower, const Vector3d& upper) {
   lower_ = lower;
   upper_ = upper;
+
+  BumpEpoch();
 }
 
 } //\namespace meta
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the CostToGoGrid class, which computes minimum travel times from
+// a single source to every cell of a grid with Dijkstra's algorithm.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/cost_to_go_grid.h>
+#include <utils/thread_pool.h>
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <math.h>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+CostToGoGrid::Ptr CostToGoGrid::Create(const Vector3d& lower,
+                                       const Vector3d& upper,
+                                       double resolution) {
+  CostToGoGrid::Ptr ptr(new CostToGoGrid(lower, upper, resolution));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+CostToGoGrid::CostToGoGrid(const Vector3d& lower, const Vector3d& upper,
+                           double resolution)
+  : lower_(lower),
+    resolution_(resolution),
+    source_(Vector3d::Zero()),
+    max_speed_(Vector3d::Ones()) {
+  size_t num_cells = 1;
+  for (size_t ii = 0; ii < 3; ii++) {
+    sizes_[ii] = std::max<size_t>(1, static_cast<size_t>(
+      std::ceil((upper(ii) - lower(ii)) / resolution_)));
+    num_cells *= sizes_[ii];
+  }
+
+  free_.assign(num_cells, false);
+  costs_.assign(num_cells, std::numeric_limits<double>::infinity());
+}
+
+// Compute times from the source to all cells.
+void CostToGoGrid::Compute(const Vector3d& source, const Vector3d& max_speed,
+                           const std::function<bool(const Vector3d&)>& is_free) {
+  source_ = source;
+  max_speed_ = max_speed;
+  costs_.assign(costs_.size(), std::numeric_limits<double>::infinity());
+
+  // Blocked cells. std::vector<bool> packs bits, so each task writes a
+  // separate byte-sized flag array which is then copied over.
+  std::vector<unsigned char> free(costs_.size(), 0);
+  ThreadPool::Shared().ParallelFor(0, costs_.size(), [&](size_t idx) {
+      free[idx] = is_free(CellCenter(idx)) ? 1 : 0;
+    }, 256);
+
+  for (size_t idx = 0; idx < free.size(); idx++)
+    free_[idx] = (free[idx] != 0);
+
+  size_t source_idx = 0;
+  if (!CellIndex(source, source_idx))
+    return;
+
+  // Dijkstra's algorithm from the source cell. The source itself is allowed
+  // to be blocked, e.g. if it is within a tracking bound of an obstacle.
+  typedef std::pair<double, size_t> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+
+  costs_[source_idx] = Time(CellCenter(source_idx) - source);
+  open.push(Entry(costs_[source_idx], source_idx));
+
+  const size_t stride_y = sizes_[0];
+  const size_t stride_z = sizes_[0] * sizes_[1];
+
+  while (!open.empty()) {
+    const Entry top = open.top();
+    open.pop();
+
+    const size_t idx = top.second;
+    if (top.first > costs_[idx])
+      continue;
+
+    const int ix = static_cast<int>(idx % sizes_[0]);
+    const int iy = static_cast<int>((idx / stride_y) % sizes_[1]);
+    const int iz = static_cast<int>(idx / stride_z);
+
+    for (int dz = -1; dz <= 1; dz++) {
+      const int jz = iz + dz;
+      if (jz < 0 || jz >= static_cast<int>(sizes_[2]))
+        continue;
+
+      for (int dy = -1; dy <= 1; dy++) {
+        const int jy = iy + dy;
+        if (jy < 0 || jy >= static_cast<int>(sizes_[1]))
+          continue;
+
+        for (int dx = -1; dx <= 1; dx++) {
+          const int jx = ix + dx;
+          if (jx < 0 || jx >= static_cast<int>(sizes_[0]) ||
+              (dx == 0 && dy == 0 && dz == 0))
+            continue;
+
+          const size_t neighbor = jx + jy * stride_y + jz * stride_z;
+          if (!free_[neighbor])
+            continue;
+
+          const double cost = top.first +
+            Time(resolution_ * Vector3d(dx, dy, dz));
+          if (cost < costs_[neighbor]) {
+            costs_[neighbor] = cost;
+            open.push(Entry(cost, neighbor));
+          }
+        }
+      }
+    }
+  }
+}
+
+// Time from the source to this point.
+double CostToGoGrid::Cost(const Vector3d& point) const {
+  size_t idx = 0;
+  if (!CellIndex(point, idx) || !free_[idx])
+    return std::numeric_limits<double>::infinity();
+
+  // Within the source cell, go straight there.
+  size_t source_idx = 0;
+  if (CellIndex(source_, source_idx) && idx == source_idx)
+    return Time(point - source_);
+
+  return costs_[idx] + Time(point - CellCenter(idx));
+}
+
+// Index of the cell containing this point.
+bool CostToGoGrid::CellIndex(const Vector3d& point, size_t& idx) const {
+  idx = 0;
+  size_t stride = 1;
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double offset = (point(ii) - lower_(ii)) / resolution_;
+    if (offset < 0.0 || offset >= static_cast<double>(sizes_[ii]))
+      return false;
+
+    idx += stride * static_cast<size_t>(offset);
+    stride *= sizes_[ii];
+  }
+
+  return true;
+}
+
+// Center of a cell.
+Vector3d CostToGoGrid::CellCenter(size_t idx) const {
+  Vector3d center;
+  for (size_t ii = 0; ii < 3; ii++) {
+    center(ii) = lower_(ii) + resolution_ * (0.5 + (idx % sizes_[ii]));
+    idx /= sizes_[ii];
+  }
+
+  return center;
+}
+
+// Travel time along a displacement.
+double CostToGoGrid::Time(const Vector3d& displacement) const {
+  double time = 0.0;
+  for (size_t ii = 0; ii < 3; ii++)
+    time = std::max(time, std::abs(displacement(ii)) / max_speed_(ii));
+
+  return time;
+}
+
+} //\namespace meta
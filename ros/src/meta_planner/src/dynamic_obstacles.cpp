@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the DynamicObstacles class, which holds spherical obstacles that
+// move over time and answers time-indexed collision queries against them.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/dynamic_obstacles.h>
+
+#include <algorithm>
+#include <math.h>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+DynamicObstacles::Ptr DynamicObstacles::Create(double cell_size,
+                                               double time_resolution) {
+  if (cell_size <= 0.0 || time_resolution <= 0.0) {
+    ROS_ERROR("DynamicObstacles: Cell size and time resolution must be "
+              "positive.");
+    return nullptr;
+  }
+
+  DynamicObstacles::Ptr ptr(new DynamicObstacles(cell_size, time_resolution));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+DynamicObstacles::DynamicObstacles(double cell_size, double time_resolution)
+  : cell_size_(cell_size),
+    time_resolution_(time_resolution),
+    first_segments_(1, 0),
+    max_speed_(0.0) {}
+
+// Add a sphere moving at constant velocity.
+bool DynamicObstacles::Add(const Vector3d& position, const Vector3d& velocity,
+                           double radius, double start_time,
+                           double end_time) {
+  if (radius <= 0.0 || !(start_time <= end_time)) {
+    ROS_ERROR("DynamicObstacles: Invalid obstacle.");
+    return false;
+  }
+
+  Insert({ start_time, end_time, position, velocity, radius });
+  first_segments_.push_back(segments_.size());
+  return true;
+}
+
+// Add a sphere following a predicted track.
+bool DynamicObstacles::Add(const std::vector<double>& times,
+                           const std::vector<Vector3d>& positions,
+                           double radius) {
+  if (radius <= 0.0 || times.empty() || times.size() != positions.size()) {
+    ROS_ERROR("DynamicObstacles: Invalid track.");
+    return false;
+  }
+
+  for (size_t ii = 1; ii < times.size(); ii++) {
+    if (!(times[ii - 1] < times[ii])) {
+      ROS_ERROR("DynamicObstacles: Track times must be increasing.");
+      return false;
+    }
+  }
+
+  // A single time stamp is a stationary sphere at that instant.
+  if (times.size() == 1)
+    Insert({ times[0], times[0], positions[0], Vector3d::Zero(), radius });
+
+  for (size_t ii = 1; ii < times.size(); ii++) {
+    const Vector3d velocity =
+      (positions[ii] - positions[ii - 1]) / (times[ii] - times[ii - 1]);
+    Insert({ times[ii - 1], times[ii], positions[ii - 1], velocity, radius });
+  }
+
+  first_segments_.push_back(segments_.size());
+  return true;
+}
+
+// Remove all obstacles.
+void DynamicObstacles::Clear() {
+  segments_.clear();
+  first_segments_.assign(1, 0);
+  index_.clear();
+  max_speed_ = 0.0;
+}
+
+// Check if a box of the given half-widths centered at the position is
+// clear of every obstacle at the given time.
+bool DynamicObstacles::IsFree(const Vector3d& position, const Vector3d& bound,
+                              double time) const {
+  if (segments_.empty())
+    return true;
+
+  const Vector3d lower = position - bound;
+  const Vector3d upper = position + bound;
+  const int64_t it = Quantize(time, time_resolution_);
+
+  const int64_t ix_lo = Quantize(lower(0), cell_size_);
+  const int64_t iy_lo = Quantize(lower(1), cell_size_);
+  const int64_t iz_lo = Quantize(lower(2), cell_size_);
+  const int64_t ix_hi = Quantize(upper(0), cell_size_);
+  const int64_t iy_hi = Quantize(upper(1), cell_size_);
+  const int64_t iz_hi = Quantize(upper(2), cell_size_);
+
+  for (int64_t ix = ix_lo; ix <= ix_hi; ix++) {
+    for (int64_t iy = iy_lo; iy <= iy_hi; iy++) {
+      for (int64_t iz = iz_lo; iz <= iz_hi; iz++) {
+        const auto cell = index_.find(Key(ix, iy, iz, it));
+        if (cell == index_.end())
+          continue;
+
+        for (const uint32_t idx : cell->second) {
+          const Segment& segment = segments_[idx];
+          if (time < segment.start_time || time > segment.end_time)
+            continue;
+
+          // Closest point in the box to the obstacle center.
+          const Vector3d center = segment.position +
+            (time - segment.start_time) * segment.velocity;
+          const Vector3d closest_point = center.cwiseMax(lower).cwiseMin(upper);
+
+          if ((closest_point - center).squaredNorm() <=
+              segment.radius * segment.radius)
+            return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+// Get the position of the obstacle with the given index at a time.
+bool DynamicObstacles::GetObstacle(size_t idx, double time,
+                                   Vector3d& position, double& radius) const {
+  if (idx >= NumObstacles())
+    return false;
+
+  for (size_t ii = first_segments_[idx]; ii < first_segments_[idx + 1]; ii++) {
+    const Segment& segment = segments_[ii];
+    if (time >= segment.start_time && time <= segment.end_time) {
+      position = segment.position +
+        (time - segment.start_time) * segment.velocity;
+      radius = segment.radius;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Add a segment to the current obstacle and to every cell it sweeps.
+void DynamicObstacles::Insert(const Segment& segment) {
+  const uint32_t idx = static_cast<uint32_t>(segments_.size());
+  segments_.push_back(segment);
+  max_speed_ = std::max(max_speed_, segment.velocity.norm());
+
+  // Within each time bucket the sphere sweeps the bounding box of its
+  // positions at either end of the bucket.
+  const int64_t it_lo = Quantize(segment.start_time, time_resolution_);
+  const int64_t it_hi = Quantize(segment.end_time, time_resolution_);
+  const Vector3d radius = Vector3d::Constant(segment.radius);
+
+  for (int64_t it = it_lo; it <= it_hi; it++) {
+    const double start_time =
+      std::max(segment.start_time, it * time_resolution_);
+    const double end_time =
+      std::min(segment.end_time, (it + 1) * time_resolution_);
+    const Vector3d start = segment.position +
+      (start_time - segment.start_time) * segment.velocity;
+    const Vector3d end = segment.position +
+      (end_time - segment.start_time) * segment.velocity;
+    const Vector3d lower = start.cwiseMin(end) - radius;
+    const Vector3d upper = start.cwiseMax(end) + radius;
+
+    for (int64_t ix = Quantize(lower(0), cell_size_);
+         ix <= Quantize(upper(0), cell_size_); ix++) {
+      for (int64_t iy = Quantize(lower(1), cell_size_);
+           iy <= Quantize(upper(1), cell_size_); iy++) {
+        for (int64_t iz = Quantize(lower(2), cell_size_);
+             iz <= Quantize(upper(2), cell_size_); iz++) {
+          std::vector<uint32_t>& cell = index_[Key(ix, iy, iz, it)];
+
+          // Neighboring buckets can alias to the same key.
+          if (cell.empty() || cell.back() != idx)
+            cell.push_back(idx);
+        }
+      }
+    }
+  }
+}
+
+// Cell or bucket containing a coordinate.
+int64_t DynamicObstacles::Quantize(double x, double size) {
+  return static_cast<int64_t>(floor(x / size));
+}
+
+// Key of a cell and bucket, 16 bits each.
+uint64_t DynamicObstacles::Key(int64_t ix, int64_t iy, int64_t iz,
+                               int64_t it) {
+  return ((static_cast<uint64_t>(ix) & 0xffff) << 48) |
+    ((static_cast<uint64_t>(iy) & 0xffff) << 32) |
+    ((static_cast<uint64_t>(iz) & 0xffff) << 16) |
+    (static_cast<uint64_t>(it) & 0xffff);
+}
+
+} //\namespace meta
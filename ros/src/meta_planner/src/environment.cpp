@@ -42,6 +42,9 @@
 
 #include <meta_planner/environment.h>
 
+#include <algorithm>
+#include <math.h>
+
 namespace meta {
 
 // Initialize this class from a ROS node.
@@ -69,6 +72,25 @@ bool Environment::LoadParameters(const ros::NodeHandle& n) {
   // Sensor radius.
   if (!nl.getParam("srv/switching_bound", switching_bound_name_)) return false;
 
+  // Validity cache.
+  bool cache_enabled = false;
+  double cache_resolution = 1e-3;
+  int cache_max_entries = 1000000;
+  nl.param("validity_cache/enabled", cache_enabled, false);
+  nl.param("validity_cache/resolution", cache_resolution, 1e-3);
+  nl.param("validity_cache/max_entries", cache_max_entries, 1000000);
+
+  if (cache_enabled) {
+    if (cache_resolution <= 0.0 || cache_max_entries <= 0) {
+      ROS_ERROR("%s: Validity cache resolution and size must be positive.",
+                name_.c_str());
+      return false;
+    }
+
+    EnableValidityCache(cache_resolution,
+                        static_cast<size_t>(cache_max_entries));
+  }
+
   return true;
 }
 
@@ -83,4 +105,68 @@ bool Environment::RegisterCallbacks(const ros::NodeHandle& n) {
   return true;
 }
 
+// Check straight-line motion between two positions over a time interval.
+bool Environment::IsMotionValid(const Vector3d& from, const Vector3d& to,
+                                double from_time, double to_time,
+                                double resolution,
+                                ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value) const {
+  if (resolution <= 0.0) {
+    ROS_ERROR("%s: Motion check resolution must be positive.", name_.c_str());
+    return false;
+  }
+
+  // Distance covered relative to the fastest obstacle.
+  const double distance = (to - from).norm() +
+    MaxObstacleSpeed() * std::abs(to_time - from_time);
+  const size_t num_steps = std::max<size_t>(
+    1, static_cast<size_t>(ceil(distance / resolution)));
+
+  for (size_t ii = 1; ii <= num_steps; ii++) {
+    const double fraction = static_cast<double>(ii) / num_steps;
+    if (!IsValidAt(from + fraction * (to - from),
+                   from_time + fraction * (to_time - from_time),
+                   incoming_value, outgoing_value))
+      return false;
+  }
+
+  return true;
+}
+
+// Memoize IsValid results at the given position resolution.
+void Environment::EnableValidityCache(double resolution, size_t max_entries) {
+  validity_cache_ = ValidityCache::Create(resolution, max_entries);
+}
+
+// Look up an IsValid result for the given epoch.
+bool Environment::LookupValidity(const Vector3d& position,
+                                 ValueFunctionId incoming_value,
+                                 ValueFunctionId outgoing_value,
+                                 size_t epoch, bool& valid) const {
+  if (validity_cache_ == nullptr)
+    return false;
+
+  return validity_cache_->Lookup(
+    position, incoming_value, outgoing_value, epoch, valid);
+}
+
+// Store an IsValid result for the given epoch.
+void Environment::StoreValidity(const Vector3d& position,
+                                ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value,
+                                size_t epoch, bool valid) const {
+  if (validity_cache_ != nullptr)
+    validity_cache_->Insert(
+      position, incoming_value, outgoing_value, epoch, valid);
+}
+
+// Grow a check to cover the whole cache cell containing this position.
+void Environment::CoverCacheCell(Vector3d& position, Vector3d& bound) const {
+  if (validity_cache_ == nullptr)
+    return;
+
+  position = validity_cache_->CellCenter(position);
+  bound += Vector3d::Constant(0.5 * validity_cache_->Resolution());
+}
+
 } //\namespace meta
@@ -46,7 +46,11 @@
 namespace meta {
 
 FlannTree::~FlannTree() {
-  // Free memory from points in the kdtree.
+  FreePoints();
+}
+
+// Free memory from points in the kdtree.
+void FlannTree::FreePoints() {
   if (index_ != nullptr) {
     for (size_t ii = 0; ii < index_->size(); ++ii) {
       double* point = index_->getPoint(ii);
@@ -151,4 +155,30 @@ FlannTree::RadiusSearch(Vector3d& query, double r) const {
   return neighbors;
 }
 
+// Remove all Waypoints for which the predicate is true, and rebuild the
+// index from the rest. Returns the number removed.
+size_t FlannTree::Remove(
+  const std::function<bool(const Waypoint::ConstPtr&)>& predicate) {
+  std::vector<Waypoint::ConstPtr> kept;
+  for (const auto& waypoint : registry_) {
+    if (!predicate(waypoint))
+      kept.push_back(waypoint);
+  }
+
+  const size_t num_removed = registry_.size() - kept.size();
+  if (num_removed == 0)
+    return 0;
+
+  // Start over with a fresh index. FLANN can mark points as removed, but
+  // they would still take up memory and search time.
+  FreePoints();
+  index_.reset();
+  registry_.clear();
+
+  for (const auto& waypoint : kept)
+    Insert(waypoint);
+
+  return num_removed;
+}
+
 } //\namespace meta
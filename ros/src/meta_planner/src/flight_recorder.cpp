@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the FlightRecorder class, which logs fixed-size records at full
+// control rate without perturbing the control loop.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/flight_recorder.h>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace meta {
+
+const char FlightRecorder::kMagic[8] = {
+  'M', 'E', 'T', 'A', 'F', 'D', 'R', '1' };
+const size_t FlightRecorder::kColumnNameLength;
+
+// Factory method. Opens the file and starts the background writer.
+FlightRecorder::Ptr FlightRecorder::Create(const std::string& file_name,
+                                           size_t capacity,
+                                           double flush_period,
+                                           Layout layout) {
+  FlightRecorder::Ptr ptr(
+    new FlightRecorder(file_name, capacity, flush_period, layout));
+
+  if (!ptr->file_.is_open()) {
+    ROS_ERROR("FlightRecorder: Could not open %s.", file_name.c_str());
+    return FlightRecorder::Ptr();
+  }
+
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+FlightRecorder::FlightRecorder(const std::string& file_name,
+                               size_t capacity, double flush_period,
+                               Layout layout)
+  : buffer_(capacity),
+    num_columns_((layout == EVENTS) ? NUM_EVENT_COLUMNS : NUM_COLUMNS),
+    file_(file_name.c_str(), std::ios::out | std::ios::binary),
+    flush_period_(flush_period),
+    stop_(false) {
+  if (!file_.is_open())
+    return;
+
+  batch_.reserve(buffer_.Capacity());
+  column_.reserve(buffer_.Capacity());
+
+  // Write header.
+  const uint32_t num_columns = static_cast<uint32_t>(num_columns_);
+  file_.write(kMagic, sizeof(kMagic));
+  file_.write(reinterpret_cast<const char*>(&num_columns),
+              sizeof(num_columns));
+
+  for (size_t ii = 0; ii < num_columns_; ii++) {
+    char name[kColumnNameLength];
+    memset(name, 0, kColumnNameLength);
+    strncpy(name, (layout == EVENTS) ?
+            ColumnName(static_cast<EventColumn>(ii)) :
+            ColumnName(static_cast<Column>(ii)),
+            kColumnNameLength - 1);
+    file_.write(name, kColumnNameLength);
+  }
+
+  thread_ = std::thread(&FlightRecorder::Run, this);
+}
+
+// Destructor flushes everything still queued and closes the file.
+FlightRecorder::~FlightRecorder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  stop_signal_.notify_all();
+
+  if (thread_.joinable())
+    thread_.join();
+
+  if (buffer_.Dropped() > 0)
+    ROS_WARN("FlightRecorder: Dropped %zu records.", buffer_.Dropped());
+}
+
+// Background writer loop.
+void FlightRecorder::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    stop_signal_.wait_for(
+      lock, std::chrono::duration<double>(flush_period_));
+
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+
+  // Final drain.
+  lock.unlock();
+  Flush();
+  file_.flush();
+}
+
+// Drain the ring buffer and write one block per batch.
+void FlightRecorder::Flush() {
+  batch_.clear();
+
+  Record record;
+  while (batch_.size() < buffer_.Capacity() && buffer_.Pop(record))
+    batch_.push_back(record);
+
+  if (batch_.empty())
+    return;
+
+  const uint32_t num_records = static_cast<uint32_t>(batch_.size());
+  file_.write(reinterpret_cast<const char*>(&num_records),
+              sizeof(num_records));
+
+  // Transpose into columns.
+  for (size_t ii = 0; ii < num_columns_; ii++) {
+    column_.clear();
+    for (size_t jj = 0; jj < batch_.size(); jj++)
+      column_.push_back(batch_[jj].values[ii]);
+
+    file_.write(reinterpret_cast<const char*>(column_.data()),
+                column_.size() * sizeof(double));
+  }
+}
+
+// Name of a column.
+const char* FlightRecorder::ColumnName(Column column) {
+  switch (column) {
+  case TIME: return "time";
+  case STATE_X: return "x";
+  case STATE_Y: return "y";
+  case STATE_Z: return "z";
+  case STATE_VX: return "x_dot";
+  case STATE_VY: return "y_dot";
+  case STATE_VZ: return "z_dot";
+  case REF_X: return "ref_x";
+  case REF_Y: return "ref_y";
+  case REF_Z: return "ref_z";
+  case REF_VX: return "ref_x_dot";
+  case REF_VY: return "ref_y_dot";
+  case REF_VZ: return "ref_z_dot";
+  case PITCH: return "pitch";
+  case ROLL: return "roll";
+  case THRUST: return "thrust";
+  case PRIORITY: return "priority";
+  case CONTROL_VALUE_ID: return "control_value_id";
+  case BOUND_VALUE_ID: return "bound_value_id";
+  default: return "unknown";
+  }
+}
+
+// Name of a planner event column.
+const char* FlightRecorder::ColumnName(EventColumn column) {
+  switch (column) {
+  case EVENT_TIME: return "time";
+  case EVENT_TYPE: return "event";
+  case EVENT_X: return "x";
+  case EVENT_Y: return "y";
+  case EVENT_Z: return "z";
+  case EVENT_VALUE_ID: return "value_id";
+  case EVENT_DURATION: return "duration";
+  default: return "unknown";
+  }
+}
+
+// Read a log file back into memory, one vector per column.
+bool FlightRecorder::Read(const std::string& file_name,
+                          std::vector<std::string>& names,
+                          std::vector< std::vector<double> >& columns) {
+  std::ifstream file(file_name.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    ROS_ERROR("FlightRecorder: Could not open %s.", file_name.c_str());
+    return false;
+  }
+
+  // Header.
+  char magic[sizeof(kMagic)];
+  uint32_t num_columns = 0;
+  if (!file.read(magic, sizeof(magic)) ||
+      memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !file.read(reinterpret_cast<char*>(&num_columns),
+                 sizeof(num_columns))) {
+    ROS_ERROR("FlightRecorder: %s is not a flight log.", file_name.c_str());
+    return false;
+  }
+
+  names.clear();
+  columns.clear();
+  columns.resize(num_columns);
+  for (size_t ii = 0; ii < num_columns; ii++) {
+    char name[kColumnNameLength];
+    if (!file.read(name, kColumnNameLength)) {
+      ROS_ERROR("FlightRecorder: Truncated header in %s.", file_name.c_str());
+      return false;
+    }
+
+    name[kColumnNameLength - 1] = '\0';
+    names.push_back(std::string(name));
+  }
+
+  // Blocks. A truncated final block (e.g. after a crash) is discarded.
+  uint32_t num_records = 0;
+  while (file.read(reinterpret_cast<char*>(&num_records),
+                   sizeof(num_records))) {
+    std::vector< std::vector<double> > block(num_columns);
+    for (size_t ii = 0; ii < num_columns; ii++) {
+      block[ii].resize(num_records);
+      if (!file.read(reinterpret_cast<char*>(block[ii].data()),
+                     num_records * sizeof(double))) {
+        ROS_WARN("FlightRecorder: Discarding truncated block in %s.",
+                 file_name.c_str());
+        return true;
+      }
+    }
+
+    for (size_t ii = 0; ii < num_columns; ii++)
+      columns[ii].insert(columns[ii].end(), block[ii].begin(), block[ii].end());
+  }
+
+  return true;
+}
+
+} //\namespace meta
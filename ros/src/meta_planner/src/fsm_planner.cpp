@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the FsmPlanner class, which inherits from the Planner abstract
+// class and plans Dubins car paths with the CCMotion solver.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/fsm_planner.h>
+
+#include <chrono>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+Planner::Ptr FsmPlanner::Create(ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value,
+                                const Box::ConstPtr& space,
+                                const Dynamics::ConstPtr& dynamics) {
+  Planner::Ptr ptr(new FsmPlanner(incoming_value, outgoing_value,
+                                  space, dynamics));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+FsmPlanner::FsmPlanner(ValueFunctionId incoming_value,
+                       ValueFunctionId outgoing_value,
+                       const Box::ConstPtr& space,
+                       const Dynamics::ConstPtr& dynamics)
+  : Planner(incoming_value, outgoing_value, space, dynamics),
+    cache_epoch_(0),
+    solve_time_(0.0) {}
+
+// Plan a trajectory between two points.
+Trajectory::Ptr FsmPlanner::Plan(const Vector3d& start, const Vector3d& stop,
+                                 double start_time, double budget) const {
+  const std::chrono::steady_clock::time_point begin =
+    std::chrono::steady_clock::now();
+
+  // Check that both start and stop are in bounds. The time we reach the
+  // stop is not known yet, so it is only checked against static obstacles.
+  if (!space_->IsValidAt(start, start_time, incoming_value_, outgoing_value_)) {
+    ROS_WARN_THROTTLE(1.0, "Start point was in collision or out of bounds.");
+    return nullptr;
+  }
+
+  if (!space_->IsValid(stop, incoming_value_, outgoing_value_)) {
+    ROS_WARN_THROTTLE(1.0, "Stop point was in collision or out of bounds.");
+    return nullptr;
+  }
+
+  // The start must be inside the window around the stop point.
+  if ((start - stop).head<2>().lpNorm<Eigen::Infinity>() >= half_width_) {
+    ROS_WARN_THROTTLE(1.0, "%s: Start point is too far from stop point.",
+                      name_.c_str());
+    return nullptr;
+  }
+
+  // Look up limits once, so that the field and path are checked locally
+  // against the environment rather than with a server call per point.
+  Vector3d max_speed, bound;
+  if (!GetLimits(max_speed, bound))
+    return nullptr;
+
+  const double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - begin).count();
+  const ArrivalTimeField::ConstPtr field =
+    GetField(stop, max_speed, bound, budget - elapsed);
+  if (field == nullptr)
+    return nullptr;
+
+  // Descend the field in steps of half a cell.
+  const double dt = 0.5 * field->Resolution() / field->Speed();
+  std::vector<Vector3d> positions;
+  if (!field->ExtractPath(start, field->BestHeading(start), dt, positions)) {
+    ROS_WARN_THROTTLE(1.0, "%s: FSM planner could not compute a solution.",
+                      name_.c_str());
+    return nullptr;
+  }
+
+  // Interpolate altitude, and time each step at the Dubins speed (or
+  // slower, if climbing or the final step onto the stop point need it).
+  std::vector<double> times;
+  std::vector<ValueFunctionId> values;
+  double time = start_time;
+  for (size_t ii = 0; ii < positions.size(); ii++) {
+    const double fraction = (positions.size() > 1) ?
+      static_cast<double>(ii) / static_cast<double>(positions.size() - 1) :
+      1.0;
+    positions[ii](2) = start(2) + fraction * (stop(2) - start(2));
+
+    if (!space_->IsFree(positions[ii], bound)) {
+      ROS_WARN_THROTTLE(1.0, "%s: FSM path left free space.", name_.c_str());
+      return nullptr;
+    }
+
+    if (ii > 0) {
+      const Vector3d delta = positions[ii] - positions[ii - 1];
+      time += std::max(dt, delta.cwiseAbs().cwiseQuotient(max_speed)
+                       .maxCoeff());
+    }
+
+    times.push_back(time);
+    values.push_back(incoming_value_);
+  }
+
+  // The field only knows about static obstacles, so check the path against
+  // moving obstacles at the time each step is flown.
+  for (size_t ii = 1; ii < positions.size(); ii++) {
+    if (!space_->IsMotionValid(positions[ii - 1], positions[ii],
+                               times[ii - 1], times[ii], field->Resolution(),
+                               incoming_value_, outgoing_value_)) {
+      ROS_WARN_THROTTLE(1.0, "%s: FSM path collides with a moving obstacle.",
+                        name_.c_str());
+      return nullptr;
+    }
+  }
+
+  // Convert to full state space. Make sure to use the INCOMING VALUE!
+  std::vector<VectorXd> full_states =
+    dynamics_->LiftGeometricTrajectory(positions, times);
+  return Trajectory::Create(times, full_states, values, values);
+}
+
+// Get the arrival time field to this stop point, from the cache if possible.
+ArrivalTimeField::ConstPtr FsmPlanner::
+GetField(const Vector3d& stop, const Vector3d& max_speed,
+         const Vector3d& bound, double budget) const {
+  const std::chrono::steady_clock::time_point begin =
+    std::chrono::steady_clock::now();
+
+  // The car must respect the planner speed in both horizontal dimensions.
+  const double speed = std::min(max_speed(0), max_speed(1));
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+
+  // Drop all fields if the environment has changed.
+  const size_t epoch = space_->Epoch();
+  if (epoch != cache_epoch_) {
+    cache_.clear();
+    cache_epoch_ = epoch;
+  }
+
+  for (auto iter = cache_.begin(); iter != cache_.end(); iter++) {
+    if ((*iter)->Target() == stop && (*iter)->Speed() == speed) {
+      cache_.splice(cache_.begin(), cache_, iter);
+      return cache_.front();
+    }
+  }
+
+  // Rasterize the environment around the stop point, at its altitude.
+  const ArrivalTimeField::Ptr field = ArrivalTimeField::Create(
+    stop, half_width_, static_cast<size_t>(num_cells_),
+    static_cast<size_t>(num_headings_));
+
+  std::vector<bool> free(field->NumCells() * field->NumCells());
+  for (size_t ii = 0; ii < field->NumCells(); ii++) {
+    for (size_t jj = 0; jj < field->NumCells(); jj++) {
+      free[ii * field->NumCells() + jj] =
+        space_->IsFree(field->Point(ii, jj), bound);
+    }
+  }
+
+  // The solver cannot be interrupted, so don't start it unless the last
+  // solve would have fit in what is left of the budget.
+  const double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - begin).count();
+  if (elapsed + solve_time_ > budget) {
+    ROS_WARN_THROTTLE(1.0, "%s: Not enough time to compute a FSM field.",
+                      name_.c_str());
+    return nullptr;
+  }
+
+  const std::chrono::steady_clock::time_point solve_begin =
+    std::chrono::steady_clock::now();
+  const bool solved = field->Solve(free, speed, turning_radius_,
+                                   target_radius_, march_, method_);
+  solve_time_ = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - solve_begin).count();
+
+  if (!solved) {
+    ROS_WARN_THROTTLE(1.0, "%s: Stop point is blocked at grid resolution.",
+                      name_.c_str());
+    return nullptr;
+  }
+
+  cache_.push_front(field);
+  while (cache_.size() > static_cast<size_t>(cache_size_))
+    cache_.pop_back();
+
+  return field;
+}
+
+// Query this planner's max speed and switching tracking bound.
+bool FsmPlanner::GetLimits(Vector3d& max_speed, Vector3d& bound) const {
+  // Make sure servers are up.
+  if (!max_speed_srv_) {
+    ROS_WARN("%s: Max planner speed server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    max_speed_srv_ = nl.serviceClient<value_function::GeometricPlannerSpeed>(
+      max_speed_name_.c_str(), true);
+    return false;
+  }
+
+  if (!switching_bound_srv_) {
+    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    switching_bound_srv_ =
+      nl.serviceClient<value_function::SwitchingTrackingBoundBox>(
+        switching_bound_name_.c_str(), true);
+    return false;
+  }
+
+  value_function::GeometricPlannerSpeed s;
+  s.request.id = incoming_value_;
+  if (!max_speed_srv_.call(s)) {
+    ROS_ERROR("%s: Error calling max planner speed server.", name_.c_str());
+    return false;
+  }
+
+  max_speed = Vector3d(s.response.x, s.response.y, s.response.z);
+  if (max_speed.minCoeff() <= 0.0) {
+    ROS_ERROR("%s: Max planner speed must be positive.", name_.c_str());
+    return false;
+  }
+
+  value_function::SwitchingTrackingBoundBox b;
+  b.request.from_id = incoming_value_;
+  b.request.to_id = outgoing_value_;
+  if (!switching_bound_srv_.call(b)) {
+    ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
+    return false;
+  }
+
+  bound = Vector3d(b.response.x, b.response.y, b.response.z);
+  return true;
+}
+
+// Load all parameters.
+bool FsmPlanner::LoadParameters(const ros::NodeHandle& n) {
+  if (!Planner::LoadParameters(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Service names.
+  if (!nl.getParam("srv/switching_bound", switching_bound_name_))
+    return false;
+  nl.param("srv/max_planner_speed", max_speed_name_,
+           std::string("/max_planner_speed"));
+
+  // Solver settings.
+  nl.param("fsm/half_width", half_width_, 3.0);
+  nl.param("fsm/num_cells", num_cells_, 31);
+  nl.param("fsm/num_headings", num_headings_, 24);
+  nl.param("fsm/turning_radius", turning_radius_, 0.5);
+  nl.param("fsm/target_radius", target_radius_, 0.0);
+  nl.param("fsm/march", march_, true);
+  nl.param("fsm/method", method_, 0);
+  nl.param("fsm/cache_size", cache_size_, 8);
+
+  if (half_width_ <= 0.0 || turning_radius_ <= 0.0) {
+    ROS_ERROR("%s: FSM window and turning radius must be positive.",
+              name_.c_str());
+    return false;
+  }
+
+  if (num_cells_ < 3 || num_headings_ < 4) {
+    ROS_ERROR("%s: FSM grid needs at least 3 cells and 4 headings.",
+              name_.c_str());
+    return false;
+  }
+
+  if (method_ < 0 || method_ > 2) {
+    ROS_ERROR("%s: FSM method must be 0 (semi-Lagrangian), "
+              "1 (finite difference) or 2 (both).", name_.c_str());
+    return false;
+  }
+
+  if (cache_size_ < 1)
+    cache_size_ = 1;
+
+  return true;
+}
+
+// Register all callbacks and publishers.
+bool FsmPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
+  if (!Planner::RegisterCallbacks(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Servers.
+  max_speed_srv_ = nl.serviceClient<value_function::GeometricPlannerSpeed>(
+    max_speed_name_.c_str(), true);
+  switching_bound_srv_ =
+    nl.serviceClient<value_function::SwitchingTrackingBoundBox>(
+      switching_bound_name_.c_str(), true);
+
+  return true;
+}
+
+} //\namespace meta
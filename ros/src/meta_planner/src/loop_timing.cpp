@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the LoopTiming class, which records start jitter, compute time,
+// and deadline misses of a periodic control loop.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/loop_timing.h>
+
+#include <algorithm>
+
+namespace meta {
+
+const size_t LoopTiming::kNumBuckets;
+
+// Factory method. Use this instead of the constructor.
+LoopTiming::Ptr LoopTiming::Create(double period) {
+  LoopTiming::Ptr ptr(new LoopTiming(period));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+LoopTiming::LoopTiming(double period)
+  : period_(period) {
+  Reset();
+}
+
+// Clear all counters. Atomics are not zero-initialized by default.
+void LoopTiming::Reset() {
+  ticks_.store(0);
+  misses_.store(0);
+
+  for (Histogram* histogram : { &jitter_, &compute_ }) {
+    histogram->total_ns.store(0);
+    histogram->max_ns.store(0);
+
+    for (size_t ii = 0; ii < kNumBuckets; ii++)
+      histogram->buckets[ii].store(0);
+  }
+}
+
+// Record a tick which started 'jitter' seconds after it was scheduled and
+// took 'compute' seconds to run.
+void LoopTiming::RecordTick(double jitter, double compute) {
+  ticks_.fetch_add(1, std::memory_order_relaxed);
+
+  // The tick was due to finish before the next one is scheduled.
+  if (std::max(0.0, jitter) + std::max(0.0, compute) > period_)
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+  Record(jitter_, jitter);
+  Record(compute_, compute);
+}
+
+// Add a value to a histogram.
+void LoopTiming::Record(Histogram& histogram, double seconds) {
+  const uint64_t ns = static_cast<uint64_t>(std::max(0.0, seconds) * 1e9);
+
+  histogram.total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+  // Atomic max.
+  uint64_t previous_max = histogram.max_ns.load(std::memory_order_relaxed);
+  while (ns > previous_max &&
+         !histogram.max_ns.compare_exchange_weak(previous_max, ns))
+    ;
+
+  // Bucket index is the bit length of the value in microseconds.
+  uint64_t us = ns / 1000;
+  size_t bucket = 0;
+  while (us > 0 && bucket < kNumBuckets - 1) {
+    us >>= 1;
+    bucket++;
+  }
+
+  histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Accessors.
+size_t LoopTiming::NumTicks() const {
+  return ticks_.load(std::memory_order_relaxed);
+}
+
+size_t LoopTiming::NumDeadlineMisses() const {
+  return misses_.load(std::memory_order_relaxed);
+}
+
+size_t LoopTiming::JitterBucket(size_t ii) const {
+  if (ii >= kNumBuckets)
+    return 0;
+
+  return jitter_.buckets[ii].load(std::memory_order_relaxed);
+}
+
+size_t LoopTiming::ComputeBucket(size_t ii) const {
+  if (ii >= kNumBuckets)
+    return 0;
+
+  return compute_.buckets[ii].load(std::memory_order_relaxed);
+}
+
+// Mean and max (seconds).
+double LoopTiming::MeanJitter() const {
+  const size_t ticks = NumTicks();
+  if (ticks == 0)
+    return 0.0;
+
+  return 1e-9 * static_cast<double>(
+    jitter_.total_ns.load(std::memory_order_relaxed)) / ticks;
+}
+
+double LoopTiming::MaxJitter() const {
+  return 1e-9 * static_cast<double>(
+    jitter_.max_ns.load(std::memory_order_relaxed));
+}
+
+double LoopTiming::MeanCompute() const {
+  const size_t ticks = NumTicks();
+  if (ticks == 0)
+    return 0.0;
+
+  return 1e-9 * static_cast<double>(
+    compute_.total_ns.load(std::memory_order_relaxed)) / ticks;
+}
+
+double LoopTiming::MaxCompute() const {
+  return 1e-9 * static_cast<double>(
+    compute_.max_ns.load(std::memory_order_relaxed));
+}
+
+// Upper edge (seconds) of the bucket containing the given quantile.
+double LoopTiming::JitterQuantile(double quantile) const {
+  return Quantile(jitter_, quantile);
+}
+
+double LoopTiming::ComputeQuantile(double quantile) const {
+  return Quantile(compute_, quantile);
+}
+
+double LoopTiming::Quantile(const Histogram& histogram,
+                            double quantile) const {
+  const size_t ticks = NumTicks();
+  if (ticks == 0)
+    return 0.0;
+
+  const double target = std::max(0.0, std::min(1.0, quantile)) * ticks;
+
+  size_t cumulative = 0;
+  for (size_t ii = 0; ii < kNumBuckets; ii++) {
+    cumulative += histogram.buckets[ii].load(std::memory_order_relaxed);
+    if (static_cast<double>(cumulative) >= target)
+      return BucketUpperEdge(ii);
+  }
+
+  return 1e-9 * static_cast<double>(
+    histogram.max_ns.load(std::memory_order_relaxed));
+}
+
+// Upper edge (seconds) of the given bucket.
+double LoopTiming::BucketUpperEdge(size_t ii) {
+  return 1e-6 * static_cast<double>(1 << std::min(ii, kNumBuckets - 1));
+}
+
+} //\namespace meta
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the MetaGraph class, which holds candidate connections between
+// sampled points for lazy meta planning.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/meta_graph.h>
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace meta {
+
+const size_t MetaGraph::kStartNode = 0;
+const size_t MetaGraph::kGoalNode = 1;
+
+// The start is reached at time zero.
+MetaGraph::MetaGraph(const Vector3d& start, const Vector3d& goal,
+                     double radius, size_t max_neighbors,
+                     const CostFunction& optimistic_cost)
+  : radius_(radius),
+    max_neighbors_(max_neighbors),
+    optimistic_cost_(optimistic_cost) {
+  points_.push_back(start);
+  points_.push_back(goal);
+  edges_.resize(2);
+  cost_to_come_.push_back(0.0);
+  cost_to_come_.push_back(std::numeric_limits<double>::infinity());
+}
+
+// Add a node and connect it to its nearest neighbors within the radius.
+size_t MetaGraph::AddNode(const Vector3d& point) {
+  const size_t node = points_.size();
+
+  // Linear scan. Nodes are only added when they could improve on the best
+  // trajectory, so the graph stays small.
+  std::vector< std::pair<double, size_t> > neighbors;
+  for (size_t ii = 0; ii < node; ii++) {
+    const double distance = (points_[ii] - point).norm();
+    if (distance <= radius_)
+      neighbors.push_back(std::make_pair(distance, ii));
+  }
+
+  if (neighbors.size() > max_neighbors_) {
+    std::nth_element(neighbors.begin(), neighbors.begin() + max_neighbors_,
+                     neighbors.end());
+    neighbors.resize(max_neighbors_);
+  }
+
+  points_.push_back(point);
+  edges_.resize(node + 1);
+  cost_to_come_.push_back(std::numeric_limits<double>::infinity());
+
+  for (const auto& neighbor : neighbors) {
+    const size_t other = neighbor.second;
+    Connect(other, node, optimistic_cost_(points_[other], point));
+  }
+
+  return node;
+}
+
+// Mark a node as reached at the given time from the start.
+void MetaGraph::SetReached(size_t node, double cost_to_come) {
+  if (node != kGoalNode)
+    cost_to_come_[node] = cost_to_come;
+}
+
+bool MetaGraph::IsReached(size_t node) const {
+  return cost_to_come_[node] < std::numeric_limits<double>::infinity();
+}
+
+// Remove the edge between these nodes from the search.
+void MetaGraph::RemoveEdge(size_t from, size_t to) {
+  std::vector<Edge>& edges = edges_[from];
+  edges.erase(std::remove_if(edges.begin(), edges.end(),
+                             [to](const Edge& e) { return e.to_ == to; }),
+              edges.end());
+}
+
+// A* search from all reached nodes to the goal. The optimistic cost to the
+// goal is an admissible and consistent heuristic, since the optimistic cost
+// itself satisfies the triangle inequality.
+double MetaGraph::BestPath(std::vector<size_t>& path) const {
+  path.clear();
+
+  const size_t kNoParent = std::numeric_limits<size_t>::max();
+  std::vector<double> costs(cost_to_come_);
+  std::vector<size_t> parents(points_.size(), kNoParent);
+  std::vector<bool> closed(points_.size(), false);
+
+  typedef std::pair<double, size_t> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > open;
+
+  const Vector3d& goal = points_[kGoalNode];
+  for (size_t ii = 0; ii < points_.size(); ii++)
+    if (IsReached(ii))
+      open.push(Entry(costs[ii] + optimistic_cost_(points_[ii], goal), ii));
+
+  while (!open.empty()) {
+    const size_t node = open.top().second;
+    open.pop();
+
+    if (closed[node])
+      continue;
+
+    closed[node] = true;
+    if (node == kGoalNode)
+      break;
+
+    for (const auto& edge : edges_[node]) {
+      if (IsReached(edge.to_) || closed[edge.to_])
+        continue;
+
+      const double cost = costs[node] + edge.cost_;
+      if (cost < costs[edge.to_]) {
+        costs[edge.to_] = cost;
+        parents[edge.to_] = node;
+        open.push(Entry(cost + optimistic_cost_(points_[edge.to_], goal),
+                        edge.to_));
+      }
+    }
+  }
+
+  if (!closed[kGoalNode])
+    return std::numeric_limits<double>::infinity();
+
+  for (size_t node = kGoalNode; node != kNoParent; node = parents[node])
+    path.push_back(node);
+
+  std::reverse(path.begin(), path.end());
+  return costs[kGoalNode];
+}
+
+// Total number of edges in the search.
+size_t MetaGraph::NumEdges() const {
+  size_t num_edges = 0;
+  for (const auto& edges : edges_)
+    num_edges += edges.size();
+
+  return num_edges;
+}
+
+// Add an edge in each direction, except into the start or out of the goal.
+// The start and goal are never connected directly, as in MetaPlanner::Plan.
+void MetaGraph::Connect(size_t from, size_t to, double cost) {
+  if (to != kStartNode && from != kGoalNode) {
+    Edge edge;
+    edge.to_ = to;
+    edge.cost_ = cost;
+    edges_[from].push_back(edge);
+  }
+
+  if (from != kStartNode && to != kGoalNode) {
+    Edge edge;
+    edge.to_ = from;
+    edge.cost_ = cost;
+    edges_[to].push_back(edge);
+  }
+}
+
+} //\namespace meta
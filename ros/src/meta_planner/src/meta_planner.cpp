@@ -43,6 +43,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <meta_planner/meta_planner.h>
+#include <utils/thread_pool.h>
 
 #include <ompl/util/Console.h>
 
@@ -79,9 +80,32 @@ bool MetaPlanner::Initialize(const ros::NodeHandle& n) {
   dynamics_ = NearHoverQuadNoYaw::Create(control_lower_vec, control_upper_vec);
 
   // Initialize state space.
-  space_ = BallsInBox::Create();
+  if (environment_type_ == "voxel_box") {
+    space_ = VoxelBox::Create(voxel_resolution_);
+  } else if (environment_type_ == "tiled_box") {
+    tiles_ = TiledBox::Create(tile_file_, tile_active_radius_);
+    if (!tiles_->IsLoaded()) {
+      ROS_ERROR("%s: Failed to load tiles from %s.", name_.c_str(),
+                tile_file_.c_str());
+      return false;
+    }
+
+    space_ = tiles_;
+  } else {
+    balls_ = BallsInBox::Create();
+    space_ = balls_;
+  }
+
   if (!space_->Initialize(n)) {
-    ROS_ERROR("%s: Failed to initialize BallsInBox.", name_.c_str());
+    ROS_ERROR("%s: Failed to initialize %s.", name_.c_str(),
+              environment_type_.c_str());
+    return false;
+  }
+
+  if (balls_ != nullptr &&
+      !balls_->SetDynamicObstacleResolution(dynamic_cell_size_,
+                                            dynamic_time_resolution_)) {
+    ROS_ERROR("%s: Failed to set up moving obstacles.", name_.c_str());
     return false;
   }
 
@@ -98,10 +122,24 @@ bool MetaPlanner::Initialize(const ros::NodeHandle& n) {
 
   space_->Seed(seed_);
 
+  // Sampling and collision checking are restricted to active tiles.
+  if (tiles_ != nullptr)
+    UpdateActiveTiles();
+
+  // Cost-to-go grid for time to goal estimates, over the same bounds.
+  cost_to_go_ = CostToGoGrid::Create(dynamics_->Puncture(state_lower_vec),
+                                     dynamics_->Puncture(state_upper_vec),
+                                     eta_resolution_);
+
   // Create planners.
   for (ValueFunctionId ii = 0; ii < num_value_functions_ - 1; ii += 2) {
-    const Planner::Ptr planner =
-      OmplPlanner<og::BITstar>::Create(ii, ii + 1, space_, dynamics_);
+    Planner::Ptr planner;
+    if (planner_type_ == "mpc")
+      planner = MpcPlanner::Create(ii, ii + 1, balls_, dynamics_);
+    else if (planner_type_ == "fsm")
+      planner = FsmPlanner::Create(ii, ii + 1, space_, dynamics_);
+    else
+      planner = OmplPlanner<og::BITstar>::Create(ii, ii + 1, space_, dynamics_);
 
     if (!planner->Initialize(n)) {
       ROS_ERROR("%s: Failed to initialize planner.", name_.c_str());
@@ -136,6 +174,25 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("max_connection_radius", max_connection_radius_))
     return false;
 
+  int prune_interval = 0;
+  int max_tree_size = 0;
+  nl.param("prune_interval", prune_interval, 0);
+  nl.param("max_tree_size", max_tree_size, 0);
+  prune_interval_ = static_cast<size_t>(std::max(prune_interval, 0));
+  max_tree_size_ = static_cast<size_t>(std::max(max_tree_size, 0));
+
+  // Size-triggered pruning keeps 3/4 of the cap, which must be nonzero.
+  if (max_tree_size_ == 1) {
+    ROS_ERROR("%s: Max tree size must be 0 (no cap) or at least 2.",
+              name_.c_str());
+    return false;
+  }
+
+  int lazy_max_neighbors = 10;
+  nl.param("lazy", lazy_, false);
+  nl.param("lazy_max_neighbors", lazy_max_neighbors, 10);
+  lazy_max_neighbors_ = static_cast<size_t>(std::max(lazy_max_neighbors, 1));
+
   int dimension = 1;
   if (!nl.getParam("control/dim", dimension)) return false;
   control_dim_ = static_cast<size_t>(dimension);
@@ -161,6 +218,43 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
     return false;
   }
 
+  nl.param("planners/type", planner_type_, std::string("bitstar"));
+  if (planner_type_ != "bitstar" && planner_type_ != "mpc" &&
+      planner_type_ != "fsm") {
+    ROS_ERROR("%s: Unknown planner type %s.", name_.c_str(),
+              planner_type_.c_str());
+    return false;
+  }
+
+  // Environment parameters.
+  nl.param("environment/type", environment_type_,
+           std::string("balls_in_box"));
+  nl.param("environment/voxel_resolution", voxel_resolution_, 0.1);
+  nl.param("environment/active_radius", tile_active_radius_, 5.0);
+  if (environment_type_ != "balls_in_box" &&
+      environment_type_ != "voxel_box" &&
+      environment_type_ != "tiled_box") {
+    ROS_ERROR("%s: Unknown environment type %s.", name_.c_str(),
+              environment_type_.c_str());
+    return false;
+  }
+
+  if (voxel_resolution_ <= 0.0 || tile_active_radius_ <= 0.0) {
+    ROS_ERROR("%s: Voxel resolution and active radius must be positive.",
+              name_.c_str());
+    return false;
+  }
+
+  if (environment_type_ == "tiled_box" &&
+      !nl.getParam("environment/tile_file", tile_file_)) return false;
+
+  // The MPC planner checks obstacles directly.
+  if (planner_type_ == "mpc" && environment_type_ != "balls_in_box") {
+    ROS_ERROR("%s: The mpc planner requires a balls_in_box environment.",
+              name_.c_str());
+    return false;
+  }
+
   // State space parameters.
   if (!nl.getParam("state/dim", dimension)) return false;
   state_dim_ = static_cast<size_t>(dimension);
@@ -181,6 +275,44 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("srv/switching_time", switching_time_name_)) return false;
   if (!nl.getParam("srv/switching_distance", switching_distance_name_))
     return false;
+  nl.param("srv/max_planner_speed", max_speed_name_,
+           std::string("/max_planner_speed"));
+  nl.param("srv/estimate_time_to_goal", eta_name_,
+           std::string("/estimate_time_to_goal"));
+
+  // Time to goal estimation.
+  nl.param("eta/resolution", eta_resolution_, 0.25);
+  if (eta_resolution_ <= 0.0) {
+    ROS_ERROR("%s: Time to goal grid resolution must be positive.",
+              name_.c_str());
+    return false;
+  }
+
+  // Moving obstacles.
+  nl.param("dynamic_obstacles/horizon", dynamic_horizon_, 2.0);
+  nl.param("dynamic_obstacles/cell_size", dynamic_cell_size_, 1.0);
+  nl.param("dynamic_obstacles/time_resolution",
+           dynamic_time_resolution_, 0.25);
+  nl.param("dynamic_obstacles/check_resolution",
+           dynamic_check_resolution_, 0.05);
+  if (dynamic_horizon_ <= 0.0 || dynamic_cell_size_ <= 0.0 ||
+      dynamic_time_resolution_ <= 0.0 || dynamic_check_resolution_ <= 0.0) {
+    ROS_ERROR("%s: Moving obstacle parameters must be positive.",
+              name_.c_str());
+    return false;
+  }
+
+  // Optional planner event recorder.
+  bool record = false;
+  nl.param("recorder/enabled", record, false);
+  if (record) {
+    if (!nl.getParam("recorder/file", recorder_file_)) return false;
+
+    recorder_ = FlightRecorder::Create(recorder_file_, 1 << 12, 0.5,
+                                       FlightRecorder::EVENTS);
+    if (!recorder_)
+      return false;
+  }
 
   // Topics and frame ids.
   if (!nl.getParam("topics/sensor", sensor_topic_)) return false;
@@ -190,6 +322,8 @@ bool MetaPlanner::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("topics/request_traj", request_traj_topic_)) return false;
   if (!nl.getParam("topics/trigger_replan", trigger_replan_topic_)) return false;
   if (!nl.getParam("topics/in_flight", in_flight_topic_)) return false;
+  nl.param("topics/value_functions_reloaded", values_reloaded_topic_,
+           std::string("/value_functions_reloaded"));
 
   if (!nl.getParam("frames/fixed", fixed_frame_id_)) return false;
 
@@ -213,6 +347,12 @@ bool MetaPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
   switching_distance_srv_ = nl.serviceClient<value_function::GuaranteedSwitchingDistance>(
     switching_distance_name_.c_str(), true);
 
+  max_speed_srv_ = nl.serviceClient<value_function::GeometricPlannerSpeed>(
+    max_speed_name_.c_str(), true);
+
+  eta_srv_ = nl.advertiseService(
+    eta_name_.c_str(), &MetaPlanner::EstimateTimeToGoalCallback, this);
+
   // Subscribers.
   sensor_sub_ = nl.subscribe(
     sensor_topic_.c_str(), 1, &MetaPlanner::SensorCallback, this);
@@ -226,6 +366,10 @@ bool MetaPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
   in_flight_sub_ = nl.subscribe(
     in_flight_topic_.c_str(), 1, &MetaPlanner::InFlightCallback, this);
 
+  values_reloaded_sub_ = nl.subscribe(
+    values_reloaded_topic_.c_str(), 1,
+    &MetaPlanner::ValueFunctionsReloadedCallback, this);
+
   // Visualization publisher(s).
   env_pub_ = nl.advertise<visualization_msgs::Marker>(
     env_topic_.c_str(), 1, false);
@@ -249,6 +393,41 @@ StateCallback(const crazyflie_msgs::PositionStateStamped::ConstPtr& msg) {
   position_(2) = msg->state.z;
 
   been_updated_ = true;
+
+  // Keep the active tiles around the vehicle and the current trajectory.
+  // Updating invalidates cached collision checks, so only do it once we
+  // have moved a good part of a tile or have a new trajectory.
+  if (tiles_ != nullptr &&
+      (traj_ != tiles_traj_ ||
+       (position_ - tiles_position_).norm() > 0.5 * tiles_->TileSize()))
+    UpdateActiveTiles();
+}
+
+// Update the active tiles of a TiledBox environment around the vehicle and
+// along the corridor to the goal through the current trajectory.
+void MetaPlanner::UpdateActiveTiles() {
+  std::vector<Vector3d> corridor;
+  corridor.push_back(position_);
+
+  if (traj_ != nullptr && !traj_->IsEmpty()) {
+    const double now = ros::Time::now().toSec();
+    for (const double time : traj_->Times()) {
+      if (time > now)
+        corridor.push_back(dynamics_->Puncture(traj_->GetState(time)));
+    }
+  }
+
+  corridor.push_back(goal_);
+
+  const size_t num_loaded = tiles_->UpdateActive(position_, corridor);
+  tiles_position_ = position_;
+  tiles_traj_ = traj_;
+
+  // Obstacles may have come into or out of view.
+  cost_to_go_valid_ = false;
+
+  if (num_loaded > 0)
+    space_->Visualize(env_pub_, fixed_frame_id_);
 }
 
 // Callback for processing sensor measurements. Replan trajectory.
@@ -257,7 +436,22 @@ SensorCallback(const meta_planner_msgs::SensorMeasurement::ConstPtr& msg) {
   if (!in_flight_)
     return;
 
+  const double now = ros::Time::now().toSec();
+  // Only BallsInBox tracks moving obstacles. Other environments treat every
+  // obstacle as static where it was sensed, which is conservative. Movers
+  // are flagged by the sensor, so one which is momentarily still is not
+  // mistaken for part of the static map.
+  const bool have_velocities = balls_ != nullptr &&
+    msg->velocities.size() == msg->num_obstacles &&
+    msg->moving.size() == msg->num_obstacles;
+
+  // Moving obstacles are reported on every measurement, so forget the old
+  // predictions.
+  if (have_velocities)
+    balls_->ClearDynamicObstacles();
+
   bool unseen_obstacle = false;
+  bool moving_obstacle = false;
 
   for (size_t ii = 0; ii < msg->num_obstacles; ii++) {
     const double radius = msg->radii[ii];
@@ -265,6 +459,17 @@ SensorCallback(const meta_planner_msgs::SensorMeasurement::ConstPtr& msg) {
                          msg->positions[ii].y,
                          msg->positions[ii].z);
 
+    if (have_velocities && msg->moving[ii]) {
+      const Vector3d velocity(msg->velocities[ii].x,
+                              msg->velocities[ii].y,
+                              msg->velocities[ii].z);
+
+      balls_->AddDynamicObstacle(point, velocity, radius,
+                                 now, now + dynamic_horizon_);
+      moving_obstacle = true;
+      continue;
+    }
+
     // Check if our version of the map has already seen this point.
     if (!(space_->IsObstacle(point, radius))) {
       space_->AddObstacle(point, radius);
@@ -273,12 +478,191 @@ SensorCallback(const meta_planner_msgs::SensorMeasurement::ConstPtr& msg) {
   }
 
   if (unseen_obstacle) {
+    // Time to goal estimates are stale.
+    cost_to_go_valid_ = false;
+
     // Trigger a replan.
     trigger_replan_pub_.publish(std_msgs::Empty());
+  } else if (moving_obstacle && traj_ != nullptr && !reached_goal_ &&
+             !IsValid(traj_, now)) {
+    // Moving obstacles don't change the map, so only replan if one now
+    // crosses the current trajectory.
+    trigger_replan_pub_.publish(std_msgs::Empty());
+  }
 
-    // Publish environment.
+  // Publish environment.
+  if (unseen_obstacle || moving_obstacle)
     space_->Visualize(env_pub_, fixed_frame_id_);
+}
+
+// Callback for value function server reloads.
+void MetaPlanner::ValueFunctionsReloadedCallback(
+  const meta_planner_msgs::ValueFunctionsReloaded::ConstPtr& msg) {
+  if (msg->num_values != num_value_functions_) {
+    ROS_ERROR("%s: Value function server now has %zu value functions, "
+              "but planners were set up for %zu.", name_.c_str(),
+              static_cast<size_t>(msg->num_values), num_value_functions_);
+    return;
+  }
+
+  ROS_INFO("%s: Value functions reloaded (generation %zu).",
+           name_.c_str(), static_cast<size_t>(msg->generation));
+
+  // Speeds and bounds may have changed.
+  have_planner_limits_ = false;
+  cost_to_go_valid_ = false;
+  space_->BumpEpoch();
+
+  // The trajectory we last sent was planned against the old bounds.
+  if (in_flight_ && !reached_goal_)
+    trigger_replan_pub_.publish(std_msgs::Empty());
+}
+
+// Check the remainder of a trajectory after the given time. Moving
+// obstacles are only predicted over the horizon, so the check stops there.
+// Each piece is checked with the value functions it is flown with.
+bool MetaPlanner::IsValid(const Trajectory::ConstPtr& traj,
+                          double start_time) const {
+  if (traj == nullptr || traj->IsEmpty())
+    return true;
+
+  const std::vector<double> times = traj->Times();
+  const double end_time = std::min(start_time + dynamic_horizon_,
+                                   times.back());
+  double time = std::max(start_time, times.front());
+  if (time > end_time)
+    return true;
+
+  Vector3d position = dynamics_->Puncture(traj->GetState(time));
+  if (!space_->IsValidAt(position, time, traj->GetBoundValueFunction(time),
+                         traj->GetControlValueFunction(time)))
+    return false;
+
+  for (size_t ii = 0; ii < times.size() && time < end_time; ii++) {
+    if (times[ii] <= time)
+      continue;
+
+    const double next_time = std::min(times[ii], end_time);
+    const Vector3d next_position =
+      dynamics_->Puncture(traj->GetState(next_time));
+    if (!space_->IsMotionValid(position, next_position, time, next_time,
+                               dynamic_check_resolution_,
+                               traj->GetBoundValueFunction(time),
+                               traj->GetControlValueFunction(time)))
+      return false;
+
+    position = next_position;
+    time = next_time;
+  }
+
+  return true;
+}
+
+// Service callback estimating time to reach each of a batch of goals.
+bool MetaPlanner::EstimateTimeToGoalCallback(
+  meta_planner_msgs::EstimateTimeToGoal::Request& req,
+  meta_planner_msgs::EstimateTimeToGoal::Response& res) {
+  if (!initialized_) {
+    ROS_ERROR("%s: MetaPlanner was not initialized.", name_.c_str());
+    return false;
+  }
+
+  if (!have_planner_limits_ && !UpdatePlannerLimits())
+    return false;
+
+  // Recompute the cost-to-go grid if obstacles changed or we have moved
+  // more than half a cell since it was computed.
+  if (!cost_to_go_valid_ ||
+      (position_ - cost_to_go_->Source()).cwiseAbs().maxCoeff() >
+      0.5 * cost_to_go_->Resolution()) {
+    const Vector3d bound = min_tracking_bound_;
+    const Box::ConstPtr space = space_;
+    cost_to_go_->Compute(position_, max_planner_speed_,
+                         [&space, &bound](const Vector3d& point) {
+                           return space->IsFree(point, bound); });
+    cost_to_go_valid_ = true;
+  }
+
+  // Evaluate all goals in parallel. Each only reads the grid.
+  const size_t num_goals = req.goals.size();
+  res.lower_bounds.resize(num_goals);
+  res.estimates.resize(num_goals);
+
+  ThreadPool::Shared().ParallelFor(0, num_goals, [&](size_t ii) {
+      const Vector3d goal(req.goals[ii].x, req.goals[ii].y, req.goals[ii].z);
+
+      const double lower_bound = OptimisticTime(position_, goal);
+      res.lower_bounds[ii] = lower_bound;
+      res.estimates[ii] = std::max(lower_bound, cost_to_go_->Cost(goal));
+    }, 16);
+
+  return true;
+}
+
+// Query max speeds and tracking bounds over all planners.
+bool MetaPlanner::UpdatePlannerLimits() {
+  // Make sure servers are up.
+  if (!max_speed_srv_) {
+    ROS_WARN("%s: Max planner speed server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    max_speed_srv_ = nl.serviceClient<value_function::GeometricPlannerSpeed>(
+      max_speed_name_.c_str(), true);
+    return false;
   }
+
+  if (!bound_srv_) {
+    ROS_WARN("%s: Tracking bound server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    bound_srv_ = nl.serviceClient<value_function::TrackingBoundBox>(
+      bound_name_.c_str(), true);
+    return false;
+  }
+
+  max_planner_speed_ = Vector3d::Zero();
+  min_tracking_bound_ = Vector3d::Constant(std::numeric_limits<double>::infinity());
+
+  for (const auto& planner : planners_) {
+    value_function::GeometricPlannerSpeed s;
+    s.request.id = planner->GetIncomingValueFunction();
+    if (!max_speed_srv_.call(s)) {
+      ROS_ERROR("%s: Error calling max planner speed server.", name_.c_str());
+      return false;
+    }
+
+    value_function::TrackingBoundBox b;
+    b.request.id = planner->GetIncomingValueFunction();
+    b.request.time = -1.0;
+    if (!bound_srv_.call(b)) {
+      ROS_ERROR("%s: Error calling tracking bound server.", name_.c_str());
+      return false;
+    }
+
+    max_planner_speed_ = max_planner_speed_.cwiseMax(
+      Vector3d(s.response.x, s.response.y, s.response.z));
+    min_tracking_bound_ = min_tracking_bound_.cwiseMin(
+      Vector3d(b.response.x, b.response.y, b.response.z));
+  }
+
+  if (max_planner_speed_.minCoeff() <= 0.0) {
+    ROS_ERROR("%s: Max planner speed must be positive.", name_.c_str());
+    return false;
+  }
+
+  have_planner_limits_ = true;
+  return true;
+}
+
+// Optimistic travel time between two points at the max planner speed.
+double MetaPlanner::OptimisticTime(const Vector3d& start,
+                                   const Vector3d& stop) const {
+  double time = 0.0;
+  for (size_t ii = 0; ii < 3; ii++)
+    time = std::max(time, std::abs(stop(ii) - start(ii)) /
+                    max_planner_speed_(ii));
+
+  return time;
 }
 
 // Callback to handle requests for new trajectory.
@@ -317,6 +701,7 @@ void MetaPlanner::RequestTrajectoryCallback(
 
   value_function::TrackingBoundBox b;
   b.request.id = planners_.back()->GetOutgoingValueFunction();
+  b.request.time = -1.0;
   if (!bound_srv_.call(b))
     ROS_ERROR("%s: Error calling tracking bound server.", name_.c_str());
   else {
@@ -391,13 +776,28 @@ void MetaPlanner::RequestTrajectoryCallback(
     return;
   }
 
+  const ValueFunctionId start_value = (traj_ == nullptr) ?
+    planners_.back()->GetOutgoingValueFunction() :
+    traj_->GetBoundValueFunction(start_time);
+
   if (!Plan(start_position, goal_, start_time)) {
     ROS_ERROR("%s: MetaPlanner failed. Please come again.", name_.c_str());
+    RecordEvent(FlightRecorder::REPLAN_FAILED, current_time.toSec(),
+                start_position, start_value,
+                (ros::Time::now() - current_time).toSec());
     return;
   }
 
   ROS_INFO("%s: MetaPlanner succeeded after %2.5f seconds.",
            name_.c_str(), (ros::Time::now() - current_time).toSec());
+  RecordEvent(FlightRecorder::REPLAN, current_time.toSec(),
+              start_position, start_value,
+              (ros::Time::now() - current_time).toSec());
+
+  const ValidityCache::ConstPtr cache = space_->GetValidityCache();
+  if (cache != nullptr)
+    ROS_INFO("%s: Validity cache has %zu hits and %zu misses so far.",
+             name_.c_str(), cache->NumHits(), cache->NumMisses());
 }
 
 // Plan a trajectory using the given (ordered) list of Planners.
@@ -414,6 +814,9 @@ bool MetaPlanner::Plan(const Vector3d& start, const Vector3d& stop,
   if (!been_updated_)
     return false;
 
+  if (lazy_)
+    return PlanLazy(start, stop, start_time);
+
   // (1) Set up a new RRT-like structure to hold the meta plan.
   const ros::Time current_time = ros::Time::now();
   const ValueFunctionId start_value = (traj_ == nullptr) ?
@@ -422,18 +825,38 @@ bool MetaPlanner::Plan(const Vector3d& start, const Vector3d& stop,
 
   WaypointTree tree(start, start_value, start_time);
 
+  // Optimistic time between two points at the max speed over all planners,
+  // for pruning. This is computed locally rather than with a server call per
+  // sample. If the planner limits are unavailable, assume zero so that
+  // nothing is pruned.
+  const bool have_limits = have_planner_limits_ || UpdatePlannerLimits();
+  const auto optimistic_time = [&](const Vector3d& from, const Vector3d& to) {
+    return (have_limits) ? OptimisticTime(from, to) : 0.0;
+  };
+
+  const auto cost_to_go = [&](const Vector3d& point) {
+    return optimistic_time(point, stop);
+  };
+
   bool found = false;
+  size_t num_iterations = 0;
   while ((ros::Time::now() - current_time).toSec() < max_runtime_) {
+    // Prune waypoints which can no longer lead to a faster trajectory. When
+    // over the size cap, prune down to 3/4 of it so that we don't rebuild
+    // the kdtree on every insertion.
+    num_iterations++;
+    if ((prune_interval_ > 0 && num_iterations % prune_interval_ == 0) ||
+        (max_tree_size_ > 0 && tree.Size() > max_tree_size_))
+      tree.Prune(cost_to_go, (3 * max_tree_size_) / 4);
+
     // (2) Sample a new point in the state space.
     Vector3d sample = space_->Sample();
 
     // Throw out this sample if it could never lead to a faster trajectory than
     // the best one currently.
-    // NOTE! This test assumes that the first planner is the fastest.
     // NOTE! If no valid trajectory has been found, the tree's best time will
     // be infinite, so this test will automatically fail.
-    if (planners_.front()->BestPossibleTime(start, sample) +
-        planners_.front()->BestPossibleTime(sample, stop) > tree.BestTime())
+    if (optimistic_time(start, sample) + cost_to_go(sample) > tree.BestTime())
       continue;
 
     // (3) Find the nearest neighbor.
@@ -446,197 +869,364 @@ bool MetaPlanner::Plan(const Vector3d& start, const Vector3d& stop,
         (neighbors[0]->point_ - sample).norm() > max_connection_radius_)
       continue;
 
-    Waypoint::ConstPtr neighbor = neighbors[0];
+    const Waypoint::ConstPtr neighbor = neighbors[0];
+    const size_t neighbor_planner_id = neighbor->value_ / 2;
 
-    // Extract value function and corresponding planner ID from last waypoint.
-    // If value is null, (i.e. at root) then set to planners_.size() since
-    // any planner is valid from the root. Convert value ID to planner ID
-    // by dividing by 2 since each planner has two value functions.
-    const Trajectory::ConstPtr neighbor_traj = neighbor->traj_;
-    const ValueFunctionId neighbor_val = neighbor->value_;
+    // (4) Plan a trajectory to the sample and insert it in the tree.
+    Waypoint::ConstPtr waypoint;
+    if (!Extend(tree, neighbor, sample, start_time, waypoint))
+      return false;
 
-    const size_t neighbor_planner_id = neighbor_val / 2;
+    // Check if we could find a trajectory to this sample.
+    if (waypoint == nullptr)
+      continue;
 
-    // (4) Plan a trajectory (starting with the most aggressive planner and ending
-    // with the next-most cautious planner).
-    Trajectory::Ptr traj;
-    ValueFunctionId value_used;
-    for (size_t ii = 0;
-         ii < std::min(neighbor_planner_id + 2, planners_.size()); ii++) {
-      const Planner::ConstPtr planner = planners_[ii];
+    // (5) Try to connect to the goal point. (6) If connected, the goal is
+    // inserted as a new tree terminus.
+    if ((sample - stop).norm() <= max_connection_radius_ &&
+        ConnectToGoal(tree, waypoint, neighbor_planner_id, true, stop))
+      found = true;
+  }
 
-      value_used = planner->GetIncomingValueFunction();
-      const ValueFunctionId possible_next_value =
-        planner->GetOutgoingValueFunction();
+  return found && PublishBest(tree);
+}
 
-      // Make sure switching distance server is up.
-      if (!switching_distance_srv_) {
-        ROS_WARN("%s: Switching distance server disconnected.", name_.c_str());
+// Plan lazily, running the planners only where they could improve on the
+// best trajectory found so far.
+// (1) Set up the tree as in Plan, plus a MetaGraph with optimistic costs.
+// (2) Find the best candidate path to the goal in the graph.
+// (3) If it could beat the best trajectory, plan along its first edge and
+//     remove that edge from the graph. On success, the edge's end point is
+//     now reached, with its actual time. Go to (2).
+// (4) Otherwise, sample a new point which could beat the best trajectory,
+//     add it to the graph, and go to (2).
+// (5) When out of time, publish as in Plan.
+bool MetaPlanner::PlanLazy(const Vector3d& start, const Vector3d& stop,
+                           double start_time) {
+  // Optimistic costs use the fastest speed over all planners.
+  if (!have_planner_limits_ && !UpdatePlannerLimits())
+    return false;
 
-        ros::NodeHandle nl;
-        switching_distance_srv_ = nl.serviceClient<value_function::GuaranteedSwitchingDistance>(
-          switching_distance_name_.c_str(), true);
-        return false;
-      }
+  // (1) Set up the tree and graph.
+  const ros::Time current_time = ros::Time::now();
+  const ValueFunctionId start_value = (traj_ == nullptr) ?
+    planners_.back()->GetOutgoingValueFunction() :
+    traj_->GetBoundValueFunction(start_time);
 
-      // Get the tracking bound for this planner.
-      double switch_x = 0.0;
-      double switch_y = 0.0;
-      double switch_z = 0.0;
-
-      value_function::GuaranteedSwitchingDistance d;
-      d.request.from_id = value_used;
-      d.request.to_id = possible_next_value;
-      if (!switching_distance_srv_.call(d))
-        ROS_ERROR("%s: Error calling switching distance server.", name_.c_str());
-      else {
-        switch_x = d.response.x;
-        switch_y = d.response.y;
-        switch_z = d.response.z;
-      }
+  WaypointTree tree(start, start_value, start_time);
 
-      // Since we might always end up switching, make sure this point
-      // is not closer than the guaranteed switching distance.
-      // NOTE! This enforces backtracking only one planner at a time.
-      // In full generality, we would just need to replace possible_next_value
-      // with the most cautious value.
-      if (std::abs(neighbor->point_(0) - sample(0)) < switch_x &&
-          std::abs(neighbor->point_(1) - sample(1)) < switch_y &&
-          std::abs(neighbor->point_(2) - sample(2)) < switch_z)
-        continue;
+  const MetaGraph::CostFunction optimistic_time =
+    [this](const Vector3d& from, const Vector3d& to) {
+    return OptimisticTime(from, to);
+  };
 
-      // Plan using 10% of the available total runtime.
-      // NOTE! This is just a heuristic and could easily be changed.
-      const double time = (neighbor_traj == nullptr) ?
-        start_time : neighbor_traj->LastTime();
+  MetaGraph graph(start, stop, max_connection_radius_,
+                  lazy_max_neighbors_, optimistic_time);
 
-      traj = planner->Plan(neighbor->point_, sample, time, 0.1 * max_runtime_);
+  // Waypoint reached at each graph node, the planner used by the waypoint
+  // it was extended from, and whether it has been extended itself (all
+  // needed when connecting to the goal).
+  std::vector<Waypoint::ConstPtr> reached(graph.NumNodes());
+  std::vector<size_t> neighbor_planner_ids(graph.NumNodes(), 0);
+  std::vector<bool> has_children(graph.NumNodes(), false);
+  reached[MetaGraph::kStartNode] = tree.Root();
 
-      if (traj != nullptr) {
-        // When we succeed...
-        // If we just planned with a more cautious planner than the one used
-        // by the nearest neighbor, do a 1-step backtrack.
-        if (ii > neighbor_planner_id) {
-#if 0
-          std::cout << "Switched from planner " << neighbor_planner_id
-                    << " with value id " << neighbor_val->Id()
-                    << " to planner " << ii
-                    << " with value id " << value_used->Id() << std::endl;
-#endif
-          // Clone the neighbor.
-          const Vector3d jittered(neighbor->point_(0) + 1e-4,
-                                  neighbor->point_(1) + 1e-4,
-                                  neighbor->point_(2) + 1e-4);
-
-          const double time = (neighbor_traj == nullptr) ?
-            start_time : neighbor_traj->FirstTime();
-
-          if (time <= start_time + 1e-8) {
-            ROS_INFO_THROTTLE(1.0, "%s: Tried to clone the root.", name_.c_str());
-
-            // Didn't really succeed. Can't clone the root in general.
-            traj = nullptr;
-          } else {
-            Waypoint::ConstPtr clone =
-              Waypoint::Create(jittered,
-                               value_used,
-                               Trajectory::Create(neighbor_traj, time),
-                               neighbor->parent_);
-
-            // Swap out the control value function in the neighbor's trajectory
-            // and update time stamps accordingly.
-            clone->traj_->ExecuteSwitch(value_used, best_time_srv_);
-
-            // Insert the clone.
-            tree.Insert(clone, false);
-
-            // Adjust the time stamps for the new trajectory to occur after the
-            // updated neighbor's trajectory.
-            traj->ResetStartTime(clone->traj_->LastTime());
-
-            // Neighbor is now clone.
-            neighbor = clone;
-          }
+  bool found = false;
+  std::vector<size_t> path;
+  while ((ros::Time::now() - current_time).toSec() < max_runtime_) {
+    // (2) Find the best candidate path.
+    if (graph.BestPath(path) < tree.BestTime()) {
+      // (3) Plan along its first edge.
+      const size_t from = path[0];
+      const size_t to = path[1];
+      graph.RemoveEdge(from, to);
+
+      if (to == MetaGraph::kGoalNode) {
+        if (ConnectToGoal(tree, reached[from], neighbor_planner_ids[from],
+                          !has_children[from], stop)) {
+          has_children[from] = true;
+          found = true;
         }
 
-        break;
+        continue;
       }
+
+      Waypoint::ConstPtr waypoint;
+      if (!Extend(tree, reached[from], graph.Point(to), start_time, waypoint))
+        return false;
+
+      if (waypoint != nullptr) {
+        graph.SetReached(to, waypoint->traj_->LastTime() - start_time);
+        reached[to] = waypoint;
+        neighbor_planner_ids[to] = reached[from]->value_ / 2;
+        has_children[from] = true;
+      }
+
+      continue;
     }
 
-    // Check if we could found a trajectory to this sample.
-    if (traj == nullptr)
+    // (4) Sample a new point, unless it could never lead to a faster
+    // trajectory than the best one currently.
+    const Vector3d sample = space_->Sample();
+    if (OptimisticTime(start, sample) + OptimisticTime(sample, stop) >
+        tree.BestTime())
       continue;
 
-    // Insert the sample.
-    const Waypoint::ConstPtr waypoint = Waypoint::Create(
-      sample, value_used, traj, neighbor);
-
-    tree.Insert(waypoint, false);
-
-    // (5) Try to connect to the goal point.
-    Trajectory::Ptr goal_traj;
-    ValueFunctionId goal_value_used;
-    const size_t planner_used_id = value_used / 2;
-
-    if ((sample - stop).norm() <= max_connection_radius_) {
-      for (size_t ii = 0;
-           ii < std::min(planner_used_id + 2, planners_.size()); ii++) {
-        const Planner::ConstPtr planner = planners_[ii];
-        goal_value_used = planner->GetIncomingValueFunction();
-
-        // We are never gonna need to switch if this succeeds.
-        // Plan using 10% of the available total runtime.
-        // NOTE! This is just a heuristic and could easily be changed.
-        goal_traj =
-          planner->Plan(sample, stop, traj->LastTime(), 0.1 * max_runtime_);
-
-        if (goal_traj != nullptr) {
-          // When we succeed... don't need to clone because waypoint has no kids.
-          // If we just planned with a more cautious planner than the one used
-          // by the nearest neighbor, do a 1-step backtrack.
-          if (ii > neighbor_planner_id) {
-            // Swap out the control value function in the neighbor's trajectory
-            // and update time stamps accordingly.
-            waypoint->traj_->ExecuteSwitch(goal_value_used, best_time_srv_);
-
-            // Adjust the time stamps for the new trajectory to occur after the
-            // updated neighbor's trajectory.
-            goal_traj->ResetStartTime(waypoint->traj_->LastTime());
-          }
-
-          break;
+    graph.AddNode(sample);
+    reached.resize(graph.NumNodes());
+    neighbor_planner_ids.resize(graph.NumNodes(), 0);
+    has_children.resize(graph.NumNodes(), false);
+  }
+
+  // (5) Publish.
+  return found && PublishBest(tree);
+}
+
+// Plan from a waypoint in the tree to a new point, starting with the most
+// aggressive planner and ending with the next-most cautious one. If a more
+// cautious planner than the waypoint's was needed, the waypoint is first
+// cloned with a switch to it (a 1-step backtrack). On success, the new
+// waypoint is inserted in the tree and returned. Otherwise it is null.
+// Returns false only if a server was unavailable.
+bool MetaPlanner::Extend(WaypointTree& tree, Waypoint::ConstPtr neighbor,
+                         const Vector3d& sample, double start_time,
+                         Waypoint::ConstPtr& waypoint) {
+  waypoint = nullptr;
+
+  // Extract value function and corresponding planner ID from last waypoint.
+  // If value is null, (i.e. at root) then set to planners_.size() since
+  // any planner is valid from the root. Convert value ID to planner ID
+  // by dividing by 2 since each planner has two value functions.
+  const Trajectory::ConstPtr neighbor_traj = neighbor->traj_;
+  const ValueFunctionId neighbor_val = neighbor->value_;
+
+  const size_t neighbor_planner_id = neighbor_val / 2;
+
+  Trajectory::Ptr traj;
+  ValueFunctionId value_used;
+  for (size_t ii = 0;
+       ii < std::min(neighbor_planner_id + 2, planners_.size()); ii++) {
+    const Planner::ConstPtr planner = planners_[ii];
+
+    value_used = planner->GetIncomingValueFunction();
+    const ValueFunctionId possible_next_value =
+      planner->GetOutgoingValueFunction();
+
+    // Make sure switching distance server is up.
+    if (!switching_distance_srv_) {
+      ROS_WARN("%s: Switching distance server disconnected.", name_.c_str());
+
+      ros::NodeHandle nl;
+      switching_distance_srv_ = nl.serviceClient<value_function::GuaranteedSwitchingDistance>(
+        switching_distance_name_.c_str(), true);
+      return false;
+    }
+
+    // Get the tracking bound for this planner.
+    double switch_x = 0.0;
+    double switch_y = 0.0;
+    double switch_z = 0.0;
+
+    value_function::GuaranteedSwitchingDistance d;
+    d.request.from_id = value_used;
+    d.request.to_id = possible_next_value;
+    if (!switching_distance_srv_.call(d))
+      ROS_ERROR("%s: Error calling switching distance server.", name_.c_str());
+    else {
+      switch_x = d.response.x;
+      switch_y = d.response.y;
+      switch_z = d.response.z;
+    }
+
+    // Since we might always end up switching, make sure this point
+    // is not closer than the guaranteed switching distance.
+    // NOTE! This enforces backtracking only one planner at a time.
+    // In full generality, we would just need to replace possible_next_value
+    // with the most cautious value.
+    if (std::abs(neighbor->point_(0) - sample(0)) < switch_x &&
+        std::abs(neighbor->point_(1) - sample(1)) < switch_y &&
+        std::abs(neighbor->point_(2) - sample(2)) < switch_z)
+      continue;
+
+    // Plan using 10% of the available total runtime.
+    // NOTE! This is just a heuristic and could easily be changed.
+    const double time = (neighbor_traj == nullptr) ?
+      start_time : neighbor_traj->LastTime();
+
+    traj = planner->Plan(neighbor->point_, sample, time, 0.1 * max_runtime_);
+
+    if (traj != nullptr) {
+      // When we succeed...
+      // If we just planned with a more cautious planner than the one used
+      // by the nearest neighbor, do a 1-step backtrack.
+      if (ii > neighbor_planner_id) {
+#if 0
+        std::cout << "Switched from planner " << neighbor_planner_id
+                  << " with value id " << neighbor_val->Id()
+                  << " to planner " << ii
+                  << " with value id " << value_used->Id() << std::endl;
+#endif
+        // Clone the neighbor.
+        const Vector3d jittered(neighbor->point_(0) + 1e-4,
+                                neighbor->point_(1) + 1e-4,
+                                neighbor->point_(2) + 1e-4);
+
+        const double time = (neighbor_traj == nullptr) ?
+          start_time : neighbor_traj->FirstTime();
+
+        if (time <= start_time + 1e-8) {
+          ROS_INFO_THROTTLE(1.0, "%s: Tried to clone the root.", name_.c_str());
+
+          // Didn't really succeed. Can't clone the root in general.
+          traj = nullptr;
+        } else {
+          Waypoint::ConstPtr clone =
+            Waypoint::Create(jittered,
+                             value_used,
+                             Trajectory::Create(neighbor_traj, time),
+                             neighbor->parent_);
+
+          // Swap out the control value function in the neighbor's trajectory
+          // and update time stamps accordingly.
+          clone->traj_->ExecuteSwitch(value_used, best_time_srv_);
+
+          // Insert the clone.
+          tree.Insert(clone, false);
+
+          // Adjust the time stamps for the new trajectory to occur after the
+          // updated neighbor's trajectory.
+          traj->ResetStartTime(clone->traj_->LastTime());
+
+          // Neighbor is now clone.
+          neighbor = clone;
         }
       }
+
+      break;
     }
+  }
 
-    // (6) If this sample was connected to the goal, update the tree terminus.
-    if (goal_traj != nullptr) {
-      // Connect to the goal.
-      // NOTE: the first point in goal_traj coincides with the last point in
-      // traj, but when we merge the two trajectories the std::map insertion
-      // rules will prevent duplicates.
-      const Waypoint::ConstPtr goal = Waypoint::Create(
-        stop, value_used, goal_traj, waypoint);
+  // Check if we could find a trajectory to this sample.
+  if (traj == nullptr)
+    return true;
 
-      tree.Insert(goal, true);
+  // Insert the sample.
+  waypoint = Waypoint::Create(sample, value_used, traj, neighbor);
+  tree.Insert(waypoint, false);
 
-      // Mark that we've found a valid trajectory.
-      found = true;
+  return true;
+}
+
+// Try to connect a waypoint to the goal, starting with the most aggressive
+// planner and ending with the next-most cautious one than the waypoint's.
+// 'neighbor_planner_id' is the planner of the waypoint the given one was
+// extended from. A more cautious planner than that requires switching in
+// the waypoint's own trajectory, which is only allowed if 'allow_switch'
+// (i.e. the waypoint has no children). If connected, inserts the goal as a
+// tree terminus.
+bool MetaPlanner::ConnectToGoal(WaypointTree& tree,
+                                const Waypoint::ConstPtr& waypoint,
+                                size_t neighbor_planner_id,
+                                bool allow_switch, const Vector3d& stop) {
+  Trajectory::Ptr goal_traj;
+  ValueFunctionId goal_value_used;
+  const size_t planner_used_id = waypoint->value_ / 2;
+
+  for (size_t ii = 0;
+       ii < std::min(planner_used_id + 2, planners_.size()); ii++) {
+    const Planner::ConstPtr planner = planners_[ii];
+    goal_value_used = planner->GetIncomingValueFunction();
+
+    if (ii > neighbor_planner_id && !allow_switch)
+      break;
+
+    // We are never gonna need to switch if this succeeds.
+    // Plan using 10% of the available total runtime.
+    // NOTE! This is just a heuristic and could easily be changed.
+    goal_traj =
+      planner->Plan(waypoint->point_, stop, waypoint->traj_->LastTime(),
+                    0.1 * max_runtime_);
+
+    if (goal_traj != nullptr) {
+      // When we succeed... don't need to clone because waypoint has no kids.
+      // If we just planned with a more cautious planner than the one used
+      // by the nearest neighbor, do a 1-step backtrack.
+      if (ii > neighbor_planner_id) {
+        // Swap out the control value function in the neighbor's trajectory
+        // and update time stamps accordingly.
+        waypoint->traj_->ExecuteSwitch(goal_value_used, best_time_srv_);
+
+        // Adjust the time stamps for the new trajectory to occur after the
+        // updated neighbor's trajectory.
+        goal_traj->ResetStartTime(waypoint->traj_->LastTime());
+      }
+
+      break;
     }
   }
 
-  if (found) {
-    // Get the best (fastest) trajectory out of the tree.
-    const Trajectory::ConstPtr best = tree.BestTrajectory();
-    ROS_INFO("%s: Publishing trajectory of length %zu.",
-             name_.c_str(), best->Size());
+  if (goal_traj == nullptr)
+    return false;
 
-    traj_ = best;
-    traj_pub_.publish(best->ToRosMessage());
-    return true;
+  // Connect to the goal.
+  // NOTE: the first point in goal_traj coincides with the last point in
+  // the waypoint's trajectory, but when we merge the two trajectories the
+  // std::map insertion rules will prevent duplicates.
+  const Waypoint::ConstPtr goal = Waypoint::Create(
+    stop, waypoint->value_, goal_traj, waypoint);
+
+  tree.Insert(goal, true);
+  return true;
+}
+
+// Publish the best trajectory in the tree. Returns false if there is none.
+bool MetaPlanner::PublishBest(const WaypointTree& tree) {
+  // Get the best (fastest) trajectory out of the tree.
+  const Trajectory::ConstPtr best = tree.BestTrajectory();
+  if (best == nullptr)
+    return false;
+
+  ROS_INFO("%s: Publishing trajectory of length %zu.",
+           name_.c_str(), best->Size());
+
+  traj_ = best;
+  traj_pub_.publish(best->ToRosMessage());
+
+  // Record the waypoints along the published trajectory, in order.
+  if (recorder_) {
+    std::vector<Waypoint::ConstPtr> waypoints;
+    for (Waypoint::ConstPtr waypoint = tree.Terminus();
+         waypoint != nullptr && waypoint->traj_ != nullptr;
+         waypoint = waypoint->parent_)
+      waypoints.push_back(waypoint);
+
+    for (auto iter = waypoints.rbegin(); iter != waypoints.rend(); iter++) {
+      const Trajectory::ConstPtr traj = (*iter)->traj_;
+      RecordEvent(FlightRecorder::WAYPOINT, traj->LastTime(), (*iter)->point_,
+                  (*iter)->value_, traj->LastTime() - traj->FirstTime());
+    }
   }
 
-  return false;
+  return true;
+}
+
+// Record a planner event, if recording. Never blocks.
+void MetaPlanner::RecordEvent(FlightRecorder::Event event, double time,
+                              const Vector3d& position, ValueFunctionId value,
+                              double duration) {
+  if (!recorder_)
+    return;
+
+  FlightRecorder::Record record;
+  record.values[FlightRecorder::EVENT_TIME] = time;
+  record.values[FlightRecorder::EVENT_TYPE] = event;
+  record.values[FlightRecorder::EVENT_X] = position(0);
+  record.values[FlightRecorder::EVENT_Y] = position(1);
+  record.values[FlightRecorder::EVENT_Z] = position(2);
+  record.values[FlightRecorder::EVENT_VALUE_ID] = value;
+  record.values[FlightRecorder::EVENT_DURATION] = duration;
+
+  recorder_->Push(record);
 }
 
 } //\namespace meta
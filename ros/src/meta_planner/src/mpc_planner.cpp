@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the MpcPlanner class, which inherits from the Planner abstract
+// class and plans with a short-horizon trajectory optimizer.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/mpc_planner.h>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+Planner::Ptr MpcPlanner::Create(ValueFunctionId incoming_value,
+                                ValueFunctionId outgoing_value,
+                                const BallsInBox::ConstPtr& space,
+                                const Dynamics::ConstPtr& dynamics) {
+  Planner::Ptr ptr(new MpcPlanner(incoming_value, outgoing_value,
+                                  space, dynamics));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+MpcPlanner::MpcPlanner(ValueFunctionId incoming_value,
+                       ValueFunctionId outgoing_value,
+                       const BallsInBox::ConstPtr& space,
+                       const Dynamics::ConstPtr& dynamics)
+  : Planner(incoming_value, outgoing_value, space, dynamics),
+    obstacles_(space) {}
+
+// Plan a trajectory between two points.
+Trajectory::Ptr MpcPlanner::Plan(const Vector3d& start, const Vector3d& stop,
+                                 double start_time, double budget) const {
+  // Check that both start and stop are in bounds. The time we reach the
+  // stop is not known yet, so it is only checked against static obstacles.
+  if (!space_->IsValidAt(start, start_time, incoming_value_, outgoing_value_)) {
+    ROS_WARN_THROTTLE(1.0, "Start point was in collision or out of bounds.");
+    return nullptr;
+  }
+
+  if (!space_->IsValid(stop, incoming_value_, outgoing_value_)) {
+    ROS_WARN_THROTTLE(1.0, "Stop point was in collision or out of bounds.");
+    return nullptr;
+  }
+
+  Vector3d max_speed, bound;
+  if (!GetLimits(max_speed, bound))
+    return nullptr;
+
+  // Plan with a fraction of the control authority, leaving the rest to
+  // the tracking controller.
+  Vector3d max_acceleration;
+  for (size_t ii = 0; ii < 3; ii++)
+    max_acceleration(ii) =
+      acceleration_fraction_ * dynamics_->MaxAcceleration(ii);
+
+  // Collect obstacles.
+  std::vector<Vector3d> centers;
+  std::vector<double> radii;
+  Vector3d center;
+  double radius;
+  for (size_t ii = 0; obstacles_->GetObstacle(ii, center, radius); ii++) {
+    centers.push_back(center);
+    radii.push_back(radius);
+  }
+
+  const TrajectoryOptimizer::Ptr optimizer = TrajectoryOptimizer::Create(
+    static_cast<size_t>(horizon_), static_cast<size_t>(max_iterations_),
+    time_scale_);
+  optimizer->SetBounds(space_->LowerBounds(), space_->UpperBounds());
+  optimizer->SetLimits(max_speed, max_acceleration);
+  optimizer->SetPadding(bound);
+  optimizer->SetObstacles(centers, radii);
+  optimizer->SetActivationDistance(activation_distance_);
+
+  std::vector<Vector3d> positions;
+  double dt = 0.0;
+  if (!optimizer->Optimize(start, stop, budget, positions, dt)) {
+    ROS_WARN_THROTTLE(1.0, "%s: MPC planner could not compute a solution.",
+                      name_.c_str());
+    return nullptr;
+  }
+
+  // Populate the Trajectory with states and time stamps.
+  std::vector<double> times;
+  std::vector<ValueFunctionId> values;
+  for (size_t ii = 0; ii < positions.size(); ii++) {
+    times.push_back(start_time + static_cast<double>(ii) * dt);
+    values.push_back(incoming_value_);
+  }
+
+  // The optimizer only sees the static obstacle geometry, so check every
+  // segment against the environment itself, including moving obstacles at
+  // the time the segment is flown.
+  for (size_t ii = 1; ii < positions.size(); ii++) {
+    if (!space_->IsMotionValid(positions[ii - 1], positions[ii],
+                               times[ii - 1], times[ii], check_resolution_,
+                               incoming_value_, outgoing_value_)) {
+      ROS_WARN_THROTTLE(1.0, "%s: MPC planner solution was not valid.",
+                        name_.c_str());
+      return nullptr;
+    }
+  }
+
+  // Convert to full state space. Make sure to use the INCOMING VALUE!
+  std::vector<VectorXd> full_states =
+    dynamics_->LiftGeometricTrajectory(positions, times);
+  return Trajectory::Create(times, full_states, values, values);
+}
+
+// Query this planner's speed and switching tracking bound.
+bool MpcPlanner::GetLimits(Vector3d& max_speed, Vector3d& bound) const {
+  // Make sure servers are up.
+  if (!max_speed_srv_) {
+    ROS_WARN("%s: Max planner speed server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    max_speed_srv_ = nl.serviceClient<value_function::GeometricPlannerSpeed>(
+      max_speed_name_.c_str(), true);
+    return false;
+  }
+
+  if (!switching_bound_srv_) {
+    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    switching_bound_srv_ =
+      nl.serviceClient<value_function::SwitchingTrackingBoundBox>(
+        switching_bound_name_.c_str(), true);
+    return false;
+  }
+
+  value_function::GeometricPlannerSpeed s;
+  s.request.id = incoming_value_;
+  if (!max_speed_srv_.call(s)) {
+    ROS_ERROR("%s: Error calling max planner speed server.", name_.c_str());
+    return false;
+  }
+
+  value_function::SwitchingTrackingBoundBox b;
+  b.request.from_id = incoming_value_;
+  b.request.to_id = outgoing_value_;
+  if (!switching_bound_srv_.call(b)) {
+    ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
+    return false;
+  }
+
+  max_speed = Vector3d(s.response.x, s.response.y, s.response.z);
+  bound = Vector3d(b.response.x, b.response.y, b.response.z);
+  return true;
+}
+
+// Load all parameters.
+bool MpcPlanner::LoadParameters(const ros::NodeHandle& n) {
+  if (!Planner::LoadParameters(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Service names.
+  if (!nl.getParam("srv/switching_bound", switching_bound_name_))
+    return false;
+  nl.param("srv/max_planner_speed", max_speed_name_,
+           std::string("/max_planner_speed"));
+
+  // Optimizer settings.
+  nl.param("mpc/horizon", horizon_, 20);
+  nl.param("mpc/max_iterations", max_iterations_, 10);
+  nl.param("mpc/time_scale", time_scale_, 1.5);
+  nl.param("mpc/activation_distance", activation_distance_, 1.0);
+  nl.param("mpc/acceleration_fraction", acceleration_fraction_, 0.5);
+  nl.param("mpc/check_resolution", check_resolution_, 0.05);
+
+  if (horizon_ < 2 || max_iterations_ < 1) {
+    ROS_ERROR("%s: MPC horizon must be at least 2 and iterations at least 1.",
+              name_.c_str());
+    return false;
+  }
+
+  if (check_resolution_ <= 0.0) {
+    ROS_ERROR("%s: MPC check resolution must be positive.", name_.c_str());
+    return false;
+  }
+
+  if (acceleration_fraction_ <= 0.0 || acceleration_fraction_ > 1.0) {
+    ROS_ERROR("%s: MPC acceleration fraction must be in (0, 1].",
+              name_.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Register all callbacks and publishers.
+bool MpcPlanner::RegisterCallbacks(const ros::NodeHandle& n) {
+  if (!Planner::RegisterCallbacks(n)) return false;
+
+  ros::NodeHandle nl(n);
+
+  // Servers.
+  max_speed_srv_ = nl.serviceClient<value_function::GeometricPlannerSpeed>(
+    max_speed_name_.c_str(), true);
+  switching_bound_srv_ =
+    nl.serviceClient<value_function::SwitchingTrackingBoundBox>(
+      switching_bound_name_.c_str(), true);
+
+  return true;
+}
+
+} //\namespace meta
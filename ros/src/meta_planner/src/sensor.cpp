@@ -38,16 +38,25 @@
 //
 // Defines the Simulator class. Holds a BallsInBox environment and sends
 // simulated sensor measurements consisting of detected balls in range.
+// Optionally simulates a depth/LiDAR sensor instead: a fan of rays is cast
+// against the true environment each time step, the hit points are
+// published, and only balls actually hit by some ray are reported.
+//
+// Optionally some balls move at constant speed, bouncing off the walls.
+// These are reported with their velocities whenever they are within the
+// sensor radius, in either mode.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <demo/sensor.h>
 #include <random>
+#include <set>
 
 namespace meta {
 
 Sensor::Sensor()
   : tf_listener_(tf_buffer_),
+    depth_mode_(false),
     in_flight_(false),
     initialized_(false) {}
 
@@ -86,8 +95,9 @@ bool Sensor::Initialize(const ros::NodeHandle& n) {
     state_lower_vec(ii) = state_lower_[ii];
   }
 
-  space_->SetBounds(dynamics_->Puncture(state_lower_vec),
-                    dynamics_->Puncture(state_upper_vec));
+  lower_ = dynamics_->Puncture(state_lower_vec);
+  upper_ = dynamics_->Puncture(state_upper_vec);
+  space_->SetBounds(lower_, upper_);
 
   space_->Seed(seed_);
 
@@ -101,6 +111,19 @@ bool Sensor::Initialize(const ros::NodeHandle& n) {
   for (size_t ii = 0; ii < num_obstacles_; ii++)
     space_->AddObstacle(space_->Sample(), uniform_radius(rng));
 
+  // Add moving obstacles heading in random directions.
+  std::normal_distribution<double> normal(0.0, 1.0);
+  for (size_t ii = 0; ii < num_moving_obstacles_; ii++) {
+    Vector3d direction(normal(rng), normal(rng), normal(rng));
+    if (direction.norm() < 1e-8)
+      direction = Vector3d::UnitX();
+
+    moving_positions_.push_back(space_->Sample());
+    moving_velocities_.push_back(
+      moving_obstacle_speed_ * direction.normalized());
+    moving_radii_.push_back(uniform_radius(rng));
+  }
+
   initialized_ = true;
   return true;
 }
@@ -129,6 +152,56 @@ bool Sensor::LoadParameters(const ros::NodeHandle& n) {
   // Time step.
   if (!nl.getParam("sensor/time_step", time_step_)) return false;
 
+  // Moving obstacles.
+  int num_moving_obstacles = 0;
+  nl.param("sensor/num_moving_obstacles", num_moving_obstacles, 0);
+  nl.param("sensor/moving_obstacle_speed", moving_obstacle_speed_, 0.5);
+  num_moving_obstacles_ =
+    static_cast<size_t>(std::max(num_moving_obstacles, 0));
+
+  // Depth sensor mode. The ray fan is an azimuth x elevation grid centered
+  // on the robot's x axis.
+  nl.param("sensor/depth/enabled", depth_mode_, false);
+  nl.param("sensor/depth/max_range", max_range_, sensor_radius_);
+
+  int horizontal_rays = 64;
+  int vertical_rays = 16;
+  double horizontal_fov = 2.0 * M_PI;
+  double vertical_fov = M_PI / 6.0;
+  nl.param("sensor/depth/horizontal_rays", horizontal_rays, horizontal_rays);
+  nl.param("sensor/depth/vertical_rays", vertical_rays, vertical_rays);
+  nl.param("sensor/depth/horizontal_fov", horizontal_fov, horizontal_fov);
+  nl.param("sensor/depth/vertical_fov", vertical_fov, vertical_fov);
+
+  if (depth_mode_ && (horizontal_rays < 1 || vertical_rays < 1)) {
+    ROS_ERROR("%s: Depth sensor needs at least one ray per axis.",
+              name_.c_str());
+    return false;
+  }
+
+  // A full circle would put the first and last azimuths on top of each other.
+  const bool wraps = horizontal_fov >= 2.0 * M_PI - 1e-6;
+  const double azimuth_step = (horizontal_rays > 1) ?
+    horizontal_fov / ((wraps) ? horizontal_rays : horizontal_rays - 1) : 0.0;
+  const double elevation_step = (vertical_rays > 1) ?
+    vertical_fov / (vertical_rays - 1) : 0.0;
+  const double first_azimuth = (horizontal_rays > 1 && !wraps) ?
+    -0.5 * horizontal_fov : -0.5 * azimuth_step * (horizontal_rays - 1);
+  const double first_elevation = -0.5 * elevation_step * (vertical_rays - 1);
+
+  ray_directions_.resize(horizontal_rays * vertical_rays, 3);
+  for (int ii = 0; ii < vertical_rays; ii++) {
+    const double elevation = first_elevation + ii * elevation_step;
+
+    for (int jj = 0; jj < horizontal_rays; jj++) {
+      const double azimuth = first_azimuth + jj * azimuth_step;
+      ray_directions_.row(ii * horizontal_rays + jj) <<
+        std::cos(elevation) * std::cos(azimuth),
+        std::cos(elevation) * std::sin(azimuth),
+        std::sin(elevation);
+    }
+  }
+
   // State space parameters.
   int dimension = 1;
   if (!nl.getParam("control/dim", dimension)) return false;
@@ -142,6 +215,7 @@ bool Sensor::LoadParameters(const ros::NodeHandle& n) {
 
   // Topics and frame ids.
   if (!nl.getParam("topics/sensor", sensor_topic_)) return false;
+  nl.param("topics/depth", depth_topic_, std::string("/depth"));
   if (!nl.getParam("topics/in_flight", in_flight_topic_)) return false;
   if (!nl.getParam("topics/vis/sensor_radius", sensor_radius_topic_)) return false;
   if (!nl.getParam("topics/vis/true_environment", environment_topic_)) return false;
@@ -166,6 +240,10 @@ bool Sensor::RegisterCallbacks(const ros::NodeHandle& n) {
   sensor_pub_ = nl.advertise<meta_planner_msgs::SensorMeasurement>(
     sensor_topic_.c_str(), 1, false);
 
+  if (depth_mode_)
+    depth_pub_ = nl.advertise<meta_planner_msgs::DepthMeasurement>(
+      depth_topic_.c_str(), 1, false);
+
   // Subscriber.
   in_flight_sub_ = nl.subscribe(
     in_flight_topic_.c_str(), 1, &Sensor::InFlightCallback, this);
@@ -203,13 +281,38 @@ void Sensor::TimerCallback(const ros::TimerEvent& e) {
                           tf.transform.translation.y,
                           tf.transform.translation.z);
 
+  // Move the moving obstacles up to now.
+  MoveObstacles(right_now.toSec());
 
   // Publish sensor message if an obstacle is within range.
   std::vector<Vector3d> obstacle_positions;
   std::vector<double> obstacle_radii;
 
-  if (space_->SenseObstacles(position, sensor_radius_,
-                            obstacle_positions, obstacle_radii)) {
+  if (depth_mode_) {
+    const Quaterniond orientation(tf.transform.rotation.w,
+                                  tf.transform.rotation.x,
+                                  tf.transform.rotation.y,
+                                  tf.transform.rotation.z);
+
+    SenseDepth(position, orientation, obstacle_positions, obstacle_radii);
+  } else {
+    space_->SenseObstacles(position, sensor_radius_,
+                           obstacle_positions, obstacle_radii);
+  }
+
+  // Static obstacles don't move. Moving ones are seen within range.
+  const size_t num_static = obstacle_positions.size();
+  std::vector<Vector3d> obstacle_velocities(num_static, Vector3d::Zero());
+  for (size_t ii = 0; ii < moving_positions_.size(); ii++) {
+    if ((position - moving_positions_[ii]).norm() <=
+        moving_radii_[ii] + sensor_radius_) {
+      obstacle_positions.push_back(moving_positions_[ii]);
+      obstacle_radii.push_back(moving_radii_[ii]);
+      obstacle_velocities.push_back(moving_velocities_[ii]);
+    }
+  }
+
+  if (obstacle_positions.size() > 0) {
     // Saw at least one obstacle, so convert to message and publish.
     meta_planner_msgs::SensorMeasurement msg;
     msg.num_obstacles = obstacle_positions.size();
@@ -220,8 +323,15 @@ void Sensor::TimerCallback(const ros::TimerEvent& e) {
       p.y = obstacle_positions[ii](1);
       p.z = obstacle_positions[ii](2);
 
+      geometry_msgs::Vector3 v;
+      v.x = obstacle_velocities[ii](0);
+      v.y = obstacle_velocities[ii](1);
+      v.z = obstacle_velocities[ii](2);
+
       msg.positions.push_back(p);
       msg.radii.push_back(obstacle_radii[ii]);
+      msg.velocities.push_back(v);
+      msg.moving.push_back(ii >= num_static);
     }
 
     sensor_pub_.publish(msg);
@@ -251,4 +361,83 @@ void Sensor::TimerCallback(const ros::TimerEvent& e) {
   sensor_radius_pub_.publish(sensor_radius_marker);
 }
 
+// Move the moving obstacles forward one time step to the given time,
+// bouncing them off the walls. The true environment shows them where they
+// are now.
+void Sensor::MoveObstacles(double time) {
+  if (moving_positions_.empty())
+    return;
+
+  space_->ClearDynamicObstacles();
+
+  for (size_t ii = 0; ii < moving_positions_.size(); ii++) {
+    Vector3d& point = moving_positions_[ii];
+    Vector3d& velocity = moving_velocities_[ii];
+    point += time_step_ * velocity;
+
+    for (size_t jj = 0; jj < 3; jj++) {
+      if ((point(jj) < lower_(jj) && velocity(jj) < 0.0) ||
+          (point(jj) > upper_(jj) && velocity(jj) > 0.0))
+        velocity(jj) = -velocity(jj);
+    }
+
+    space_->AddDynamicObstacle(point, velocity, moving_radii_[ii],
+                               time, time + time_step_);
+  }
+}
+
+// Cast the ray fan from this pose, publish the hit points, and collect
+// the obstacles that were hit.
+void Sensor::SenseDepth(const Vector3d& position,
+                        const Quaterniond& orientation,
+                        std::vector<Vector3d>& obstacle_positions,
+                        std::vector<double>& obstacle_radii) {
+  // Rotate the fan into the fixed frame. Directions are rows, so
+  // multiply by the transpose of the rotation on the right.
+  const Eigen::MatrixX3d directions =
+    ray_directions_ * orientation.normalized().toRotationMatrix().transpose();
+
+  VectorXd ranges;
+  Eigen::VectorXi hits;
+  space_->CastRays(position, directions, max_range_, ranges, hits);
+
+  // Publish every return that came back before max range.
+  meta_planner_msgs::DepthMeasurement msg;
+  msg.origin.x = position(0);
+  msg.origin.y = position(1);
+  msg.origin.z = position(2);
+  msg.num_rays = directions.rows();
+  msg.max_range = max_range_;
+
+  std::set<int> obstacles_hit;
+  for (size_t ii = 0; ii < static_cast<size_t>(ranges.size()); ii++) {
+    if (ranges(ii) >= max_range_)
+      continue;
+
+    const Vector3d point = position + ranges(ii) * directions.row(ii).transpose();
+
+    geometry_msgs::Vector3 p;
+    p.x = point(0);
+    p.y = point(1);
+    p.z = point(2);
+    msg.points.push_back(p);
+
+    if (hits(ii) >= 0)
+      obstacles_hit.insert(hits(ii));
+  }
+
+  depth_pub_.publish(msg);
+
+  // Report only the balls that were actually seen.
+  for (const int idx : obstacles_hit) {
+    Vector3d obstacle_position;
+    double obstacle_radius;
+    if (!space_->GetObstacle(idx, obstacle_position, obstacle_radius))
+      continue;
+
+    obstacle_positions.push_back(obstacle_position);
+    obstacle_radii.push_back(obstacle_radius);
+  }
+}
+
 } //\namespace meta
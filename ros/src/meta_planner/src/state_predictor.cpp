@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the StatePredictor class, which compensates for latency in the
+// state estimate by forward-integrating the near-hover quadrotor dynamics.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/state_predictor.h>
+
+#include <algorithm>
+#include <math.h>
+
+namespace meta {
+
+const size_t StatePredictor::kHistorySize;
+const double StatePredictor::kLatencySmoothing = 0.05;
+
+// Factory method. Use this instead of the constructor.
+StatePredictor::Ptr StatePredictor::Create(double max_horizon) {
+  StatePredictor::Ptr ptr(new StatePredictor(max_horizon));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+StatePredictor::StatePredictor(double max_horizon)
+  : first_(0),
+    size_(0),
+    latency_(0.0),
+    latency_initialized_(false),
+    max_horizon_(std::max(max_horizon, 0.0)) {}
+
+// Record a control applied from this time onward.
+void StatePredictor::RecordControl(double time, const Vector3d& control) {
+  // Ignore controls out of order.
+  if (size_ > 0 && time < times_[(first_ + size_ - 1) % kHistorySize])
+    return;
+
+  if (size_ == kHistorySize) {
+    first_ = (first_ + 1) % kHistorySize;
+    size_--;
+  }
+
+  const size_t idx = (first_ + size_) % kHistorySize;
+  times_[idx] = time;
+  controls_[idx] = control;
+  size_++;
+}
+
+// Record a measured latency between a state's time stamp and its arrival.
+void StatePredictor::RecordLatency(double latency) {
+  if (!latency_initialized_) {
+    latency_ = latency;
+    latency_initialized_ = true;
+    return;
+  }
+
+  latency_ += kLatencySmoothing * (latency - latency_);
+}
+
+// Predict the state at 'target_time' given the state measured at
+// 'state_time'. Returns the horizon actually integrated over.
+double StatePredictor::Predict(const State& state, double state_time,
+                               double target_time, State& predicted) const {
+  predicted = state;
+
+  const double end_time =
+    std::min(target_time, state_time + max_horizon_);
+  if (end_time <= state_time)
+    return 0.0;
+
+  // Hover until the first recorded control.
+  Vector3d control(0.0, 0.0, constants::G);
+
+  double time = state_time;
+  size_t ii = 0;
+
+  // Find the control in effect at the state time.
+  for (; ii < size_; ii++) {
+    const size_t idx = (first_ + ii) % kHistorySize;
+    if (times_[idx] > state_time)
+      break;
+
+    control = controls_[idx];
+  }
+
+  // Integrate each zero-order hold piece exactly.
+  while (time < end_time) {
+    double next_time = end_time;
+    if (ii < size_)
+      next_time = std::min(next_time, times_[(first_ + ii) % kHistorySize]);
+
+    const double dt = next_time - time;
+    const Vector3d acceleration = Acceleration(control);
+
+    predicted.head<3>() +=
+      dt * predicted.tail<3>() + 0.5 * dt * dt * acceleration;
+    predicted.tail<3>() += dt * acceleration;
+
+    time = next_time;
+    if (ii < size_)
+      control = controls_[(first_ + ii++) % kHistorySize];
+  }
+
+  return end_time - state_time;
+}
+
+// Acceleration under a control, as in NearHoverQuadNoYaw::Evaluate.
+Vector3d StatePredictor::Acceleration(const Vector3d& control) {
+  return Vector3d(constants::G * std::tan(control(0)),
+                  -constants::G * std::tan(control(1)),
+                  control(2) - constants::G);
+}
+
+} //\namespace meta
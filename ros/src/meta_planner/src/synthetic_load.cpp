@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SyntheticLoad class, which generates configurable background
+// load for timing benchmarks of the control loop.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/synthetic_load.h>
+#include <meta_planner/flann_tree.h>
+#include <meta_planner/waypoint.h>
+
+#include <visualization_msgs/Marker.h>
+#include <geometry_msgs/Point.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+SyntheticLoad::Ptr SyntheticLoad::Create() {
+  SyntheticLoad::Ptr ptr(new SyntheticLoad());
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+SyntheticLoad::SyntheticLoad()
+  : running_(true),
+    planner_queries_(0),
+    published_messages_(0),
+    copied_bytes_(0) {}
+
+// Start planner threads.
+void SyntheticLoad::StartPlannerThreads(size_t num_threads, size_t tree_size) {
+  for (size_t ii = 0; ii < num_threads; ii++)
+    threads_.push_back(std::thread(&SyntheticLoad::PlannerThread, this,
+                                   tree_size, static_cast<unsigned int>(ii)));
+}
+
+// Start publishing markers at a fixed rate.
+void SyntheticLoad::StartPublisherFlood(const ros::NodeHandle& n,
+                                        const std::string& topic,
+                                        double rate, size_t num_points) {
+  if (rate <= 0.0)
+    return;
+
+  ros::NodeHandle nl(n);
+  const ros::Publisher pub =
+    nl.advertise<visualization_msgs::Marker>(topic.c_str(), 1, false);
+
+  threads_.push_back(std::thread(&SyntheticLoad::FloodThread, this,
+                                 pub, rate, num_points));
+}
+
+// Start memory-bandwidth hogs.
+void SyntheticLoad::StartMemoryHogs(size_t num_threads, size_t megabytes) {
+  for (size_t ii = 0; ii < num_threads; ii++)
+    threads_.push_back(std::thread(&SyntheticLoad::MemoryHogThread, this,
+                                   megabytes));
+}
+
+// Stop and join all threads.
+void SyntheticLoad::Stop() {
+  running_ = false;
+
+  for (auto& thread : threads_)
+    thread.join();
+
+  threads_.clear();
+  running_ = true;
+}
+
+// Build and query trees of random waypoints, as in MetaPlanner::Plan.
+void SyntheticLoad::PlannerThread(size_t tree_size, unsigned int seed) {
+  std::default_random_engine rng(seed);
+  std::uniform_real_distribution<double> unif(-10.0, 10.0);
+
+  const size_t kNumNeighbors = 5;
+  const double kSearchRadius = 2.0;
+
+  while (running_) {
+    FlannTree tree;
+
+    for (size_t ii = 0; ii < tree_size && running_; ii++) {
+      Vector3d sample(unif(rng), unif(rng), unif(rng));
+
+      if (tree.Size() > 0) {
+        tree.KnnSearch(sample, kNumNeighbors);
+        tree.RadiusSearch(sample, kSearchRadius);
+        planner_queries_.fetch_add(2, std::memory_order_relaxed);
+      }
+
+      tree.Insert(Waypoint::Create(sample, 0, nullptr, nullptr));
+    }
+  }
+}
+
+// Publish large markers at a fixed rate.
+void SyntheticLoad::FloodThread(ros::Publisher pub, double rate,
+                                size_t num_points) {
+  visualization_msgs::Marker marker;
+  marker.ns = "load";
+  marker.id = 0;
+  marker.type = visualization_msgs::Marker::POINTS;
+  marker.action = visualization_msgs::Marker::ADD;
+  marker.scale.x = 0.05;
+  marker.scale.y = 0.05;
+  marker.color.a = 1.0;
+
+  marker.points.resize(num_points);
+  for (size_t ii = 0; ii < num_points; ii++) {
+    marker.points[ii].x = static_cast<double>(ii % 100);
+    marker.points[ii].y = static_cast<double>((ii / 100) % 100);
+    marker.points[ii].z = static_cast<double>(ii / 10000);
+  }
+
+  const std::chrono::nanoseconds period(
+    static_cast<int64_t>(1e9 / rate));
+  std::chrono::steady_clock::time_point next =
+    std::chrono::steady_clock::now();
+
+  while (running_) {
+    marker.header.stamp = ros::Time::now();
+    pub.publish(marker);
+    published_messages_.fetch_add(1, std::memory_order_relaxed);
+
+    next += period;
+    std::this_thread::sleep_until(next);
+  }
+}
+
+// Stream over a large buffer, copying one half onto the other.
+void SyntheticLoad::MemoryHogThread(size_t megabytes) {
+  const size_t half = std::max<size_t>(megabytes, 1) * (1 << 20) / 2;
+  std::vector<char> buffer(2 * half, 1);
+
+  while (running_) {
+    std::memcpy(buffer.data() + half, buffer.data(), half);
+    std::memcpy(buffer.data(), buffer.data() + half, half);
+    copied_bytes_.fetch_add(2 * half, std::memory_order_relaxed);
+  }
+}
+
+} //\namespace meta
@@ -0,0 +1,614 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TiledBox class, a Box for large worlds whose spherical
+// obstacles are partitioned into fixed-size tiles stored in a
+// memory-mapped file. Only tiles near the vehicle and the meta-plan
+// corridor are kept in memory.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/tiled_box.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace meta {
+
+const char TiledBox::kMagic[8] = { 'M', 'E', 'T', 'A', 'T', 'I', 'L', 'E' };
+
+// Factory method. Use this instead of the constructor.
+TiledBox::Ptr TiledBox::Create(const std::string& file_name,
+                               double active_radius) {
+  TiledBox::Ptr ptr(new TiledBox(active_radius));
+
+  if (!ptr->Load(file_name))
+    ROS_ERROR("Could not load tiled environment: %s.", file_name.c_str());
+
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+TiledBox::TiledBox(double active_radius)
+  : Box(),
+    num_tiles_(Eigen::Vector3i::Ones()),
+    tile_size_(1.0),
+    max_radius_(0.0),
+    active_radius_(active_radius),
+    map_(MAP_FAILED),
+    map_size_(0),
+    offsets_(NULL),
+    obstacles_(NULL) {}
+
+// Destructor unmaps the file.
+TiledBox::~TiledBox() {
+  if (map_ != MAP_FAILED)
+    munmap(map_, map_size_);
+}
+
+// Inherited collision checker from Box needs to be overwritten.
+// Takes in incoming and outgoing value functions. See planner.h for details.
+bool TiledBox::IsValid(const Vector3d& position,
+                       ValueFunctionId incoming_value,
+                       ValueFunctionId outgoing_value) const {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized TiledBox.",
+             name_.c_str());
+    return false;
+  }
+#endif
+
+  // Only plan inside the active tiles.
+  if (active_set_.count(Index(Tile(position))) == 0)
+    return false;
+
+  // Reuse the result of a recent check near this position.
+  const size_t epoch = Epoch();
+  bool valid = false;
+  if (LookupValidity(position, incoming_value, outgoing_value, epoch, valid))
+    return valid;
+
+  // Make sure server is up.
+  if (!switching_bound_srv_) {
+    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    switching_bound_srv_ = nl.serviceClient<value_function::SwitchingTrackingBoundBox>(
+      switching_bound_name_.c_str(), true);
+
+    return false;
+  }
+
+  value_function::SwitchingTrackingBoundBox bound;
+  bound.request.from_id = incoming_value;
+  bound.request.to_id = outgoing_value;
+  if (!switching_bound_srv_.call(bound)) {
+    ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
+    return false;
+  }
+
+  Vector3d checked_position = position;
+  Vector3d bound_vector(bound.response.x, bound.response.y, bound.response.z);
+  CoverCacheCell(checked_position, bound_vector);
+
+  valid = IsFree(checked_position, bound_vector);
+  StoreValidity(position, incoming_value, outgoing_value, epoch, valid);
+
+  return valid;
+}
+
+// Check the tracking bound around a position against the box walls and
+// every obstacle which could touch it.
+bool TiledBox::IsFree(const Vector3d& position,
+                      const Vector3d& bound_vector) const {
+  if (position(0) < lower_(0) + bound_vector(0) ||
+      position(0) > upper_(0) - bound_vector(0) ||
+      position(1) < lower_(1) + bound_vector(1) ||
+      position(1) > upper_(1) - bound_vector(1) ||
+      position(2) < lower_(2) + bound_vector(2) ||
+      position(2) > upper_(2) - bound_vector(2))
+    return false;
+
+  // Check obstacles in every tile that could hold one touching the
+  // tracking bound.
+  const Vector3d margin = bound_vector + Vector3d::Constant(max_radius_);
+  const Eigen::Vector3i first = Tile(position - margin);
+  const Eigen::Vector3i last = Tile(position + margin);
+
+  for (int z = first(2); z <= last(2); z++) {
+    for (int y = first(1); y <= last(1); y++) {
+      for (int x = first(0); x <= last(0); x++) {
+        const size_t idx = Index(Eigen::Vector3i(x, y, z));
+
+        const auto loaded_iter = loaded_.find(idx);
+        if (loaded_iter != loaded_.end()) {
+          const Obstacles& tile = loaded_iter->second;
+          for (size_t ii = 0; ii < tile.points.size(); ii++)
+            if (Overlaps(position, bound_vector,
+                         tile.points[ii], tile.radii[ii]))
+              return false;
+        } else if (offsets_ != NULL && offsets_[idx + 1] > offsets_[idx]) {
+          // Unknown obstacles nearby. Be conservative.
+          return false;
+        }
+
+        const auto added_iter = added_.find(idx);
+        if (added_iter != added_.end()) {
+          const Obstacles& tile = added_iter->second;
+          for (size_t ii = 0; ii < tile.points.size(); ii++)
+            if (Overlaps(position, bound_vector,
+                         tile.points[ii], tile.radii[ii]))
+              return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+// Inherited sampler from Box needs to be overwritten. Samples uniformly
+// from the active tiles.
+Vector3d TiledBox::Sample() const {
+  if (active_.empty())
+    return Box::Sample();
+
+  // All tiles have the same volume, so pick one uniformly and then a
+  // point uniformly inside it.
+  std::uniform_int_distribution<size_t> unif_tile(0, active_.size() - 1);
+  const size_t idx = active_[unif_tile(rng_)];
+
+  const Eigen::Vector3i tile(
+    idx % num_tiles_(0), (idx / num_tiles_(0)) % num_tiles_(1),
+    idx / (num_tiles_(0) * num_tiles_(1)));
+
+  Vector3d sample;
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double tile_lower = lower_(ii) + tile(ii) * tile_size_;
+    std::uniform_real_distribution<double> unif(
+      tile_lower, std::min(tile_lower + tile_size_, upper_(ii)));
+    sample(ii) = unif(rng_);
+  }
+
+  return sample;
+}
+
+// Update the active tiles around the vehicle position and along the
+// corridor. Returns the number of tiles loaded.
+size_t TiledBox::UpdateActive(const Vector3d& position,
+                              const std::vector<Vector3d>& corridor) {
+  std::unordered_set<size_t> active;
+  AddTiles(position, position, active_radius_, active);
+
+  for (size_t ii = 0; ii < corridor.size(); ii++)
+    AddTiles(corridor[ii], corridor[std::min(ii + 1, corridor.size() - 1)],
+             active_radius_, active);
+
+  active_.assign(active.begin(), active.end());
+  std::sort(active_.begin(), active_.end());
+  active_set_.swap(active);
+  BumpEpoch();
+
+  // Active tiles and their neighbors must be in memory.
+  std::unordered_set<size_t> needed;
+  for (const size_t idx : active_) {
+    const Eigen::Vector3i tile(
+      idx % num_tiles_(0), (idx / num_tiles_(0)) % num_tiles_(1),
+      idx / (num_tiles_(0) * num_tiles_(1)));
+
+    for (int z = std::max(tile(2) - 1, 0);
+         z <= std::min(tile(2) + 1, num_tiles_(2) - 1); z++)
+      for (int y = std::max(tile(1) - 1, 0);
+           y <= std::min(tile(1) + 1, num_tiles_(1) - 1); y++)
+        for (int x = std::max(tile(0) - 1, 0);
+             x <= std::min(tile(0) + 1, num_tiles_(0) - 1); x++)
+          needed.insert(Index(Eigen::Vector3i(x, y, z)));
+  }
+
+  // Evict tiles which are no longer needed.
+  for (auto iter = loaded_.begin(); iter != loaded_.end(); ) {
+    if (needed.count(iter->first) == 0)
+      iter = loaded_.erase(iter);
+    else
+      ++iter;
+  }
+
+  if (offsets_ == NULL)
+    return 0;
+
+  // Copy newly needed tiles out of the mapping.
+  size_t num_loaded = 0;
+  for (const size_t idx : needed) {
+    if (loaded_.count(idx) > 0)
+      continue;
+
+    Obstacles& tile = loaded_[idx];
+    for (uint64_t ii = offsets_[idx]; ii < offsets_[idx + 1]; ii++) {
+      const double* obstacle = obstacles_ + 4 * ii;
+      tile.points.push_back(Vector3d(obstacle[0], obstacle[1], obstacle[2]));
+      tile.radii.push_back(obstacle[3]);
+    }
+
+    Release(idx);
+    num_loaded++;
+  }
+
+  return num_loaded;
+}
+
+// Add a spherical obstacle of the given radius to the environment.
+void TiledBox::AddObstacle(const Vector3d& point, double r) {
+  const double kSmallNumber = 1e-8;
+
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (r < kSmallNumber)
+    ROS_ERROR("Radius was too small: %f.", r);
+#endif
+
+  Obstacles& tile = added_[Index(Tile(point))];
+  tile.points.push_back(point);
+  tile.radii.push_back(std::max(r, kSmallNumber));
+
+  max_radius_ = std::max(max_radius_, r);
+  BumpEpoch();
+}
+
+// Check if a given obstacle is in the loaded part of the environment.
+bool TiledBox::IsObstacle(const Vector3d& obstacle_position,
+                          double obstacle_radius) const {
+  const size_t idx = Index(Tile(obstacle_position));
+
+  for (const auto* tiles : { &loaded_, &added_ }) {
+    const auto iter = tiles->find(idx);
+    if (iter == tiles->end())
+      continue;
+
+    const Obstacles& tile = iter->second;
+    for (size_t ii = 0; ii < tile.points.size(); ii++)
+      if ((obstacle_position - tile.points[ii]).norm() < 1e-8 &&
+          std::abs(obstacle_radius - tile.radii[ii]) < 1e-8)
+        return true;
+  }
+
+  return false;
+}
+
+// Inherited visualizer from Box needs to be overwritten.
+void TiledBox::Visualize(const ros::Publisher& pub,
+                         const std::string& frame_id) const {
+  if (pub.getNumSubscribers() <= 0)
+    return;
+
+  // Box marker.
+  Box::Visualize(pub, frame_id);
+
+  // Visualize obstacles in memory as spheres.
+  int id = 0;
+  for (const auto* tiles : { &loaded_, &added_ }) {
+    for (const auto& entry : *tiles) {
+      const Obstacles& tile = entry.second;
+
+      for (size_t ii = 0; ii < tile.points.size(); ii++) {
+        visualization_msgs::Marker sphere;
+        sphere.ns = "sphere";
+        sphere.header.frame_id = frame_id;
+        sphere.header.stamp = ros::Time::now();
+        sphere.id = id++;
+        sphere.type = visualization_msgs::Marker::SPHERE;
+        sphere.action = visualization_msgs::Marker::ADD;
+
+        sphere.scale.x = 2.0 * tile.radii[ii];
+        sphere.scale.y = 2.0 * tile.radii[ii];
+        sphere.scale.z = 2.0 * tile.radii[ii];
+
+        sphere.color.a = 0.9;
+        sphere.color.r = 0.7;
+        sphere.color.g = 0.5;
+        sphere.color.b = 0.5;
+
+        geometry_msgs::Point p;
+        p.x = tile.points[ii](0);
+        p.y = tile.points[ii](1);
+        p.z = tile.points[ii](2);
+
+        sphere.pose.position = p;
+        sphere.pose.orientation.w = 1.0;
+
+        // Publish sphere marker.
+        pub.publish(sphere);
+      }
+    }
+  }
+}
+
+// Map the file and read its header. Returns whether it was successful.
+bool TiledBox::Load(const std::string& file_name) {
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    ROS_ERROR("Could not stat file: %s.", file_name.c_str());
+    close(fd);
+    return false;
+  }
+
+  map_size_ = static_cast<size_t>(file_stat.st_size);
+  map_ = (map_size_ > 0) ?
+    mmap(NULL, map_size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+  // The mapping holds its own reference to the file.
+  close(fd);
+
+  if (map_ == MAP_FAILED) {
+    ROS_ERROR("Could not map file: %s.", file_name.c_str());
+    return false;
+  }
+
+  // Tiles are loaded in no particular order.
+  madvise(map_, map_size_, MADV_RANDOM);
+
+  // Walk the header.
+  const char* cursor = static_cast<const char*>(map_);
+  const char* end = cursor + map_size_;
+
+  const size_t header_size =
+    sizeof(kMagic) + 3 * sizeof(uint64_t) + 5 * sizeof(double);
+  if (map_size_ < header_size ||
+      std::memcmp(cursor, kMagic, sizeof(kMagic)) != 0) {
+    ROS_ERROR("%s: Not a tiled environment file.", file_name.c_str());
+    return false;
+  }
+  cursor += sizeof(kMagic);
+
+  uint64_t num_tiles[3];
+  std::memcpy(num_tiles, cursor, sizeof(num_tiles));
+  cursor += sizeof(num_tiles);
+
+  double doubles[5];
+  std::memcpy(doubles, cursor, sizeof(doubles));
+  cursor += sizeof(doubles);
+
+  const size_t total_tiles = num_tiles[0] * num_tiles[1] * num_tiles[2];
+  if (total_tiles == 0 || doubles[3] <= 0.0) {
+    ROS_ERROR("%s: Empty tile grid.", file_name.c_str());
+    return false;
+  }
+
+  if (static_cast<size_t>(end - cursor) < (total_tiles + 1) * sizeof(uint64_t)) {
+    ROS_ERROR("%s: Truncated tile index.", file_name.c_str());
+    return false;
+  }
+
+  const uint64_t* offsets = reinterpret_cast<const uint64_t*>(cursor);
+  cursor += (total_tiles + 1) * sizeof(uint64_t);
+
+  for (size_t ii = 0; ii < total_tiles; ii++) {
+    if (offsets[ii] > offsets[ii + 1]) {
+      ROS_ERROR("%s: Corrupt tile index.", file_name.c_str());
+      return false;
+    }
+  }
+
+  if (offsets[0] != 0 || static_cast<size_t>(end - cursor) <
+      offsets[total_tiles] * 4 * sizeof(double)) {
+    ROS_ERROR("%s: Truncated obstacles.", file_name.c_str());
+    return false;
+  }
+
+  // Set up the grid.
+  for (size_t ii = 0; ii < 3; ii++)
+    num_tiles_(ii) = static_cast<int>(num_tiles[ii]);
+
+  const Vector3d lower(doubles[0], doubles[1], doubles[2]);
+  tile_size_ = doubles[3];
+  max_radius_ = std::max(max_radius_, doubles[4]);
+
+  SetBounds(lower, lower + tile_size_ * num_tiles_.cast<double>());
+
+  offsets_ = offsets;
+  obstacles_ = reinterpret_cast<const double*>(cursor);
+
+  // Nothing needs to be resident until tiles are activated.
+  madvise(map_, map_size_, MADV_DONTNEED);
+  return true;
+}
+
+// Release the pages of the mapping holding this tile's obstacles.
+void TiledBox::Release(size_t tile) const {
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+  // Only whole pages, so we never drop pages shared with other tiles.
+  const char* base = static_cast<const char*>(map_);
+  size_t begin = reinterpret_cast<const char*>(obstacles_ + 4 * offsets_[tile]) - base;
+  size_t end = reinterpret_cast<const char*>(obstacles_ + 4 * offsets_[tile + 1]) - base;
+
+  begin = ((begin + page_size - 1) / page_size) * page_size;
+  end = (end / page_size) * page_size;
+
+  if (begin < end)
+    madvise(static_cast<char*>(map_) + begin, end - begin, MADV_DONTNEED);
+}
+
+// Tile containing this point, clamped to the grid.
+Eigen::Vector3i TiledBox::Tile(const Vector3d& point) const {
+  Eigen::Vector3i tile;
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double index = std::floor((point(ii) - lower_(ii)) / tile_size_);
+    tile(ii) = static_cast<int>(
+      std::min(std::max(index, 0.0), num_tiles_(ii) - 1.0));
+  }
+
+  return tile;
+}
+
+// Index of a tile.
+size_t TiledBox::Index(const Eigen::Vector3i& tile) const {
+  return static_cast<size_t>(tile(0)) + static_cast<size_t>(num_tiles_(0)) *
+    (static_cast<size_t>(tile(1)) +
+     static_cast<size_t>(num_tiles_(1)) * static_cast<size_t>(tile(2)));
+}
+
+// Add all tiles within 'radius' of the segment [from, to] to the set.
+void TiledBox::AddTiles(const Vector3d& from, const Vector3d& to,
+                        double radius, std::unordered_set<size_t>& tiles) const {
+  const Eigen::Vector3i first =
+    Tile(from.cwiseMin(to) - Vector3d::Constant(radius));
+  const Eigen::Vector3i last =
+    Tile(from.cwiseMax(to) + Vector3d::Constant(radius));
+
+  // Compare distance from each tile center to the segment against the
+  // radius plus half the tile diagonal.
+  const Vector3d segment = to - from;
+  const double length_squared = segment.squaredNorm();
+  const double threshold = radius + 0.5 * std::sqrt(3.0) * tile_size_;
+
+  for (int z = first(2); z <= last(2); z++) {
+    for (int y = first(1); y <= last(1); y++) {
+      for (int x = first(0); x <= last(0); x++) {
+        const Vector3d center = lower_ + tile_size_ *
+          (Vector3d(x, y, z) + Vector3d::Constant(0.5));
+
+        const double t = (length_squared > 0.0) ?
+          std::min(std::max((center - from).dot(segment) / length_squared,
+                            0.0), 1.0) : 0.0;
+
+        if ((center - from - t * segment).norm() <= threshold)
+          tiles.insert(Index(Eigen::Vector3i(x, y, z)));
+      }
+    }
+  }
+}
+
+// Check if a sphere overlaps the tracking bound around a position.
+bool TiledBox::Overlaps(const Vector3d& position, const Vector3d& bound,
+                        const Vector3d& center, double radius) {
+  // Closest point in the tracking bound to the sphere center.
+  const Vector3d closest_point =
+    center.cwiseMax(position - bound).cwiseMin(position + bound);
+
+  return (closest_point - center).norm() <= radius;
+}
+
+// Write a file in the format read by this class. Returns whether it was
+// successful.
+bool TiledBox::Write(const std::string& file_name,
+                     const Vector3d& lower, const Vector3d& upper,
+                     double tile_size,
+                     const std::vector<Vector3d>& points,
+                     const std::vector<double>& radii) {
+  if (tile_size <= 0.0 || points.size() != radii.size() ||
+      (upper.array() <= lower.array()).any()) {
+    ROS_ERROR("Inconsistent parameters when writing %s.", file_name.c_str());
+    return false;
+  }
+
+  // Tile grid covering [lower, upper].
+  uint64_t num_tiles[3];
+  for (size_t ii = 0; ii < 3; ii++)
+    num_tiles[ii] = static_cast<uint64_t>(
+      std::max(std::ceil((upper(ii) - lower(ii)) / tile_size), 1.0));
+
+  const size_t total_tiles = num_tiles[0] * num_tiles[1] * num_tiles[2];
+
+  // Bucket obstacles by tile.
+  std::vector<size_t> tile_of(points.size());
+  std::vector<uint64_t> offsets(total_tiles + 1, 0);
+  double max_radius = 0.0;
+  for (size_t ii = 0; ii < points.size(); ii++) {
+    size_t idx = 0;
+    for (int jj = 2; jj >= 0; jj--) {
+      const double index = std::floor((points[ii](jj) - lower(jj)) / tile_size);
+      idx = idx * num_tiles[jj] + static_cast<size_t>(
+        std::min(std::max(index, 0.0), num_tiles[jj] - 1.0));
+    }
+
+    tile_of[ii] = idx;
+    offsets[idx + 1]++;
+    max_radius = std::max(max_radius, radii[ii]);
+  }
+
+  for (size_t ii = 0; ii < total_tiles; ii++)
+    offsets[ii + 1] += offsets[ii];
+
+  std::vector<double> obstacles(4 * points.size());
+  std::vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t ii = 0; ii < points.size(); ii++) {
+    double* obstacle = obstacles.data() + 4 * next[tile_of[ii]]++;
+    obstacle[0] = points[ii](0);
+    obstacle[1] = points[ii](1);
+    obstacle[2] = points[ii](2);
+    obstacle[3] = radii[ii];
+  }
+
+  std::ofstream file(file_name.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  const double doubles[5] = { lower(0), lower(1), lower(2),
+                              tile_size, max_radius };
+
+  file.write(kMagic, sizeof(kMagic));
+  file.write(reinterpret_cast<const char*>(num_tiles), sizeof(num_tiles));
+  file.write(reinterpret_cast<const char*>(doubles), sizeof(doubles));
+  file.write(reinterpret_cast<const char*>(offsets.data()),
+             offsets.size() * sizeof(uint64_t));
+  file.write(reinterpret_cast<const char*>(obstacles.data()),
+             obstacles.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("Error writing file: %s.", file_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+} //\namespace meta
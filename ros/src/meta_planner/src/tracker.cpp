@@ -44,11 +44,17 @@
 #include <crazyflie_utils/angles.h>
 
 #include <stdlib.h>
+#include <fstream>
+#include <algorithm>
 
 namespace meta {
 
 Tracker::Tracker()
-  : in_flight_(false),
+  : state_time_(0.0),
+    actuation_delay_(0.0),
+    merge_control_(false),
+    merge_mode_(MERGE),
+    in_flight_(false),
     been_updated_(false),
     initialized_(false) {}
 
@@ -71,10 +77,18 @@ bool Tracker::Initialize(const ros::NodeHandle& n) {
   // Set the initial state and reference to zero.
   state_ = VectorXd::Zero(state_dim_);
   reference_ = VectorXd::Zero(state_dim_);
+  compensated_state_ = VectorXd::Zero(state_dim_);
+
+  // Preallocate per-tick buffers so that ticks don't allocate.
+  relative_state_ = VectorXd::Zero(state_dim_);
+  tracking_error_ = VectorXd::Zero(state_dim_);
+  optimal_control_ = VectorXd::Zero(control_dim_);
+  applied_control_ = VectorXd::Zero(control_dim_);
 
   // Start control and bound values at most/least conservative.
   control_value_id_ = 0;
   bound_value_id_ = 0;
+  control_start_time_ = -1.0;
 
   initialized_ = true;
   return true;
@@ -113,6 +127,100 @@ bool Tracker::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("frames/tracker", tracker_frame_id_)) return false;
   if (!nl.getParam("frames/planner", planner_frame_id_)) return false;
 
+  // Optional latency compensation.
+  bool predict = false;
+  nl.param("prediction/enabled", predict, false);
+  if (predict) {
+    // HACK! Assuming state layout.
+    if (state_dim_ != 6 || control_dim_ != 3) {
+      ROS_ERROR("%s: State prediction assumes near-hover quadrotor dynamics.",
+                name_.c_str());
+      return false;
+    }
+
+    double max_horizon = 0.1;
+    nl.param("prediction/max_horizon", max_horizon, 0.1);
+    nl.param("prediction/actuation_delay", actuation_delay_, 0.0);
+
+    predictor_ = StatePredictor::Create(max_horizon);
+  }
+
+  // Optional in-process LQR/optimal control merging. The merge mode should
+  // match the merger node's when merging there instead, since prediction
+  // needs the control that is actually applied.
+  nl.param("control/merge", merge_control_, false);
+
+  std::string mode = "MERGE";
+  nl.param("control/merge_mode", mode, std::string("MERGE"));
+  if (mode == "MERGE")
+    merge_mode_ = MERGE;
+  else if (mode == "OPTIMAL")
+    merge_mode_ = OPTIMAL;
+  else if (mode == "LQR")
+    merge_mode_ = LQR;
+  else {
+    ROS_ERROR("%s: Unknown merge mode %s.", name_.c_str(), mode.c_str());
+    return false;
+  }
+
+  if (merge_control_ &&
+      !nl.getParam("topics/merged", merged_control_topic_)) return false;
+
+  // LQR gains, for merging or for predicting the merged control.
+  if (merge_control_ || predictor_) {
+    if (!nl.getParam("lqr/K_file", lqr_K_file_)) return false;
+    if (!nl.getParam("lqr/u_ref_file", lqr_u_ref_file_)) return false;
+
+    if (!LoadMatrix(lqr_K_file_, control_dim_, state_dim_, lqr_K_))
+      return false;
+
+    MatrixXd u_ref;
+    if (!LoadMatrix(lqr_u_ref_file_, control_dim_, 1, u_ref))
+      return false;
+
+    lqr_u_ref_ = u_ref.col(0);
+  }
+
+  // Optional flight data recorder.
+  bool record = false;
+  nl.param("recorder/enabled", record, false);
+  if (record) {
+    if (!nl.getParam("recorder/file", recorder_file_)) return false;
+
+    recorder_ = FlightRecorder::Create(recorder_file_);
+    if (!recorder_)
+      return false;
+  }
+
+  // Optional control loop timing.
+  bool timing = false;
+  nl.param("timing/enabled", timing, false);
+  if (timing)
+    timing_ = LoopTiming::Create(time_step_);
+
+  return true;
+}
+
+// Load a whitespace-delimited matrix of known size from a text file.
+bool Tracker::LoadMatrix(const std::string& file_name,
+                         size_t rows, size_t cols, MatrixXd& matrix) const {
+  std::ifstream file(file_name.c_str());
+  if (!file.is_open()) {
+    ROS_ERROR("%s: Could not open %s.", name_.c_str(), file_name.c_str());
+    return false;
+  }
+
+  matrix = MatrixXd::Zero(rows, cols);
+  for (size_t ii = 0; ii < rows; ii++) {
+    for (size_t jj = 0; jj < cols; jj++) {
+      if (!(file >> matrix(ii, jj))) {
+        ROS_ERROR("%s: Expected a %zu x %zu matrix in %s.", name_.c_str(),
+                  rows, cols, file_name.c_str());
+        return false;
+      }
+    }
+  }
+
   return true;
 }
 
@@ -137,6 +245,10 @@ bool Tracker::RegisterCallbacks(const ros::NodeHandle& n) {
   control_pub_ = nl.advertise<crazyflie_msgs::NoYawControlStamped>(
     control_topic_.c_str(), 1, false);
 
+  if (merge_control_)
+    merged_control_pub_ = nl.advertise<crazyflie_msgs::NoYawControlStamped>(
+      merged_control_topic_.c_str(), 1, false);
+
   // Service clients.
   optimal_control_srv_ = nl.serviceClient<value_function::OptimalControl>(
     optimal_control_name_.c_str(), true);
@@ -162,6 +274,18 @@ StateCallback(const crazyflie_msgs::PositionStateStamped::ConstPtr& msg) {
   state_(4) = msg->state.y_dot;
   state_(5) = msg->state.z_dot;
 
+  // Time of measurement. Unstamped states are assumed to be as old as the
+  // average latency of stamped ones.
+  const double arrival_time = ros::Time::now().toSec();
+  if (predictor_) {
+    if (msg->header.stamp.toSec() > 0.0) {
+      state_time_ = msg->header.stamp.toSec();
+      predictor_->RecordLatency(arrival_time - state_time_);
+    } else {
+      state_time_ = arrival_time - predictor_->Latency();
+    }
+  }
+
   been_updated_ = true;
 }
 
@@ -182,17 +306,50 @@ void Tracker::ControllerIdCallback(
   const meta_planner_msgs::ControllerId::ConstPtr& msg) {
   control_value_id_ = msg->control_value_function_id;
   bound_value_id_ = msg->bound_value_function_id;
+  control_start_time_ = msg->control_start_time;
 }
 
-// Callback for applying tracking controller.
+// Timer callback. Runs one control tick and records its timing.
 void Tracker::TimerCallback(const ros::TimerEvent& e) {
+  const ros::WallTime start = ros::WallTime::now();
+
+  Tick();
+
+  if (timing_)
+    timing_->RecordTick((e.current_real - e.current_expected).toSec(),
+                        (ros::WallTime::now() - start).toSec());
+}
+
+// Apply the tracking controller once.
+void Tracker::Tick() {
   if (!in_flight_ || !been_updated_)
     return;
 
+  const ros::Time right_now = ros::Time::now();
+
+  // (0) Compensate for latency by predicting where we will be when this
+  // tick's control is applied.
+  const VectorXd* state = &state_;
+  if (predictor_) {
+    measured_state_ = state_.head<6>();
+    predictor_->Predict(measured_state_, state_time_,
+                        right_now.toSec() + actuation_delay_,
+                        predicted_state_);
+
+    compensated_state_.head<6>() = predicted_state_;
+    state = &compensated_state_;
+  }
+
   // HACK! Assuming state layout.
-  const VectorXd relative_state = state_ - reference_;
+  relative_state_ = *state - reference_;
   const Vector3d planner_position(reference_(0), reference_(1), reference_(2));
 
+  // Time since tracking with the control value function began, so that
+  // time-varying value functions give the control backing the bound the
+  // trajectory interpreter reports. Negative before we know.
+  const double control_time = (control_start_time_ < 0.0) ?
+    -1.0 : std::max(0.0, right_now.toSec() - control_start_time_);
+
   // (1) Get priority.
   if (!priority_srv_) {
     ROS_WARN("%s: Priority server disconnected.", name_.c_str());
@@ -208,7 +365,8 @@ void Tracker::TimerCallback(const ros::TimerEvent& e) {
 
   value_function::Priority p;
   p.request.id = control_value_id_;
-  p.request.state = utils::PackState(relative_state);
+  p.request.time = control_time;
+  p.request.state = utils::PackState(relative_state_);
   if (!priority_srv_.call(p))
     ROS_ERROR("%s: Error calling priority server.", name_.c_str());
   else
@@ -225,29 +383,107 @@ void Tracker::TimerCallback(const ros::TimerEvent& e) {
     return;
   }
 
-  VectorXd optimal_control(control_dim_);
+  optimal_control_.setZero();
 
   value_function::OptimalControl c;
   c.request.id = control_value_id_;
-  c.request.state = utils::PackState(relative_state);
+  c.request.time = control_time;
+  c.request.state = utils::PackState(relative_state_);
   if (!optimal_control_srv_.call(c))
     ROS_ERROR("%s: Error calling optimal control server.", name_.c_str());
-  else
-    optimal_control = utils::Unpack(c.response.control);
+  else if (c.response.control.control.size() != control_dim_)
+    ROS_ERROR("%s: Optimal control had the wrong dimension.", name_.c_str());
+  else {
+    for (size_t ii = 0; ii < control_dim_; ii++)
+      optimal_control_(ii) = c.response.control.control[ii];
+  }
 
   // (3) Publish optimal control with priority in (0, 1).
   crazyflie_msgs::NoYawControlStamped control_msg;
-  control_msg.header.stamp = ros::Time::now();
+  control_msg.header.stamp = right_now;
 
   // NOTE! Remember, control is assumed to be [pitch, roll, thrust].
   control_msg.control.pitch =
-    crazyflie_utils::angles::WrapAngleRadians(optimal_control(0));
+    crazyflie_utils::angles::WrapAngleRadians(optimal_control_(0));
   control_msg.control.roll =
-    crazyflie_utils::angles::WrapAngleRadians(optimal_control(1));
-  control_msg.control.thrust = optimal_control(2);
+    crazyflie_utils::angles::WrapAngleRadians(optimal_control_(1));
+  control_msg.control.thrust = optimal_control_(2);
   control_msg.control.priority = priority;
 
   control_pub_.publish(control_msg);
+
+  // (4) Work out the control which will actually be applied. Without
+  // in-process merging we don't see the merged control, so merge here the
+  // same way the merger node does, with our own LQR gains as the prior.
+  if (merge_control_ || predictor_)
+    MergeControl(*state, optimal_control_, priority, applied_control_);
+  else
+    applied_control_ = optimal_control_;
+
+  // If merging in-process, publish merged control on the same tick.
+  if (merge_control_) {
+    crazyflie_msgs::NoYawControlStamped merged_msg;
+    merged_msg.header.stamp = control_msg.header.stamp;
+
+    merged_msg.control.pitch =
+      crazyflie_utils::angles::WrapAngleRadians(applied_control_(0));
+    merged_msg.control.roll =
+      crazyflie_utils::angles::WrapAngleRadians(applied_control_(1));
+    merged_msg.control.thrust = applied_control_(2);
+    merged_msg.control.priority = priority;
+
+    merged_control_pub_.publish(merged_msg);
+  }
+
+  // Remember what will be applied, for predicting the next state.
+  if (predictor_)
+    predictor_->RecordControl(right_now.toSec() + actuation_delay_,
+                              applied_control_.head<3>());
+
+  // (5) Record this tick. Never blocks.
+  if (recorder_) {
+    FlightRecorder::Record record;
+    record.values[FlightRecorder::TIME] = control_msg.header.stamp.toSec();
+
+    // HACK! Assuming state layout.
+    for (size_t ii = 0; ii < 6; ii++) {
+      record.values[FlightRecorder::STATE_X + ii] = state_(ii);
+      record.values[FlightRecorder::REF_X + ii] = reference_(ii);
+    }
+
+    record.values[FlightRecorder::PITCH] =
+      crazyflie_utils::angles::WrapAngleRadians(applied_control_(0));
+    record.values[FlightRecorder::ROLL] =
+      crazyflie_utils::angles::WrapAngleRadians(applied_control_(1));
+    record.values[FlightRecorder::THRUST] = applied_control_(2);
+    record.values[FlightRecorder::PRIORITY] = priority;
+    record.values[FlightRecorder::CONTROL_VALUE_ID] = control_value_id_;
+    record.values[FlightRecorder::BOUND_VALUE_ID] = bound_value_id_;
+
+    recorder_->Push(record);
+  }
+}
+
+// Compute the LQR control for the given state and current reference, and
+// combine it with the given optimal control according to the merge mode.
+// Writes into 'merged', which must already have the control dimension.
+void Tracker::MergeControl(const VectorXd& state,
+                           const VectorXd& optimal_control,
+                           double priority, VectorXd& merged) const {
+  if (merge_mode_ == OPTIMAL) {
+    merged = optimal_control;
+    return;
+  }
+
+  tracking_error_ = reference_ - state;
+  merged = lqr_u_ref_;
+  merged.noalias() += lqr_K_ * tracking_error_;
+  if (merge_mode_ == LQR)
+    return;
+
+  // Clamp priority to [0, 1] before blending.
+  priority = std::max(0.0, std::min(1.0, priority));
+  merged = priority * optimal_control + (1.0 - priority) * merged;
 }
 
 } //\namespace meta
@@ -123,6 +123,16 @@ Create(const Trajectory::ConstPtr& other, double start) {
   return traj;
 }
 
+// Time stamps of all states, in increasing order.
+std::vector<double> Trajectory::Times() const {
+  std::vector<double> times;
+  times.reserve(map_.size());
+  for (const auto& pair : map_)
+    times.push_back(pair.first);
+
+  return times;
+}
+
 // Convert to ROS message.
 meta_planner_msgs::Trajectory Trajectory::ToRosMessage() const {
   meta_planner_msgs::Trajectory traj_msg;
@@ -50,6 +50,12 @@ namespace meta {
 TrajectoryInterpreter::TrajectoryInterpreter()
   : in_flight_(false),
     been_updated_(false),
+    have_control_value_id_(false),
+    control_value_id_(0),
+    control_start_time_(0.0),
+    have_bound_value_id_(false),
+    bound_value_id_(0),
+    bound_start_time_(0.0),
     initialized_(false) {}
 
 TrajectoryInterpreter::~TrajectoryInterpreter() {}
@@ -117,6 +123,12 @@ bool TrajectoryInterpreter::LoadParameters(const ros::NodeHandle& n) {
   if (!nl.getParam("frames/tracker", tracker_frame_id_)) return false;
   if (!nl.getParam("frames/planner", planner_frame_id_)) return false;
 
+  // Optional control loop timing.
+  bool timing = false;
+  nl.param("timing/enabled", timing, false);
+  if (timing)
+    timing_ = LoopTiming::Create(time_step_);
+
   return true;
 }
 
@@ -205,8 +217,19 @@ TriggerReplanCallback(const std_msgs::Empty::ConstPtr& msg) {
   RequestNewTrajectory();
 }
 
-// Callback for applying tracking controller.
+// Timer callback. Runs one tick and records its timing.
 void TrajectoryInterpreter::TimerCallback(const ros::TimerEvent& e) {
+  const ros::WallTime start = ros::WallTime::now();
+
+  Tick();
+
+  if (timing_)
+    timing_->RecordTick((e.current_real - e.current_expected).toSec(),
+                        (ros::WallTime::now() - start).toSec());
+}
+
+// Publish the reference and controller IDs for the current time once.
+void TrajectoryInterpreter::Tick() {
   if (!in_flight_ || !been_updated_)
     return;
 
@@ -261,6 +284,24 @@ void TrajectoryInterpreter::TimerCallback(const ros::TimerEvent& e) {
   const ValueFunctionId bound_value_id =
     traj_->GetBoundValueFunction(current_time.toSec());
 
+  // Time-varying value functions depend on how long we have been tracking
+  // with them. Once the bound value function is also the one in control,
+  // its bound is taken at the same time as the tracker's control.
+  if (!have_control_value_id_ || control_value_id != control_value_id_) {
+    control_value_id_ = control_value_id;
+    control_start_time_ = current_time.toSec();
+    have_control_value_id_ = true;
+  }
+
+  if (!have_bound_value_id_ || bound_value_id != bound_value_id_) {
+    bound_value_id_ = bound_value_id;
+    bound_start_time_ = current_time.toSec();
+    have_bound_value_id_ = true;
+  }
+
+  const double bound_start_time = (bound_value_id == control_value_id) ?
+    control_start_time_ : bound_start_time_;
+
   // Publish planner position to the reference topic.
   // HACK! Assuming planner state order.
   crazyflie_msgs::PositionStateStamped reference;
@@ -279,6 +320,7 @@ void TrajectoryInterpreter::TimerCallback(const ros::TimerEvent& e) {
   meta_planner_msgs::ControllerId controller_id;
   controller_id.control_value_function_id = control_value_id;
   controller_id.bound_value_function_id = bound_value_id;
+  controller_id.control_start_time = control_start_time_;
 
   controller_id_pub_.publish(controller_id);
 
@@ -303,6 +345,7 @@ void TrajectoryInterpreter::TimerCallback(const ros::TimerEvent& e) {
   } else {
     value_function::TrackingBoundBox b;
     b.request.id = bound_value_id;
+    b.request.time = current_time.toSec() - bound_start_time;
     if (!tracking_bound_srv_.call(b))
       ROS_ERROR("%s: Tracking bound server error.", name_.c_str());
     else {
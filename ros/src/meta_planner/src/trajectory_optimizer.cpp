@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TrajectoryOptimizer class, which computes a smooth,
+// rest-to-rest trajectory between two points over a short horizon by
+// sequential convex programming.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/trajectory_optimizer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <math.h>
+
+namespace meta {
+
+// ADMM parameters.
+const size_t TrajectoryOptimizer::kMaxQpIterations = 4000;
+const double TrajectoryOptimizer::kQpTolerance = 1e-5;
+const double TrajectoryOptimizer::kRho = 0.1;
+const double TrajectoryOptimizer::kSigma = 1e-6;
+const double TrajectoryOptimizer::kAlpha = 1.6;
+
+// Factory method. Use this instead of the constructor.
+TrajectoryOptimizer::Ptr TrajectoryOptimizer::
+Create(size_t horizon, size_t max_iterations, double time_scale) {
+  TrajectoryOptimizer::Ptr ptr(
+    new TrajectoryOptimizer(horizon, max_iterations, time_scale));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+TrajectoryOptimizer::TrajectoryOptimizer(size_t horizon,
+                                         size_t max_iterations,
+                                         double time_scale)
+  : horizon_(std::max<size_t>(2, horizon)),
+    max_iterations_(std::max<size_t>(1, max_iterations)),
+    time_scale_(std::max(1.0, time_scale)),
+    activation_distance_(1.0),
+    lower_(Vector3d::Constant(-std::numeric_limits<double>::infinity())),
+    upper_(Vector3d::Constant(std::numeric_limits<double>::infinity())),
+    max_speed_(Vector3d::Ones()),
+    max_acceleration_(Vector3d::Ones()),
+    padding_(Vector3d::Zero()) {}
+
+// Problem setup.
+void TrajectoryOptimizer::SetBounds(const Vector3d& lower,
+                                    const Vector3d& upper) {
+  lower_ = lower;
+  upper_ = upper;
+}
+
+void TrajectoryOptimizer::SetLimits(const Vector3d& max_speed,
+                                    const Vector3d& max_acceleration) {
+  max_speed_ = max_speed;
+  max_acceleration_ = max_acceleration;
+}
+
+void TrajectoryOptimizer::SetPadding(const Vector3d& padding) {
+  padding_ = padding;
+}
+
+void TrajectoryOptimizer::SetObstacles(const std::vector<Vector3d>& centers,
+                                       const std::vector<double>& radii) {
+  centers_ = centers;
+  radii_ = radii;
+  radii_.resize(centers_.size(), 0.0);
+}
+
+void TrajectoryOptimizer::SetActivationDistance(double distance) {
+  activation_distance_ = distance;
+}
+
+// Optimize a trajectory from start to stop, spending at most 'budget'
+// seconds. On success, returns the horizon + 1 knot positions (starting
+// at start and ending at stop) and the time step between them.
+bool TrajectoryOptimizer::Optimize(const Vector3d& start,
+                                   const Vector3d& stop, double budget,
+                                   std::vector<Vector3d>& positions,
+                                   double& dt) const {
+  const std::chrono::steady_clock::time_point begin =
+    std::chrono::steady_clock::now();
+
+  for (size_t ii = 0; ii < 3; ii++) {
+    if (max_speed_(ii) <= 0.0 || max_acceleration_(ii) <= 0.0)
+      return false;
+  }
+
+  // Horizon time is the slowest dimension's minimum time, stretched.
+  double horizon_time = 0.0;
+  for (size_t ii = 0; ii < 3; ii++)
+    horizon_time = std::max(horizon_time,
+                            MinimumTime(std::abs(stop(ii) - start(ii)), ii));
+
+  if (horizon_time <= 0.0)
+    return false;
+
+  const size_t N = horizon_;
+  dt = time_scale_ * horizon_time / static_cast<double>(N);
+
+  // Linear maps from accelerations to knot positions and velocities
+  // (per dimension, so only the scalar coefficients are stored):
+  //   p_k = start + sum_{j < k} pos_coeff(k, j) u_j
+  //   v_k =         sum_{j < k} vel_coeff       u_j
+  MatrixXd pos_coeff = MatrixXd::Zero(N + 1, N);
+  for (size_t kk = 1; kk <= N; kk++)
+    for (size_t jj = 0; jj < kk; jj++)
+      pos_coeff(kk, jj) = dt * dt * (static_cast<double>(kk - jj) - 0.5);
+  const double vel_coeff = dt;
+
+  // Fixed constraints: terminal position and velocity, intermediate
+  // position and velocity bounds, and acceleration bounds.
+  const size_t num_vars = 3 * N;
+  const size_t num_equality = 6;
+  const size_t num_fixed = num_equality + 6 * (N - 1) + num_vars;
+
+  MatrixXd fixed_A = MatrixXd::Zero(num_fixed, num_vars);
+  VectorXd fixed_l(num_fixed);
+  VectorXd fixed_u(num_fixed);
+
+  size_t row = 0;
+  for (size_t ii = 0; ii < 3; ii++, row++) {
+    for (size_t jj = 0; jj < N; jj++)
+      fixed_A(row, 3 * jj + ii) = pos_coeff(N, jj);
+    fixed_l(row) = fixed_u(row) = stop(ii) - start(ii);
+  }
+
+  for (size_t ii = 0; ii < 3; ii++, row++) {
+    for (size_t jj = 0; jj < N; jj++)
+      fixed_A(row, 3 * jj + ii) = vel_coeff;
+    fixed_l(row) = fixed_u(row) = 0.0;
+  }
+
+  for (size_t kk = 1; kk < N; kk++) {
+    for (size_t ii = 0; ii < 3; ii++, row++) {
+      for (size_t jj = 0; jj < kk; jj++)
+        fixed_A(row, 3 * jj + ii) = pos_coeff(kk, jj);
+      fixed_l(row) = lower_(ii) + padding_(ii) - start(ii);
+      fixed_u(row) = upper_(ii) - padding_(ii) - start(ii);
+    }
+
+    for (size_t ii = 0; ii < 3; ii++, row++) {
+      for (size_t jj = 0; jj < kk; jj++)
+        fixed_A(row, 3 * jj + ii) = vel_coeff;
+      fixed_l(row) = -max_speed_(ii);
+      fixed_u(row) = max_speed_(ii);
+    }
+  }
+
+  for (size_t jj = 0; jj < N; jj++) {
+    for (size_t ii = 0; ii < 3; ii++, row++) {
+      fixed_A(row, 3 * jj + ii) = 1.0;
+      fixed_l(row) = -max_acceleration_(ii);
+      fixed_u(row) = max_acceleration_(ii);
+    }
+  }
+
+  // Minimize total squared acceleration.
+  const MatrixXd P = MatrixXd::Identity(num_vars, num_vars);
+  const VectorXd q = VectorXd::Zero(num_vars);
+
+  // Obstacles are kept clear between knots as well: within half a step of
+  // the nearest knot, the vehicle moves no farther than half a step at top
+  // speed in each axis, so the padding box grows by that much per axis.
+  // Constraints add a small buffer on top so that solutions within the QP
+  // tolerance still clear it.
+  const Vector3d swept_padding = padding_ + 0.5 * dt * max_speed_;
+  const double kBuffer = 1e-2;
+
+  // The first iterate is the straight line from start to stop, so normals
+  // from an obstacle to its knots point along the line for obstacles on or
+  // near it, and the half-spaces would block all progress. Linearize that
+  // iterate with normals perpendicular to the line instead, so that the
+  // next one detours around the side.
+  const Vector3d direction = (stop - start).normalized();
+
+  VectorXd u = VectorXd::Zero(num_vars);
+  VectorXd y = VectorXd::Zero(num_fixed);
+  bool found = false;
+
+  // Knot/obstacle pairs which have been near in any iterate so far. Pairs
+  // stay active once activated, so that the iterates do not oscillate
+  // between avoiding an obstacle and forgetting about it.
+  std::vector<bool> active((N + 1) * centers_.size(), false);
+
+  for (size_t iter = 0; iter < max_iterations_; iter++) {
+    const std::vector<Vector3d> previous = Positions(start, u, dt);
+
+    // Linearize obstacles near each intermediate knot of the current
+    // iterate. The first pass is obstacle free.
+    std::vector<size_t> knots;
+    std::vector<Vector3d> normals;
+    std::vector<double> offsets;
+    if (iter > 0) {
+      for (size_t kk = 1; kk < N; kk++) {
+        for (size_t ii = 0; ii < centers_.size(); ii++) {
+          const size_t pair = kk * centers_.size() + ii;
+          if (Clearance(previous[kk], ii, swept_padding) <=
+              activation_distance_)
+            active[pair] = true;
+
+          if (!active[pair])
+            continue;
+
+          const Vector3d normal = (iter == 1) ?
+            DetourNormal(previous[kk], ii, direction) :
+            KnotNormal(previous[kk], ii);
+
+          knots.push_back(kk);
+          normals.push_back(normal);
+          offsets.push_back(normal.dot(centers_[ii]) + radii_[ii] +
+                            normal.cwiseAbs().dot(swept_padding) + kBuffer);
+        }
+      }
+    }
+
+    const size_t num_rows = num_fixed + knots.size();
+    MatrixXd A(num_rows, num_vars);
+    VectorXd l(num_rows);
+    VectorXd h(num_rows);
+    A.topRows(num_fixed) = fixed_A;
+    l.head(num_fixed) = fixed_l;
+    h.head(num_fixed) = fixed_u;
+
+    for (size_t ii = 0; ii < knots.size(); ii++) {
+      const size_t r = num_fixed + ii;
+      A.row(r).setZero();
+      for (size_t jj = 0; jj < knots[ii]; jj++)
+        for (size_t dd = 0; dd < 3; dd++)
+          A(r, 3 * jj + dd) = normals[ii](dd) * pos_coeff(knots[ii], jj);
+
+      l(r) = offsets[ii] - normals[ii].dot(start);
+      h(r) = std::numeric_limits<double>::infinity();
+    }
+
+    // Warm start from the previous iterate and fixed-row multipliers.
+    VectorXd warm_y = VectorXd::Zero(num_rows);
+    warm_y.head(num_fixed) = y.head(num_fixed);
+
+    VectorXd next = u;
+    if (!SolveQp(P, q, A, l, h, next, warm_y))
+      break;
+
+    const double change = (next - u).lpNorm<Eigen::Infinity>();
+    u = next;
+    y = warm_y;
+
+    // Only accept a clear iterate once the sequence has converged to a
+    // (local) optimum. The first pass ignores obstacles, so it never counts
+    // as converged on its own.
+    const std::vector<Vector3d> current = Positions(start, u, dt);
+    if (iter > 0 && change < 1e-3 * max_acceleration_.maxCoeff()) {
+      if (IsClear(current, swept_padding)) {
+        positions = current;
+        found = true;
+      }
+
+      break;
+    }
+
+    const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+    if (elapsed > budget)
+      break;
+  }
+
+  if (!found)
+    return false;
+
+  // Snap the last knot to the goal, within the QP tolerance of the
+  // solution, and make sure it is still clear.
+  positions.back() = stop;
+  return IsClear(positions, swept_padding);
+}
+
+// Minimum time to go from rest to rest over this distance in the given
+// dimension, under the speed and acceleration limits.
+double TrajectoryOptimizer::MinimumTime(double distance,
+                                        size_t dimension) const {
+  const double v = max_speed_(dimension);
+  const double a = max_acceleration_(dimension);
+
+  // Accelerate, cruise, decelerate if there is room to reach top speed.
+  if (distance >= v * v / a)
+    return distance / v + v / a;
+
+  return 2.0 * std::sqrt(distance / a);
+}
+
+// Knot positions for the given accelerations.
+std::vector<Vector3d> TrajectoryOptimizer::
+Positions(const Vector3d& start, const VectorXd& u, double dt) const {
+  std::vector<Vector3d> positions(horizon_ + 1, start);
+
+  Vector3d velocity = Vector3d::Zero();
+  for (size_t kk = 0; kk < horizon_; kk++) {
+    const Vector3d accel = u.segment<3>(3 * kk);
+    positions[kk + 1] = positions[kk] + dt * velocity + 0.5 * dt * dt * accel;
+    velocity += dt * accel;
+  }
+
+  return positions;
+}
+
+// Unit normal from the given obstacle's center towards this knot.
+Vector3d TrajectoryOptimizer::KnotNormal(const Vector3d& position,
+                                         size_t obstacle) const {
+  const Vector3d normal = position - centers_[obstacle];
+  if (normal.norm() < 1e-8)
+    return Vector3d::UnitZ();
+
+  return normal.normalized();
+}
+
+// Unit normal from the given obstacle towards this knot of a straight line
+// with the given direction, perpendicular to the line. If the line runs
+// through the center, pick a side: horizontal if possible, towards the
+// middle of the bounds if they are finite.
+Vector3d TrajectoryOptimizer::DetourNormal(const Vector3d& position,
+                                           size_t obstacle,
+                                           const Vector3d& direction) const {
+  Vector3d normal = position - centers_[obstacle];
+  normal -= normal.dot(direction) * direction;
+  if (normal.norm() >= 1e-8)
+    return normal.normalized();
+
+  normal = direction.cross(Vector3d::UnitZ());
+  if (normal.norm() < 1e-8)
+    normal = direction.cross(Vector3d::UnitX());
+
+  const Vector3d middle = 0.5 * (lower_ + upper_);
+  if (middle.allFinite() && normal.dot(middle - centers_[obstacle]) < 0.0)
+    normal = -normal;
+
+  return normal.normalized();
+}
+
+// Distance from the given padding box around this point to the given
+// obstacle (negative inside).
+double TrajectoryOptimizer::Clearance(const Vector3d& position,
+                                      size_t obstacle,
+                                      const Vector3d& padding) const {
+  const Vector3d& center = centers_[obstacle];
+
+  // Closest point of the box to the center.
+  Vector3d closest;
+  for (size_t ii = 0; ii < 3; ii++)
+    closest(ii) = std::min(std::max(center(ii), position(ii) - padding(ii)),
+                           position(ii) + padding(ii));
+
+  return (closest - center).norm() - radii_[obstacle];
+}
+
+// Check that the given padding box around each knot clears every obstacle.
+bool TrajectoryOptimizer::IsClear(const std::vector<Vector3d>& positions,
+                                  const Vector3d& padding) const {
+  for (const auto& position : positions) {
+    for (size_t ii = 0; ii < centers_.size(); ii++) {
+      if (Clearance(position, ii, padding) <= 0.0)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+// Solve min 0.5 x'Px + q'x s.t. l <= Ax <= u with ADMM, starting from
+// (and returning in) x and y. Returns false if not converged.
+bool TrajectoryOptimizer::SolveQp(const MatrixXd& P, const VectorXd& q,
+                                  const MatrixXd& A, const VectorXd& l,
+                                  const VectorXd& u, VectorXd& x,
+                                  VectorXd& y) {
+  // Stiffer penalty on equality rows.
+  VectorXd rho(A.rows());
+  for (int ii = 0; ii < A.rows(); ii++)
+    rho(ii) = (l(ii) == u(ii)) ? 1e3 * kRho : kRho;
+
+  const MatrixXd K = P + kSigma * MatrixXd::Identity(P.rows(), P.cols()) +
+    A.transpose() * rho.asDiagonal() * A;
+  const Eigen::LDLT<MatrixXd> ldlt(K);
+  if (ldlt.info() != Eigen::Success)
+    return false;
+
+  VectorXd z = (A * x).cwiseMax(l).cwiseMin(u);
+
+  for (size_t iter = 0; iter < kMaxQpIterations; iter++) {
+    const VectorXd rhs = kSigma * x - q +
+      A.transpose() * (rho.cwiseProduct(z) - y);
+    const VectorXd x_tilde = ldlt.solve(rhs);
+    const VectorXd z_tilde = A * x_tilde;
+
+    x = kAlpha * x_tilde + (1.0 - kAlpha) * x;
+    const VectorXd z_relaxed = kAlpha * z_tilde + (1.0 - kAlpha) * z;
+    const VectorXd z_next =
+      (z_relaxed + y.cwiseQuotient(rho)).cwiseMax(l).cwiseMin(u);
+    y += rho.cwiseProduct(z_relaxed - z_next);
+    z = z_next;
+
+    // Check primal and dual residuals every so often.
+    if (iter % 10 != 0)
+      continue;
+
+    const VectorXd Ax = A * x;
+    const VectorXd Px = P * x;
+    const VectorXd Aty = A.transpose() * y;
+    const double primal = (Ax - z).lpNorm<Eigen::Infinity>();
+    const double dual = (Px + q + Aty).lpNorm<Eigen::Infinity>();
+
+    const double primal_tol = kQpTolerance + kQpTolerance *
+      std::max(Ax.lpNorm<Eigen::Infinity>(), z.lpNorm<Eigen::Infinity>());
+    const double dual_tol = kQpTolerance + kQpTolerance *
+      std::max(Px.lpNorm<Eigen::Infinity>(), Aty.lpNorm<Eigen::Infinity>());
+
+    if (primal < primal_tol && dual < dual_tol)
+      return true;
+  }
+
+  return false;
+}
+
+} //\namespace meta
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ValidityCache class, which memoizes collision check results
+// by planner pair and quantized position.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/validity_cache.h>
+
+#include <math.h>
+
+namespace meta {
+
+// Factory method. Use this instead of the constructor.
+ValidityCache::Ptr ValidityCache::Create(double resolution,
+                                         size_t max_entries) {
+  ValidityCache::Ptr ptr(new ValidityCache(resolution, max_entries));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+ValidityCache::ValidityCache(double resolution, size_t max_entries)
+  : resolution_(resolution),
+    max_entries_(max_entries),
+    epoch_(0),
+    hits_(0),
+    misses_(0) {}
+
+// Look up the result for this position and planner pair.
+bool ValidityCache::Lookup(const Vector3d& position,
+                           ValueFunctionId incoming_value,
+                           ValueFunctionId outgoing_value,
+                           size_t epoch, bool& valid) {
+  const Key key = MakeKey(position, incoming_value, outgoing_value);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  SyncEpoch(epoch);
+
+  const auto iter = entries_.find(key);
+  if (iter == entries_.end()) {
+    misses_++;
+    return false;
+  }
+
+  hits_++;
+  valid = iter->second;
+  return true;
+}
+
+// Store a result computed during the given epoch.
+void ValidityCache::Insert(const Vector3d& position,
+                           ValueFunctionId incoming_value,
+                           ValueFunctionId outgoing_value,
+                           size_t epoch, bool valid) {
+  const Key key = MakeKey(position, incoming_value, outgoing_value);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  SyncEpoch(epoch);
+
+  // Computed against an environment that has since changed.
+  if (epoch != epoch_)
+    return;
+
+  if (entries_.size() >= max_entries_)
+    entries_.clear();
+
+  entries_[key] = valid;
+}
+
+// Drop all entries and reset counters.
+void ValidityCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  hits_ = 0;
+  misses_ = 0;
+}
+
+// Center of the quantization cell containing this position.
+Vector3d ValidityCache::CellCenter(const Vector3d& position) const {
+  Vector3d center;
+  for (size_t ii = 0; ii < 3; ii++)
+    center(ii) = (std::floor(position(ii) / resolution_) + 0.5) * resolution_;
+
+  return center;
+}
+
+// Number of entries.
+size_t ValidityCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+// Drop entries from an older epoch. Epochs only increase, so results from
+// a stale epoch are never allowed to replace newer ones.
+void ValidityCache::SyncEpoch(size_t epoch) {
+  if (epoch > epoch_) {
+    entries_.clear();
+    epoch_ = epoch;
+  }
+}
+
+// Key of a planner pair and quantized position.
+ValidityCache::Key ValidityCache::MakeKey(const Vector3d& position,
+                                          ValueFunctionId incoming_value,
+                                          ValueFunctionId outgoing_value) const {
+  Key key;
+  key.incoming_value = incoming_value;
+  key.outgoing_value = outgoing_value;
+  for (size_t ii = 0; ii < 3; ii++)
+    key.cell[ii] = static_cast<int64_t>(std::floor(position(ii) / resolution_));
+
+  return key;
+}
+
+bool ValidityCache::Key::operator==(const Key& other) const {
+  return incoming_value == other.incoming_value &&
+    outgoing_value == other.outgoing_value &&
+    cell[0] == other.cell[0] &&
+    cell[1] == other.cell[1] &&
+    cell[2] == other.cell[2];
+}
+
+// Combine fields with large odd multipliers, as in boost::hash_combine.
+size_t ValidityCache::KeyHash::operator()(const Key& key) const {
+  size_t hash = std::hash<size_t>()(key.incoming_value);
+  const size_t fields[4] = { key.outgoing_value,
+                             static_cast<size_t>(key.cell[0]),
+                             static_cast<size_t>(key.cell[1]),
+                             static_cast<size_t>(key.cell[2]) };
+  for (size_t ii = 0; ii < 4; ii++)
+    hash ^= std::hash<size_t>()(fields[ii]) + 0x9e3779b97f4a7c15ULL +
+      (hash << 6) + (hash >> 2);
+
+  return hash;
+}
+
+} //\namespace meta
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the VoxelBox class, a Box whose obstacles are occupied voxels,
+// e.g. built up from depth measurements. Occupancy is stored in a sparse
+// hierarchy of bit-packed 4 x 4 x 4 blocks.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/voxel_box.h>
+
+namespace meta {
+
+// Keys pack three 21-bit voxel coordinates.
+const int VoxelBox::kMaxVoxels = 1 << 21;
+
+// Factory method. Use this instead of the constructor.
+VoxelBox::Ptr VoxelBox::Create(double resolution) {
+  VoxelBox::Ptr ptr(new VoxelBox(resolution));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+VoxelBox::VoxelBox(double resolution)
+  : Box(),
+    resolution_(std::max(resolution, 1e-8)),
+    num_occupied_(0) {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (resolution < 1e-8)
+    ROS_ERROR("Resolution was too small: %f.", resolution);
+#endif
+
+  SetBounds(lower_, upper_);
+}
+
+// Inherited collision checker from Box needs to be overwritten.
+// Takes in incoming and outgoing value functions. See planner.h for details.
+bool VoxelBox::IsValid(const Vector3d& position,
+                       ValueFunctionId incoming_value,
+                       ValueFunctionId outgoing_value) const {
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (!initialized_) {
+    ROS_WARN("%s: Tried to collision check an uninitialized VoxelBox.",
+             name_.c_str());
+    return false;
+  }
+#endif
+
+  // Reuse the result of a recent check near this position.
+  const size_t epoch = Epoch();
+  bool valid = false;
+  if (LookupValidity(position, incoming_value, outgoing_value, epoch, valid))
+    return valid;
+
+  // Make sure server is up.
+  if (!switching_bound_srv_) {
+    ROS_WARN("%s: Switching bound server disconnected.", name_.c_str());
+
+    ros::NodeHandle nl;
+    switching_bound_srv_ = nl.serviceClient<value_function::SwitchingTrackingBoundBox>(
+      switching_bound_name_.c_str(), true);
+
+    return false;
+  }
+
+  value_function::SwitchingTrackingBoundBox bound;
+  bound.request.from_id = incoming_value;
+  bound.request.to_id = outgoing_value;
+  if (!switching_bound_srv_.call(bound)) {
+    ROS_ERROR("%s: Error calling switching bound server.", name_.c_str());
+    return false;
+  }
+
+  Vector3d checked_position = position;
+  Vector3d bound_vector(bound.response.x, bound.response.y, bound.response.z);
+  CoverCacheCell(checked_position, bound_vector);
+
+  valid = IsFree(checked_position, bound_vector);
+  StoreValidity(position, incoming_value, outgoing_value, epoch, valid);
+  return valid;
+}
+
+// Check the tracking bound around this position against the box walls
+// and the voxels.
+bool VoxelBox::IsFree(const Vector3d& position, const Vector3d& bound) const {
+  if (!Box::IsFree(position, bound))
+    return false;
+
+  return !IsOccupied(position - bound, position + bound);
+}
+
+// Check if the voxel containing the center of this obstacle is occupied.
+bool VoxelBox::IsObstacle(const Vector3d& obstacle_position,
+                          double obstacle_radius) const {
+  return IsOccupied(obstacle_position, obstacle_position);
+}
+
+// Occupy every voxel which the spherical obstacle touches.
+void VoxelBox::AddObstacle(const Vector3d& point, double r) {
+  const Vector3d radius = Vector3d::Constant(r);
+  const Eigen::Vector3i first = Voxel(point - radius);
+  const Eigen::Vector3i last = Voxel(point + radius);
+
+  for (int z = first(2); z <= last(2); z++) {
+    for (int y = first(1); y <= last(1); y++) {
+      for (int x = first(0); x <= last(0); x++) {
+        // Closest point of the voxel to the center of the obstacle.
+        const Vector3d voxel_lower =
+          lower_ + resolution_ * Eigen::Vector3i(x, y, z).cast<double>();
+        const Vector3d closest = point.cwiseMax(voxel_lower).cwiseMin(
+          voxel_lower + Vector3d::Constant(resolution_));
+
+        if ((closest - point).norm() <= r)
+          Insert((voxel_lower + Vector3d::Constant(0.5 * resolution_))
+                 .cwiseMin(upper_));
+      }
+    }
+  }
+}
+
+// Set bounds in each dimension. Clears the occupancy grid.
+void VoxelBox::SetBounds(const Vector3d& lower, const Vector3d& upper) {
+  Box::SetBounds(lower, upper);
+
+  // Number of voxels along each dimension.
+  int max_voxels = 1;
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double extent = std::max(upper_(ii) - lower_(ii), 0.0);
+    double voxels = std::max(std::ceil(extent / resolution_), 1.0);
+
+    if (voxels > kMaxVoxels) {
+      ROS_ERROR("VoxelBox: Too many voxels (%f) along dimension %zu.",
+                voxels, ii);
+      voxels = kMaxVoxels;
+    }
+
+    num_voxels_(ii) = static_cast<int>(voxels);
+    max_voxels = std::max(max_voxels, num_voxels_(ii));
+  }
+
+  // Enough levels that the top one is a single word.
+  size_t num_levels = 1;
+  while ((1L << (2 * num_levels)) < max_voxels)
+    num_levels++;
+
+  levels_.clear();
+  levels_.resize(num_levels);
+  num_occupied_ = 0;
+}
+
+// Mark the voxel containing this point as occupied. Returns true if the
+// voxel was not already occupied.
+bool VoxelBox::Insert(const Vector3d& point) {
+  if ((point.array() < lower_.array()).any() ||
+      (point.array() > upper_.array()).any())
+    return false;
+
+  // Set the bit at each level, stopping as soon as it is already set since
+  // then all the levels above are set too.
+  Eigen::Vector3i child = Voxel(point);
+  for (size_t ii = 0; ii < levels_.size(); ii++) {
+    const Eigen::Vector3i node(child(0) >> 2, child(1) >> 2, child(2) >> 2);
+    const uint64_t bit = Bit(child);
+
+    uint64_t& word = levels_[ii][Key(node)];
+    if (word & bit) {
+      if (ii == 0)
+        return false;
+
+      break;
+    }
+
+    word |= bit;
+    child = node;
+  }
+
+  num_occupied_++;
+  BumpEpoch();
+  return true;
+}
+
+// Insert a whole point cloud. Returns the number of newly occupied voxels.
+size_t VoxelBox::Insert(const std::vector<Vector3d>& points) {
+  size_t num_inserted = 0;
+  for (const auto& point : points)
+    num_inserted += Insert(point);
+
+  return num_inserted;
+}
+
+// Check if any occupied voxel intersects the box [lower, upper].
+bool VoxelBox::IsOccupied(const Vector3d& lower, const Vector3d& upper) const {
+  if ((upper.array() < lower_.array()).any() ||
+      (lower.array() > upper_.array()).any())
+    return false;
+
+  return IsOccupied(levels_.size() - 1, Eigen::Vector3i::Zero(),
+                    Voxel(lower), Voxel(upper));
+}
+
+// Check if any occupied voxel in [lo, hi] lies under the given node.
+bool VoxelBox::IsOccupied(size_t level, const Eigen::Vector3i& node,
+                          const Eigen::Vector3i& lo,
+                          const Eigen::Vector3i& hi) const {
+  const auto iter = levels_[level].find(Key(node));
+  if (iter == levels_[level].end())
+    return false;
+
+  // Children of this node which overlap [lo, hi], and those which lie
+  // entirely inside it. Each child covers 4^level voxels per dimension.
+  const int shift = 2 * level;
+  const Eigen::Vector3i base = 4 * node;
+
+  Eigen::Vector3i first, last, inner_first, inner_last;
+  for (size_t ii = 0; ii < 3; ii++) {
+    first(ii) = std::max(lo(ii) >> shift, base(ii)) - base(ii);
+    last(ii) = std::min(hi(ii) >> shift, base(ii) + 3) - base(ii);
+    inner_first(ii) = std::max(
+      (lo(ii) + (1 << shift) - 1) >> shift, base(ii)) - base(ii);
+    inner_last(ii) = std::min(
+      ((hi(ii) + 1) >> shift) - 1, base(ii) + 3) - base(ii);
+  }
+
+  const uint64_t overlap = iter->second & Mask(first, last);
+  if (!overlap)
+    return false;
+
+  // At the bottom, or an occupied child is covered entirely.
+  if (level == 0 || (overlap & Mask(inner_first, inner_last)))
+    return true;
+
+  // Descend into the occupied children on the boundary of the region.
+  for (uint64_t bits = overlap; bits; bits &= bits - 1) {
+    const int bit = __builtin_ctzll(bits);
+    const Eigen::Vector3i child =
+      base + Eigen::Vector3i(bit & 3, (bit >> 2) & 3, bit >> 4);
+
+    if (IsOccupied(level - 1, child, lo, hi))
+      return true;
+  }
+
+  return false;
+}
+
+// Clear all occupied voxels.
+void VoxelBox::Clear() {
+  for (auto& level : levels_)
+    level.clear();
+
+  num_occupied_ = 0;
+  BumpEpoch();
+}
+
+// Total number of stored occupancy words over all levels.
+size_t VoxelBox::NumWords() const {
+  size_t num_words = 0;
+  for (const auto& level : levels_)
+    num_words += level.size();
+
+  return num_words;
+}
+
+// Inherited visualizer from Box needs to be overwritten.
+void VoxelBox::Visualize(const ros::Publisher& pub,
+                         const std::string& frame_id) const {
+  if (pub.getNumSubscribers() <= 0)
+    return;
+
+  // Box marker.
+  Box::Visualize(pub, frame_id);
+
+  // Occupied voxels as a cube list.
+  visualization_msgs::Marker voxels;
+  voxels.ns = "voxels";
+  voxels.header.frame_id = frame_id;
+  voxels.header.stamp = ros::Time::now();
+  voxels.id = 0;
+  voxels.type = visualization_msgs::Marker::CUBE_LIST;
+  voxels.action = visualization_msgs::Marker::ADD;
+
+  voxels.scale.x = resolution_;
+  voxels.scale.y = resolution_;
+  voxels.scale.z = resolution_;
+
+  voxels.color.a = 0.9;
+  voxels.color.r = 0.7;
+  voxels.color.g = 0.5;
+  voxels.color.b = 0.5;
+
+  voxels.pose.orientation.w = 1.0;
+
+  for (const auto& entry : levels_[0]) {
+    const Eigen::Vector3i base = 4 * Node(entry.first);
+
+    for (uint64_t bits = entry.second; bits; bits &= bits - 1) {
+      const int bit = __builtin_ctzll(bits);
+      const Eigen::Vector3i voxel =
+        base + Eigen::Vector3i(bit & 3, (bit >> 2) & 3, bit >> 4);
+
+      geometry_msgs::Point p;
+      p.x = lower_(0) + (voxel(0) + 0.5) * resolution_;
+      p.y = lower_(1) + (voxel(1) + 0.5) * resolution_;
+      p.z = lower_(2) + (voxel(2) + 0.5) * resolution_;
+      voxels.points.push_back(p);
+    }
+  }
+
+  pub.publish(voxels);
+}
+
+// Voxel containing this point, clamped to the grid.
+Eigen::Vector3i VoxelBox::Voxel(const Vector3d& point) const {
+  Eigen::Vector3i voxel;
+  for (size_t ii = 0; ii < 3; ii++) {
+    const double index = std::floor((point(ii) - lower_(ii)) / resolution_);
+    voxel(ii) = static_cast<int>(
+      std::min(std::max(index, 0.0), num_voxels_(ii) - 1.0));
+  }
+
+  return voxel;
+}
+
+// Hash key for a node.
+uint64_t VoxelBox::Key(const Eigen::Vector3i& node) {
+  return (static_cast<uint64_t>(node(0)) << 42) |
+    (static_cast<uint64_t>(node(1)) << 21) | static_cast<uint64_t>(node(2));
+}
+
+// Node for a hash key.
+Eigen::Vector3i VoxelBox::Node(uint64_t key) {
+  const uint64_t kMask = (1UL << 21) - 1;
+  return Eigen::Vector3i(static_cast<int>(key >> 42),
+                         static_cast<int>((key >> 21) & kMask),
+                         static_cast<int>(key & kMask));
+}
+
+// Bit for a child within its parent's word.
+uint64_t VoxelBox::Bit(const Eigen::Vector3i& child) {
+  return 1UL << ((child(0) & 3) + 4 * (child(1) & 3) + 16 * (child(2) & 3));
+}
+
+// Mask of the children in [first, last].
+uint64_t VoxelBox::Mask(const Eigen::Vector3i& first,
+                        const Eigen::Vector3i& last) {
+  if ((first.array() > last.array()).any())
+    return 0;
+
+  const uint64_t row = ((1UL << (last(0) + 1)) - 1) & ~((1UL << first(0)) - 1);
+
+  uint64_t mask = 0;
+  for (int z = first(2); z <= last(2); z++)
+    for (int y = first(1); y <= last(1); y++)
+      mask |= row << (4 * y + 16 * z);
+
+  return mask;
+}
+
+} //\namespace meta
@@ -40,10 +40,17 @@
 // finding the nearest k points, as well as the length (in time) of the
 // shortest path to the goal.
 //
+// To bound memory and nearest neighbor cost, the tree can be pruned of
+// dominated waypoints.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <meta_planner/waypoint_tree.h>
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace meta {
 
 WaypointTree::WaypointTree(const Vector3d& start,
@@ -79,6 +86,75 @@ double WaypointTree::BestTime() const {
   return terminus_->traj_->LastTime() - start_time_;
 }
 
+// Remove dominated subtrees, and if necessary the least promising ones
+// until at most 'max_size' waypoints remain. Returns the number removed.
+size_t WaypointTree::Prune(
+  const std::function<double(const Vector3d&)>& cost_to_go, size_t max_size) {
+  const std::vector<Waypoint::ConstPtr>& waypoints = kdtree_.Waypoints();
+
+  // Lower bound on the total time of any trajectory through each waypoint.
+  // Since the cost-to-go is optimistic, this never decreases from a
+  // waypoint to its children.
+  std::unordered_map<const Waypoint*, double> lower_bounds;
+  std::vector<double> sorted_bounds;
+  for (const auto& waypoint : waypoints) {
+    const double bound = CostToCome(waypoint) + cost_to_go(waypoint->point_);
+
+    lower_bounds[waypoint.get()] = bound;
+    sorted_bounds.push_back(bound);
+  }
+
+  // Anything that cannot beat the best time is dominated. On top of that,
+  // only keep the 'max_size' most promising waypoints.
+  const double kSmallNumber = 1e-8;
+  double threshold = BestTime() + kSmallNumber;
+
+  if (max_size > 0 && sorted_bounds.size() > max_size) {
+    std::nth_element(sorted_bounds.begin(),
+                     sorted_bounds.begin() + max_size - 1,
+                     sorted_bounds.end());
+    threshold = std::min(threshold, sorted_bounds[max_size - 1]);
+  }
+
+  // The root and the best trajectory are always kept.
+  std::unordered_set<const Waypoint*> protect;
+  protect.insert(root_.get());
+  for (Waypoint::ConstPtr waypoint = terminus_;
+       waypoint != nullptr; waypoint = waypoint->parent_)
+    protect.insert(waypoint.get());
+
+  // Remove whole subtrees, so that no kept waypoint hangs off a removed
+  // one even if the bounds are not quite monotone (e.g. after a switch).
+  std::unordered_map<const Waypoint*, bool> removed;
+  const std::function<bool(const Waypoint::ConstPtr&)> is_removed =
+    [&](const Waypoint::ConstPtr& waypoint) {
+    if (waypoint == nullptr || protect.count(waypoint.get()) > 0)
+      return false;
+
+    const auto iter = removed.find(waypoint.get());
+    if (iter != removed.end())
+      return iter->second;
+
+    const auto bound = lower_bounds.find(waypoint.get());
+    const bool remove = (bound != lower_bounds.end() &&
+                         bound->second > threshold) ||
+      is_removed(waypoint->parent_);
+
+    removed[waypoint.get()] = remove;
+    return remove;
+  };
+
+  return kdtree_.Remove(is_removed);
+}
+
+// Time from the root to this waypoint.
+double WaypointTree::CostToCome(const Waypoint::ConstPtr& waypoint) const {
+  if (waypoint->traj_ == nullptr)
+    return 0.0;
+
+  return waypoint->traj_->LastTime() - start_time_;
+}
+
 // Get best (fastest) trajectory (if it exists).
 Trajectory::Ptr WaypointTree::BestTrajectory() const {
   if (terminus_ == nullptr) {
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the ArrivalTimeField class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/arrival_time_field.h>
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+using namespace meta;
+
+// In free space, arrival time is at least the straight line time, and the
+// extracted path reaches the target in about that time.
+TEST(ArrivalTimeField, TestFreeSpace) {
+  const Vector3d target(1.0, 2.0, 3.0);
+  const ArrivalTimeField::Ptr field =
+    ArrivalTimeField::Create(target, 2.0, 31, 24);
+  ASSERT_TRUE(field->Solve(std::vector<bool>(31 * 31, true), 1.0, 0.3, 0.1,
+                           true, 0));
+
+  const Vector3d start(-0.5, 1.0, 3.0);
+  const double straight = (start - target).head<2>().norm();
+  const double heading = field->BestHeading(start);
+  const double time = field->Time(start, heading);
+  EXPECT_GT(time, straight - 0.2);
+  EXPECT_LT(time, 1.3 * straight);
+
+  // Facing away takes longer.
+  EXPECT_GT(field->Time(start, heading + M_PI), time + 0.5);
+
+  std::vector<Vector3d> positions;
+  const double dt = 0.05;
+  ASSERT_TRUE(field->ExtractPath(start, heading, dt, positions));
+  EXPECT_LT((positions.back() - target).norm(), 1e-8);
+  EXPECT_LT(dt * positions.size(), 1.5 * time);
+
+  // Outside the window.
+  EXPECT_TRUE(std::isinf(field->Time(Vector3d(4.0, 2.0, 3.0), 0.0)));
+}
+
+// A wall between start and target forces a detour around its end.
+TEST(ArrivalTimeField, TestWall) {
+  const Vector3d target(0.0, 0.0, 0.0);
+  const size_t num_cells = 31;
+  const ArrivalTimeField::Ptr field =
+    ArrivalTimeField::Create(target, 2.0, num_cells, 32);
+
+  // Wall at x in [-0.6, -0.4] for y below 1.
+  std::vector<bool> free(num_cells * num_cells, true);
+  for (size_t ii = 0; ii < num_cells; ii++) {
+    for (size_t jj = 0; jj < num_cells; jj++) {
+      const Vector3d p = field->Point(ii, jj);
+      if (p(0) >= -0.6 && p(0) <= -0.4 && p(1) < 1.0)
+        free[ii * num_cells + jj] = false;
+    }
+  }
+
+  ASSERT_TRUE(field->Solve(free, 1.0, 0.2, 0.1, true, 0));
+
+  const Vector3d start(-1.5, 0.0, 0.0);
+  const double heading = field->BestHeading(start);
+  EXPECT_GT(field->Time(start, heading), 2.5);
+
+  std::vector<Vector3d> positions;
+  ASSERT_TRUE(field->ExtractPath(start, heading, 0.02, positions));
+  for (const auto& p : positions)
+    EXPECT_FALSE(p(0) >= -0.6 && p(0) <= -0.4 && p(1) < 1.0);
+}
+
+// A blocked target fails.
+TEST(ArrivalTimeField, TestBlockedTarget) {
+  const ArrivalTimeField::Ptr field =
+    ArrivalTimeField::Create(Vector3d::Zero(), 1.0, 21, 16);
+  EXPECT_FALSE(field->Solve(std::vector<bool>(21 * 21, false), 1.0, 0.2,
+                            0.1, true, 0));
+}
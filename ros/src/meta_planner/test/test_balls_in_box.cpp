@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for ray casting in the BallsInBox class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <demo/balls_in_box.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// A 10 x 10 x 10 box with one ball of radius 1 centered at (7, 5, 5), seen
+// from the middle of the box.
+TEST(BallsInBox, TestCastRays) {
+  const BallsInBox::Ptr space = BallsInBox::Create();
+  space->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  space->AddObstacle(Vector3d(7.0, 5.0, 5.0), 1.0);
+
+  const Vector3d origin = Vector3d::Constant(5.0);
+
+  // Toward the ball, toward a wall, and straight up.
+  Eigen::MatrixX3d directions(3, 3);
+  directions << 1.0, 0.0, 0.0,
+               -1.0, 0.0, 0.0,
+                0.0, 0.0, 1.0;
+
+  VectorXd ranges;
+  Eigen::VectorXi obstacles;
+  space->CastRays(origin, directions, 20.0, ranges, obstacles);
+
+  const double kSmallNumber = 1e-8;
+  EXPECT_NEAR(ranges(0), 1.0, kSmallNumber);
+  EXPECT_EQ(obstacles(0), 0);
+  EXPECT_NEAR(ranges(1), 5.0, kSmallNumber);
+  EXPECT_EQ(obstacles(1), -1);
+  EXPECT_NEAR(ranges(2), 5.0, kSmallNumber);
+  EXPECT_EQ(obstacles(2), -1);
+
+  // Nothing within a short max range.
+  space->CastRays(origin, directions, 0.5, ranges, obstacles);
+  for (size_t ii = 0; ii < 3; ii++) {
+    EXPECT_NEAR(ranges(ii), 0.5, kSmallNumber);
+    EXPECT_EQ(obstacles(ii), -1);
+  }
+
+  // The hit obstacle can be looked up by index.
+  Vector3d position;
+  double radius;
+  EXPECT_TRUE(space->GetObstacle(0, position, radius));
+  EXPECT_NEAR((position - Vector3d(7.0, 5.0, 5.0)).norm(), 0.0, kSmallNumber);
+  EXPECT_NEAR(radius, 1.0, kSmallNumber);
+  EXPECT_FALSE(space->GetObstacle(1, position, radius));
+}
+
+// Rays that graze or pass beside a ball must not hit it, and nearer balls
+// must occlude farther ones.
+TEST(BallsInBox, TestCastRaysOcclusion) {
+  const BallsInBox::Ptr space = BallsInBox::Create();
+  space->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  space->AddObstacle(Vector3d(8.0, 5.0, 5.0), 1.0);
+  space->AddObstacle(Vector3d(6.5, 5.0, 5.0), 0.5);
+  space->AddObstacle(Vector3d(5.0, 7.0, 5.0), 0.5);
+
+  const Vector3d origin = Vector3d::Constant(5.0);
+
+  // Toward both balls on the x axis, and diagonally past the third.
+  Eigen::MatrixX3d directions(2, 3);
+  directions << 1.0, 0.0, 0.0,
+                0.0, std::sqrt(0.5), std::sqrt(0.5);
+
+  VectorXd ranges;
+  Eigen::VectorXi obstacles;
+  space->CastRays(origin, directions, 20.0, ranges, obstacles);
+
+  const double kSmallNumber = 1e-8;
+  EXPECT_NEAR(ranges(0), 1.0, kSmallNumber);
+  EXPECT_EQ(obstacles(0), 1);
+  EXPECT_NEAR(ranges(1), 5.0 * std::sqrt(2.0), kSmallNumber);
+  EXPECT_EQ(obstacles(1), -1);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the CostToGoGrid class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/cost_to_go_grid.h>
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+using namespace meta;
+
+// In free space the cost matches the straight line time, up to a cell.
+TEST(CostToGoGrid, TestFreeSpace) {
+  const CostToGoGrid::Ptr grid =
+    CostToGoGrid::Create(Vector3d::Zero(), Vector3d::Constant(10.0), 0.5);
+  EXPECT_EQ(grid->NumCells(), 8000);
+
+  const Vector3d speed(1.0, 2.0, 1.0);
+  grid->Compute(Vector3d(1.0, 1.0, 1.0), speed,
+                [](const Vector3d& p) { return true; });
+
+  const Vector3d goal(8.0, 3.0, 5.0);
+  const double straight = 7.0;
+  EXPECT_GE(grid->Cost(goal), straight - 1e-8);
+  EXPECT_LE(grid->Cost(goal), straight + grid->Resolution());
+
+  // Outside the grid.
+  EXPECT_TRUE(std::isinf(grid->Cost(Vector3d(11.0, 1.0, 1.0))));
+}
+
+// A wall with a gap forces a detour.
+TEST(CostToGoGrid, TestWall) {
+  const CostToGoGrid::Ptr grid =
+    CostToGoGrid::Create(Vector3d::Zero(), Vector3d::Constant(10.0), 0.5);
+
+  const auto is_free = [](const Vector3d& p) {
+    return p(0) < 4.0 || p(0) > 5.0 || p(1) > 8.0;
+  };
+
+  grid->Compute(Vector3d(1.0, 1.0, 5.0), Vector3d::Ones(), is_free);
+
+  // Through the gap at y > 8.
+  const double cost = grid->Cost(Vector3d(9.0, 1.0, 5.0));
+  EXPECT_GE(cost, 14.0 - 1e-8);
+  EXPECT_LE(cost, 14.0 + 2.0 * grid->Resolution());
+
+  // Inside the wall.
+  EXPECT_TRUE(std::isinf(grid->Cost(Vector3d(4.5, 1.0, 5.0))));
+
+  // Closing the gap makes the far side unreachable.
+  grid->Compute(Vector3d(1.0, 1.0, 5.0), Vector3d::Ones(),
+                [](const Vector3d& p) { return p(0) < 4.0 || p(0) > 5.0; });
+  EXPECT_TRUE(std::isinf(grid->Cost(Vector3d(9.0, 1.0, 5.0))));
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the DynamicObstacles class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/dynamic_obstacles.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+
+using namespace meta;
+
+// A sphere moving at constant velocity is only where it should be, and only
+// over its time span.
+TEST(DynamicObstacles, TestConstantVelocity) {
+  const DynamicObstacles::Ptr obstacles = DynamicObstacles::Create(0.5, 0.25);
+  ASSERT_TRUE(obstacles->Add(Vector3d(0.0, 0.0, 1.0), Vector3d(1.0, 0.0, 0.0),
+                             0.2, 10.0, 14.0));
+  EXPECT_EQ(obstacles->NumObstacles(), 1);
+
+  const Vector3d bound(0.1, 0.1, 0.1);
+  EXPECT_FALSE(obstacles->IsFree(Vector3d(0.0, 0.0, 1.0), bound, 10.0));
+  EXPECT_FALSE(obstacles->IsFree(Vector3d(2.5, 0.0, 1.0), bound, 12.5));
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(2.5, 0.0, 1.0), bound, 11.0));
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(0.0, 0.0, 1.0), bound, 12.5));
+
+  // Box corner just inside and just outside the sphere.
+  EXPECT_FALSE(obstacles->IsFree(Vector3d(1.25, 0.0, 1.0), bound, 11.0));
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(1.35, 0.0, 1.0), bound, 11.0));
+
+  // Outside the time span.
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(0.0, 0.0, 1.0), bound, 9.9));
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(4.1, 0.0, 1.0), bound, 14.1));
+
+  Vector3d position;
+  double radius = 0.0;
+  EXPECT_TRUE(obstacles->GetObstacle(0, 13.0, position, radius));
+  EXPECT_NEAR((position - Vector3d(3.0, 0.0, 1.0)).norm(), 0.0, 1e-12);
+  EXPECT_EQ(radius, 0.2);
+  EXPECT_FALSE(obstacles->GetObstacle(0, 15.0, position, radius));
+  EXPECT_FALSE(obstacles->GetObstacle(1, 13.0, position, radius));
+}
+
+// Predicted tracks are interpolated between their time stamps.
+TEST(DynamicObstacles, TestTrack) {
+  const DynamicObstacles::Ptr obstacles = DynamicObstacles::Create(1.0, 0.5);
+  const std::vector<double> times = { 0.0, 1.0, 3.0 };
+  const std::vector<Vector3d> positions = {
+    Vector3d(0.0, 0.0, 0.0), Vector3d(0.0, 2.0, 0.0), Vector3d(2.0, 2.0, 0.0) };
+  ASSERT_TRUE(obstacles->Add(times, positions, 0.3));
+  EXPECT_EQ(obstacles->NumSegments(), 2);
+  EXPECT_NEAR(obstacles->MaxSpeed(), 2.0, 1e-12);
+
+  const Vector3d bound = Vector3d::Zero();
+  EXPECT_FALSE(obstacles->IsFree(Vector3d(0.0, 1.0, 0.0), bound, 0.5));
+  EXPECT_FALSE(obstacles->IsFree(Vector3d(1.0, 2.0, 0.0), bound, 2.0));
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(0.0, 1.0, 0.0), bound, 2.0));
+
+  // Bad tracks.
+  EXPECT_FALSE(obstacles->Add({ 0.0, 0.0 }, positions, 0.3));
+  EXPECT_FALSE(obstacles->Add({ 1.0, 0.0 },
+                              { Vector3d::Zero(), Vector3d::Zero() }, 0.3));
+  EXPECT_FALSE(obstacles->Add(Vector3d::Zero(), Vector3d::Zero(), 0.0,
+                              0.0, 1.0));
+  EXPECT_EQ(obstacles->NumObstacles(), 1);
+
+  obstacles->Clear();
+  EXPECT_EQ(obstacles->NumObstacles(), 0);
+  EXPECT_TRUE(obstacles->IsFree(Vector3d(0.0, 1.0, 0.0), bound, 0.5));
+}
+
+// The index agrees with checking every obstacle, including across the
+// wraparound of its keys, and stays fast with many movers.
+TEST(DynamicObstacles, TestManyObstacles) {
+  const double kCellSize = 0.5;
+  const double kTimeResolution = 0.1;
+  const size_t kNumObstacles = 1000;
+  const size_t kNumQueries = 100000;
+  const double kStartTime = 1.5e9;
+
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> unif_position(-10.0, 10.0);
+  std::uniform_real_distribution<double> unif_velocity(-1.0, 1.0);
+  std::uniform_real_distribution<double> unif_radius(0.1, 0.5);
+  std::uniform_real_distribution<double> unif_time(0.0, 2.0);
+
+  const DynamicObstacles::Ptr obstacles =
+    DynamicObstacles::Create(kCellSize, kTimeResolution);
+  std::vector<Vector3d> points, velocities;
+  std::vector<double> radii;
+  for (size_t ii = 0; ii < kNumObstacles; ii++) {
+    points.push_back(Vector3d(unif_position(rng), unif_position(rng),
+                              unif_position(rng)));
+    velocities.push_back(Vector3d(unif_velocity(rng), unif_velocity(rng),
+                                  unif_velocity(rng)));
+    radii.push_back(unif_radius(rng));
+    ASSERT_TRUE(obstacles->Add(points.back(), velocities.back(), radii.back(),
+                               kStartTime, kStartTime + 2.0));
+  }
+
+  std::vector<Vector3d> queries;
+  std::vector<double> query_times;
+  for (size_t ii = 0; ii < kNumQueries; ii++) {
+    queries.push_back(Vector3d(unif_position(rng), unif_position(rng),
+                               unif_position(rng)));
+    query_times.push_back(kStartTime + unif_time(rng));
+  }
+
+  const Vector3d bound(0.2, 0.2, 0.1);
+  size_t num_free = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t ii = 0; ii < kNumQueries; ii++)
+    num_free += obstacles->IsFree(queries[ii], bound, query_times[ii]);
+  const double elapsed = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  std::cout << "DynamicObstacles: " << 1e9 * elapsed / kNumQueries
+            << " ns per query against " << kNumObstacles << " obstacles."
+            << std::endl;
+
+  size_t num_expected_free = 0;
+  for (size_t ii = 0; ii < kNumQueries; ii++) {
+    bool free = true;
+    for (size_t jj = 0; jj < kNumObstacles && free; jj++) {
+      const Vector3d center = points[jj] +
+        (query_times[ii] - kStartTime) * velocities[jj];
+      const Vector3d closest_point =
+        center.cwiseMax(queries[ii] - bound).cwiseMin(queries[ii] + bound);
+      free = (closest_point - center).norm() > radii[jj];
+    }
+
+    EXPECT_EQ(obstacles->IsFree(queries[ii], bound, query_times[ii]), free);
+    num_expected_free += free;
+  }
+
+  EXPECT_EQ(num_free, num_expected_free);
+  EXPECT_LT(num_free, kNumQueries);
+}
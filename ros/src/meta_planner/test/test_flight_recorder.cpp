@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the RingBuffer and FlightRecorder classes.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/flight_recorder.h>
+#include <utils/ring_buffer.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Test that the ring buffer preserves order and drops when full.
+TEST(RingBuffer, TestPushPop) {
+  RingBuffer<int> buffer(3);
+  EXPECT_EQ(buffer.Capacity(), 4);
+
+  for (int ii = 0; ii < 5; ii++)
+    buffer.Push(ii);
+
+  EXPECT_EQ(buffer.Size(), 4);
+  EXPECT_EQ(buffer.Dropped(), 1);
+
+  int value = -1;
+  for (int ii = 0; ii < 4; ii++) {
+    EXPECT_TRUE(buffer.Pop(value));
+    EXPECT_EQ(value, ii);
+  }
+
+  EXPECT_FALSE(buffer.Pop(value));
+}
+
+// Test that records written by the recorder can be read back.
+TEST(FlightRecorder, TestRoundTrip) {
+  const std::string file_name = "/tmp/test_flight_recorder.bin";
+  const size_t kNumRecords = 1000;
+
+  {
+    const FlightRecorder::Ptr recorder =
+      FlightRecorder::Create(file_name, 2 * kNumRecords, 0.01);
+    ASSERT_TRUE(recorder.get() != nullptr);
+
+    for (size_t ii = 0; ii < kNumRecords; ii++) {
+      FlightRecorder::Record record;
+      for (size_t jj = 0; jj < FlightRecorder::NUM_COLUMNS; jj++)
+        record.values[jj] = static_cast<double>(ii * jj);
+
+      EXPECT_TRUE(recorder->Push(record));
+    }
+  }
+
+  std::vector<std::string> names;
+  std::vector< std::vector<double> > columns;
+  ASSERT_TRUE(FlightRecorder::Read(file_name, names, columns));
+
+  ASSERT_EQ(names.size(), FlightRecorder::NUM_COLUMNS);
+  EXPECT_EQ(names[FlightRecorder::PRIORITY], "priority");
+
+  for (size_t jj = 0; jj < FlightRecorder::NUM_COLUMNS; jj++) {
+    ASSERT_EQ(columns[jj].size(), kNumRecords);
+    for (size_t ii = 0; ii < kNumRecords; ii++)
+      EXPECT_EQ(columns[jj][ii], static_cast<double>(ii * jj));
+  }
+}
+
+// Test that planner event logs only contain the event columns.
+TEST(FlightRecorder, TestEvents) {
+  const std::string file_name = "/tmp/test_flight_recorder_events.bin";
+
+  {
+    const FlightRecorder::Ptr recorder =
+      FlightRecorder::Create(file_name, 16, 0.01, FlightRecorder::EVENTS);
+    ASSERT_TRUE(recorder.get() != nullptr);
+
+    FlightRecorder::Record record;
+    for (size_t jj = 0; jj < FlightRecorder::NUM_COLUMNS; jj++)
+      record.values[jj] = static_cast<double>(jj);
+
+    record.values[FlightRecorder::EVENT_TYPE] = FlightRecorder::WAYPOINT;
+    EXPECT_TRUE(recorder->Push(record));
+  }
+
+  std::vector<std::string> names;
+  std::vector< std::vector<double> > columns;
+  ASSERT_TRUE(FlightRecorder::Read(file_name, names, columns));
+
+  ASSERT_EQ(names.size(), FlightRecorder::NUM_EVENT_COLUMNS);
+  EXPECT_EQ(names[FlightRecorder::EVENT_TYPE], "event");
+  EXPECT_EQ(names[FlightRecorder::EVENT_DURATION], "duration");
+
+  ASSERT_EQ(columns[FlightRecorder::EVENT_TYPE].size(), 1);
+  EXPECT_EQ(columns[FlightRecorder::EVENT_TYPE][0], FlightRecorder::WAYPOINT);
+  EXPECT_EQ(columns[FlightRecorder::EVENT_DURATION][0],
+            static_cast<double>(FlightRecorder::EVENT_DURATION));
+}
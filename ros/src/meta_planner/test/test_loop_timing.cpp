@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the LoopTiming class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/loop_timing.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Test that jitter and compute times are binned, and deadline misses counted.
+TEST(LoopTiming, TestHistograms) {
+  const LoopTiming::Ptr timing = LoopTiming::Create(1e-3);
+
+  // On time and fast, late but fast enough, and on time but too slow.
+  timing->RecordTick(0.0, 10e-6);
+  timing->RecordTick(300e-6, 500e-6);
+  timing->RecordTick(5e-6, 2e-3);
+
+  EXPECT_EQ(timing->NumTicks(), 3);
+  EXPECT_EQ(timing->NumDeadlineMisses(), 1);
+
+  // 0 us, 300 us, and 5 us.
+  EXPECT_EQ(timing->JitterBucket(0), 1);
+  EXPECT_EQ(timing->JitterBucket(9), 1);
+  EXPECT_EQ(timing->JitterBucket(3), 1);
+
+  // 10 us, 500 us, and 2000 us.
+  EXPECT_EQ(timing->ComputeBucket(4), 1);
+  EXPECT_EQ(timing->ComputeBucket(9), 1);
+  EXPECT_EQ(timing->ComputeBucket(11), 1);
+
+  EXPECT_NEAR(timing->MeanJitter(), 305e-6 / 3.0, 1e-9);
+  EXPECT_NEAR(timing->MaxJitter(), 300e-6, 1e-9);
+  EXPECT_NEAR(timing->MaxCompute(), 2e-3, 1e-9);
+  EXPECT_NEAR(timing->ComputeQuantile(0.5), 512e-6, 1e-12);
+  EXPECT_NEAR(timing->ComputeQuantile(1.0), 2048e-6, 1e-12);
+
+  // Late start plus compute past the next tick is also a miss.
+  timing->RecordTick(600e-6, 600e-6);
+  EXPECT_EQ(timing->NumDeadlineMisses(), 2);
+
+  timing->Reset();
+  EXPECT_EQ(timing->NumTicks(), 0);
+  EXPECT_EQ(timing->NumDeadlineMisses(), 0);
+  EXPECT_EQ(timing->JitterBucket(9), 0);
+  EXPECT_EQ(timing->MaxCompute(), 0.0);
+}
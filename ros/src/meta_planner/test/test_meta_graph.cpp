@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the MetaGraph class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/meta_graph.h>
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+using namespace meta;
+
+// Euclidean distance as the optimistic cost.
+const MetaGraph::CostFunction kDistance =
+  [](const Vector3d& a, const Vector3d& b) { return (a - b).norm(); };
+
+// The best path follows the cheapest unevaluated edges, and detours once
+// an edge on it is removed.
+TEST(MetaGraph, TestBestPath) {
+  const Vector3d start(0.0, 0.0, 0.0);
+  const Vector3d goal(4.0, 0.0, 0.0);
+  MetaGraph graph(start, goal, 2.5, 10, kDistance);
+
+  std::vector<size_t> path;
+  EXPECT_TRUE(std::isinf(graph.BestPath(path)));
+  EXPECT_TRUE(path.empty());
+
+  const size_t middle = graph.AddNode(Vector3d(2.0, 0.0, 0.0));
+  const size_t above = graph.AddNode(Vector3d(2.0, 1.5, 0.0));
+
+  const double kSmallNumber = 1e-8;
+  EXPECT_NEAR(graph.BestPath(path), 4.0, kSmallNumber);
+  ASSERT_EQ(path.size(), 3);
+  EXPECT_EQ(path[0], MetaGraph::kStartNode);
+  EXPECT_EQ(path[1], middle);
+  EXPECT_EQ(path[2], MetaGraph::kGoalNode);
+
+  graph.RemoveEdge(MetaGraph::kStartNode, middle);
+  EXPECT_NEAR(graph.BestPath(path), 5.0, kSmallNumber);
+  ASSERT_EQ(path.size(), 3);
+  EXPECT_EQ(path[1], above);
+}
+
+// Reached nodes are sources with their true cost-to-come.
+TEST(MetaGraph, TestReached) {
+  const Vector3d start(0.0, 0.0, 0.0);
+  const Vector3d goal(4.0, 0.0, 0.0);
+  MetaGraph graph(start, goal, 2.5, 10, kDistance);
+
+  const size_t middle = graph.AddNode(Vector3d(2.0, 0.0, 0.0));
+  graph.SetReached(middle, 3.0);
+  EXPECT_TRUE(graph.IsReached(middle));
+
+  std::vector<size_t> path;
+  EXPECT_NEAR(graph.BestPath(path), 5.0, 1e-8);
+  ASSERT_EQ(path.size(), 2);
+  EXPECT_EQ(path[0], middle);
+
+  // The goal is never reached, so it can still be improved upon.
+  graph.SetReached(MetaGraph::kGoalNode, 5.0);
+  EXPECT_FALSE(graph.IsReached(MetaGraph::kGoalNode));
+}
+
+// New nodes connect only to their nearest neighbors.
+TEST(MetaGraph, TestMaxNeighbors) {
+  MetaGraph graph(Vector3d::Zero(), Vector3d(100.0, 0.0, 0.0), 5.0, 2,
+                  kDistance);
+
+  for (size_t ii = 0; ii < 10; ii++)
+    graph.AddNode(Vector3d(0.1 * (ii + 1), 0.0, 0.0));
+
+  // Each node adds at most two edges in each direction.
+  EXPECT_LE(graph.NumEdges(), 4 * 10);
+}
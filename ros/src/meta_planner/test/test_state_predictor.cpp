@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the StatePredictor class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/state_predictor.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// With no recorded controls, the prediction hovers at constant velocity.
+TEST(StatePredictor, TestHover) {
+  const StatePredictor::Ptr predictor = StatePredictor::Create(1.0);
+
+  StatePredictor::State state;
+  state << 1.0, 2.0, 3.0, 0.5, -0.5, 0.1;
+
+  StatePredictor::State predicted;
+  EXPECT_NEAR(predictor->Predict(state, 10.0, 10.2, predicted), 0.2, 1e-12);
+
+  StatePredictor::State expected = state;
+  expected.head<3>() += 0.2 * state.tail<3>();
+  EXPECT_NEAR((predicted - expected).norm(), 0.0, 1e-12);
+
+  // Horizon is capped.
+  EXPECT_NEAR(predictor->Predict(state, 10.0, 20.0, predicted), 1.0, 1e-12);
+
+  // Never predicts backward.
+  EXPECT_NEAR(predictor->Predict(state, 10.0, 9.0, predicted), 0.0, 1e-12);
+  EXPECT_NEAR((predicted - state).norm(), 0.0, 1e-12);
+}
+
+// Piecewise-constant controls are integrated exactly, switching at the
+// recorded times.
+TEST(StatePredictor, TestControlHistory) {
+  const StatePredictor::Ptr predictor = StatePredictor::Create(1.0);
+
+  // Thrust 1 m/s^2 above hover from t = 0, then free fall from t = 0.1.
+  predictor->RecordControl(0.0, Vector3d(0.0, 0.0, constants::G + 1.0));
+  predictor->RecordControl(0.1, Vector3d(0.0, 0.0, 0.0));
+
+  StatePredictor::State state = StatePredictor::State::Zero();
+  StatePredictor::State predicted;
+  predictor->Predict(state, 0.05, 0.15, predicted);
+
+  // 0.05 s at +1, then 0.05 s at -G.
+  const double z1 = 0.5 * 0.05 * 0.05;
+  const double v1 = 0.05;
+  const double z2 = z1 + v1 * 0.05 - 0.5 * constants::G * 0.05 * 0.05;
+  const double v2 = v1 - constants::G * 0.05;
+  EXPECT_NEAR(predicted(2), z2, 1e-12);
+  EXPECT_NEAR(predicted(5), v2, 1e-12);
+  EXPECT_NEAR(predicted.head<2>().norm(), 0.0, 1e-12);
+
+  // Pitch accelerates in +x.
+  predictor->RecordControl(0.2, Vector3d(0.1, 0.0, constants::G));
+  predictor->Predict(state, 0.2, 0.3, predicted);
+  EXPECT_NEAR(predicted(3), 0.1 * constants::G * std::tan(0.1), 1e-12);
+}
+
+// Latency is smoothed, starting from the first measurement.
+TEST(StatePredictor, TestLatency) {
+  const StatePredictor::Ptr predictor = StatePredictor::Create(1.0);
+
+  predictor->RecordLatency(0.01);
+  EXPECT_NEAR(predictor->Latency(), 0.01, 1e-12);
+
+  for (size_t ii = 0; ii < 1000; ii++)
+    predictor->RecordLatency(0.02);
+  EXPECT_NEAR(predictor->Latency(), 0.02, 1e-6);
+}
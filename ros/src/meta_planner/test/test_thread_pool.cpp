@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the ThreadPool class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <utils/thread_pool.h>
+
+#include <atomic>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Test that submitted tasks return their results through futures.
+TEST(ThreadPool, TestSubmit) {
+  const ThreadPool::Ptr pool = ThreadPool::Create(4);
+
+  std::vector< std::future<size_t> > futures;
+  for (size_t ii = 0; ii < 100; ii++)
+    futures.push_back(pool->Submit([](size_t x) { return x * x; }, ii));
+
+  for (size_t ii = 0; ii < futures.size(); ii++)
+    EXPECT_EQ(futures[ii].get(), ii * ii);
+}
+
+// Test that parallel for loops visit every index exactly once, including
+// when nested inside another task.
+TEST(ThreadPool, TestParallelFor) {
+  const ThreadPool::Ptr pool = ThreadPool::Create(4);
+  const size_t kNumIndices = 10000;
+
+  std::atomic<size_t> sum(0);
+  EXPECT_TRUE(pool->ParallelFor(0, kNumIndices, [&sum](size_t ii) {
+        sum += ii;
+      }));
+  EXPECT_EQ(sum.load(), kNumIndices * (kNumIndices - 1) / 2);
+
+  std::future<size_t> nested = pool->Submit([&pool]() {
+      std::atomic<size_t> count(0);
+      pool->ParallelFor(0, 1000, [&count](size_t /* ii */) { count++; });
+      return count.load();
+    });
+  EXPECT_EQ(nested.get(), 1000);
+}
+
+// Test that a cancelled token stops a parallel for loop.
+TEST(ThreadPool, TestCancellation) {
+  const ThreadPool::Ptr pool = ThreadPool::Create(2);
+
+  CancellationToken token;
+  token.Cancel();
+
+  std::atomic<size_t> count(0);
+  EXPECT_FALSE(pool->ParallelFor(0, 1000, [&count](size_t /* ii */) {
+        count++;
+      }, 1, token));
+  EXPECT_EQ(count.load(), 0);
+}
+
+// Test that the scratch arena hands out aligned memory and resets.
+TEST(ThreadPool, TestScratchArena) {
+  ScratchArena arena(1024);
+
+  double* values = arena.Allocate<double>(16);
+  EXPECT_EQ(reinterpret_cast<size_t>(values) % alignof(double), 0);
+  EXPECT_GE(arena.Used(), 16 * sizeof(double));
+
+  // Larger than capacity falls back to an overflow block.
+  EXPECT_TRUE(arena.Allocate<char>(4096) != nullptr);
+
+  arena.Reset();
+  EXPECT_EQ(arena.Used(), 0);
+}
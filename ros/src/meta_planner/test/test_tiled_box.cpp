@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the TiledBox class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/tiled_box.h>
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Write a 100 x 100 x 10 world of 10 m tiles with one obstacle in the
+// middle of each tile, and activate tiles along a corridor.
+TEST(TiledBox, TestCorridor) {
+  const std::string file_name = "/tmp/test_tiled_box.tile";
+  const double kTileSize = 10.0;
+
+  std::vector<Vector3d> points;
+  std::vector<double> radii;
+  for (size_t ii = 0; ii < 10; ii++) {
+    for (size_t jj = 0; jj < 10; jj++) {
+      points.push_back(Vector3d(kTileSize * (ii + 0.5),
+                                kTileSize * (jj + 0.5), 5.0));
+      radii.push_back(1.0);
+    }
+  }
+
+  ASSERT_TRUE(TiledBox::Write(file_name, Vector3d::Zero(),
+                              Vector3d(100.0, 100.0, 10.0), kTileSize,
+                              points, radii));
+
+  const TiledBox::Ptr space = TiledBox::Create(file_name, 1.0);
+  ASSERT_TRUE(space->IsLoaded());
+  EXPECT_NEAR((space->UpperBounds() - Vector3d(100.0, 100.0, 10.0)).norm(),
+              0.0, 1e-8);
+
+  // Nothing is in memory before activation.
+  EXPECT_EQ(space->NumLoadedTiles(), 0);
+  EXPECT_FALSE(space->IsObstacle(points[0], radii[0]));
+
+  // Corridor along the bottom row of tiles.
+  std::vector<Vector3d> corridor;
+  corridor.push_back(Vector3d(5.0, 5.0, 5.0));
+  corridor.push_back(Vector3d(95.0, 5.0, 5.0));
+
+  const size_t num_loaded = space->UpdateActive(corridor.front(), corridor);
+  EXPECT_EQ(space->NumActiveTiles(), 10);
+  EXPECT_EQ(num_loaded, 20);
+  EXPECT_EQ(space->NumLoadedTiles(), 20);
+
+  // Obstacles along the corridor and in the halo are known, others not.
+  EXPECT_TRUE(space->IsObstacle(points[0], radii[0]));
+  EXPECT_TRUE(space->IsObstacle(points[1], radii[1]));
+  EXPECT_FALSE(space->IsObstacle(points[2], radii[2]));
+
+  // Samples stay in the corridor.
+  for (size_t ii = 0; ii < 100; ii++) {
+    const Vector3d sample = space->Sample();
+    EXPECT_LE(sample(1), kTileSize);
+  }
+
+  // Moving the corridor evicts old tiles.
+  corridor[0] = Vector3d(5.0, 95.0, 5.0);
+  corridor[1] = Vector3d(95.0, 95.0, 5.0);
+  EXPECT_EQ(space->UpdateActive(corridor.front(), corridor), 20);
+  EXPECT_EQ(space->NumLoadedTiles(), 20);
+  EXPECT_FALSE(space->IsObstacle(points[0], radii[0]));
+  EXPECT_TRUE(space->IsObstacle(points[9], radii[9]));
+
+  // Added obstacles survive eviction.
+  space->AddObstacle(Vector3d(1.0, 1.0, 1.0), 0.5);
+  EXPECT_TRUE(space->IsObstacle(Vector3d(1.0, 1.0, 1.0), 0.5));
+
+  std::remove(file_name.c_str());
+}
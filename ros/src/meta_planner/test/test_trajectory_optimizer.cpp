@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the TrajectoryOptimizer class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/trajectory_optimizer.h>
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+using namespace meta;
+
+// Without obstacles the trajectory reaches the goal within the limits.
+TEST(TrajectoryOptimizer, TestFreeSpace) {
+  const TrajectoryOptimizer::Ptr optimizer =
+    TrajectoryOptimizer::Create(20, 10, 1.5);
+  optimizer->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  optimizer->SetLimits(Vector3d::Constant(2.0), Vector3d::Constant(1.0));
+  optimizer->SetPadding(Vector3d::Constant(0.2));
+
+  const Vector3d start(1.0, 1.0, 5.0);
+  const Vector3d stop(8.0, 3.0, 5.0);
+
+  std::vector<Vector3d> positions;
+  double dt = 0.0;
+  ASSERT_TRUE(optimizer->Optimize(start, stop, 1.0, positions, dt));
+  ASSERT_EQ(positions.size(), 21);
+  EXPECT_GT(dt, 0.0);
+  EXPECT_LT((positions.front() - start).norm(), 1e-8);
+  EXPECT_LT((positions.back() - stop).norm(), 1e-8);
+
+  for (size_t ii = 1; ii < positions.size(); ii++) {
+    const Vector3d velocity = (positions[ii] - positions[ii - 1]) / dt;
+    EXPECT_LE(velocity.lpNorm<Eigen::Infinity>(), 2.0 + 1e-3);
+
+    for (size_t jj = 0; jj < 3; jj++) {
+      EXPECT_GE(positions[ii](jj), 0.2 - 1e-3);
+      EXPECT_LE(positions[ii](jj), 9.8 + 1e-3);
+    }
+  }
+
+  // The z coordinate should not move.
+  for (const auto& position : positions)
+    EXPECT_NEAR(position(2), 5.0, 1e-3);
+}
+
+// Check that each padding box, grown by the distance covered in half a step
+// at top speed in each axis, stays outside the sphere.
+void ExpectClear(const std::vector<Vector3d>& positions, double dt,
+                 const Vector3d& center, double radius, double padding,
+                 double max_speed) {
+  const Vector3d swept = Vector3d::Constant(padding + 0.5 * max_speed * dt);
+  for (const auto& position : positions) {
+    const Vector3d closest =
+      center.cwiseMax(position - swept).cwiseMin(position + swept);
+    EXPECT_GT((closest - center).norm(), radius);
+  }
+}
+
+// A sphere near the straight line forces a detour around it.
+TEST(TrajectoryOptimizer, TestObstacle) {
+  const TrajectoryOptimizer::Ptr optimizer =
+    TrajectoryOptimizer::Create(20, 10, 1.5);
+  optimizer->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  optimizer->SetLimits(Vector3d::Constant(2.0), Vector3d::Constant(2.0));
+  optimizer->SetPadding(Vector3d::Constant(0.1));
+
+  const Vector3d center(5.0, 5.0, 5.0);
+  const double radius = 1.0;
+  optimizer->SetObstacles(std::vector<Vector3d>(1, center),
+                          std::vector<double>(1, radius));
+
+  const Vector3d start(1.0, 5.1, 5.0);
+  const Vector3d stop(9.0, 5.1, 5.0);
+
+  std::vector<Vector3d> positions;
+  double dt = 0.0;
+  ASSERT_TRUE(optimizer->Optimize(start, stop, 1.0, positions, dt));
+  EXPECT_LT((positions.back() - stop).norm(), 1e-8);
+  ExpectClear(positions, dt, center, radius, 0.1, 2.0);
+}
+
+// A sphere centered exactly on the straight line is passed on one side.
+TEST(TrajectoryOptimizer, TestObstacleOnLine) {
+  const TrajectoryOptimizer::Ptr optimizer =
+    TrajectoryOptimizer::Create(20, 10, 1.5);
+  optimizer->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  optimizer->SetLimits(Vector3d::Constant(2.0), Vector3d::Constant(2.0));
+  optimizer->SetPadding(Vector3d::Constant(0.1));
+
+  const Vector3d center(5.0, 5.0, 5.0);
+  const double radius = 1.0;
+  optimizer->SetObstacles(std::vector<Vector3d>(1, center),
+                          std::vector<double>(1, radius));
+
+  const Vector3d start(1.0, 5.0, 5.0);
+  const Vector3d stop(9.0, 5.0, 5.0);
+
+  std::vector<Vector3d> positions;
+  double dt = 0.0;
+  ASSERT_TRUE(optimizer->Optimize(start, stop, 1.0, positions, dt));
+  EXPECT_LT((positions.back() - stop).norm(), 1e-8);
+  ExpectClear(positions, dt, center, radius, 0.1, 2.0);
+}
+
+// Goals blocked by an obstacle fail.
+TEST(TrajectoryOptimizer, TestBlockedGoal) {
+  const TrajectoryOptimizer::Ptr optimizer =
+    TrajectoryOptimizer::Create(20, 5, 1.5);
+  optimizer->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  optimizer->SetLimits(Vector3d::Constant(2.0), Vector3d::Constant(1.0));
+  optimizer->SetObstacles(std::vector<Vector3d>(1, Vector3d::Constant(8.0)),
+                          std::vector<double>(1, 1.0));
+
+  std::vector<Vector3d> positions;
+  double dt = 0.0;
+  EXPECT_FALSE(optimizer->Optimize(Vector3d::Constant(1.0),
+                                   Vector3d::Constant(8.0), 1.0,
+                                   positions, dt));
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the ValidityCache class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/validity_cache.h>
+#include <demo/balls_in_box.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Results are keyed by planner pair and quantized position.
+TEST(ValidityCache, TestLookup) {
+  const ValidityCache::Ptr cache = ValidityCache::Create(0.1, 100);
+  const Vector3d position(1.03, 2.04, 3.05);
+
+  bool valid = false;
+  EXPECT_FALSE(cache->Lookup(position, 0, 1, 0, valid));
+  cache->Insert(position, 0, 1, 0, true);
+
+  // Same cell.
+  EXPECT_TRUE(cache->Lookup(Vector3d(1.06, 2.01, 3.09), 0, 1, 0, valid));
+  EXPECT_TRUE(valid);
+
+  // Different cell or planner pair.
+  EXPECT_FALSE(cache->Lookup(Vector3d(1.13, 2.04, 3.05), 0, 1, 0, valid));
+  EXPECT_FALSE(cache->Lookup(position, 2, 3, 0, valid));
+
+  EXPECT_EQ(cache->NumHits(), 1);
+  EXPECT_EQ(cache->NumMisses(), 3);
+}
+
+// A newer epoch drops old entries, and stale results are not stored.
+TEST(ValidityCache, TestEpoch) {
+  const ValidityCache::Ptr cache = ValidityCache::Create(0.1, 100);
+  const Vector3d position(-1.0, 0.5, 2.0);
+
+  cache->Insert(position, 0, 1, 0, true);
+  EXPECT_EQ(cache->Size(), 1);
+
+  bool valid = false;
+  EXPECT_FALSE(cache->Lookup(position, 0, 1, 1, valid));
+  EXPECT_EQ(cache->Size(), 0);
+
+  cache->Insert(position, 0, 1, 0, true);
+  EXPECT_EQ(cache->Size(), 0);
+
+  cache->Insert(position, 0, 1, 1, false);
+  EXPECT_TRUE(cache->Lookup(position, 0, 1, 1, valid));
+  EXPECT_FALSE(valid);
+}
+
+// The cache never grows past its maximum size.
+TEST(ValidityCache, TestMaxEntries) {
+  const size_t kMaxEntries = 10;
+  const ValidityCache::Ptr cache = ValidityCache::Create(0.1, kMaxEntries);
+
+  for (size_t ii = 0; ii < 5 * kMaxEntries; ii++) {
+    cache->Insert(Vector3d(0.1 * ii + 0.05, 0.0, 0.0), 0, 1, 0, true);
+    EXPECT_LE(cache->Size(), kMaxEntries);
+  }
+
+  cache->Clear();
+  EXPECT_EQ(cache->Size(), 0);
+  EXPECT_EQ(cache->NumHits(), 0);
+  EXPECT_EQ(cache->NumMisses(), 0);
+}
+
+// Checking the cell center with the bound grown by half a cell covers every
+// position in the cell, so a shared result is never a false positive.
+TEST(ValidityCache, TestCellCenter) {
+  const double kResolution = 0.1;
+  const ValidityCache::Ptr cache = ValidityCache::Create(kResolution, 100);
+
+  const BallsInBox::Ptr space = BallsInBox::Create();
+  space->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+  space->AddObstacle(Vector3d(4.95, 5.0, 5.0), 1.0);
+
+  // Both positions are in the same cell, one just outside the obstacle and
+  // one just inside.
+  const Vector3d bound = Vector3d::Constant(0.2);
+  const Vector3d outside(6.16, 5.05, 5.05);
+  const Vector3d inside(6.14, 5.05, 5.05);
+  EXPECT_TRUE(space->IsFree(outside, bound));
+  EXPECT_FALSE(space->IsFree(inside, bound));
+
+  const Vector3d center = cache->CellCenter(outside);
+  EXPECT_TRUE(center.isApprox(cache->CellCenter(inside)));
+  EXPECT_LE((center - outside).cwiseAbs().maxCoeff(), 0.5 * kResolution);
+  EXPECT_LE((center - inside).cwiseAbs().maxCoeff(), 0.5 * kResolution);
+
+  const Vector3d cell_bound =
+    bound + Vector3d::Constant(0.5 * kResolution);
+  EXPECT_FALSE(space->IsFree(center, cell_bound));
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the VoxelBox class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/voxel_box.h>
+
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Check region queries against brute force over the inserted points.
+TEST(VoxelBox, TestIsOccupied) {
+  const double kResolution = 0.1;
+  const VoxelBox::Ptr space = VoxelBox::Create(kResolution);
+  space->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+
+  std::random_device rd;
+  std::default_random_engine rng(rd());
+  std::uniform_real_distribution<double> unif(0.0, 10.0);
+  std::uniform_real_distribution<double> size(0.0, 1.0);
+
+  // Random point cloud, snapped to voxel centers.
+  std::vector<Vector3d> points;
+  for (size_t ii = 0; ii < 200; ii++) {
+    const Vector3d p(unif(rng), unif(rng), unif(rng));
+    points.push_back(kResolution *
+      ((p / kResolution).array().floor() + 0.5).matrix());
+  }
+
+  const size_t num_inserted = space->Insert(points);
+  EXPECT_LE(num_inserted, points.size());
+  EXPECT_EQ(space->NumOccupied(), num_inserted);
+
+  // Inserting again adds nothing.
+  EXPECT_EQ(space->Insert(points), 0);
+
+  for (size_t ii = 0; ii < 1000; ii++) {
+    const Vector3d lower(unif(rng), unif(rng), unif(rng));
+    const Vector3d upper =
+      lower + Vector3d(size(rng), size(rng), size(rng));
+
+    // Occupied if any inserted voxel overlaps the query box.
+    bool occupied = false;
+    for (const auto& p : points)
+      if ((p.array() + 0.5 * kResolution >= lower.array()).all() &&
+          (p.array() - 0.5 * kResolution <= upper.array()).all())
+        occupied = true;
+
+    EXPECT_EQ(space->IsOccupied(lower, upper), occupied);
+  }
+
+  // Clearing empties the grid.
+  space->Clear();
+  EXPECT_EQ(space->NumOccupied(), 0);
+  EXPECT_FALSE(space->IsOccupied(Vector3d::Zero(), Vector3d::Constant(10.0)));
+}
+
+// Storage should grow with occupied volume, not with the size of the box.
+TEST(VoxelBox, TestSparseStorage) {
+  const VoxelBox::Ptr space = VoxelBox::Create(0.05);
+  space->SetBounds(Vector3d::Zero(), Vector3d::Constant(1000.0));
+
+  space->Insert(Vector3d(1.0, 2.0, 3.0));
+  space->Insert(Vector3d(900.0, 900.0, 900.0));
+  EXPECT_EQ(space->NumOccupied(), 2);
+
+  // One word per level per point, plus the shared root.
+  EXPECT_LE(space->NumWords(), 2 * 11);
+
+  EXPECT_TRUE(space->IsOccupied(Vector3d(0.9, 1.9, 2.9),
+                                Vector3d(1.1, 2.1, 3.1)));
+  EXPECT_FALSE(space->IsOccupied(Vector3d(1.2, 2.0, 3.0),
+                                 Vector3d(800.0, 800.0, 800.0)));
+  EXPECT_TRUE(space->IsOccupied(Vector3d::Zero(),
+                                Vector3d::Constant(1000.0)));
+
+  // Points outside the box are ignored.
+  EXPECT_FALSE(space->Insert(Vector3d(-1.0, 0.0, 0.0)));
+}
+
+// Spherical obstacles should occupy every voxel they touch, and no others.
+TEST(VoxelBox, TestAddObstacle) {
+  const VoxelBox::Ptr space = VoxelBox::Create(0.1);
+  space->SetBounds(Vector3d::Zero(), Vector3d::Constant(10.0));
+
+  const Vector3d center(5.02, 5.02, 5.02);
+  EXPECT_FALSE(space->IsObstacle(center, 0.3));
+  space->AddObstacle(center, 0.3);
+  EXPECT_TRUE(space->IsObstacle(center, 0.3));
+
+  // Touching the sphere is blocked, clear of it is free.
+  EXPECT_FALSE(space->IsFree(center + Vector3d(0.5, 0.0, 0.0),
+                             Vector3d::Constant(0.25)));
+  EXPECT_TRUE(space->IsFree(center + Vector3d(1.0, 0.0, 0.0),
+                            Vector3d::Constant(0.25)));
+
+  // The corners of the bounding cube are outside the sphere.
+  EXPECT_FALSE(space->IsOccupied(center + Vector3d::Constant(0.25),
+                                 center + Vector3d::Constant(0.25)));
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for pruning in the WaypointTree class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <meta_planner/waypoint_tree.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// The size cap removes the least promising subtrees first, and once a
+// trajectory is found dominated subtrees are removed.
+TEST(WaypointTree, TestPrune) {
+  const Vector3d start = Vector3d::Zero();
+  const Vector3d stop(10.0, 0.0, 0.0);
+  WaypointTree tree(start, 0);
+
+  // Euclidean distance is an optimistic time to go at unit speed.
+  const auto cost_to_go = [&](const Vector3d& point) {
+    return (point - stop).norm();
+  };
+
+  // Straight-line trajectory at unit speed from the parent waypoint.
+  const auto connect = [](const Waypoint::ConstPtr& parent,
+                          const Vector3d& point) {
+    const double start = (parent->traj_ == nullptr) ?
+      0.0 : parent->traj_->LastTime();
+
+    const Trajectory::Ptr traj = Trajectory::Create();
+    traj->Add(start, parent->point_, 0, 0);
+    traj->Add(start + (point - parent->point_).norm(), point, 0, 0);
+
+    return Waypoint::Create(point, 0, traj, parent);
+  };
+
+  // Connect everything to the root.
+  Vector3d query = start;
+  const Waypoint::ConstPtr root = tree.KnnSearch(query, 1)[0];
+
+  // Best trajectory straight to the goal.
+  const Waypoint::ConstPtr middle = connect(root, Vector3d(5.0, 0.0, 0.0));
+  const Waypoint::ConstPtr goal = connect(middle, stop);
+
+  // A detour whose subtree cannot beat it, and a waypoint on the way.
+  const Waypoint::ConstPtr detour = connect(root, Vector3d(0.0, 5.0, 0.0));
+  const Waypoint::ConstPtr detour_child =
+    connect(detour, Vector3d(5.0, 5.0, 0.0));
+  const Waypoint::ConstPtr on_the_way = connect(root, Vector3d(2.0, 0.0, 0.0));
+
+  tree.Insert(middle, false);
+  tree.Insert(detour, false);
+  tree.Insert(detour_child, false);
+  tree.Insert(on_the_way, false);
+
+  // Nothing is dominated before a trajectory is found.
+  EXPECT_EQ(tree.Prune(cost_to_go), 0);
+  EXPECT_EQ(tree.Size(), 5);
+
+  // A cap removes the least promising subtree first.
+  EXPECT_EQ(tree.Prune(cost_to_go, 3), 2);
+  EXPECT_EQ(tree.Size(), 3);
+
+  // Detour is gone from the index.
+  query = Vector3d(0.0, 5.0, 0.0);
+  EXPECT_NEAR((tree.KnnSearch(query, 1)[0]->point_ - start).norm(),
+              0.0, 1e-8);
+
+  // Once the goal is reached, a waypoint off the best trajectory is
+  // dominated, but those on it are not.
+  tree.Insert(goal, true);
+  EXPECT_NEAR(tree.BestTime(), 10.0, 1e-8);
+
+  tree.Insert(connect(on_the_way, Vector3d(3.0, 1.0, 0.0)), false);
+  EXPECT_EQ(tree.Size(), 5);
+  EXPECT_EQ(tree.Prune(cost_to_go), 1);
+  EXPECT_EQ(tree.Size(), 4);
+  EXPECT_NEAR(tree.BestTrajectory()->LastTime(), 10.0, 1e-8);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the RingBuffer class, a lock-free single-producer/single-consumer
+// queue of fixed capacity. Push() never blocks or allocates, so it is safe to
+// call from a hard real-time loop; if the buffer is full the element is
+// dropped and counted instead.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef UTILS_RING_BUFFER_H
+#define UTILS_RING_BUFFER_H
+
+#include <utils/uncopyable.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace meta {
+
+template<typename T>
+class RingBuffer : private Uncopyable {
+public:
+  // Capacity is rounded up to the next power of two.
+  explicit RingBuffer(size_t capacity)
+    : capacity_(RoundUp(capacity)),
+      mask_(capacity_ - 1),
+      data_(new T[capacity_]),
+      head_(0),
+      tail_(0),
+      dropped_(0) {}
+  ~RingBuffer() {}
+
+  // Producer side. Returns false (and drops the element) if full.
+  inline bool Push(const T& element) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= capacity_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    data_[head & mask_] = element;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if empty.
+  inline bool Pop(T& element) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+      return false;
+
+    element = data_[tail & mask_];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate number of elements currently queued.
+  inline size_t Size() const {
+    return head_.load(std::memory_order_acquire) -
+      tail_.load(std::memory_order_acquire);
+  }
+
+  inline size_t Capacity() const { return capacity_; }
+
+  // Number of elements dropped because the buffer was full.
+  inline size_t Dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static inline size_t RoundUp(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity)
+      rounded <<= 1;
+    return rounded;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<T[]> data_;
+
+  // Pad so producer and consumer indices sit on separate cache lines.
+  char pad0_[64];
+  std::atomic<size_t> head_;
+  char pad1_[64];
+  std::atomic<size_t> tail_;
+  char pad2_[64];
+  std::atomic<size_t> dropped_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the ThreadPool class, a work-stealing task pool intended to be
+// shared by every subsystem that wants parallelism (planner racing, batch
+// value function evaluation, parallel loading, Monte Carlo runs, etc.).
+//
+// Each worker owns a task deque. Workers pop their own deque LIFO (for cache
+// locality when tasks spawn subtasks) and steal FIFO from other workers when
+// their own deque is empty. Tasks submitted from outside the pool are
+// distributed round robin.
+//
+// Cancellation is cooperative: tasks receive (or capture) a
+// CancellationToken and should poll it at convenient points.
+//
+// Each thread has a ScratchArena for short-lived allocations, which is reset
+// after every task run on a worker thread.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef UTILS_THREAD_POOL_H
+#define UTILS_THREAD_POOL_H
+
+#include <utils/uncopyable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace meta {
+
+// ---------------------------- CANCELLATION -------------------------------- //
+
+// Cooperative cancellation flag. Copies share the same underlying state, so
+// a token may be handed to many tasks and cancelled once from anywhere.
+class CancellationToken {
+public:
+  CancellationToken()
+    : cancelled_(new std::atomic<bool>(false)) {}
+
+  // Request cancellation.
+  inline void Cancel() { cancelled_->store(true, std::memory_order_release); }
+
+  // Has cancellation been requested?
+  inline bool IsCancelled() const {
+    return cancelled_->load(std::memory_order_acquire);
+  }
+
+private:
+  std::shared_ptr< std::atomic<bool> > cancelled_;
+};
+
+// ----------------------------- SCRATCH ARENA ------------------------------ //
+
+// Bump allocator for short-lived, per-task scratch memory. Allocations are
+// never freed individually; the whole arena is reset at once. Requests that
+// do not fit in the main block are served from overflow blocks, which are
+// released on reset.
+class ScratchArena : private Uncopyable {
+public:
+  explicit ScratchArena(size_t capacity = kDefaultCapacity)
+    : buffer_(new unsigned char[capacity]),
+      capacity_(capacity),
+      offset_(0) {}
+  ~ScratchArena() {}
+
+  // Allocate 'bytes' bytes aligned to 'alignment' (a power of two).
+  inline void* Allocate(size_t bytes,
+                        size_t alignment = alignof(std::max_align_t)) {
+    const size_t aligned = (offset_ + alignment - 1) & ~(alignment - 1);
+    if (aligned + bytes <= capacity_) {
+      offset_ = aligned + bytes;
+      return buffer_.get() + aligned;
+    }
+
+    // Fall back to a dedicated overflow block.
+    overflow_.emplace_back(new unsigned char[bytes + alignment]);
+    const size_t address =
+      reinterpret_cast<size_t>(overflow_.back().get());
+    return reinterpret_cast<void*>(
+      (address + alignment - 1) & ~(alignment - 1));
+  }
+
+  // Allocate space for 'count' objects of trivially destructible type T.
+  template<typename T>
+  inline T* Allocate(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "ScratchArena only holds trivially destructible types.");
+    return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // Release everything allocated since the last reset.
+  inline void Reset() {
+    offset_ = 0;
+    overflow_.clear();
+  }
+
+  // Bytes used in the main block.
+  inline size_t Used() const { return offset_; }
+  inline size_t Capacity() const { return capacity_; }
+
+  // Default capacity per thread.
+  static const size_t kDefaultCapacity = 1 << 20;
+
+private:
+  std::unique_ptr<unsigned char[]> buffer_;
+  const size_t capacity_;
+  size_t offset_;
+
+  std::vector< std::unique_ptr<unsigned char[]> > overflow_;
+};
+
+// ------------------------------ THREAD POOL ------------------------------- //
+
+class ThreadPool : private Uncopyable {
+public:
+  typedef std::shared_ptr<ThreadPool> Ptr;
+  typedef std::shared_ptr<const ThreadPool> ConstPtr;
+
+  ~ThreadPool() {
+    stop_ = true;
+    {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_all();
+
+    for (size_t ii = 0; ii < threads_.size(); ii++)
+      threads_[ii].join();
+  }
+
+  // Factory method. A thread count of zero means one fewer than the number
+  // of hardware threads (leaving a core free for the control loop).
+  static inline Ptr Create(size_t num_threads = 0) {
+    if (num_threads == 0) {
+      const size_t hardware = std::thread::hardware_concurrency();
+      num_threads = (hardware > 1) ? hardware - 1 : 1;
+    }
+
+    return Ptr(new ThreadPool(num_threads));
+  }
+
+  // Process-wide shared pool. All subsystems should use this one unless they
+  // have a very good reason not to, so that parallel features compose
+  // without oversubscribing the machine.
+  static inline ThreadPool& Shared() {
+    static const Ptr pool = Create();
+    return *pool;
+  }
+
+  // Submit a callable (with arguments) and get a future for its result.
+  template<typename F, typename... Args>
+  std::future<typename std::result_of<F(Args...)>::type>
+  Submit(F&& f, Args&&... args);
+
+  // Run fn(ii) for ii in [begin, end) across the pool, split into chunks of
+  // at least 'grain' indices. The calling thread participates, so this is
+  // safe to call from inside a task. Stops scheduling new chunks once the
+  // token is cancelled. Returns false if cancelled.
+  bool ParallelFor(size_t begin, size_t end,
+                   const std::function<void(size_t)>& fn,
+                   size_t grain = 1,
+                   const CancellationToken& token = CancellationToken());
+
+  // Wait for a future, running queued tasks on this thread in the meantime.
+  // Use this instead of future::wait() from inside a task to avoid
+  // deadlocking the pool.
+  template<typename T>
+  void Wait(const std::future<T>& future);
+
+  // Pin worker 'ii' to CPU cpus[ii % cpus.size()]. Returns false if
+  // unsupported on this platform or if any call fails.
+  bool SetAffinity(const std::vector<int>& cpus);
+
+  // Scratch arena for the calling thread. On pool workers this is reset
+  // after every task; other threads must call Reset() themselves.
+  static inline ScratchArena& Scratch() {
+    static thread_local ScratchArena arena;
+    return arena;
+  }
+
+  // Number of worker threads.
+  inline size_t NumThreads() const { return threads_.size(); }
+
+private:
+  typedef std::function<void()> Task;
+
+  // A worker's task deque.
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  explicit ThreadPool(size_t num_threads);
+
+  // Push a task, onto this thread's own queue if it is a worker of this pool.
+  void Push(Task task);
+
+  // Try to grab a task: own queue first (LIFO), then steal (FIFO).
+  bool Pop(Task& task);
+
+  // Run one queued task if there is one. Returns true if a task ran.
+  bool RunPendingTask();
+
+  // Main loop for worker 'index'.
+  void Run(size_t index);
+
+  // Index of this thread's queue, or -1 if not a worker of this pool.
+  inline int LocalIndex() const {
+    return (CurrentPool() == this) ? CurrentIndex() : -1;
+  }
+
+  static inline const ThreadPool*& CurrentPool() {
+    static thread_local const ThreadPool* pool = nullptr;
+    return pool;
+  }
+
+  static inline int& CurrentIndex() {
+    static thread_local int index = -1;
+    return index;
+  }
+
+  std::vector< std::unique_ptr<Queue> > queues_;
+  std::vector<std::thread> threads_;
+
+  // Sleeping workers wait on this until there is work or we are stopping.
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+
+  std::atomic<size_t> pending_;
+  std::atomic<size_t> next_queue_;
+  std::atomic<bool> stop_;
+};
+
+// ---------------------------- IMPLEMENTATION ------------------------------ //
+
+inline ThreadPool::ThreadPool(size_t num_threads)
+  : pending_(0),
+    next_queue_(0),
+    stop_(false) {
+  for (size_t ii = 0; ii < num_threads; ii++)
+    queues_.emplace_back(new Queue);
+
+  for (size_t ii = 0; ii < num_threads; ii++)
+    threads_.emplace_back(&ThreadPool::Run, this, ii);
+}
+
+// Submit a callable (with arguments) and get a future for its result.
+template<typename F, typename... Args>
+std::future<typename std::result_of<F(Args...)>::type>
+ThreadPool::Submit(F&& f, Args&&... args) {
+  typedef typename std::result_of<F(Args...)>::type ReturnType;
+
+  // std::function requires copyable targets, so share the packaged task.
+  const std::shared_ptr< std::packaged_task<ReturnType()> > task =
+    std::make_shared< std::packaged_task<ReturnType()> >(
+      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+
+  std::future<ReturnType> future = task->get_future();
+  Push([task]() { (*task)(); });
+
+  return future;
+}
+
+// Push a task, onto this thread's own queue if it is a worker of this pool.
+inline void ThreadPool::Push(Task task) {
+  const int local = LocalIndex();
+  const size_t index = (local >= 0) ?
+    static_cast<size_t>(local) : next_queue_++ % queues_.size();
+
+  // Count the task before it becomes visible so 'pending_' never underflows.
+  pending_++;
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+  }
+  wake_.notify_one();
+}
+
+// Try to grab a task: own queue first (LIFO), then steal (FIFO).
+inline bool ThreadPool::Pop(Task& task) {
+  const int local = LocalIndex();
+  if (local >= 0) {
+    Queue& queue = *queues_[local];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      pending_--;
+      return true;
+    }
+  }
+
+  // Steal, starting just past our own queue to spread contention.
+  const size_t start = (local >= 0) ? local + 1 : next_queue_.load();
+  for (size_t ii = 0; ii < queues_.size(); ii++) {
+    Queue& victim = *queues_[(start + ii) % queues_.size()];
+    std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+    if (!lock.owns_lock() || victim.tasks.empty())
+      continue;
+
+    task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    pending_--;
+    return true;
+  }
+
+  return false;
+}
+
+// Run one queued task if there is one. Returns true if a task ran.
+inline bool ThreadPool::RunPendingTask() {
+  Task task;
+  if (!Pop(task))
+    return false;
+
+  task();
+  return true;
+}
+
+// Main loop for worker 'index'.
+inline void ThreadPool::Run(size_t index) {
+  CurrentPool() = this;
+  CurrentIndex() = static_cast<int>(index);
+
+  while (true) {
+    if (RunPendingTask()) {
+      Scratch().Reset();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [this]() { return stop_ || pending_ > 0; });
+
+    if (stop_ && pending_ == 0)
+      return;
+  }
+}
+
+// Wait for a future, running queued tasks on this thread in the meantime.
+template<typename T>
+void ThreadPool::Wait(const std::future<T>& future) {
+  while (future.wait_for(std::chrono::seconds(0)) !=
+         std::future_status::ready) {
+    if (!RunPendingTask())
+      std::this_thread::yield();
+  }
+}
+
+// Run fn(ii) for ii in [begin, end) across the pool.
+inline bool ThreadPool::ParallelFor(size_t begin, size_t end,
+                                    const std::function<void(size_t)>& fn,
+                                    size_t grain,
+                                    const CancellationToken& token) {
+  if (end <= begin)
+    return true;
+
+  // Aim for a few chunks per worker so stealing can balance the load.
+  const size_t count = end - begin;
+  const size_t target_chunks = 4 * (NumThreads() + 1);
+  const size_t chunk =
+    std::max<size_t>(std::max<size_t>(grain, 1), count / target_chunks + 1);
+
+  std::vector< std::future<void> > futures;
+  for (size_t lower = begin; lower < end; lower += chunk) {
+    const size_t upper = std::min(lower + chunk, end);
+    futures.push_back(Submit([&fn, &token, lower, upper]() {
+      for (size_t ii = lower; ii < upper; ii++) {
+        if (token.IsCancelled())
+          return;
+        fn(ii);
+      }
+    }));
+  }
+
+  for (size_t ii = 0; ii < futures.size(); ii++)
+    Wait(futures[ii]);
+
+  return !token.IsCancelled();
+}
+
+// Pin worker 'ii' to CPU cpus[ii % cpus.size()].
+inline bool ThreadPool::SetAffinity(const std::vector<int>& cpus) {
+  if (cpus.empty())
+    return false;
+
+#ifdef __linux__
+  bool success = true;
+  for (size_t ii = 0; ii < threads_.size(); ii++) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[ii % cpus.size()], &set);
+
+    if (pthread_setaffinity_np(threads_[ii].native_handle(),
+                               sizeof(cpu_set_t), &set) != 0)
+      success = false;
+  }
+
+  return success;
+#else
+  return false;
+#endif
+}
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Converts a subsystem value function stored as a full grid (.mat file, as
+// loaded by SubsystemValueFunction) to a sparse grid (.sgvf file). The
+// value and gradient are sampled from the full grid's interpolant at the
+// sparse grid points, over the same box.
+//
+// Usage:
+//   sparse_grid_value_function_converter <input.mat> <output.sgvf> [level]
+// The level (default 6) is the finest level in each dimension, i.e. the
+// sparse grid resolves 2^level - 1 points along each axis.
+//
+// Mostly useful to check sparse grids against existing full grids; for
+// subsystems too large for a full grid, the C++ precomputation writes
+// sparse grids directly.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/subsystem_value_function.h>
+#include <value_function/sparse_grid.h>
+
+#include <matio.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Read a variable of any numeric type into a vector of doubles.
+bool ReadVariable(mat_t* matfp, const std::string& name,
+                  std::vector<double>& values) {
+  matvar_t* var = Mat_VarRead(matfp, name.c_str());
+  if (var == NULL) {
+    fprintf(stderr, "Could not read variable: %s.\n", name.c_str());
+    return false;
+  }
+
+  const size_t num_elements = var->nbytes / var->data_size;
+  values.resize(num_elements);
+
+  bool success = true;
+  for (size_t ii = 0; ii < num_elements; ii++) {
+    if (var->data_type == MAT_T_DOUBLE)
+      values[ii] = static_cast<double*>(var->data)[ii];
+    else if (var->data_type == MAT_T_UINT64)
+      values[ii] = static_cast<double>(static_cast<uint64_t*>(var->data)[ii]);
+    else {
+      fprintf(stderr, "%s: Wrong type of data.\n", name.c_str());
+      success = false;
+      break;
+    }
+  }
+
+  Mat_VarFree(var);
+  return success;
+}
+
+// Convert a vector of doubles to sizes.
+std::vector<size_t> ToSizes(const std::vector<double>& values) {
+  std::vector<size_t> sizes;
+  for (size_t ii = 0; ii < values.size(); ii++)
+    sizes.push_back(static_cast<size_t>(values[ii]));
+
+  return sizes;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "Usage: %s <input.mat> <output.sgvf> [level]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t level = (argc > 3) ? atoi(argv[3]) : 6;
+
+  mat_t* matfp = Mat_Open(argv[1], MAT_ACC_RDONLY);
+  if (matfp == NULL) {
+    fprintf(stderr, "Could not open file: %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<double> grid_min, grid_max, x_dims, u_dims, teb;
+  std::vector<double> priority_lower, priority_upper, max_planner_speed;
+  const bool read =
+    ReadVariable(matfp, "grid_min", grid_min) &&
+    ReadVariable(matfp, "grid_max", grid_max) &&
+    ReadVariable(matfp, "x_dims", x_dims) &&
+    ReadVariable(matfp, "u_dims", u_dims) &&
+    ReadVariable(matfp, "teb", teb) &&
+    ReadVariable(matfp, "priority_lower", priority_lower) &&
+    ReadVariable(matfp, "priority_upper", priority_upper) &&
+    ReadVariable(matfp, "max_planner_speed", max_planner_speed);
+  Mat_Close(matfp);
+
+  if (!read || priority_lower.empty() || priority_upper.empty())
+    return EXIT_FAILURE;
+
+  const meta::SubsystemValueFunction::ConstPtr full =
+    meta::SubsystemValueFunction::Create(argv[1]);
+  if (!full->IsInitialized()) {
+    fprintf(stderr, "Could not load file: %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  // Subsystem dimensions within a full state just large enough to hold them.
+  const std::vector<size_t> state_dims = ToSizes(x_dims);
+  const size_t num_dims = state_dims.size();
+  const size_t state_dim =
+    *std::max_element(state_dims.begin(), state_dims.end()) + 1;
+  meta::VectorXd state = meta::VectorXd::Zero(state_dim);
+
+  // Sample the value and gradient at the sparse grid points.
+  const std::vector<double> points = meta::SparseGrid::Points(num_dims, level);
+  std::vector<double> values;
+  values.reserve(points.size() / num_dims * (num_dims + 1));
+
+  for (size_t ii = 0; ii < points.size(); ii += num_dims) {
+    for (size_t jj = 0; jj < num_dims; jj++)
+      state(state_dims[jj]) =
+        grid_min[jj] + points[ii + jj] * (grid_max[jj] - grid_min[jj]);
+
+    values.push_back(full->Value(state));
+
+    const meta::VectorXd gradient = full->Gradient(state);
+    for (size_t jj = 0; jj < num_dims; jj++)
+      values.push_back(gradient(state_dims[jj]));
+  }
+
+  const meta::SparseGrid::ConstPtr grid =
+    meta::SparseGrid::Interpolate(num_dims, level, num_dims + 1, values);
+
+  if (!meta::SubsystemValueFunction::SaveSparseGrid(
+        argv[2], state_dims, ToSizes(u_dims), grid_min, grid_max,
+        max_planner_speed, priority_lower[0], priority_upper[0], teb,
+        *grid)) {
+    fprintf(stderr, "Could not write file: %s.\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  // Report on the result, comparing against the full grid at random states.
+  const meta::SubsystemValueFunction::ConstPtr sparse =
+    meta::SubsystemValueFunction::Create(argv[2]);
+  if (!sparse->IsInitialized()) {
+    fprintf(stderr, "Could not read back file: %s.\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 rng(0);
+  double max_error = 0.0;
+  for (size_t ii = 0; ii < 10000; ii++) {
+    for (size_t jj = 0; jj < num_dims; jj++) {
+      std::uniform_real_distribution<double>
+        unif(grid_min[jj], grid_max[jj]);
+      state(state_dims[jj]) = unif(rng);
+    }
+
+    max_error = std::max(max_error,
+                         std::abs(sparse->Value(state) - full->Value(state)));
+  }
+
+  printf("%s: level %zu, %zu points, %zu bytes, max value error %g.\n",
+         argv[2], level, grid->NumPoints(), grid->MemoryBytes(), max_error);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Converts a time-varying subsystem value function from .mat to the
+// memory-mappable format read by TimeVaryingSubsystemValueFunction.
+//
+// The .mat file holds the same variables as a SubsystemValueFunction
+// (grid_min, grid_max, grid_N, x_dims, u_dims, priority_lower,
+// priority_upper, max_planner_speed), plus:
+//   tau  -- slice times (T entries, increasing)
+//   teb  -- tracking error bound per slice (T x num_dims, slice-major)
+//   data -- values, slice-major, each slice in row-major order
+//
+// Usage: tv_value_function_converter <input.mat> <output.tvvf>
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/time_varying_subsystem_value_function.h>
+
+#include <matio.h>
+#include <stdio.h>
+
+// Read a variable of any numeric type into a vector of doubles.
+bool ReadVariable(mat_t* matfp, const std::string& name,
+                  std::vector<double>& values) {
+  matvar_t* var = Mat_VarRead(matfp, name.c_str());
+  if (var == NULL) {
+    fprintf(stderr, "Could not read variable: %s.\n", name.c_str());
+    return false;
+  }
+
+  const size_t num_elements = var->nbytes / var->data_size;
+  values.resize(num_elements);
+
+  bool success = true;
+  for (size_t ii = 0; ii < num_elements; ii++) {
+    if (var->data_type == MAT_T_DOUBLE)
+      values[ii] = static_cast<double*>(var->data)[ii];
+    else if (var->data_type == MAT_T_UINT64)
+      values[ii] = static_cast<double>(static_cast<uint64_t*>(var->data)[ii]);
+    else {
+      fprintf(stderr, "%s: Wrong type of data.\n", name.c_str());
+      success = false;
+      break;
+    }
+  }
+
+  Mat_VarFree(var);
+  return success;
+}
+
+// Convert a vector of doubles to sizes.
+std::vector<size_t> ToSizes(const std::vector<double>& values) {
+  std::vector<size_t> sizes;
+  for (size_t ii = 0; ii < values.size(); ii++)
+    sizes.push_back(static_cast<size_t>(values[ii]));
+
+  return sizes;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <input.mat> <output.tvvf>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  mat_t* matfp = Mat_Open(argv[1], MAT_ACC_RDONLY);
+  if (matfp == NULL) {
+    fprintf(stderr, "Could not open file: %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<double> grid_min, grid_max, grid_N, x_dims, u_dims;
+  std::vector<double> priority_lower, priority_upper, max_planner_speed;
+  std::vector<double> tau, teb, data;
+  const bool read =
+    ReadVariable(matfp, "grid_min", grid_min) &&
+    ReadVariable(matfp, "grid_max", grid_max) &&
+    ReadVariable(matfp, "grid_N", grid_N) &&
+    ReadVariable(matfp, "x_dims", x_dims) &&
+    ReadVariable(matfp, "u_dims", u_dims) &&
+    ReadVariable(matfp, "priority_lower", priority_lower) &&
+    ReadVariable(matfp, "priority_upper", priority_upper) &&
+    ReadVariable(matfp, "max_planner_speed", max_planner_speed) &&
+    ReadVariable(matfp, "tau", tau) &&
+    ReadVariable(matfp, "teb", teb) &&
+    ReadVariable(matfp, "data", data);
+  Mat_Close(matfp);
+
+  if (!read || priority_lower.empty() || priority_upper.empty())
+    return EXIT_FAILURE;
+
+  if (!meta::TimeVaryingSubsystemValueFunction::Write(
+        argv[2], ToSizes(x_dims), ToSizes(u_dims), ToSizes(grid_N),
+        grid_min, grid_max, max_planner_speed,
+        priority_lower[0], priority_upper[0], tau, teb, data)) {
+    fprintf(stderr, "Could not write file: %s.\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
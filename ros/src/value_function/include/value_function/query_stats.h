@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the QueryStats class, which keeps per-ValueFunctionId query counts,
+// latency histograms, and priority distributions. All counters are atomic so
+// that they may be updated from any thread without locking.
+//
+// Latency histograms use power-of-two buckets in microseconds, i.e. bucket
+// ii holds latencies in [2^(ii-1), 2^ii) us (bucket 0 is < 1 us, and the
+// last bucket holds everything larger).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VALUE_FUNCTION_QUERY_STATS_H
+#define VALUE_FUNCTION_QUERY_STATS_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <atomic>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class QueryStats : private Uncopyable {
+public:
+  typedef std::shared_ptr<QueryStats> Ptr;
+  typedef std::shared_ptr<const QueryStats> ConstPtr;
+
+  // Types of queries we keep track of.
+  enum QueryType {
+    OPTIMAL_CONTROL,
+    PRIORITY,
+    TRACKING_BOUND,
+    SWITCHING_TRACKING_BOUND,
+    SWITCHING_TIME,
+    SWITCHING_DISTANCE,
+    MAX_PLANNER_SPEED,
+    BEST_POSSIBLE_TIME,
+    NUM_QUERY_TYPES
+  };
+
+  // Histogram sizes.
+  static const size_t kNumLatencyBuckets = 16;
+  static const size_t kNumPriorityBuckets = 10;
+
+  ~QueryStats() {}
+
+  // Factory method. Use this instead of the constructor.
+  static Ptr Create(size_t num_ids);
+
+  // Record a query of the given type against the given ID, which took
+  // 'seconds' to answer. Unknown IDs are ignored.
+  void RecordQuery(ValueFunctionId id, QueryType type, double seconds);
+
+  // Record a priority returned for the given ID.
+  void RecordPriority(ValueFunctionId id, double priority);
+
+  // Accessors.
+  size_t NumIds() const { return num_ids_; }
+  size_t NumQueries(ValueFunctionId id, QueryType type) const;
+  size_t LatencyBucket(ValueFunctionId id, QueryType type, size_t ii) const;
+  size_t PriorityBucket(ValueFunctionId id, size_t ii) const;
+
+  // Mean and max latency (seconds) for this ID and query type.
+  double MeanLatency(ValueFunctionId id, QueryType type) const;
+  double MaxLatency(ValueFunctionId id, QueryType type) const;
+
+  // Upper edge (seconds) of the latency bucket containing the given quantile
+  // in [0, 1], e.g. 0.99 for the 99th percentile.
+  double LatencyQuantile(ValueFunctionId id, QueryType type,
+                         double quantile) const;
+
+  // Human-readable name of a query type.
+  static const char* QueryName(QueryType type);
+
+private:
+  explicit QueryStats(size_t num_ids);
+
+  // Counters for a single (ID, query type) pair.
+  struct Counters {
+    std::atomic<size_t> count;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<size_t> latency[kNumLatencyBuckets];
+  };
+
+  // Index into counters_.
+  inline size_t Index(ValueFunctionId id, QueryType type) const {
+    return id * NUM_QUERY_TYPES + type;
+  }
+
+  const size_t num_ids_;
+
+  std::unique_ptr<Counters[]> counters_;
+  std::unique_ptr<std::atomic<size_t>[]> priorities_;
+};
+
+} //\namespace meta
+
+#endif
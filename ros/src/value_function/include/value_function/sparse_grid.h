@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SparseGrid class, a piecewise multilinear interpolant on a
+// regular sparse grid over the unit cube, used to store value functions of
+// subsystems with too many dimensions for a full grid.
+//
+// The interpolant is a sum over subspaces, one per level vector l with
+// l_i >= 1 and sum_i (l_i - 1) <= level - 1. Subspace l holds the points
+// z_i = (2 p_i + 1) / 2^l_i, 0 <= p_i < 2^(l_i - 1), and each point carries
+// a hierarchical surplus times a product of 1D basis functions. The basis is
+// the "modified" linear one: level 1 is constant, the outermost functions
+// of every finer level extrapolate linearly to the boundary, and all others
+// are the usual hats. There are no boundary points, so a level-n grid in d
+// dimensions has O(2^n n^(d-1)) points rather than O(2^(nd)), and a query
+// touches one point per subspace.
+//
+// Subspaces are stored in lexicographic order of their level vectors (last
+// dimension fastest), and points within a subspace in row-major order of
+// p, so the index of a point within its subspace is the concatenation of
+// the bits of p_0, ..., p_{d-1}. Every point carries num_fields surpluses,
+// stored contiguously, so that several functions sharing the grid (e.g. a
+// value and its gradient) are evaluated in one pass.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VALUE_FUNCTION_SPARSE_GRID_H
+#define VALUE_FUNCTION_SPARSE_GRID_H
+
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class SparseGrid : private Uncopyable {
+public:
+  typedef std::unique_ptr<const SparseGrid> ConstPtr;
+
+  // Destructor.
+  ~SparseGrid() {}
+
+  // Factory method from hierarchical surpluses, num_fields per point in
+  // storage order. Use this instead of the constructor.
+  // Note that this class is const-only, which means that once it is
+  // instantiated it can never be changed.
+  static ConstPtr Create(size_t num_dims, size_t level, size_t num_fields,
+                         const std::vector<double>& surpluses);
+
+  // Factory method from function values at the grid points (in the order
+  // given by Points), num_fields per point. These are converted to
+  // hierarchical surpluses, so the result interpolates them.
+  static ConstPtr Interpolate(size_t num_dims, size_t level,
+                              size_t num_fields,
+                              const std::vector<double>& values);
+
+  // Coordinates of all grid points in the unit cube, num_dims per point, in
+  // storage order.
+  static std::vector<double> Points(size_t num_dims, size_t level);
+
+  // Number of points of a grid, without building it.
+  static size_t NumPoints(size_t num_dims, size_t level);
+
+  // Evaluate the first num_fields fields (all by default) at a point of the
+  // unit cube. Coordinates outside [0, 1] are clamped.
+  void Evaluate(const double* z, double* fields) const {
+    Evaluate(z, fields, num_fields_);
+  }
+  void Evaluate(const double* z, double* fields, size_t num_fields) const;
+
+  // Accessors.
+  inline size_t NumDimensions() const { return num_dims_; }
+  inline size_t Level() const { return level_; }
+  inline size_t NumFields() const { return num_fields_; }
+  inline size_t NumPoints() const { return offsets_.back(); }
+  inline size_t NumSubspaces() const { return offsets_.size() - 1; }
+  inline const std::vector<double>& Surpluses() const { return surpluses_; }
+
+  // Approximate memory footprint, in bytes.
+  size_t MemoryBytes() const;
+
+  // Was this grid properly initialized?
+  inline bool IsInitialized() const { return initialized_; }
+
+  // Limits on the number of dimensions and the level.
+  static const size_t kMaxDimensions;
+  static const size_t kMaxLevel;
+
+private:
+  explicit SparseGrid(size_t num_dims, size_t level, size_t num_fields,
+                      const std::vector<double>& surpluses);
+
+  // Build a grid and check that the data (num_fields per point) matches it.
+  static SparseGrid* Build(size_t num_dims, size_t level, size_t num_fields,
+                           const std::vector<double>& data);
+
+  // Set up the subspace tables. Returns whether or not it was successful.
+  bool Initialize();
+
+  // Number of subspaces over dimensions [dim, num_dims) whose levels sum to
+  // at most 'budget' above one per dimension.
+  inline size_t Count(size_t dim, size_t budget) const {
+    return counts_[dim * level_ + budget];
+  }
+
+  // Index of the subspace with these levels.
+  size_t SubspaceIndex(const std::vector<size_t>& levels) const;
+
+  // Step through level vectors in storage order. Returns false once every
+  // subspace has been visited.
+  bool NextSubspace(std::vector<size_t>& levels) const;
+
+  // Convert values at the grid points to surpluses, in place.
+  void Hierarchize(std::vector<double>& values) const;
+
+  // Position of z within a level, and the value of its basis function there.
+  static uint64_t Position(size_t level, double z);
+  static double Basis(size_t level, uint64_t position, double z);
+
+  // Number of dimensions, level, and fields per point.
+  size_t num_dims_;
+  size_t level_;
+  size_t num_fields_;
+
+  // Subspace counts (see Count), the first point of each subspace with the
+  // total number of points at the end, and the levels of each subspace.
+  std::vector<size_t> counts_;
+  std::vector<size_t> offsets_;
+  std::vector<uint8_t> subspace_levels_;
+
+  // Surpluses, num_fields_ per point.
+  std::vector<double> surpluses_;
+
+  // Was this grid initialized properly?
+  bool initialized_;
+};
+
+} //\namespace meta
+
+#endif
@@ -38,12 +38,27 @@
 //
 // Defines the SubsystemValueFunction class.
 //
+// Subsystems are loaded either from a full grid (.mat files) or, for
+// subsystems with too many dimensions for that, from a sparse grid (.sgvf
+// files; see SparseGrid). Sparse grid files are written by the C++
+// precomputation or by SaveSparseGrid. Layout (host byte order):
+//   char[8] magic "METASGVF"
+//   uint64 num_dims, num_control_dims, level
+//   uint64 x_dims[num_dims], u_dims[num_control_dims]
+//   double grid_min[num_dims], grid_max[num_dims], max_planner_speed[3],
+//          priority_lower, priority_upper, teb[num_dims]
+//   double surpluses[num_points * (num_dims + 1)]
+// The sparse grid spans [grid_min, grid_max] (boundaries included, unlike
+// the cell-centered full grids) and has num_dims + 1 fields per point: the
+// value, then its gradient with respect to the subsystem state.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef VALUE_FUNCTION_SUBSYSTEM_VALUE_FUNCTION_H
 #define VALUE_FUNCTION_SUBSYSTEM_VALUE_FUNCTION_H
 
 #include <value_function/dynamics.h>
+#include <value_function/sparse_grid.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
 
@@ -51,6 +66,7 @@
 #include <matio.h>
 #include <math.h>
 #include <memory>
+#include <atomic>
 
 namespace meta {
 
@@ -91,9 +107,42 @@ public:
     return max_planner_speed_[ii];
   }
 
+  // Grid bounds in the specified subsystem dimension, and spacing between
+  // grid points (the finest spacing, for sparse grids).
+  inline double LowerBound(size_t ii) const { return lower_[ii]; }
+  inline double UpperBound(size_t ii) const { return upper_[ii]; }
+  inline double GridSpacing(size_t ii) const {
+    return (IsSparse()) ?
+      (upper_[ii] - lower_[ii]) /
+      static_cast<double>(1 << sparse_grid_->Level()) :
+      voxel_size_[ii];
+  }
+
+  // Number of queries which fell outside the grid in the specified
+  // subsystem dimension.
+  inline size_t OutOfGridCount(size_t ii) const {
+    return out_of_grid_[ii].load(std::memory_order_relaxed);
+  }
+
+  // Is this subsystem stored on a sparse grid?
+  inline bool IsSparse() const { return sparse_grid_ != nullptr; }
+
   // Was this SubsystemValueFunction properly initialized?
   inline bool IsInitialized() const { return initialized_; }
 
+  // Write a sparse grid subsystem file. The grid must have the value and
+  // its gradient as fields, and span [lower, upper]. Returns whether it was
+  // successful.
+  static bool SaveSparseGrid(const std::string& file_name,
+                             const std::vector<size_t>& state_dimensions,
+                             const std::vector<size_t>& control_dimensions,
+                             const std::vector<double>& lower,
+                             const std::vector<double>& upper,
+                             const std::vector<double>& max_planner_speed,
+                             double priority_lower, double priority_upper,
+                             const std::vector<double>& tracking_bound,
+                             const SparseGrid& grid);
+
 private:
   explicit SubsystemValueFunction(const std::string& file_name);
 
@@ -101,6 +150,10 @@ private:
   // valid state vector for this subsystem.
   VectorXd Puncture(const VectorXd& state) const;
 
+  // Record which dimensions of this (punctured) query state lie outside
+  // the grid.
+  void RecordOutOfGrid(const VectorXd& punctured) const;
+
   // Return the 1D voxel index corresponding to the given state.
   size_t StateToIndex(const VectorXd& punctured) const;
 
@@ -118,8 +171,14 @@ private:
   // Takes a (punctured) state and index along which to interpolate.
   VectorXd RecursiveGradientInterpolator(const VectorXd& x, size_t idx) const;
 
+  // Interpolate the sparse grid to get the value and gradient at a
+  // (punctured) state. Off the grid, the value is extrapolated linearly
+  // from the nearest point on it.
+  double SparseGridValue(const VectorXd& punctured, VectorXd* gradient) const;
+
   // Load from file. Returns whether or not it was successful.
   bool Load(const std::string& file_name);
+  bool LoadSparseGrid(const std::string& file_name);
 
   // Which dimensions in the full state/control space does this
   // value grid correspond to?
@@ -150,6 +209,17 @@ private:
   // Max planner speed in each spatial dimension.
   std::vector<double> max_planner_speed_;
 
+  // Value and gradient on a sparse grid, used instead of data_ and
+  // gradient_ when loaded from a .sgvf file.
+  SparseGrid::ConstPtr sparse_grid_;
+
+  // File magic for sparse grid files.
+  static const char kSparseGridMagic[8];
+
+  // Out-of-grid query counts in each subsystem dimension. Mutable since
+  // this is telemetry, not state.
+  mutable std::unique_ptr<std::atomic<size_t>[]> out_of_grid_;
+
   // Was this value function initialized/loaded properly?
   bool initialized_;
 };
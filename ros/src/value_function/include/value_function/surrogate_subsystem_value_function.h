@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SurrogateSubsystemValueFunction class, a compact stand-in for
+// a SubsystemValueFunction. The subsystem grid is split into cells of a
+// fixed number of voxels, and each cell is represented by a full quadratic
+// polynomial fitted (least squares) to the voxel values in that cell, so a
+// query costs a handful of multiply-adds and the whole model typically
+// takes a few hundred bytes.
+//
+// Each cell carries an error bound, certified against the grid's own
+// interpolant (nearest voxel plus first-order correction, as in
+// SubsystemValueFunction::Value) everywhere within the cell. The bound is
+// the fit residual at the cell's voxels and its one-voxel border, scaled by
+// the interpolant's worst-case amplification, plus the interpolation error
+// of the quadratic itself, which depends only on its (constant) Hessian.
+// Cells whose bound exceeds the fitting tolerance keep their voxel values
+// instead and are evaluated exactly as on the grid.
+//
+// Files are produced by the static Fit function (see the
+// surrogate_value_function_fitter executable). Layout (host byte order):
+//   char[8] magic "METASRVF"
+//   uint64 num_dims, num_control_dims, num_patch_values
+//   uint64 x_dims[num_dims], u_dims[num_control_dims], grid_N[num_dims],
+//          cell_voxels[num_dims]
+//   double grid_min[num_dims], grid_max[num_dims], max_planner_speed[3],
+//          priority_lower, priority_upper, teb[num_dims]
+//   per cell, in row-major order:
+//     double coefficients[num_terms], error_bound
+//     uint64 patch_offset (kNoPatch if the polynomial is used)
+//   double patch_values[num_patch_values]
+// where num_terms = (num_dims + 1) * (num_dims + 2) / 2. Coefficients are in
+// coordinates normalized to [-1, 1] over the cell, ordered as
+// [1, z_0, ..., z_{n-1}, z_0 z_0, z_0 z_1, ..., z_{n-1} z_{n-1}]. A patch
+// holds the cell's voxels plus a one-voxel border (clipped to the grid), in
+// row-major order.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VALUE_FUNCTION_SURROGATE_SUBSYSTEM_VALUE_FUNCTION_H
+#define VALUE_FUNCTION_SURROGATE_SUBSYSTEM_VALUE_FUNCTION_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace meta {
+
+class SurrogateSubsystemValueFunction : private Uncopyable {
+public:
+  typedef std::unique_ptr<const SurrogateSubsystemValueFunction> ConstPtr;
+
+  // Destructor.
+  ~SurrogateSubsystemValueFunction() {}
+
+  // Factory method. Use this instead of the constructor.
+  // Note that this class is const-only, which means that once it is
+  // instantiated it can never be changed.
+  static ConstPtr Create(const std::string& file_name);
+
+  // Evaluate the surrogate to get the value/gradient at a particular state.
+  // States outside the grid are extrapolated linearly from the grid edge.
+  double Value(const VectorXd& state) const;
+  VectorXd Gradient(const VectorXd& state) const;
+
+  // Priority of the optimal control at the given state. This is a number
+  // between 0 and 1, where 1 means the final control signal should be exactly
+  // the optimal control signal computed by this value function.
+  double Priority(const VectorXd& state) const;
+
+  // Get the state/control dimensions for this subsystem.
+  inline const std::vector<size_t>& StateDimensions() const {
+    return state_dimensions_;
+  }
+  inline const std::vector<size_t>& ControlDimensions() const {
+    return control_dimensions_;
+  }
+
+  // Get the tracking error bound in the specified subsystem dimension.
+  inline double TrackingBound(size_t ii) const { return tracking_bound_[ii]; }
+
+  // Max planner speed in the given spatial dimension.
+  inline double MaxPlannerSpeed(size_t ii) const {
+    return max_planner_speed_[ii];
+  }
+
+  // Grid bounds and voxel size in the specified subsystem dimension.
+  inline double LowerBound(size_t ii) const { return lower_[ii]; }
+  inline double UpperBound(size_t ii) const { return upper_[ii]; }
+  inline double GridSpacing(size_t ii) const { return voxel_size_[ii]; }
+
+  // Number of cells, and how many of them fall back to grid values.
+  inline size_t NumCells() const { return error_bound_.size(); }
+  size_t NumFallbackCells() const;
+
+  // Largest certified error bound over all cells using a polynomial.
+  double MaxErrorBound() const;
+
+  // Approximate memory footprint of the model, in bytes.
+  size_t MemoryBytes() const;
+
+  // Was this value function properly initialized?
+  inline bool IsInitialized() const { return initialized_; }
+
+  // Fit a surrogate to grid data (voxel values in row-major order, as in a
+  // SubsystemValueFunction) and write it to file. Cells are 'cell_voxels'
+  // voxels wide in each dimension; cells whose certified error bound
+  // exceeds 'tolerance' fall back to the grid. Returns whether it was
+  // successful.
+  static bool Fit(const std::string& file_name,
+                  const std::vector<size_t>& state_dimensions,
+                  const std::vector<size_t>& control_dimensions,
+                  const std::vector<size_t>& num_voxels,
+                  const std::vector<double>& lower,
+                  const std::vector<double>& upper,
+                  const std::vector<double>& max_planner_speed,
+                  double priority_lower, double priority_upper,
+                  const std::vector<double>& tracking_bound,
+                  const std::vector<double>& data,
+                  const std::vector<size_t>& cell_voxels,
+                  double tolerance);
+
+  // Patch offset marking a cell that uses its polynomial.
+  static const uint64_t kNoPatch;
+
+private:
+  explicit SurrogateSubsystemValueFunction(const std::string& file_name);
+
+  // Load from file. Returns whether or not it was successful.
+  bool Load(const std::string& file_name);
+
+  // Puncture a state vector for the overall system to get a
+  // valid state vector for this subsystem.
+  VectorXd Puncture(const VectorXd& state) const;
+
+  // Clamp a (punctured) state to the grid, find the voxel and cell
+  // containing it, and the cell's row-major index.
+  size_t Locate(const VectorXd& punctured, VectorXd& clamped,
+                std::vector<size_t>& voxel) const;
+
+  // Cell extent in voxels along dimension ii: [first, last).
+  void CellVoxels(size_t cell, size_t ii, size_t& first, size_t& last) const;
+
+  // Normalized coordinates of a state within a cell, and the cell's half
+  // width in each dimension.
+  VectorXd CellCoordinates(size_t cell, const VectorXd& clamped,
+                           VectorXd& half_width) const;
+
+  // Polynomial value/gradient (with respect to the state) within a cell.
+  double PolynomialValue(size_t cell, const VectorXd& z) const;
+  VectorXd PolynomialGradient(size_t cell, const VectorXd& z,
+                              const VectorXd& half_width) const;
+
+  // Grid value/gradient within a fallback cell, from its patch.
+  double PatchValue(size_t cell, const VectorXd& clamped,
+                    const std::vector<size_t>& voxel) const;
+  VectorXd PatchGradient(size_t cell, const std::vector<size_t>& voxel) const;
+
+  // Value of the voxel at this (grid-clamped) multi-index within a patch.
+  double PatchVoxel(size_t cell, const std::vector<size_t>& voxel) const;
+
+  // Step a row-major multi-index through the box [first, last). Returns
+  // false once every index has been visited.
+  static bool Increment(std::vector<size_t>& index,
+                        const std::vector<size_t>& first,
+                        const std::vector<size_t>& last);
+
+  // Which dimensions in the full state/control space does this
+  // value function correspond to?
+  std::vector<size_t> state_dimensions_;
+  std::vector<size_t> control_dimensions_;
+
+  // Grid: number of voxels, voxel size, and bounds in each dimension.
+  std::vector<size_t> num_voxels_;
+  std::vector<double> voxel_size_;
+  std::vector<double> lower_;
+  std::vector<double> upper_;
+
+  // Cell size in voxels and number of cells in each dimension.
+  std::vector<size_t> cell_voxels_;
+  std::vector<size_t> num_cells_;
+
+  // Lower and upper bounds for the value function, for priority.
+  double priority_lower_;
+  double priority_upper_;
+
+  // Tracking error bound in each subsystem dimension.
+  std::vector<double> tracking_bound_;
+
+  // Max planner speed in each spatial dimension.
+  std::vector<double> max_planner_speed_;
+
+  // Per cell: polynomial coefficients (num_terms_ each), certified error
+  // bound, and patch offset. Fallback cells' voxel values live in patches_.
+  size_t num_terms_;
+  std::vector<double> coefficients_;
+  std::vector<double> error_bound_;
+  std::vector<uint64_t> patch_offset_;
+  std::vector<double> patches_;
+
+  // Was this value function initialized/loaded properly?
+  bool initialized_;
+
+  // File magic.
+  static const char kMagic[8];
+};
+
+} //\namespace meta
+
+#endif
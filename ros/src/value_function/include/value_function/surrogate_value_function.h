@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SurrogateValueFunction class, which inherits from the
+// ValueFunction class and combines SurrogateSubsystemValueFunctions (loaded
+// from the .svf files in a directory) instead of gridded subsystems.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VALUE_FUNCTION_SURROGATE_VALUE_FUNCTION_H
+#define VALUE_FUNCTION_SURROGATE_VALUE_FUNCTION_H
+
+#include <value_function/value_function.h>
+#include <value_function/surrogate_subsystem_value_function.h>
+#include <value_function/dynamics.h>
+#include <utils/types.h>
+
+#include <ros/ros.h>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class SurrogateValueFunction : public ValueFunction {
+public:
+  typedef std::shared_ptr<const SurrogateValueFunction> ConstPtr;
+
+  // Destructor.
+  virtual ~SurrogateValueFunction() {}
+
+  // Factory method. Use this instead of the constructor.
+  // Note that this class is const-only, which means that once it is
+  // instantiated it can never be changed.
+  static ConstPtr Create(const std::string& directory,
+                         const Dynamics::ConstPtr& dynamics,
+                         size_t x_dim, size_t u_dim, ValueFunctionId id);
+
+  // Evaluate the surrogates to get the value/gradient at a particular state.
+  double Value(const VectorXd& state) const;
+  VectorXd Gradient(const VectorXd& state) const;
+
+  // Get the tracking error bound in this spatial dimension.
+  double TrackingBound(size_t dimension) const;
+
+  // Priority of the optimal control at the given state. This is a number
+  // between 0 and 1, where 1 means the final control signal should be exactly
+  // the optimal control signal computed by this value function.
+  double Priority(const VectorXd& state) const;
+
+  // Largest certified error bound over all subsystems.
+  double MaxErrorBound() const;
+
+private:
+  explicit SurrogateValueFunction(const std::string& directory,
+                                  const Dynamics::ConstPtr& dynamics,
+                                  size_t x_dim, size_t u_dim,
+                                  ValueFunctionId id);
+
+  // List of surrogates for independent subsystems.
+  std::vector<SurrogateSubsystemValueFunction::ConstPtr> subsystems_;
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TimeVaryingSubsystemValueFunction class, a subsystem value
+// function indexed by time (e.g. for time-varying tracking error bounds as
+// produced by tvTEB.m).
+//
+// Time slices are memory-mapped from a single binary file rather than read
+// into memory. Only a small window of slices around the most recently
+// queried time is kept resident (prefetched with madvise(MADV_WILLNEED) and
+// released with madvise(MADV_DONTNEED) when they leave the window), so memory
+// use is constant regardless of the number of slices. The final slice, used
+// by queries without a time, is always resident and never moves the window.
+// Values, gradients, and tracking bounds are linearly interpolated between
+// adjacent slices.
+//
+// Files are produced from .mat files by the tv_value_function_converter
+// executable. Layout (host byte order):
+//   char[8] magic "METATVVF"
+//   uint64 num_dims, num_control_dims, num_slices
+//   uint64 x_dims[num_dims], u_dims[num_control_dims], grid_N[num_dims]
+//   double grid_min[num_dims], grid_max[num_dims], max_planner_speed[3],
+//          priority_lower, priority_upper
+//   double times[num_slices], teb[num_slices][num_dims]
+//   (zero padding up to a kDataAlignment boundary)
+//   double data[num_slices][prod(grid_N)], each slice in row-major order
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VALUE_FUNCTION_TIME_VARYING_SUBSYSTEM_VALUE_FUNCTION_H
+#define VALUE_FUNCTION_TIME_VARYING_SUBSYSTEM_VALUE_FUNCTION_H
+
+#include <utils/types.h>
+#include <utils/uncopyable.h>
+
+#include <ros/ros.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace meta {
+
+class TimeVaryingSubsystemValueFunction : private Uncopyable {
+public:
+  typedef std::unique_ptr<const TimeVaryingSubsystemValueFunction> ConstPtr;
+
+  // Destructor unmaps the file.
+  ~TimeVaryingSubsystemValueFunction();
+
+  // Factory method. Use this instead of the constructor. Keeps
+  // 'prefetch_slices' slices resident on either side of the current one.
+  static ConstPtr Create(const std::string& file_name,
+                         size_t prefetch_slices = 2);
+
+  // Interpolate to get the value/gradient at a particular state and time.
+  double Value(const VectorXd& state, double time) const;
+  VectorXd Gradient(const VectorXd& state, double time) const;
+
+  // Priority of the optimal control at the given state and time. This is a
+  // number between 0 and 1, where 1 means the final control signal should be
+  // exactly the optimal control signal computed by this value function.
+  double Priority(const VectorXd& state, double time) const;
+
+  // Tracking error bound in the specified subsystem dimension at this time.
+  double TrackingBound(size_t ii, double time) const;
+
+  // Largest tracking error bound over all slices in this subsystem dimension.
+  double MaxTrackingBound(size_t ii) const;
+
+  // Half-width of the zero sublevel set of the given slice, projected onto
+  // subsystem dimension ii. Grid points are voxel centers, so this extends to
+  // the outer edge of the outermost voxel in the set. Negative if the set is
+  // empty. Reads the slice directly rather than through the window, so it is
+  // meant for precomputation, not queries.
+  double LevelSetBound(size_t ii, size_t slice) const;
+
+  // Get the state/control dimensions for this subsystem.
+  inline const std::vector<size_t>& StateDimensions() const {
+    return state_dimensions_;
+  }
+  inline const std::vector<size_t>& ControlDimensions() const {
+    return control_dimensions_;
+  }
+
+  // Max planner speed in the given spatial dimension.
+  inline double MaxPlannerSpeed(size_t ii) const {
+    return max_planner_speed_[ii];
+  }
+
+  // Grid bounds and spacing in the given subsystem dimension.
+  inline double LowerBound(size_t ii) const { return lower_[ii]; }
+  inline double UpperBound(size_t ii) const { return upper_[ii]; }
+  inline double GridSpacing(size_t ii) const { return voxel_size_[ii]; }
+
+  // Time span covered by this value function.
+  inline size_t NumSlices() const { return times_.size(); }
+  inline double StartTime() const { return times_.front(); }
+  inline double EndTime() const { return times_.back(); }
+  inline double SliceTime(size_t slice) const { return times_[slice]; }
+
+  // Was this value function properly initialized?
+  inline bool IsInitialized() const { return initialized_; }
+
+  // Write a file in the format read by this class. Slice data is given in
+  // time order, each slice in row-major order, and the tracking bound as
+  // num_dims entries per slice. Returns whether it was successful.
+  static bool Write(const std::string& file_name,
+                    const std::vector<size_t>& state_dimensions,
+                    const std::vector<size_t>& control_dimensions,
+                    const std::vector<size_t>& num_voxels,
+                    const std::vector<double>& lower,
+                    const std::vector<double>& upper,
+                    const std::vector<double>& max_planner_speed,
+                    double priority_lower, double priority_upper,
+                    const std::vector<double>& times,
+                    const std::vector<double>& tracking_bound,
+                    const std::vector<double>& data);
+
+  // Alignment of slice data within the file. Matches the usual page size so
+  // that slices can be advised individually.
+  static const size_t kDataAlignment;
+
+private:
+  explicit TimeVaryingSubsystemValueFunction(const std::string& file_name,
+                                             size_t prefetch_slices);
+
+  // Load header and map data from file. Returns whether it was successful.
+  bool Load(const std::string& file_name);
+
+  // Find the slice at or before this time and the fraction of the way to
+  // the next slice. Times outside the horizon are clamped.
+  size_t FindSlice(double time, double& fraction) const;
+
+  // Make sure the window around this slice is resident, and release slices
+  // which have left the window.
+  void UpdateWindow(size_t slice) const;
+
+  // Advise the kernel about a range of slices.
+  void Advise(size_t first, size_t last, int advice) const;
+
+  // Value and gradient within a single slice.
+  double SliceValue(size_t slice, const VectorXd& punctured) const;
+  VectorXd SliceGradient(size_t slice, const VectorXd& punctured) const;
+
+  // Puncture a state vector for the overall system to get a
+  // valid state vector for this subsystem.
+  VectorXd Puncture(const VectorXd& state) const;
+
+  // Return the 1D voxel index corresponding to the given state, clamping
+  // to the grid.
+  size_t StateToIndex(const VectorXd& punctured) const;
+
+  // Compute the distance (vector) from this state to the center
+  // of the nearest voxel.
+  VectorXd DistanceToCenter(const VectorXd& punctured) const;
+
+  // Which dimensions in the full state/control space does this
+  // value grid correspond to?
+  std::vector<size_t> state_dimensions_;
+  std::vector<size_t> control_dimensions_;
+
+  // Number of voxels and upper/lower bounds in each subsystem dimension.
+  std::vector<size_t> num_voxels_;
+  std::vector<double> voxel_size_;
+  std::vector<double> lower_;
+  std::vector<double> upper_;
+  size_t slice_size_;
+
+  // Lower and upper bounds for the value function, for priority.
+  double priority_lower_;
+  double priority_upper_;
+
+  // Max planner speed in each spatial dimension.
+  std::vector<double> max_planner_speed_;
+
+  // Slice times, and tracking bound per slice (num_dims entries each).
+  std::vector<double> times_;
+  std::vector<double> tracking_bound_;
+
+  // Memory map.
+  void* map_;
+  size_t map_size_;
+  const double* data_;
+
+  // Residency window. Guarded by a mutex since queries are const.
+  const size_t prefetch_slices_;
+  mutable std::mutex window_mutex_;
+  mutable size_t window_first_;
+  mutable size_t window_last_;
+  mutable bool window_valid_;
+
+  // Was this value function initialized/loaded properly?
+  bool initialized_;
+
+  // File magic.
+  static const char kMagic[8];
+};
+
+} //\namespace meta
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TimeVaryingValueFunction class, which inherits from the
+// ValueFunction class and combines TimeVaryingSubsystemValueFunctions (loaded
+// from the .tvvf files in a directory) instead of static gridded subsystems.
+//
+// Queries without a time use the final slice for values and the worst case
+// over all slices for tracking bounds, so a planner which knows nothing about
+// time stays safe. The *At() queries take the time since tracking began, so
+// the tracker applies the control of the same slice whose bound is reported.
+//
+// Switching grids (speed_X_tenths_to_Y_tenths directories) are loaded as
+// time-varying value functions too: their slices are the backward reachable
+// set of the slower planner's tracking error bound at increasing horizons,
+// so switching bounds and times are read off the slices' zero level sets.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VALUE_FUNCTION_TIME_VARYING_VALUE_FUNCTION_H
+#define VALUE_FUNCTION_TIME_VARYING_VALUE_FUNCTION_H
+
+#include <value_function/value_function.h>
+#include <value_function/time_varying_subsystem_value_function.h>
+#include <value_function/dynamics.h>
+#include <utils/types.h>
+
+#include <ros/ros.h>
+#include <memory>
+#include <vector>
+
+namespace meta {
+
+class TimeVaryingValueFunction : public ValueFunction {
+public:
+  typedef std::shared_ptr<const TimeVaryingValueFunction> ConstPtr;
+
+  // Destructor.
+  virtual ~TimeVaryingValueFunction() {}
+
+  // Factory method. Use this instead of the constructor.
+  // Note that this class is const-only, which means that once it is
+  // instantiated it can never be changed.
+  static ConstPtr Create(const std::string& directory,
+                         const Dynamics::ConstPtr& dynamics,
+                         size_t x_dim, size_t u_dim, ValueFunctionId id);
+
+  // Interpolate to get the value/gradient at a particular state, using the
+  // final time slice.
+  double Value(const VectorXd& state) const;
+  VectorXd Gradient(const VectorXd& state) const;
+
+  // Interpolate to get the value/gradient/optimal control at a particular
+  // state and time since tracking began. A negative time uses the final
+  // slice.
+  double ValueAt(const VectorXd& state, double time) const;
+  VectorXd GradientAt(const VectorXd& state, double time) const;
+  VectorXd OptimalControlAt(const VectorXd& state, double time) const;
+
+  // Get the worst-case tracking error bound in this spatial dimension.
+  double TrackingBound(size_t dimension) const;
+
+  // Get the tracking error bound in this spatial dimension at the given time
+  // since tracking began. A negative time asks for the worst case.
+  double TrackingBoundAt(size_t dimension, double time) const;
+
+  // Priority of the optimal control at the given state, using the final
+  // time slice, or at the given time since tracking began.
+  double Priority(const VectorXd& state) const;
+  double PriorityAt(const VectorXd& state, double time) const;
+
+  // Half-width of the zero level set in this spatial dimension, in the slice
+  // at or before the given time since the first slice. A negative time uses
+  // the final slice.
+  double LevelSetBoundAt(size_t dimension, double time) const;
+
+  // For a switching grid: earliest time since the first slice at which the
+  // zero level set covers an incoming tracking error bound of the given
+  // half-width in this spatial dimension, i.e. the guaranteed time to drive
+  // the error from that bound into the one at the first slice. Infinite if
+  // even the final slice does not cover it.
+  double SwitchingTime(size_t dimension, double incoming_bound) const;
+
+private:
+  explicit TimeVaryingValueFunction(const std::string& directory,
+                                    const Dynamics::ConstPtr& dynamics,
+                                    size_t x_dim, size_t u_dim,
+                                    ValueFunctionId id);
+
+  // Subsystem containing this spatial dimension, and the dimension's index
+  // within it. Returns null if there is none.
+  const TimeVaryingSubsystemValueFunction* FindSubsystem(
+    size_t dimension, size_t& index) const;
+
+  // Time of the final slice, shared by all subsystems.
+  double end_time_;
+
+  // List of time-varying value functions for independent subsystems.
+  std::vector<TimeVaryingSubsystemValueFunction::ConstPtr> subsystems_;
+};
+
+} //\namespace meta
+
+#endif
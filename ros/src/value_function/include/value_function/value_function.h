@@ -82,9 +82,33 @@ public:
     return dynamics_->OptimalControl(state, Gradient(state));
   }
 
+  // Value, gradient, optimal control, and priority at the given time (s)
+  // since tracking with this value function began. A negative time asks for
+  // the final (converged) value function. Static value functions ignore the
+  // time.
+  virtual double ValueAt(const VectorXd& state, double time) const {
+    return Value(state);
+  }
+  virtual VectorXd GradientAt(const VectorXd& state, double time) const {
+    return Gradient(state);
+  }
+  virtual VectorXd OptimalControlAt(const VectorXd& state, double time) const {
+    return OptimalControl(state);
+  }
+  virtual double PriorityAt(const VectorXd& state, double time) const {
+    return Priority(state);
+  }
+
   // Get the tracking error bound in this spatial dimension.
   virtual double TrackingBound(size_t dimension) const;
 
+  // Get the tracking error bound in this spatial dimension at the given time
+  // (s) since tracking with this value function began. A negative time asks
+  // for the worst case. Static value functions ignore the time.
+  virtual double TrackingBoundAt(size_t dimension, double time) const {
+    return TrackingBound(dimension);
+  }
+
   // Get the tracking error bound in this spatial dimension for a planner
   // switching INTO this one with the specified max speed.
   virtual double SwitchingTrackingBound(
@@ -129,6 +153,10 @@ public:
     return time;
   }
 
+  // Number of queries which fell outside the grid in the given dimension of
+  // the full state space. Always zero for value functions without a grid.
+  size_t OutOfGridCount(size_t dimension) const;
+
   // Get the ID of this value function.
   inline ValueFunctionId Id() const { return id_; }
 
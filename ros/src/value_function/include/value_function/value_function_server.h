@@ -46,8 +46,11 @@
 
 #include <value_function/value_function.h>
 #include <value_function/analytical_point_mass_value_function.h>
+#include <value_function/surrogate_value_function.h>
+#include <value_function/time_varying_value_function.h>
 #include <value_function/dynamics.h>
 #include <value_function/near_hover_quad_no_yaw.h>
+#include <value_function/query_stats.h>
 #include <utils/types.h>
 #include <utils/uncopyable.h>
 
@@ -59,20 +62,41 @@
 #include <value_function/GuaranteedSwitchingTime.h>
 #include <value_function/TrackingBoundBox.h>
 #include <value_function/SwitchingTrackingBoundBox.h>
+#include <value_function/ReloadValueFunctions.h>
+#include <meta_planner_msgs/ValueFunctionsReloaded.h>
 
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <ros/ros.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <thread>
 
 namespace meta {
 
 class ValueFunctionServer : private Uncopyable {
 public:
-  ~ValueFunctionServer() {}
+  ~ValueFunctionServer() {
+    if (reload_thread_.joinable())
+      reload_thread_.join();
+  }
+
   explicit ValueFunctionServer()
-    : initialized_(false) {}
+    : reloading_(false),
+      generation_(0),
+      initialized_(false) {}
 
   // Initialize this class with all parameters and callbacks.
   bool Initialize(const ros::NodeHandle& n);
 
+  // Create a numerical value function from the given directory, as a
+  // surrogate or time-varying value function if so specified. Returns null
+  // rather than throwing if it could not be loaded.
+  static ValueFunction::ConstPtr CreateNumericalValueFunction(
+    const std::string& directory, bool surrogate_mode,
+    bool time_varying_mode, const Dynamics::ConstPtr& dynamics,
+    size_t x_dim, size_t u_dim, ValueFunctionId id);
+
   // Get the optimal control at a particular state.
   bool OptimalControlCallback(
     value_function::OptimalControl::Request& req,
@@ -118,10 +142,100 @@ public:
     value_function::GeometricPlannerTime::Request& req,
     value_function::GeometricPlannerTime::Response& res);
 
+  // Re-read value function parameters and rebuild the value function set on
+  // a background thread. Queries keep being answered from the current set
+  // until the new one has been built and validated, at which point it is
+  // swapped in and a notification is published. Only one reload may be in
+  // progress at a time.
+  bool ReloadCallback(
+    value_function::ReloadValueFunctions::Request& req,
+    value_function::ReloadValueFunctions::Response& res);
+
 private:
+  // Value functions together with their switching tables. A set is never
+  // modified once published, so each callback takes a snapshot with
+  // CurrentSet() and may keep using it while a reload replaces it.
+  struct ValueFunctionSet {
+    typedef std::shared_ptr<const ValueFunctionSet> ConstPtr;
+
+    // Index into the switching tables.
+    inline size_t TableIndex(ValueFunctionId to, ValueFunctionId from,
+                             size_t dimension) const {
+      return (to * values.size() + from) * 3 + dimension;
+    }
+
+    bool numerical_mode;
+    std::vector<ValueFunction::ConstPtr> values;
+
+    // All-pairs switching tables, indexed by TableIndex().
+    std::vector<double> switching_bound_table;
+    std::vector<double> switching_time_table;
+    std::vector<double> switching_distance_table;
+  };
+
+  // Switching grid from one planner speed down to the next, keyed by the
+  // faster speed. Speeds are in tenths, as in the directory names.
+  struct SwitchingGrid {
+    int to_speed;
+    TimeVaryingValueFunction::ConstPtr value;
+  };
+  typedef std::map<int, SwitchingGrid> SwitchingGridMap;
+
   bool LoadParameters(const ros::NodeHandle& n);
   bool RegisterCallbacks(const ros::NodeHandle& n);
 
+  // Read value function parameters and build a new set from them. Returns
+  // null if the parameters are bad or the set fails validation.
+  ValueFunctionSet::ConstPtr LoadValueFunctionSet(
+    const ros::NodeHandle& n) const;
+
+  // Parse a value directory, "speed_X_tenths/" or a switching grid
+  // "speed_X_tenths_to_Y_tenths/", into the planner speeds (in tenths) it
+  // tracks from and to. Returns false for any other name.
+  static bool ParseSpeeds(const std::string& directory,
+                          int& from_speed, int& to_speed);
+
+  // Load the switching grids between consecutive planner speeds among these
+  // value directories. Grids which cannot be loaded are left out, so only
+  // the switches that need them fail.
+  SwitchingGridMap LoadSwitchingGrids(
+    const std::vector<std::string>& value_dirs) const;
+
+  // Compute all-pairs switching bound/time/distance tables so that later
+  // queries are a single lookup. In numerical mode these are read off the
+  // switching grids, and 'value_dirs' names the directory of each value.
+  void BuildSwitchingTables(ValueFunctionSet& set,
+                            const std::vector<std::string>& value_dirs,
+                            const SwitchingGridMap& grids) const;
+
+  // Switching bound and time in one spatial dimension for a switch from
+  // the 'from' value into the 'to' value, chaining the switching grids from
+  // the speed tracked by 'from' down to the one tracked by 'to'. Returns
+  // false if a grid along the way is missing or does not cover the
+  // incoming bound.
+  bool NumericalSwitching(const ValueFunction& to, const ValueFunction& from,
+                          const std::string& to_dir,
+                          const std::string& from_dir,
+                          const SwitchingGridMap& grids, size_t dimension,
+                          double& bound, double& time) const;
+
+  // Check that a newly built set may be served: value functions come in
+  // pairs and are initialized, every switching table entry is finite and
+  // non-negative, and (once serving) the number of value functions has not
+  // changed, since clients assign value function IDs to planners at startup.
+  bool ValidateValueFunctionSet(const ValueFunctionSet& set) const;
+
+  // Body of the background reload thread.
+  void Reload();
+
+  // Snapshot of the set currently being served.
+  inline ValueFunctionSet::ConstPtr CurrentSet() const {
+    return std::atomic_load(&set_);
+  }
+
+  // Periodically publish query statistics as diagnostics.
+  void DiagnosticsTimerCallback(const ros::TimerEvent& e);
+
   // Services.
   ros::ServiceServer optimal_control_srv_;
   ros::ServiceServer tracking_bound_srv_;
@@ -131,6 +245,7 @@ private:
   ros::ServiceServer priority_srv_;
   ros::ServiceServer max_planner_speed_srv_;
   ros::ServiceServer best_possible_time_srv_;
+  ros::ServiceServer reload_srv_;
 
   std::string optimal_control_name_;
   std::string tracking_bound_name_;
@@ -140,22 +255,36 @@ private:
   std::string priority_name_;
   std::string max_planner_speed_name_;
   std::string best_possible_time_name_;
-
-  // Numerical mode flag and associated parameters for both analytic
-  // and numerical modes.
-  bool numerical_mode_;
-  std::vector<std::string> value_dirs_;
-  std::vector<double> max_planner_speeds_;
-  std::vector<double> max_velocity_disturbances_;
-  std::vector<double> max_acceleration_disturbances_;
+  std::string reload_name_;
 
   // Control upper/lower bounds.
   size_t control_dim_, state_dim_;
   std::vector<double> control_upper_;
   std::vector<double> control_lower_;
 
-  // List of value functions.
-  std::vector<ValueFunction::ConstPtr> values_;
+  // Dynamics shared by all value functions.
+  NearHoverQuadNoYaw::ConstPtr dynamics_;
+
+  // Value function set currently being served. Only ever accessed through
+  // std::atomic_load/std::atomic_store, so that a reload can replace it while
+  // callbacks are reading; old sets are freed when their last reader is done.
+  ValueFunctionSet::ConstPtr set_;
+
+  // Background reload. 'generation_' counts completed reloads and is only
+  // touched by the reload thread.
+  ros::NodeHandle node_;
+  std::thread reload_thread_;
+  std::atomic<bool> reloading_;
+  size_t generation_;
+  ros::Publisher reloaded_pub_;
+  std::string reloaded_topic_;
+
+  // Query statistics, published periodically on the diagnostics topic.
+  QueryStats::Ptr stats_;
+  double diagnostics_period_;
+  ros::Timer diagnostics_timer_;
+  ros::Publisher diagnostics_pub_;
+  std::string diagnostics_topic_;
 
   // Initialization and naming.
   bool initialized_;
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the QueryStats class, which keeps per-ValueFunctionId query counts,
+// latency histograms, and priority distributions.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/query_stats.h>
+
+#include <algorithm>
+
+namespace meta {
+
+const size_t QueryStats::kNumLatencyBuckets;
+const size_t QueryStats::kNumPriorityBuckets;
+
+// Factory method. Use this instead of the constructor.
+QueryStats::Ptr QueryStats::Create(size_t num_ids) {
+  QueryStats::Ptr ptr(new QueryStats(num_ids));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+QueryStats::QueryStats(size_t num_ids)
+  : num_ids_(num_ids),
+    counters_(new Counters[num_ids * NUM_QUERY_TYPES]),
+    priorities_(new std::atomic<size_t>[num_ids * kNumPriorityBuckets]) {
+  // Atomics are not zero-initialized by default.
+  for (size_t ii = 0; ii < num_ids_ * NUM_QUERY_TYPES; ii++) {
+    counters_[ii].count.store(0);
+    counters_[ii].total_ns.store(0);
+    counters_[ii].max_ns.store(0);
+
+    for (size_t jj = 0; jj < kNumLatencyBuckets; jj++)
+      counters_[ii].latency[jj].store(0);
+  }
+
+  for (size_t ii = 0; ii < num_ids_ * kNumPriorityBuckets; ii++)
+    priorities_[ii].store(0);
+}
+
+// Record a query of the given type against the given ID, which took
+// 'seconds' to answer. Unknown IDs are ignored.
+void QueryStats::RecordQuery(ValueFunctionId id, QueryType type,
+                             double seconds) {
+  if (id >= num_ids_ || type >= NUM_QUERY_TYPES)
+    return;
+
+  Counters& counters = counters_[Index(id, type)];
+  const uint64_t ns = static_cast<uint64_t>(std::max(0.0, seconds) * 1e9);
+
+  counters.count.fetch_add(1, std::memory_order_relaxed);
+  counters.total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+  // Atomic max.
+  uint64_t previous_max = counters.max_ns.load(std::memory_order_relaxed);
+  while (ns > previous_max &&
+         !counters.max_ns.compare_exchange_weak(previous_max, ns))
+    ;
+
+  // Bucket index is the bit length of the latency in microseconds.
+  uint64_t us = ns / 1000;
+  size_t bucket = 0;
+  while (us > 0 && bucket < kNumLatencyBuckets - 1) {
+    us >>= 1;
+    bucket++;
+  }
+
+  counters.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+// Record a priority returned for the given ID.
+void QueryStats::RecordPriority(ValueFunctionId id, double priority) {
+  if (id >= num_ids_)
+    return;
+
+  const double clamped = std::max(0.0, std::min(1.0, priority));
+  const size_t bucket = std::min(kNumPriorityBuckets - 1,
+    static_cast<size_t>(clamped * kNumPriorityBuckets));
+
+  priorities_[id * kNumPriorityBuckets + bucket].fetch_add(
+    1, std::memory_order_relaxed);
+}
+
+// Accessors.
+size_t QueryStats::NumQueries(ValueFunctionId id, QueryType type) const {
+  if (id >= num_ids_ || type >= NUM_QUERY_TYPES)
+    return 0;
+
+  return counters_[Index(id, type)].count.load(std::memory_order_relaxed);
+}
+
+size_t QueryStats::LatencyBucket(ValueFunctionId id, QueryType type,
+                                 size_t ii) const {
+  if (id >= num_ids_ || type >= NUM_QUERY_TYPES || ii >= kNumLatencyBuckets)
+    return 0;
+
+  return counters_[Index(id, type)].latency[ii].load(
+    std::memory_order_relaxed);
+}
+
+size_t QueryStats::PriorityBucket(ValueFunctionId id, size_t ii) const {
+  if (id >= num_ids_ || ii >= kNumPriorityBuckets)
+    return 0;
+
+  return priorities_[id * kNumPriorityBuckets + ii].load(
+    std::memory_order_relaxed);
+}
+
+// Mean and max latency (seconds) for this ID and query type.
+double QueryStats::MeanLatency(ValueFunctionId id, QueryType type) const {
+  const size_t count = NumQueries(id, type);
+  if (count == 0)
+    return 0.0;
+
+  const uint64_t total_ns =
+    counters_[Index(id, type)].total_ns.load(std::memory_order_relaxed);
+  return 1e-9 * static_cast<double>(total_ns) / static_cast<double>(count);
+}
+
+double QueryStats::MaxLatency(ValueFunctionId id, QueryType type) const {
+  if (id >= num_ids_ || type >= NUM_QUERY_TYPES)
+    return 0.0;
+
+  return 1e-9 * static_cast<double>(
+    counters_[Index(id, type)].max_ns.load(std::memory_order_relaxed));
+}
+
+// Upper edge (seconds) of the latency bucket containing the given quantile.
+double QueryStats::LatencyQuantile(ValueFunctionId id, QueryType type,
+                                   double quantile) const {
+  const size_t count = NumQueries(id, type);
+  if (count == 0)
+    return 0.0;
+
+  const double target = std::max(0.0, std::min(1.0, quantile)) * count;
+
+  size_t cumulative = 0;
+  for (size_t ii = 0; ii < kNumLatencyBuckets; ii++) {
+    cumulative += LatencyBucket(id, type, ii);
+    if (static_cast<double>(cumulative) >= target)
+      return 1e-6 * static_cast<double>(1 << ii);
+  }
+
+  return MaxLatency(id, type);
+}
+
+// Human-readable name of a query type.
+const char* QueryStats::QueryName(QueryType type) {
+  switch (type) {
+  case OPTIMAL_CONTROL:
+    return "optimal_control";
+  case PRIORITY:
+    return "priority";
+  case TRACKING_BOUND:
+    return "tracking_bound";
+  case SWITCHING_TRACKING_BOUND:
+    return "switching_tracking_bound";
+  case SWITCHING_TIME:
+    return "switching_time";
+  case SWITCHING_DISTANCE:
+    return "switching_distance";
+  case MAX_PLANNER_SPEED:
+    return "max_planner_speed";
+  case BEST_POSSIBLE_TIME:
+    return "best_possible_time";
+  default:
+    return "unknown";
+  }
+}
+
+} //\namespace meta
@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SparseGrid class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/sparse_grid.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace meta {
+
+const size_t SparseGrid::kMaxDimensions = 16;
+const size_t SparseGrid::kMaxLevel = 32;
+
+// Factory method from hierarchical surpluses. Use this instead of the
+// constructor.
+SparseGrid::ConstPtr SparseGrid::
+Create(size_t num_dims, size_t level, size_t num_fields,
+       const std::vector<double>& surpluses) {
+  SparseGrid::ConstPtr ptr(Build(num_dims, level, num_fields, surpluses));
+  return ptr;
+}
+
+// Factory method from function values at the grid points.
+SparseGrid::ConstPtr SparseGrid::
+Interpolate(size_t num_dims, size_t level, size_t num_fields,
+            const std::vector<double>& values) {
+  SparseGrid* grid = Build(num_dims, level, num_fields, values);
+  if (grid->initialized_)
+    grid->Hierarchize(grid->surpluses_);
+
+  SparseGrid::ConstPtr ptr(grid);
+  return ptr;
+}
+
+// Build a grid and check that the data matches it.
+SparseGrid* SparseGrid::Build(size_t num_dims, size_t level,
+                              size_t num_fields,
+                              const std::vector<double>& data) {
+  SparseGrid* grid = new SparseGrid(num_dims, level, num_fields, data);
+  if (grid->initialized_ &&
+      (num_fields == 0 || data.size() != grid->NumPoints() * num_fields)) {
+    ROS_ERROR("SparseGrid: Expected %zu fields at %zu points, got %zu values.",
+              num_fields, grid->NumPoints(), data.size());
+    grid->initialized_ = false;
+  }
+
+  return grid;
+}
+
+// Constructor. Don't use this. Use the factory methods instead.
+SparseGrid::SparseGrid(size_t num_dims, size_t level, size_t num_fields,
+                       const std::vector<double>& surpluses)
+  : num_dims_(num_dims),
+    level_(level),
+    num_fields_(num_fields),
+    surpluses_(surpluses),
+    initialized_(Initialize()) {}
+
+// Coordinates of all grid points in the unit cube, in storage order.
+std::vector<double> SparseGrid::Points(size_t num_dims, size_t level) {
+  std::vector<double> points;
+
+  const SparseGrid grid(num_dims, level, 0, std::vector<double>());
+  if (!grid.initialized_)
+    return points;
+
+  points.reserve(grid.NumPoints() * num_dims);
+
+  std::vector<size_t> levels(num_dims, 1);
+  do {
+    size_t bits = 0;
+    for (size_t ii = 0; ii < num_dims; ii++)
+      bits += levels[ii] - 1;
+
+    // Split each point's index into the positions in each dimension.
+    for (uint64_t pp = 0; pp < (static_cast<uint64_t>(1) << bits); pp++) {
+      size_t shift = bits;
+      for (size_t ii = 0; ii < num_dims; ii++) {
+        shift -= levels[ii] - 1;
+        const uint64_t position =
+          (pp >> shift) & ((static_cast<uint64_t>(1) << (levels[ii] - 1)) - 1);
+        points.push_back((2.0 * position + 1.0) /
+                         static_cast<double>(static_cast<uint64_t>(1) <<
+                                             levels[ii]));
+      }
+    }
+  } while (grid.NextSubspace(levels));
+
+  return points;
+}
+
+// Number of points of a grid, without building it.
+size_t SparseGrid::NumPoints(size_t num_dims, size_t level) {
+  const SparseGrid grid(num_dims, level, 0, std::vector<double>());
+  return (grid.initialized_) ? grid.NumPoints() : 0;
+}
+
+// Evaluate the first num_fields fields at a point of the unit cube.
+void SparseGrid::Evaluate(const double* z, double* fields,
+                          size_t num_fields) const {
+  num_fields = std::min(num_fields, num_fields_);
+  std::fill(fields, fields + num_fields, 0.0);
+  if (!initialized_)
+    return;
+
+  // Each level has one basis function per dimension whose support contains
+  // the point, so look them all up once.
+  double basis[kMaxDimensions * (kMaxLevel + 1)];
+  uint64_t positions[kMaxDimensions * (kMaxLevel + 1)];
+  for (size_t ii = 0; ii < num_dims_; ii++) {
+    const double clamped = std::min(1.0, std::max(0.0, z[ii]));
+
+    for (size_t ll = 1; ll <= level_; ll++) {
+      const size_t idx = ii * (kMaxLevel + 1) + ll;
+      positions[idx] = Position(ll, clamped);
+      basis[idx] = Basis(ll, positions[idx], clamped);
+    }
+  }
+
+  // One point per subspace.
+  const size_t num_subspaces = NumSubspaces();
+  const uint8_t* levels = subspace_levels_.data();
+  const double* surpluses = surpluses_.data();
+  for (size_t ss = 0; ss < num_subspaces; ss++, levels += num_dims_) {
+    double weight = 1.0;
+    uint64_t bits = 0;
+    for (size_t ii = 0; ii < num_dims_; ii++) {
+      const size_t idx = ii * (kMaxLevel + 1) + levels[ii];
+      weight *= basis[idx];
+      bits = (bits << (levels[ii] - 1)) | positions[idx];
+    }
+
+    if (weight == 0.0)
+      continue;
+
+    const double* surplus = surpluses + (offsets_[ss] + bits) * num_fields_;
+    for (size_t ff = 0; ff < num_fields; ff++)
+      fields[ff] += weight * surplus[ff];
+  }
+}
+
+// Approximate memory footprint, in bytes.
+size_t SparseGrid::MemoryBytes() const {
+  return sizeof(*this) + surpluses_.size() * sizeof(double) +
+    (counts_.size() + offsets_.size()) * sizeof(size_t) +
+    subspace_levels_.size();
+}
+
+// Set up the subspace tables. Returns whether or not it was successful.
+bool SparseGrid::Initialize() {
+  if (num_dims_ == 0 || num_dims_ > kMaxDimensions) {
+    ROS_ERROR("SparseGrid: Unsupported number of dimensions: %zu.", num_dims_);
+    return false;
+  }
+
+  if (level_ == 0 || level_ > kMaxLevel) {
+    ROS_ERROR("SparseGrid: Unsupported level: %zu.", level_);
+    return false;
+  }
+
+  // Subspace counts, from the last dimension back. Past the last dimension
+  // there is exactly one (empty) level vector.
+  counts_.assign((num_dims_ + 1) * level_, 0);
+  for (size_t bb = 0; bb < level_; bb++)
+    counts_[num_dims_ * level_ + bb] = 1;
+
+  for (size_t ii = 1; ii <= num_dims_; ii++) {
+    const size_t dim = num_dims_ - ii;
+
+    for (size_t bb = 0; bb < level_; bb++) {
+      size_t count = 0;
+      for (size_t ll = 0; ll <= bb; ll++)
+        count += Count(dim + 1, bb - ll);
+
+      counts_[dim * level_ + bb] = count;
+    }
+  }
+
+  // Point offsets and levels of each subspace.
+  offsets_.clear();
+  offsets_.push_back(0);
+  subspace_levels_.clear();
+
+  std::vector<size_t> levels(num_dims_, 1);
+  do {
+    size_t bits = 0;
+    for (size_t ii = 0; ii < num_dims_; ii++)
+      bits += levels[ii] - 1;
+
+    offsets_.push_back(offsets_.back() + (static_cast<size_t>(1) << bits));
+    subspace_levels_.insert(subspace_levels_.end(),
+                            levels.begin(), levels.end());
+  } while (NextSubspace(levels));
+
+  return true;
+}
+
+// Index of the subspace with these levels.
+size_t SparseGrid::SubspaceIndex(const std::vector<size_t>& levels) const {
+  size_t index = 0;
+  size_t budget = level_ - 1;
+
+  // Skip all subspaces with a lower level in the first differing dimension.
+  for (size_t ii = 0; ii < num_dims_; ii++) {
+    for (size_t ll = 1; ll < levels[ii]; ll++)
+      index += Count(ii + 1, budget - (ll - 1));
+
+    budget -= levels[ii] - 1;
+  }
+
+  return index;
+}
+
+// Step through level vectors in storage order. Returns false once every
+// subspace has been visited.
+bool SparseGrid::NextSubspace(std::vector<size_t>& levels) const {
+  size_t used = 0;
+  for (size_t ii = 0; ii < num_dims_; ii++)
+    used += levels[ii] - 1;
+
+  for (size_t ii = 1; ii <= num_dims_; ii++) {
+    const size_t dim = num_dims_ - ii;
+
+    if (used + 1 < level_) {
+      levels[dim]++;
+      return true;
+    }
+
+    used -= levels[dim] - 1;
+    levels[dim] = 1;
+  }
+
+  return false;
+}
+
+// Convert values at the grid points to surpluses, in place. One dimension at
+// a time, each point loses the interpolant of its ancestors along that
+// dimension. Ancestors have lower levels in that dimension and the same
+// levels elsewhere, so they come first in storage order and already hold
+// their surpluses.
+void SparseGrid::Hierarchize(std::vector<double>& values) const {
+  std::vector<size_t> levels(num_dims_, 1);
+  std::vector<size_t> ancestor_offsets(level_ + 1, 0);
+
+  for (size_t dim = 0; dim < num_dims_; dim++) {
+    levels.assign(num_dims_, 1);
+    size_t subspace = 0;
+
+    do {
+      const size_t level = levels[dim];
+      if (level > 1) {
+        // Points are indexed by the concatenated bits of their positions,
+        // so split off the bits of this dimension.
+        size_t shift = 0;
+        for (size_t ii = dim + 1; ii < num_dims_; ii++)
+          shift += levels[ii] - 1;
+
+        const uint64_t low_mask = (static_cast<uint64_t>(1) << shift) - 1;
+        const uint64_t position_mask =
+          (static_cast<uint64_t>(1) << (level - 1)) - 1;
+
+        std::vector<size_t> ancestor = levels;
+        for (size_t ll = 1; ll < level; ll++) {
+          ancestor[dim] = ll;
+          ancestor_offsets[ll] = offsets_[SubspaceIndex(ancestor)];
+        }
+
+        const size_t num_points = offsets_[subspace + 1] - offsets_[subspace];
+        for (size_t pp = 0; pp < num_points; pp++) {
+          const uint64_t low = pp & low_mask;
+          const uint64_t position = (pp >> shift) & position_mask;
+          const uint64_t high = pp >> (shift + level - 1);
+          const double z = (2.0 * position + 1.0) /
+            static_cast<double>(static_cast<uint64_t>(1) << level);
+
+          double* target = &values[(offsets_[subspace] + pp) * num_fields_];
+          for (size_t ll = 1; ll < level; ll++) {
+            const uint64_t ancestor_position = position >> (level - ll);
+            const double phi = Basis(ll, ancestor_position, z);
+            if (phi == 0.0)
+              continue;
+
+            const uint64_t ancestor_bits =
+              (((high << (ll - 1)) | ancestor_position) << shift) | low;
+            const double* source =
+              &values[(ancestor_offsets[ll] + ancestor_bits) * num_fields_];
+
+            for (size_t ff = 0; ff < num_fields_; ff++)
+              target[ff] -= phi * source[ff];
+          }
+        }
+      }
+
+      subspace++;
+    } while (NextSubspace(levels));
+  }
+}
+
+// Position of z within a level, i.e. the basis function whose support
+// contains it.
+uint64_t SparseGrid::Position(size_t level, double z) {
+  const uint64_t num_positions = static_cast<uint64_t>(1) << (level - 1);
+  return std::min(num_positions - 1, static_cast<uint64_t>(
+    z * static_cast<double>(num_positions)));
+}
+
+// Modified linear basis function. Level 1 is constant, and the first and
+// last function of every finer level extend linearly to the boundary.
+double SparseGrid::Basis(size_t level, uint64_t position, double z) {
+  if (level == 1)
+    return 1.0;
+
+  const double scale = static_cast<double>(static_cast<uint64_t>(1) << level);
+  const double index = 2.0 * static_cast<double>(position) + 1.0;
+  const double scaled = scale * z;
+
+  if (position == 0)
+    return std::max(0.0, 2.0 - scaled);
+
+  if (index == scale - 1.0)
+    return std::max(0.0, scaled - index + 1.0);
+
+  return std::max(0.0, 1.0 - std::abs(scaled - index));
+}
+
+} //\namespace meta
@@ -42,8 +42,15 @@
 
 #include <value_function/subsystem_value_function.h>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
 namespace meta {
 
+const char SubsystemValueFunction::kSparseGridMagic[8] =
+  { 'M', 'E', 'T', 'A', 'S', 'G', 'V', 'F' };
+
 // Factory method. Use this instead of the constructor.
 // Note that this class is const-only, which means that once it is
 // instantiated it can never be changed.
@@ -56,7 +63,11 @@ Create(const std::string& file_name) {
 // Constructor. Don't use this. Use the factory method instead.
 SubsystemValueFunction::SubsystemValueFunction(const std::string& file_name)
   : tracking_bound_(0.0),
-    initialized_(Load(file_name)) {}
+    initialized_(Load(file_name)) {
+  out_of_grid_.reset(new std::atomic<size_t>[state_dimensions_.size()]);
+  for (size_t ii = 0; ii < state_dimensions_.size(); ii++)
+    out_of_grid_[ii].store(0);
+}
 
 // Priority of the optimal control at the given state. This is a number
 // between 0 and 1, where 1 means the final control signal should be exactly
@@ -73,16 +84,28 @@ double SubsystemValueFunction::Priority(const VectorXd& state) const {
   return (value - priority_lower_) / (priority_upper_ - priority_lower_);
 }
 
+// Record which dimensions of this (punctured) query state lie outside
+// the grid.
+void SubsystemValueFunction::RecordOutOfGrid(const VectorXd& punctured) const {
+  if (!initialized_)
+    return;
+
+  for (size_t ii = 0; ii < state_dimensions_.size(); ii++) {
+    if (punctured(ii) < lower_[ii] || punctured(ii) > upper_[ii])
+      out_of_grid_[ii].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
 // Return the voxel index corresponding to the given state.
 size_t SubsystemValueFunction::StateToIndex(const VectorXd& punctured) const {
   // Quantize each dimension of the state.
   std::vector<size_t> quantized;
   for (size_t ii = 0; ii < punctured.size(); ii++) {
     if (punctured(ii) < lower_[ii]) {
-      ROS_WARN("State is below the SubsystemValueFunction grid in dimension %zu.", ii);
+      ROS_WARN_THROTTLE(1.0, "State is below the SubsystemValueFunction grid in dimension %zu.", ii);
       quantized.push_back(0);
     } else if (punctured(ii) > upper_[ii]) {
-      ROS_WARN("State is above the SubsystemValueFunction grid in dimension %zu.", ii);
+      ROS_WARN_THROTTLE(1.0, "State is above the SubsystemValueFunction grid in dimension %zu.", ii);
       quantized.push_back(num_voxels_[ii] - 1);
     } else {
       // In bounds, so quantize. This works because of 0-indexing and casting.
@@ -190,6 +213,10 @@ RecursiveGradientInterpolator(const VectorXd& x, size_t idx) const {
 // Linearly interpolate to get the value at a particular state.
 double SubsystemValueFunction::Value(const VectorXd& state) const {
   const VectorXd punctured = Puncture(state);
+  RecordOutOfGrid(punctured);
+
+  if (sparse_grid_)
+    return SparseGridValue(punctured, nullptr);
 
   // Get distance from voxel center in each dimension.
   const VectorXd center_distance = DistanceToCenter(punctured);
@@ -224,6 +251,14 @@ double SubsystemValueFunction::Value(const VectorXd& state) const {
 // Linearly interpolate to get the gradient at a particular state.
 VectorXd SubsystemValueFunction::Gradient(const VectorXd& state) const {
   const VectorXd punctured = Puncture(state);
+  RecordOutOfGrid(punctured);
+
+  if (sparse_grid_) {
+    VectorXd gradient;
+    SparseGridValue(punctured, &gradient);
+    return gradient;
+  }
+
   const VectorXd gradient = RecursiveGradientInterpolator(punctured, 0);
 
 #if 0
@@ -256,6 +291,37 @@ VectorXd SubsystemValueFunction::Gradient(const VectorXd& state) const {
   return gradient;
 }
 
+// Interpolate the sparse grid to get the value and gradient at a
+// (punctured) state.
+double SubsystemValueFunction::
+SparseGridValue(const VectorXd& punctured, VectorXd* gradient) const {
+  const size_t num_dims = state_dimensions_.size();
+
+  // Clamp to the grid and normalize to the unit cube.
+  VectorXd clamped(num_dims);
+  VectorXd normalized(num_dims);
+  bool inside = true;
+  for (size_t ii = 0; ii < num_dims; ii++) {
+    clamped(ii) = std::min(upper_[ii], std::max(lower_[ii], punctured(ii)));
+    inside &= (clamped(ii) == punctured(ii));
+    normalized(ii) = (clamped(ii) - lower_[ii]) / (upper_[ii] - lower_[ii]);
+  }
+
+  // Inside the grid the value alone is enough, unless asked for the
+  // gradient too.
+  VectorXd fields = VectorXd::Zero(num_dims + 1);
+  sparse_grid_->Evaluate(normalized.data(), fields.data(),
+                         (inside && gradient == nullptr) ? 1 : num_dims + 1);
+
+  if (gradient != nullptr)
+    *gradient = fields.tail(num_dims);
+
+  if (inside)
+    return fields(0);
+
+  return fields(0) + fields.tail(num_dims).dot(punctured - clamped);
+}
+
 // Puncture a state vector for the overall system to get a
 // valid state vector for this subsystem.
 VectorXd SubsystemValueFunction::Puncture(const VectorXd& state) const {
@@ -320,6 +386,13 @@ DistanceToCenter(const VectorXd& punctured) const {
 // TODO! Reserve enough space initially for each vector so it does
 // resize so much.
 bool SubsystemValueFunction::Load(const std::string& file_name) {
+  // Sparse grids have their own format.
+  const std::string sparse_extension = ".sgvf";
+  if (file_name.size() > sparse_extension.size() &&
+      file_name.compare(file_name.size() - sparse_extension.size(),
+                        sparse_extension.size(), sparse_extension) == 0)
+    return LoadSparseGrid(file_name);
+
   // Open the file.
   mat_t* matfp = Mat_Open(file_name.c_str(), MAT_ACC_RDONLY);
   if (matfp == NULL) {
@@ -544,4 +617,141 @@ bool SubsystemValueFunction::Load(const std::string& file_name) {
   return true;
 }
 
+// Load a sparse grid from file. Returns whether or not it was successful.
+bool SubsystemValueFunction::LoadSparseGrid(const std::string& file_name) {
+  std::ifstream file(file_name.c_str(), std::ios::binary);
+  if (!file.is_open()) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  char magic[sizeof(kSparseGridMagic)];
+  uint64_t counts[3];
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(counts), sizeof(counts));
+  if (!file.good() ||
+      std::memcmp(magic, kSparseGridMagic, sizeof(kSparseGridMagic)) != 0) {
+    ROS_ERROR("%s: Not a sparse grid value function file.", file_name.c_str());
+    return false;
+  }
+
+  const size_t num_dims = static_cast<size_t>(counts[0]);
+  const size_t num_control_dims = static_cast<size_t>(counts[1]);
+  const size_t level = static_cast<size_t>(counts[2]);
+
+  const size_t num_points = SparseGrid::NumPoints(num_dims, level);
+  if (num_points == 0) {
+    ROS_ERROR("%s: Invalid sparse grid.", file_name.c_str());
+    return false;
+  }
+
+  std::vector<uint64_t> integers(num_dims + num_control_dims);
+  file.read(reinterpret_cast<char*>(integers.data()),
+            integers.size() * sizeof(uint64_t));
+
+  std::vector<double> doubles(3 * num_dims + 5);
+  file.read(reinterpret_cast<char*>(doubles.data()),
+            doubles.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("%s: Truncated header.", file_name.c_str());
+    return false;
+  }
+
+  state_dimensions_.assign(integers.begin(), integers.begin() + num_dims);
+  control_dimensions_.assign(integers.begin() + num_dims, integers.end());
+
+  std::vector<double>::const_iterator iter = doubles.begin();
+  lower_.assign(iter, iter + num_dims);
+  iter += num_dims;
+  upper_.assign(iter, iter + num_dims);
+  iter += num_dims;
+  max_planner_speed_.assign(iter, iter + 3);
+  iter += 3;
+  priority_lower_ = *iter++;
+  priority_upper_ = *iter++;
+  tracking_bound_.assign(iter, iter + num_dims);
+
+  for (size_t ii = 0; ii < num_dims; ii++) {
+    if (upper_[ii] <= lower_[ii]) {
+      ROS_ERROR("%s: Empty grid in dimension %zu.", file_name.c_str(), ii);
+      return false;
+    }
+  }
+
+  // Value and gradient at every point.
+  std::vector<double> surpluses(num_points * (num_dims + 1));
+  file.read(reinterpret_cast<char*>(surpluses.data()),
+            surpluses.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("%s: Truncated data.", file_name.c_str());
+    return false;
+  }
+
+  sparse_grid_ = SparseGrid::Create(num_dims, level, num_dims + 1, surpluses);
+  return sparse_grid_->IsInitialized();
+}
+
+// Write a sparse grid subsystem file. Returns whether it was successful.
+bool SubsystemValueFunction::
+SaveSparseGrid(const std::string& file_name,
+               const std::vector<size_t>& state_dimensions,
+               const std::vector<size_t>& control_dimensions,
+               const std::vector<double>& lower,
+               const std::vector<double>& upper,
+               const std::vector<double>& max_planner_speed,
+               double priority_lower, double priority_upper,
+               const std::vector<double>& tracking_bound,
+               const SparseGrid& grid) {
+  const size_t num_dims = state_dimensions.size();
+  if (!grid.IsInitialized() || grid.NumDimensions() != num_dims ||
+      grid.NumFields() != num_dims + 1 || lower.size() != num_dims ||
+      upper.size() != num_dims || tracking_bound.size() != num_dims ||
+      max_planner_speed.size() != 3) {
+    ROS_ERROR("Inconsistent sparse grid value function for %s.",
+              file_name.c_str());
+    return false;
+  }
+
+  std::ofstream file(file_name.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  file.write(kSparseGridMagic, sizeof(kSparseGridMagic));
+
+  std::vector<uint64_t> integers;
+  integers.push_back(num_dims);
+  integers.push_back(control_dimensions.size());
+  integers.push_back(grid.Level());
+  integers.insert(integers.end(),
+                  state_dimensions.begin(), state_dimensions.end());
+  integers.insert(integers.end(),
+                  control_dimensions.begin(), control_dimensions.end());
+  file.write(reinterpret_cast<const char*>(integers.data()),
+             integers.size() * sizeof(uint64_t));
+
+  std::vector<double> doubles(lower);
+  doubles.insert(doubles.end(), upper.begin(), upper.end());
+  doubles.insert(doubles.end(),
+                 max_planner_speed.begin(), max_planner_speed.end());
+  doubles.push_back(priority_lower);
+  doubles.push_back(priority_upper);
+  doubles.insert(doubles.end(), tracking_bound.begin(), tracking_bound.end());
+  file.write(reinterpret_cast<const char*>(doubles.data()),
+             doubles.size() * sizeof(double));
+
+  file.write(reinterpret_cast<const char*>(grid.Surpluses().data()),
+             grid.Surpluses().size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("Error writing file: %s.", file_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
 } //\namespace meta
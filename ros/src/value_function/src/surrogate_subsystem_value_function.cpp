@@ -0,0 +1,720 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SurrogateSubsystemValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/surrogate_subsystem_value_function.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace meta {
+
+const char SurrogateSubsystemValueFunction::kMagic[8] =
+  { 'M', 'E', 'T', 'A', 'S', 'R', 'V', 'F' };
+const uint64_t SurrogateSubsystemValueFunction::kNoPatch =
+  std::numeric_limits<uint64_t>::max();
+
+// Factory method. Use this instead of the constructor.
+// Note that this class is const-only, which means that once it is
+// instantiated it can never be changed.
+SurrogateSubsystemValueFunction::ConstPtr SurrogateSubsystemValueFunction::
+Create(const std::string& file_name) {
+  SurrogateSubsystemValueFunction::ConstPtr ptr(
+    new SurrogateSubsystemValueFunction(file_name));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+SurrogateSubsystemValueFunction::
+SurrogateSubsystemValueFunction(const std::string& file_name)
+  : priority_lower_(0.0),
+    priority_upper_(0.0),
+    num_terms_(0),
+    initialized_(false) {
+  initialized_ = Load(file_name);
+}
+
+// Priority of the optimal control at the given state. This is a number
+// between 0 and 1, where 1 means the final control signal should be exactly
+// the optimal control signal computed by this value function.
+double SurrogateSubsystemValueFunction::Priority(const VectorXd& state) const {
+  const double value = Value(state);
+
+  if (value < priority_lower_)
+    return 0.0;
+
+  if (value > priority_upper_)
+    return 1.0;
+
+  return (value - priority_lower_) / (priority_upper_ - priority_lower_);
+}
+
+// Evaluate the surrogate to get the value at a particular state.
+double SurrogateSubsystemValueFunction::Value(const VectorXd& state) const {
+  if (!initialized_) {
+    ROS_ERROR("SurrogateSubsystemValueFunction was not initialized.");
+    return 0.0;
+  }
+
+  const VectorXd punctured = Puncture(state);
+
+  VectorXd clamped;
+  std::vector<size_t> voxel;
+  const size_t cell = Locate(punctured, clamped, voxel);
+
+  double value = 0.0;
+  VectorXd gradient;
+  if (patch_offset_[cell] == kNoPatch) {
+    VectorXd half_width;
+    const VectorXd z = CellCoordinates(cell, clamped, half_width);
+    value = PolynomialValue(cell, z);
+
+    if (clamped != punctured)
+      gradient = PolynomialGradient(cell, z, half_width);
+  } else {
+    value = PatchValue(cell, clamped, voxel);
+
+    if (clamped != punctured)
+      gradient = PatchGradient(cell, voxel);
+  }
+
+  // Extrapolate linearly outside the grid.
+  if (clamped != punctured)
+    value += gradient.dot(punctured - clamped);
+
+  return value;
+}
+
+// Evaluate the surrogate to get the gradient at a particular state.
+VectorXd SurrogateSubsystemValueFunction::Gradient(const VectorXd& state) const {
+  if (!initialized_) {
+    ROS_ERROR("SurrogateSubsystemValueFunction was not initialized.");
+    return VectorXd::Zero(state_dimensions_.size());
+  }
+
+  const VectorXd punctured = Puncture(state);
+
+  VectorXd clamped;
+  std::vector<size_t> voxel;
+  const size_t cell = Locate(punctured, clamped, voxel);
+
+  if (patch_offset_[cell] != kNoPatch)
+    return PatchGradient(cell, voxel);
+
+  VectorXd half_width;
+  const VectorXd z = CellCoordinates(cell, clamped, half_width);
+  return PolynomialGradient(cell, z, half_width);
+}
+
+// Number of cells which fall back to grid values.
+size_t SurrogateSubsystemValueFunction::NumFallbackCells() const {
+  return static_cast<size_t>(
+    std::count_if(patch_offset_.begin(), patch_offset_.end(),
+                   [](uint64_t offset) { return offset != kNoPatch; }));
+}
+
+// Largest certified error bound over all cells using a polynomial.
+double SurrogateSubsystemValueFunction::MaxErrorBound() const {
+  double bound = 0.0;
+  for (size_t ii = 0; ii < error_bound_.size(); ii++) {
+    if (patch_offset_[ii] == kNoPatch)
+      bound = std::max(bound, error_bound_[ii]);
+  }
+
+  return bound;
+}
+
+// Approximate memory footprint of the model, in bytes.
+size_t SurrogateSubsystemValueFunction::MemoryBytes() const {
+  return sizeof(*this) +
+    (coefficients_.size() + error_bound_.size() + patches_.size() +
+     voxel_size_.size() + lower_.size() + upper_.size() +
+     tracking_bound_.size() + max_planner_speed_.size()) * sizeof(double) +
+    patch_offset_.size() * sizeof(uint64_t) +
+    (state_dimensions_.size() + control_dimensions_.size() +
+     num_voxels_.size() + cell_voxels_.size() + num_cells_.size()) *
+    sizeof(size_t);
+}
+
+// Puncture a state vector for the overall system to get a
+// valid state vector for this subsystem.
+VectorXd SurrogateSubsystemValueFunction::
+Puncture(const VectorXd& state) const {
+  VectorXd punctured(state_dimensions_.size());
+
+  for (size_t ii = 0; ii < state_dimensions_.size(); ii++)
+    punctured(ii) = state(state_dimensions_[ii]);
+
+  return punctured;
+}
+
+// Clamp a (punctured) state to the grid, find the voxel and cell
+// containing it, and the cell's row-major index.
+size_t SurrogateSubsystemValueFunction::
+Locate(const VectorXd& punctured, VectorXd& clamped,
+       std::vector<size_t>& voxel) const {
+  clamped = punctured;
+  voxel.resize(punctured.size());
+
+  size_t cell = 0;
+  for (size_t ii = 0; ii < punctured.size(); ii++) {
+    clamped(ii) = std::min(std::max(punctured(ii), lower_[ii]), upper_[ii]);
+    voxel[ii] = std::min(num_voxels_[ii] - 1, static_cast<size_t>(
+      (clamped(ii) - lower_[ii]) / voxel_size_[ii]));
+
+    // Row-major order.
+    cell = cell * num_cells_[ii] + voxel[ii] / cell_voxels_[ii];
+  }
+
+  return cell;
+}
+
+// Cell extent in voxels along dimension ii: [first, last).
+void SurrogateSubsystemValueFunction::
+CellVoxels(size_t cell, size_t ii, size_t& first, size_t& last) const {
+  size_t stride = 1;
+  for (size_t jj = ii + 1; jj < num_cells_.size(); jj++)
+    stride *= num_cells_[jj];
+
+  first = ((cell / stride) % num_cells_[ii]) * cell_voxels_[ii];
+  last = std::min(first + cell_voxels_[ii], num_voxels_[ii]);
+}
+
+// Normalized coordinates of a state within a cell, and the cell's half
+// width in each dimension.
+VectorXd SurrogateSubsystemValueFunction::
+CellCoordinates(size_t cell, const VectorXd& clamped,
+                VectorXd& half_width) const {
+  VectorXd z(clamped.size());
+  half_width.resize(clamped.size());
+
+  for (size_t ii = 0; ii < clamped.size(); ii++) {
+    size_t first, last;
+    CellVoxels(cell, ii, first, last);
+
+    half_width(ii) = 0.5 * (last - first) * voxel_size_[ii];
+    const double center = lower_[ii] + first * voxel_size_[ii] + half_width(ii);
+    z(ii) = (clamped(ii) - center) / half_width(ii);
+  }
+
+  return z;
+}
+
+// Polynomial value within a cell.
+double SurrogateSubsystemValueFunction::
+PolynomialValue(size_t cell, const VectorXd& z) const {
+  const double* coefficients = &coefficients_[cell * num_terms_];
+  const size_t num_dims = z.size();
+
+  double value = coefficients[0];
+  for (size_t ii = 0; ii < num_dims; ii++)
+    value += coefficients[1 + ii] * z(ii);
+
+  size_t term = 1 + num_dims;
+  for (size_t ii = 0; ii < num_dims; ii++) {
+    for (size_t jj = ii; jj < num_dims; jj++)
+      value += coefficients[term++] * z(ii) * z(jj);
+  }
+
+  return value;
+}
+
+// Polynomial gradient (with respect to the state) within a cell.
+VectorXd SurrogateSubsystemValueFunction::
+PolynomialGradient(size_t cell, const VectorXd& z,
+                   const VectorXd& half_width) const {
+  const double* coefficients = &coefficients_[cell * num_terms_];
+  const size_t num_dims = z.size();
+
+  VectorXd gradient(num_dims);
+  for (size_t ii = 0; ii < num_dims; ii++)
+    gradient(ii) = coefficients[1 + ii];
+
+  size_t term = 1 + num_dims;
+  for (size_t ii = 0; ii < num_dims; ii++) {
+    for (size_t jj = ii; jj < num_dims; jj++) {
+      const double coefficient = coefficients[term++];
+      gradient(ii) += coefficient * z(jj);
+      gradient(jj) += coefficient * z(ii);
+    }
+  }
+
+  // Chain rule back to state coordinates.
+  return gradient.cwiseQuotient(half_width);
+}
+
+// Grid value within a fallback cell. Nearest voxel plus a first-order
+// correction, as in SubsystemValueFunction::Value.
+double SurrogateSubsystemValueFunction::
+PatchValue(size_t cell, const VectorXd& clamped,
+           const std::vector<size_t>& voxel) const {
+  const double nn_value = PatchVoxel(cell, voxel);
+  double approx_value = nn_value;
+
+  std::vector<size_t> neighbor = voxel;
+  for (size_t ii = 0; ii < voxel.size(); ii++) {
+    // Get distance from voxel center and the neighboring value, clamped to
+    // the grid.
+    const double center_distance = clamped(ii) -
+      (lower_[ii] + (voxel[ii] + 0.5) * voxel_size_[ii]);
+
+    if (center_distance >= 0.0)
+      neighbor[ii] = std::min(voxel[ii] + 1, num_voxels_[ii] - 1);
+    else
+      neighbor[ii] = (voxel[ii] > 0) ? voxel[ii] - 1 : 0;
+
+    const double neighbor_value = PatchVoxel(cell, neighbor);
+    neighbor[ii] = voxel[ii];
+
+    // Compute forward difference.
+    const double slope = (center_distance >= 0.0) ?
+      (neighbor_value - nn_value) / voxel_size_[ii] :
+      (nn_value - neighbor_value) / voxel_size_[ii];
+
+    // Add to the Taylor approximation.
+    approx_value += slope * center_distance;
+  }
+
+  return approx_value;
+}
+
+// Grid gradient within a fallback cell: central difference at the
+// containing voxel, clamped to the grid.
+VectorXd SurrogateSubsystemValueFunction::
+PatchGradient(size_t cell, const std::vector<size_t>& voxel) const {
+  VectorXd gradient(voxel.size());
+
+  std::vector<size_t> neighbor = voxel;
+  for (size_t ii = 0; ii < voxel.size(); ii++) {
+    neighbor[ii] = std::min(voxel[ii] + 1, num_voxels_[ii] - 1);
+    const double forward = PatchVoxel(cell, neighbor);
+
+    neighbor[ii] = (voxel[ii] > 0) ? voxel[ii] - 1 : 0;
+    const double backward = PatchVoxel(cell, neighbor);
+
+    neighbor[ii] = voxel[ii];
+    gradient(ii) = 0.5 * (forward - backward) / voxel_size_[ii];
+  }
+
+  return gradient;
+}
+
+// Value of the voxel at this (grid-clamped) multi-index within a patch.
+double SurrogateSubsystemValueFunction::
+PatchVoxel(size_t cell, const std::vector<size_t>& voxel) const {
+  size_t index = 0;
+  for (size_t ii = 0; ii < voxel.size(); ii++) {
+    size_t first, last;
+    CellVoxels(cell, ii, first, last);
+
+    // Patches include a one-voxel border, clipped to the grid.
+    const size_t patch_first = (first > 0) ? first - 1 : 0;
+    const size_t patch_last = std::min(last + 1, num_voxels_[ii]);
+
+#ifdef ENABLE_DEBUG_MESSAGES
+    if (voxel[ii] < patch_first || voxel[ii] >= patch_last) {
+      ROS_ERROR("Voxel was outside the patch in dimension %zu.", ii);
+      return 0.0;
+    }
+#endif
+
+    // Row-major order.
+    index = index * (patch_last - patch_first) + voxel[ii] - patch_first;
+  }
+
+  return patches_[patch_offset_[cell] + index];
+}
+
+// Step a row-major multi-index through the box [first, last). Returns
+// false once every index has been visited.
+bool SurrogateSubsystemValueFunction::
+Increment(std::vector<size_t>& index, const std::vector<size_t>& first,
+          const std::vector<size_t>& last) {
+  for (size_t ii = index.size(); ii > 0; ii--) {
+    if (++index[ii - 1] < last[ii - 1])
+      return true;
+
+    index[ii - 1] = first[ii - 1];
+  }
+
+  return false;
+}
+
+// Load from file. Returns whether or not it was successful.
+bool SurrogateSubsystemValueFunction::Load(const std::string& file_name) {
+  std::ifstream file(file_name.c_str(), std::ios::binary);
+  if (!file.is_open()) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  char magic[sizeof(kMagic)];
+  uint64_t counts[3];
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(counts), sizeof(counts));
+  if (!file.good() || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+    ROS_ERROR("%s: Not a surrogate value function file.", file_name.c_str());
+    return false;
+  }
+
+  const size_t num_dims = static_cast<size_t>(counts[0]);
+  const size_t num_control_dims = static_cast<size_t>(counts[1]);
+  const size_t num_patch_values = static_cast<size_t>(counts[2]);
+
+  if (num_dims == 0) {
+    ROS_ERROR("%s: Empty value function.", file_name.c_str());
+    return false;
+  }
+
+  std::vector<uint64_t> integers(3 * num_dims + num_control_dims);
+  file.read(reinterpret_cast<char*>(integers.data()),
+            integers.size() * sizeof(uint64_t));
+
+  std::vector<double> doubles(3 * num_dims + 5);
+  file.read(reinterpret_cast<char*>(doubles.data()),
+            doubles.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("%s: Truncated header.", file_name.c_str());
+    return false;
+  }
+
+  std::vector<uint64_t>::const_iterator int_iter = integers.begin();
+  state_dimensions_.assign(int_iter, int_iter + num_dims);
+  int_iter += num_dims;
+  control_dimensions_.assign(int_iter, int_iter + num_control_dims);
+  int_iter += num_control_dims;
+  num_voxels_.assign(int_iter, int_iter + num_dims);
+  int_iter += num_dims;
+  cell_voxels_.assign(int_iter, int_iter + num_dims);
+
+  std::vector<double>::const_iterator iter = doubles.begin();
+  lower_.assign(iter, iter + num_dims);
+  iter += num_dims;
+  upper_.assign(iter, iter + num_dims);
+  iter += num_dims;
+  max_planner_speed_.assign(iter, iter + 3);
+  iter += 3;
+  priority_lower_ = *iter++;
+  priority_upper_ = *iter++;
+  tracking_bound_.assign(iter, iter + num_dims);
+
+  // Determine voxel size and number of cells.
+  size_t total_cells = 1;
+  for (size_t ii = 0; ii < num_dims; ii++) {
+    if (num_voxels_[ii] == 0 || cell_voxels_[ii] == 0) {
+      ROS_ERROR("%s: Zero voxels in dimension %zu.", file_name.c_str(), ii);
+      return false;
+    }
+
+    voxel_size_.push_back((upper_[ii] - lower_[ii]) /
+                          static_cast<double>(num_voxels_[ii]));
+    num_cells_.push_back(
+      (num_voxels_[ii] + cell_voxels_[ii] - 1) / cell_voxels_[ii]);
+    total_cells *= num_cells_.back();
+  }
+
+  // Read cells.
+  num_terms_ = (num_dims + 1) * (num_dims + 2) / 2;
+  coefficients_.resize(total_cells * num_terms_);
+  error_bound_.resize(total_cells);
+  patch_offset_.resize(total_cells);
+
+  for (size_t ii = 0; ii < total_cells; ii++) {
+    file.read(reinterpret_cast<char*>(&coefficients_[ii * num_terms_]),
+              num_terms_ * sizeof(double));
+    file.read(reinterpret_cast<char*>(&error_bound_[ii]), sizeof(double));
+    file.read(reinterpret_cast<char*>(&patch_offset_[ii]), sizeof(uint64_t));
+  }
+
+  patches_.resize(num_patch_values);
+  file.read(reinterpret_cast<char*>(patches_.data()),
+            patches_.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("%s: Truncated data.", file_name.c_str());
+    return false;
+  }
+
+  // Check that patches lie within the patch data.
+  for (size_t ii = 0; ii < total_cells; ii++) {
+    if (patch_offset_[ii] != kNoPatch && patch_offset_[ii] >= patches_.size()) {
+      ROS_ERROR("%s: Bad patch offset for cell %zu.", file_name.c_str(), ii);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Fit a surrogate to grid data and write it to file. Returns whether it
+// was successful.
+bool SurrogateSubsystemValueFunction::
+Fit(const std::string& file_name,
+    const std::vector<size_t>& state_dimensions,
+    const std::vector<size_t>& control_dimensions,
+    const std::vector<size_t>& num_voxels,
+    const std::vector<double>& lower,
+    const std::vector<double>& upper,
+    const std::vector<double>& max_planner_speed,
+    double priority_lower, double priority_upper,
+    const std::vector<double>& tracking_bound,
+    const std::vector<double>& data,
+    const std::vector<size_t>& cell_voxels,
+    double tolerance) {
+  const size_t num_dims = state_dimensions.size();
+
+  // Check sizes.
+  size_t grid_size = 1;
+  for (size_t ii = 0; ii < num_voxels.size(); ii++)
+    grid_size *= num_voxels[ii];
+
+  if (num_dims == 0 || grid_size == 0 ||
+      num_voxels.size() != num_dims || cell_voxels.size() != num_dims ||
+      lower.size() != num_dims || upper.size() != num_dims ||
+      max_planner_speed.size() != 3 || tracking_bound.size() != num_dims ||
+      data.size() != grid_size) {
+    ROS_ERROR("Inconsistent sizes when fitting %s.", file_name.c_str());
+    return false;
+  }
+
+  // Grid and cell geometry.
+  std::vector<double> voxel_size;
+  std::vector<size_t> cell_size, num_cells;
+  size_t total_cells = 1;
+  for (size_t ii = 0; ii < num_dims; ii++) {
+    voxel_size.push_back((upper[ii] - lower[ii]) /
+                         static_cast<double>(num_voxels[ii]));
+    cell_size.push_back(
+      std::min(std::max<size_t>(cell_voxels[ii], 1), num_voxels[ii]));
+    num_cells.push_back((num_voxels[ii] + cell_size[ii] - 1) / cell_size[ii]);
+    total_cells *= num_cells.back();
+  }
+
+  const size_t num_terms = (num_dims + 1) * (num_dims + 2) / 2;
+  std::vector<double> cells;
+  std::vector<double> patches;
+
+  // Worst-case amplification of voxel errors by the grid interpolant,
+  // which is an affine (not convex) combination of up to num_dims + 1
+  // voxel values.
+  const double amplification =
+    std::max(1.0, static_cast<double>(num_dims) - 1.0);
+
+  std::vector<size_t> cell_index(num_dims, 0);
+  const std::vector<size_t> cell_first(num_dims, 0);
+  do {
+    // Voxel extent of this cell, with a one-voxel border clipped to the grid.
+    std::vector<size_t> first(num_dims), last(num_dims);
+    std::vector<size_t> border_first(num_dims), border_last(num_dims);
+    VectorXd center(num_dims), half_width(num_dims);
+    for (size_t ii = 0; ii < num_dims; ii++) {
+      first[ii] = cell_index[ii] * cell_size[ii];
+      last[ii] = std::min(first[ii] + cell_size[ii], num_voxels[ii]);
+      border_first[ii] = (first[ii] > 0) ? first[ii] - 1 : 0;
+      border_last[ii] = std::min(last[ii] + 1, num_voxels[ii]);
+
+      half_width(ii) = 0.5 * (last[ii] - first[ii]) * voxel_size[ii];
+      center(ii) = lower[ii] + first[ii] * voxel_size[ii] + half_width(ii);
+    }
+
+    // Basis functions and data value at a voxel.
+    VectorXd basis(num_terms);
+    std::vector<size_t> voxel;
+    const auto evaluate_basis = [&]() {
+      basis(0) = 1.0;
+      VectorXd z(num_dims);
+      for (size_t ii = 0; ii < num_dims; ii++) {
+        z(ii) = (lower[ii] + (voxel[ii] + 0.5) * voxel_size[ii] - center(ii)) /
+          half_width(ii);
+        basis(1 + ii) = z(ii);
+      }
+
+      size_t term = 1 + num_dims;
+      for (size_t ii = 0; ii < num_dims; ii++) {
+        for (size_t jj = ii; jj < num_dims; jj++)
+          basis(term++) = z(ii) * z(jj);
+      }
+    };
+    const auto grid_value = [&]() {
+      size_t index = 0;
+      for (size_t ii = 0; ii < num_dims; ii++)
+        index = index * num_voxels[ii] + voxel[ii];
+      return data[index];
+    };
+
+    // Least squares fit over the cell's voxel centers.
+    size_t num_samples = 1;
+    for (size_t ii = 0; ii < num_dims; ii++)
+      num_samples *= last[ii] - first[ii];
+
+    MatrixXd A(num_samples, num_terms);
+    VectorXd b(num_samples);
+    size_t row = 0;
+    voxel = first;
+    do {
+      evaluate_basis();
+      A.row(row) = basis.transpose();
+      b(row) = grid_value();
+      row++;
+    } while (Increment(voxel, first, last));
+
+    const VectorXd coefficients = A.colPivHouseholderQr().solve(b);
+
+    // Residual over the cell and its border, since the grid interpolant
+    // within the cell also reads the border voxels.
+    double residual = 0.0;
+    voxel = border_first;
+    do {
+      evaluate_basis();
+      residual = std::max(residual, std::abs(basis.dot(coefficients) -
+                                             grid_value()));
+    } while (Increment(voxel, border_first, border_last));
+
+    // Hessian of the polynomial in state coordinates (constant).
+    MatrixXd hessian = MatrixXd::Zero(num_dims, num_dims);
+    size_t term = 1 + num_dims;
+    for (size_t ii = 0; ii < num_dims; ii++) {
+      for (size_t jj = ii; jj < num_dims; jj++) {
+        const double scale = half_width(ii) * half_width(jj);
+        if (ii == jj) {
+          hessian(ii, ii) = 2.0 * coefficients(term) / scale;
+        } else {
+          hessian(ii, jj) = coefficients(term) / scale;
+          hessian(jj, ii) = hessian(ii, jj);
+        }
+        term++;
+      }
+    }
+
+    // Certified bound: amplified residual plus the error of interpolating
+    // the quadratic itself. Along dimensions where the cell touches the
+    // grid edge, the grid holds values constant over the last half voxel,
+    // so add the largest slope over the cell times half a voxel there.
+    double bound = amplification * residual;
+    for (size_t ii = 0; ii < num_dims; ii++) {
+      bound += 0.125 * std::abs(hessian(ii, ii)) *
+        voxel_size[ii] * voxel_size[ii];
+      for (size_t jj = ii + 1; jj < num_dims; jj++)
+        bound += 0.25 * std::abs(hessian(ii, jj)) *
+          voxel_size[ii] * voxel_size[jj];
+
+      if (first[ii] == 0 || last[ii] == num_voxels[ii]) {
+        double max_slope = std::abs(coefficients(1 + ii) / half_width(ii));
+        for (size_t jj = 0; jj < num_dims; jj++)
+          max_slope += std::abs(hessian(ii, jj)) * half_width(jj);
+
+        bound += 0.5 * max_slope * voxel_size[ii];
+      }
+    }
+
+    // Store the cell, falling back to grid values if the bound is too loose.
+    cells.insert(cells.end(), coefficients.data(),
+                 coefficients.data() + num_terms);
+
+    uint64_t patch_offset = kNoPatch;
+    if (bound > tolerance) {
+      patch_offset = patches.size();
+      bound = 0.0;
+
+      voxel = border_first;
+      do {
+        patches.push_back(grid_value());
+      } while (Increment(voxel, border_first, border_last));
+    }
+
+    cells.push_back(bound);
+
+    // Patch offsets are stored bitwise in the double stream.
+    double offset_bits;
+    std::memcpy(&offset_bits, &patch_offset, sizeof(offset_bits));
+    cells.push_back(offset_bits);
+  } while (Increment(cell_index, cell_first, num_cells));
+
+  // Write.
+  std::ofstream file(file_name.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  file.write(kMagic, sizeof(kMagic));
+
+  std::vector<uint64_t> integers;
+  integers.push_back(num_dims);
+  integers.push_back(control_dimensions.size());
+  integers.push_back(patches.size());
+  integers.insert(integers.end(),
+                  state_dimensions.begin(), state_dimensions.end());
+  integers.insert(integers.end(),
+                  control_dimensions.begin(), control_dimensions.end());
+  integers.insert(integers.end(), num_voxels.begin(), num_voxels.end());
+  integers.insert(integers.end(), cell_size.begin(), cell_size.end());
+  file.write(reinterpret_cast<const char*>(integers.data()),
+             integers.size() * sizeof(uint64_t));
+
+  std::vector<double> doubles(lower);
+  doubles.insert(doubles.end(), upper.begin(), upper.end());
+  doubles.insert(doubles.end(),
+                 max_planner_speed.begin(), max_planner_speed.end());
+  doubles.push_back(priority_lower);
+  doubles.push_back(priority_upper);
+  doubles.insert(doubles.end(), tracking_bound.begin(), tracking_bound.end());
+  file.write(reinterpret_cast<const char*>(doubles.data()),
+             doubles.size() * sizeof(double));
+
+  file.write(reinterpret_cast<const char*>(cells.data()),
+             cells.size() * sizeof(double));
+  file.write(reinterpret_cast<const char*>(patches.data()),
+             patches.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("Error writing file: %s.", file_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+} //\namespace meta
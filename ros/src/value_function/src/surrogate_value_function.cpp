@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the SurrogateValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/surrogate_value_function.h>
+
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <unordered_set>
+
+namespace meta {
+
+namespace fs = boost::filesystem;
+
+// Factory method. Use this instead of the constructor.
+// Note that this class is const-only, which means that once it is
+// instantiated it can never be changed.
+SurrogateValueFunction::ConstPtr SurrogateValueFunction::
+Create(const std::string& directory, const Dynamics::ConstPtr& dynamics,
+       size_t x_dim, size_t u_dim, ValueFunctionId id) {
+  SurrogateValueFunction::ConstPtr ptr(
+    new SurrogateValueFunction(directory, dynamics, x_dim, u_dim, id));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+SurrogateValueFunction::
+SurrogateValueFunction(const std::string& directory,
+                       const Dynamics::ConstPtr& dynamics,
+                       size_t x_dim, size_t u_dim, ValueFunctionId id)
+  : ValueFunction(dynamics, x_dim, u_dim, id) {
+  // Extract a list of files from this directory.
+  std::vector<std::string> file_names;
+  const fs::path path(PRECOMPUTATION_DIR + directory);
+  if (fs::is_directory(path)) {
+    for (auto iter = fs::directory_iterator(path);
+         iter != fs::directory_iterator();
+         iter++) {
+      if (fs::is_regular_file(*iter) && iter->path().extension() == ".svf")
+        file_names.push_back(iter->path().filename().string());
+    }
+  }
+
+  if (file_names.size() == 0) {
+    ROS_ERROR("No valid surrogate files in this directory: %s.",
+              std::string(PRECOMPUTATION_DIR + directory).c_str());
+    initialized_ = false;
+    return;
+  }
+
+  // Load each subsystem from file.
+  for (const auto& file : file_names) {
+    subsystems_.push_back(SurrogateSubsystemValueFunction::Create(
+      PRECOMPUTATION_DIR + directory + file));
+    initialized_ &= subsystems_.back()->IsInitialized();
+  }
+
+  if (!initialized_)
+    return;
+
+  // Set max planner speed and check consistency.
+  for (size_t ii = 0; ii < 3; ii++) {
+    max_planner_speed_(ii) = subsystems_.front()->MaxPlannerSpeed(ii);
+
+    for (const auto& subsystem : subsystems_) {
+      if (std::abs(max_planner_speed_(ii) -
+                   subsystem->MaxPlannerSpeed(ii)) > 1e-8) {
+        ROS_ERROR("Max planner speed was not consistent across subsystems.");
+        initialized_ = false;
+        return;
+      }
+    }
+  }
+
+  // Check that all subsystem dimensions are mutually exclusive and
+  // cover the full state space.
+  std::unordered_set<size_t> dims;
+  for (size_t ii = 0; ii < x_dim_; ii++)
+    dims.insert(ii);
+
+  for (const auto& subsystem : subsystems_) {
+    for (size_t ii : subsystem->StateDimensions()) {
+      if (dims.count(ii) == 0) {
+        // Another subsystem already has this dimension.
+        ROS_ERROR("Multiple subsystems have dimension %zu.", ii);
+        initialized_ = false;
+        return;
+      }
+
+      // Remove this dimension from the set.
+      dims.erase(ii);
+    }
+  }
+
+  // Check if there are any dimensions remaining.
+  if (dims.size() > 0) {
+    ROS_ERROR("Not all dimensions are accounted for in SurrogateValueFunction.");
+    initialized_ = false;
+    return;
+  }
+
+  ROS_INFO("Loaded surrogate value function from %s: max error bound %f.",
+           directory.c_str(), MaxErrorBound());
+}
+
+// Combine values of different subsystems.
+double SurrogateValueFunction::Value(const VectorXd& state) const {
+  double max_value = -std::numeric_limits<double>::infinity();
+
+  for (const auto& subsystem : subsystems_)
+    max_value = std::max(max_value, subsystem->Value(state));
+
+  return max_value;
+}
+
+// Combine gradients from different subsystems.
+VectorXd SurrogateValueFunction::Gradient(const VectorXd& state) const {
+  VectorXd gradient = VectorXd::Zero(state.size());
+
+  for (const auto& subsystem : subsystems_) {
+    const VectorXd subsystem_gradient = subsystem->Gradient(state);
+    const std::vector<size_t>& dims = subsystem->StateDimensions();
+
+    for (size_t ii = 0; ii < dims.size(); ii++) {
+      gradient(dims[ii]) = subsystem_gradient(ii);
+    }
+  }
+
+  return gradient;
+}
+
+// Get the tracking error bound in this spatial dimension.
+double SurrogateValueFunction::TrackingBound(size_t dimension) const {
+  // Get corresponding full state dimension.
+  const size_t full_dim = dynamics_->SpatialDimension(dimension);
+
+  // Loop through all subsystems to find the one containing this dimension.
+  for (const auto& subsystem : subsystems_) {
+    const std::vector<size_t>& state_dims = subsystem->StateDimensions();
+
+    for (size_t ii = 0; ii < state_dims.size(); ii++) {
+      if (state_dims[ii] == full_dim)
+        return subsystem->TrackingBound(ii);
+    }
+  }
+
+  // Catch not found.
+  ROS_WARN("Could not find the tracking error bound in dimension %zu.",
+           dimension);
+
+  return std::numeric_limits<double>::infinity();
+}
+
+// Priority of the optimal control at the given state. This is a number
+// between 0 and 1, where 1 means the final control signal should be exactly
+// the optimal control signal computed by this value function.
+double SurrogateValueFunction::Priority(const VectorXd& state) const {
+  double priority = 0.0;
+
+  // Take the max priority among all subsystems.
+  for (const auto& subsystem : subsystems_)
+    priority = std::max(priority, subsystem->Priority(state));
+
+  return priority;
+}
+
+// Largest certified error bound over all subsystems.
+double SurrogateValueFunction::MaxErrorBound() const {
+  double bound = 0.0;
+
+  for (const auto& subsystem : subsystems_)
+    bound = std::max(bound, subsystem->MaxErrorBound());
+
+  return bound;
+}
+
+} //\namespace meta
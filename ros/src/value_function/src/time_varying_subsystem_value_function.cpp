@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TimeVaryingSubsystemValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/time_varying_subsystem_value_function.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace meta {
+
+const char TimeVaryingSubsystemValueFunction::kMagic[8] =
+  { 'M', 'E', 'T', 'A', 'T', 'V', 'V', 'F' };
+const size_t TimeVaryingSubsystemValueFunction::kDataAlignment = 4096;
+
+// Factory method. Use this instead of the constructor.
+// Note that this class is const-only, which means that once it is
+// instantiated it can never be changed.
+TimeVaryingSubsystemValueFunction::ConstPtr TimeVaryingSubsystemValueFunction::
+Create(const std::string& file_name, size_t prefetch_slices) {
+  TimeVaryingSubsystemValueFunction::ConstPtr ptr(
+    new TimeVaryingSubsystemValueFunction(file_name, prefetch_slices));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+TimeVaryingSubsystemValueFunction::
+TimeVaryingSubsystemValueFunction(const std::string& file_name,
+                                  size_t prefetch_slices)
+  : slice_size_(0),
+    priority_lower_(0.0),
+    priority_upper_(0.0),
+    map_(MAP_FAILED),
+    map_size_(0),
+    data_(NULL),
+    prefetch_slices_(prefetch_slices),
+    window_first_(0),
+    window_last_(0),
+    window_valid_(false),
+    initialized_(false) {
+  initialized_ = Load(file_name);
+}
+
+// Destructor unmaps the file.
+TimeVaryingSubsystemValueFunction::~TimeVaryingSubsystemValueFunction() {
+  if (map_ != MAP_FAILED)
+    munmap(map_, map_size_);
+}
+
+// Priority of the optimal control at the given state and time.
+double TimeVaryingSubsystemValueFunction::
+Priority(const VectorXd& state, double time) const {
+  const double value = Value(state, time);
+
+  if (value < priority_lower_)
+    return 0.0;
+
+  if (value > priority_upper_)
+    return 1.0;
+
+  return (value - priority_lower_) / (priority_upper_ - priority_lower_);
+}
+
+// Interpolate to get the value at a particular state and time.
+double TimeVaryingSubsystemValueFunction::
+Value(const VectorXd& state, double time) const {
+  if (!initialized_) {
+    ROS_ERROR("TimeVaryingSubsystemValueFunction was not initialized.");
+    return 0.0;
+  }
+
+  double fraction = 0.0;
+  const size_t slice = FindSlice(time, fraction);
+  UpdateWindow(slice);
+
+  const VectorXd punctured = Puncture(state);
+  const double value = SliceValue(slice, punctured);
+  if (fraction <= 0.0)
+    return value;
+
+  return (1.0 - fraction) * value + fraction * SliceValue(slice + 1, punctured);
+}
+
+// Interpolate to get the gradient at a particular state and time.
+VectorXd TimeVaryingSubsystemValueFunction::
+Gradient(const VectorXd& state, double time) const {
+  if (!initialized_) {
+    ROS_ERROR("TimeVaryingSubsystemValueFunction was not initialized.");
+    return VectorXd::Zero(state_dimensions_.size());
+  }
+
+  double fraction = 0.0;
+  const size_t slice = FindSlice(time, fraction);
+  UpdateWindow(slice);
+
+  const VectorXd punctured = Puncture(state);
+  const VectorXd gradient = SliceGradient(slice, punctured);
+  if (fraction <= 0.0)
+    return gradient;
+
+  return (1.0 - fraction) * gradient +
+    fraction * SliceGradient(slice + 1, punctured);
+}
+
+// Tracking error bound in the specified subsystem dimension at this time.
+double TimeVaryingSubsystemValueFunction::
+TrackingBound(size_t ii, double time) const {
+  if (!initialized_) {
+    ROS_ERROR("TimeVaryingSubsystemValueFunction was not initialized.");
+    return 0.0;
+  }
+
+#ifdef ENABLE_DEBUG_MESSAGES
+  if (ii >= state_dimensions_.size()) {
+    ROS_ERROR("Tracking bound index was out of range: %zu.", ii);
+    return 0.0;
+  }
+#endif
+
+  // The bound table is tiny and stays resident, so no window update needed.
+  double fraction = 0.0;
+  const size_t slice = FindSlice(time, fraction);
+
+  const size_t num_dims = state_dimensions_.size();
+  const double bound = tracking_bound_[slice * num_dims + ii];
+  if (fraction <= 0.0)
+    return bound;
+
+  return (1.0 - fraction) * bound +
+    fraction * tracking_bound_[(slice + 1) * num_dims + ii];
+}
+
+// Largest tracking error bound over all slices in this subsystem dimension.
+double TimeVaryingSubsystemValueFunction::MaxTrackingBound(size_t ii) const {
+  if (!initialized_) {
+    ROS_ERROR("TimeVaryingSubsystemValueFunction was not initialized.");
+    return 0.0;
+  }
+
+  // Interpolated bounds never exceed the larger endpoint, so the max over
+  // slices is the max over all times.
+  const size_t num_dims = state_dimensions_.size();
+  double bound = 0.0;
+  for (size_t jj = 0; jj < times_.size(); jj++)
+    bound = std::max(bound, tracking_bound_[jj * num_dims + ii]);
+
+  return bound;
+}
+
+// Half-width of the zero sublevel set of the given slice, projected onto
+// subsystem dimension ii.
+double TimeVaryingSubsystemValueFunction::
+LevelSetBound(size_t ii, size_t slice) const {
+  if (!initialized_) {
+    ROS_ERROR("TimeVaryingSubsystemValueFunction was not initialized.");
+    return -1.0;
+  }
+
+  if (ii >= state_dimensions_.size() || slice >= times_.size()) {
+    ROS_ERROR("Level set index was out of range: %zu, slice %zu.", ii, slice);
+    return -1.0;
+  }
+
+  // Stride of dimension ii in row-major order.
+  size_t stride = 1;
+  for (size_t jj = ii + 1; jj < num_voxels_.size(); jj++)
+    stride *= num_voxels_[jj];
+
+  const double* values = data_ + slice * slice_size_;
+  double bound = -1.0;
+  for (size_t kk = 0; kk < slice_size_; kk++) {
+    if (values[kk] > 0.0)
+      continue;
+
+    const size_t index = (kk / stride) % num_voxels_[ii];
+    const double center =
+      lower_[ii] + (static_cast<double>(index) + 0.5) * voxel_size_[ii];
+    bound = std::max(bound, std::abs(center) + 0.5 * voxel_size_[ii]);
+  }
+
+  // Drop the pages we just faulted in, unless the window needs them.
+  std::lock_guard<std::mutex> lock(window_mutex_);
+  if (slice != times_.size() - 1 &&
+      !(window_valid_ && slice >= window_first_ && slice <= window_last_))
+    Advise(slice, slice, MADV_DONTNEED);
+
+  return bound;
+}
+
+// Find the slice at or before this time and the fraction of the way to
+// the next slice. Times outside the horizon are clamped.
+size_t TimeVaryingSubsystemValueFunction::
+FindSlice(double time, double& fraction) const {
+  fraction = 0.0;
+  if (times_.size() == 1 || time <= times_.front())
+    return 0;
+
+  if (time >= times_.back())
+    return times_.size() - 1;
+
+  // First time strictly greater than this one; guaranteed to be in
+  // [1, NumSlices() - 1] by the checks above.
+  const size_t upper = static_cast<size_t>(
+    std::upper_bound(times_.begin(), times_.end(), time) - times_.begin());
+  const size_t lower = upper - 1;
+
+  fraction = (time - times_[lower]) / (times_[upper] - times_[lower]);
+  return lower;
+}
+
+// Make sure the window around this slice is resident, and release slices
+// which have left the window.
+void TimeVaryingSubsystemValueFunction::UpdateWindow(size_t slice) const {
+  // The final slice is always resident, so queries there (including every
+  // query without a time, and any past the horizon) leave the window where
+  // the time-indexed queries put it.
+  const size_t final_slice = times_.size() - 1;
+  if (slice >= final_slice)
+    return;
+
+  // Window covers the interpolation partner (slice + 1) plus prefetch slices
+  // on either side, so that trajectories running in either direction in time
+  // do not fault.
+  const size_t first = (slice > prefetch_slices_) ? slice - prefetch_slices_ : 0;
+  const size_t last =
+    std::min(slice + 1 + prefetch_slices_, times_.size() - 1);
+
+  std::lock_guard<std::mutex> lock(window_mutex_);
+  if (window_valid_ && first == window_first_ && last == window_last_)
+    return;
+
+  // Release slices that fell out of the window.
+  if (window_valid_) {
+    for (size_t ii = window_first_; ii <= window_last_; ii++) {
+      if ((ii < first || ii > last) && ii != final_slice)
+        Advise(ii, ii, MADV_DONTNEED);
+    }
+  }
+
+  Advise(first, last, MADV_WILLNEED);
+  window_first_ = first;
+  window_last_ = last;
+  window_valid_ = true;
+}
+
+// Advise the kernel about a range of slices.
+void TimeVaryingSubsystemValueFunction::
+Advise(size_t first, size_t last, int advice) const {
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+  // Byte range within the map. Round outward for WILLNEED, but inward for
+  // DONTNEED so we never drop pages shared with slices still in the window.
+  const size_t offset =
+    reinterpret_cast<const char*>(data_) - static_cast<const char*>(map_);
+  size_t begin = offset + first * slice_size_ * sizeof(double);
+  size_t end = offset + (last + 1) * slice_size_ * sizeof(double);
+
+  if (advice == MADV_DONTNEED) {
+    begin = ((begin + page_size - 1) / page_size) * page_size;
+    end = (end / page_size) * page_size;
+  } else {
+    begin = (begin / page_size) * page_size;
+    end = std::min(((end + page_size - 1) / page_size) * page_size, map_size_);
+  }
+
+  if (end <= begin)
+    return;
+
+  if (madvise(static_cast<char*>(map_) + begin, end - begin, advice) != 0)
+    ROS_WARN_THROTTLE(1.0, "madvise failed on time-varying value function.");
+}
+
+// Value within a single slice. Nearest voxel plus a first-order correction,
+// as in SubsystemValueFunction::Value.
+double TimeVaryingSubsystemValueFunction::
+SliceValue(size_t slice, const VectorXd& punctured) const {
+  const double* values = data_ + slice * slice_size_;
+
+  // Get distance from voxel center in each dimension.
+  const VectorXd center_distance = DistanceToCenter(punctured);
+
+  // Interpolate.
+  const double nn_value = values[StateToIndex(punctured)];
+  double approx_value = nn_value;
+
+  VectorXd neighbor = punctured;
+  for (size_t ii = 0; ii < punctured.size(); ii++) {
+    // Get neighboring value.
+    if (center_distance(ii) >= 0.0)
+      neighbor(ii) += voxel_size_[ii];
+    else
+      neighbor(ii) -= voxel_size_[ii];
+
+    const double neighbor_value = values[StateToIndex(neighbor)];
+    neighbor(ii) = punctured(ii);
+
+    // Compute forward difference.
+    const double slope = (center_distance(ii) >= 0.0) ?
+      (neighbor_value - nn_value) / voxel_size_[ii] :
+      (nn_value - neighbor_value) / voxel_size_[ii];
+
+    // Add to the Taylor approximation.
+    approx_value += slope * center_distance(ii);
+  }
+
+  return approx_value;
+}
+
+// Gradient within a single slice. Streamed files do not carry precomputed
+// derivatives, so compute a central difference at the containing voxel.
+VectorXd TimeVaryingSubsystemValueFunction::
+SliceGradient(size_t slice, const VectorXd& punctured) const {
+  const double* values = data_ + slice * slice_size_;
+  VectorXd gradient(punctured.size());
+
+  VectorXd neighbor = punctured;
+  for (size_t ii = 0; ii < punctured.size(); ii++) {
+    neighbor(ii) += voxel_size_[ii];
+    const double forward = values[StateToIndex(neighbor)];
+
+    neighbor(ii) -= 2.0 * voxel_size_[ii];
+    const double backward = values[StateToIndex(neighbor)];
+
+    neighbor(ii) = punctured(ii);
+    gradient(ii) = 0.5 * (forward - backward) / voxel_size_[ii];
+  }
+
+  return gradient;
+}
+
+// Puncture a state vector for the overall system to get a
+// valid state vector for this subsystem.
+VectorXd TimeVaryingSubsystemValueFunction::
+Puncture(const VectorXd& state) const {
+  VectorXd punctured(state_dimensions_.size());
+
+  for (size_t ii = 0; ii < state_dimensions_.size(); ii++)
+    punctured(ii) = state(state_dimensions_[ii]);
+
+  return punctured;
+}
+
+// Return the voxel index corresponding to the given state, clamping
+// to the grid.
+size_t TimeVaryingSubsystemValueFunction::
+StateToIndex(const VectorXd& punctured) const {
+  size_t index = 0;
+
+  for (size_t ii = 0; ii < punctured.size(); ii++) {
+    size_t quantized = 0;
+    if (punctured(ii) >= upper_[ii])
+      quantized = num_voxels_[ii] - 1;
+    else if (punctured(ii) > lower_[ii])
+      quantized = std::min(num_voxels_[ii] - 1, static_cast<size_t>(
+        (punctured(ii) - lower_[ii]) / voxel_size_[ii]));
+
+    // Row-major order.
+    index = index * num_voxels_[ii] + quantized;
+  }
+
+  return index;
+}
+
+// Compute the distance (vector) from this state to the center
+// of the nearest voxel.
+VectorXd TimeVaryingSubsystemValueFunction::
+DistanceToCenter(const VectorXd& punctured) const {
+  VectorXd center_distance(punctured.size());
+  for (size_t ii = 0; ii < punctured.size(); ii++) {
+    const double center =
+      std::floor((punctured(ii) - lower_[ii]) / voxel_size_[ii]) * voxel_size_[ii] +
+      0.5 * voxel_size_[ii] + lower_[ii];
+
+    center_distance(ii) = punctured(ii) - center;
+  }
+
+  return center_distance;
+}
+
+// Load header and map data from file. Returns whether it was successful.
+bool TimeVaryingSubsystemValueFunction::Load(const std::string& file_name) {
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    ROS_ERROR("Could not stat file: %s.", file_name.c_str());
+    close(fd);
+    return false;
+  }
+
+  map_size_ = static_cast<size_t>(file_stat.st_size);
+  map_ = (map_size_ > 0) ?
+    mmap(NULL, map_size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+
+  // The mapping holds its own reference to the file.
+  close(fd);
+
+  if (map_ == MAP_FAILED) {
+    ROS_ERROR("Could not map file: %s.", file_name.c_str());
+    return false;
+  }
+
+  // We touch slices in no particular order within the window.
+  madvise(map_, map_size_, MADV_RANDOM);
+
+  // Walk the header.
+  const char* cursor = static_cast<const char*>(map_);
+  const char* end = cursor + map_size_;
+
+  if (map_size_ < sizeof(kMagic) + 3 * sizeof(uint64_t) ||
+      std::memcmp(cursor, kMagic, sizeof(kMagic)) != 0) {
+    ROS_ERROR("%s: Not a time-varying value function file.", file_name.c_str());
+    return false;
+  }
+  cursor += sizeof(kMagic);
+
+  uint64_t counts[3];
+  std::memcpy(counts, cursor, sizeof(counts));
+  cursor += sizeof(counts);
+
+  const size_t num_dims = static_cast<size_t>(counts[0]);
+  const size_t num_control_dims = static_cast<size_t>(counts[1]);
+  const size_t num_slices = static_cast<size_t>(counts[2]);
+
+  if (num_dims == 0 || num_slices == 0) {
+    ROS_ERROR("%s: Empty value function.", file_name.c_str());
+    return false;
+  }
+
+  const size_t header_size =
+    (2 * num_dims + num_control_dims) * sizeof(uint64_t) +
+    (2 * num_dims + 5 + num_slices * (1 + num_dims)) * sizeof(double);
+  if (static_cast<size_t>(end - cursor) < header_size) {
+    ROS_ERROR("%s: Truncated header.", file_name.c_str());
+    return false;
+  }
+
+  std::vector<uint64_t> buffer(2 * num_dims + num_control_dims);
+  std::memcpy(buffer.data(), cursor, buffer.size() * sizeof(uint64_t));
+  cursor += buffer.size() * sizeof(uint64_t);
+
+  state_dimensions_.assign(buffer.begin(), buffer.begin() + num_dims);
+  control_dimensions_.assign(buffer.begin() + num_dims,
+                             buffer.begin() + num_dims + num_control_dims);
+  num_voxels_.assign(buffer.begin() + num_dims + num_control_dims,
+                     buffer.end());
+
+  std::vector<double> doubles(2 * num_dims + 5 + num_slices * (1 + num_dims));
+  std::memcpy(doubles.data(), cursor, doubles.size() * sizeof(double));
+  cursor += doubles.size() * sizeof(double);
+
+  std::vector<double>::const_iterator iter = doubles.begin();
+  lower_.assign(iter, iter + num_dims);
+  iter += num_dims;
+  upper_.assign(iter, iter + num_dims);
+  iter += num_dims;
+  max_planner_speed_.assign(iter, iter + 3);
+  iter += 3;
+  priority_lower_ = *iter++;
+  priority_upper_ = *iter++;
+  times_.assign(iter, iter + num_slices);
+  iter += num_slices;
+  tracking_bound_.assign(iter, iter + num_slices * num_dims);
+
+  for (size_t ii = 1; ii < num_slices; ii++) {
+    if (times_[ii] <= times_[ii - 1]) {
+      ROS_ERROR("%s: Slice times are not increasing.", file_name.c_str());
+      return false;
+    }
+  }
+
+  // Determine voxel size and slice size.
+  slice_size_ = 1;
+  for (size_t ii = 0; ii < num_voxels_.size(); ii++) {
+    if (num_voxels_[ii] == 0) {
+      ROS_ERROR("%s: Zero voxels in dimension %zu.", file_name.c_str(), ii);
+      return false;
+    }
+
+    voxel_size_.push_back((upper_[ii] - lower_[ii]) /
+                          static_cast<double>(num_voxels_[ii]));
+    slice_size_ *= num_voxels_[ii];
+  }
+
+  // Data begins at the next aligned boundary.
+  const size_t data_offset =
+    ((cursor - static_cast<const char*>(map_) + kDataAlignment - 1) /
+     kDataAlignment) * kDataAlignment;
+  if (data_offset + num_slices * slice_size_ * sizeof(double) > map_size_) {
+    ROS_ERROR("%s: Truncated data.", file_name.c_str());
+    return false;
+  }
+
+  data_ = reinterpret_cast<const double*>(
+    static_cast<const char*>(map_) + data_offset);
+
+  // The final slice is always resident (see UpdateWindow).
+  Advise(num_slices - 1, num_slices - 1, MADV_WILLNEED);
+
+  return true;
+}
+
+// Write a file in the format read by this class. Returns whether it was
+// successful.
+bool TimeVaryingSubsystemValueFunction::
+Write(const std::string& file_name,
+      const std::vector<size_t>& state_dimensions,
+      const std::vector<size_t>& control_dimensions,
+      const std::vector<size_t>& num_voxels,
+      const std::vector<double>& lower,
+      const std::vector<double>& upper,
+      const std::vector<double>& max_planner_speed,
+      double priority_lower, double priority_upper,
+      const std::vector<double>& times,
+      const std::vector<double>& tracking_bound,
+      const std::vector<double>& data) {
+  const size_t num_dims = state_dimensions.size();
+  const size_t num_slices = times.size();
+
+  // Check sizes.
+  size_t slice_size = 1;
+  for (size_t ii = 0; ii < num_voxels.size(); ii++)
+    slice_size *= num_voxels[ii];
+
+  if (num_dims == 0 || num_slices == 0 ||
+      num_voxels.size() != num_dims ||
+      lower.size() != num_dims || upper.size() != num_dims ||
+      max_planner_speed.size() != 3 ||
+      tracking_bound.size() != num_slices * num_dims ||
+      data.size() != num_slices * slice_size) {
+    ROS_ERROR("Inconsistent sizes when writing %s.", file_name.c_str());
+    return false;
+  }
+
+  std::ofstream file(file_name.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    ROS_ERROR("Could not open file: %s.", file_name.c_str());
+    return false;
+  }
+
+  file.write(kMagic, sizeof(kMagic));
+
+  std::vector<uint64_t> integers;
+  integers.push_back(num_dims);
+  integers.push_back(control_dimensions.size());
+  integers.push_back(num_slices);
+  integers.insert(integers.end(),
+                  state_dimensions.begin(), state_dimensions.end());
+  integers.insert(integers.end(),
+                  control_dimensions.begin(), control_dimensions.end());
+  integers.insert(integers.end(), num_voxels.begin(), num_voxels.end());
+  file.write(reinterpret_cast<const char*>(integers.data()),
+             integers.size() * sizeof(uint64_t));
+
+  std::vector<double> doubles(lower);
+  doubles.insert(doubles.end(), upper.begin(), upper.end());
+  doubles.insert(doubles.end(),
+                 max_planner_speed.begin(), max_planner_speed.end());
+  doubles.push_back(priority_lower);
+  doubles.push_back(priority_upper);
+  doubles.insert(doubles.end(), times.begin(), times.end());
+  doubles.insert(doubles.end(), tracking_bound.begin(), tracking_bound.end());
+  file.write(reinterpret_cast<const char*>(doubles.data()),
+             doubles.size() * sizeof(double));
+
+  // Pad to the alignment boundary.
+  const size_t header_size = sizeof(kMagic) +
+    integers.size() * sizeof(uint64_t) + doubles.size() * sizeof(double);
+  const size_t padding =
+    (kDataAlignment - header_size % kDataAlignment) % kDataAlignment;
+  const std::vector<char> zeros(padding, 0);
+  file.write(zeros.data(), zeros.size());
+
+  file.write(reinterpret_cast<const char*>(data.data()),
+             data.size() * sizeof(double));
+
+  if (!file.good()) {
+    ROS_ERROR("Error writing file: %s.", file_name.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+} //\namespace meta
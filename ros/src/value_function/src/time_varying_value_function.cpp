@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Defines the TimeVaryingValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/time_varying_value_function.h>
+
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <unordered_set>
+
+namespace meta {
+
+namespace fs = boost::filesystem;
+
+// Factory method. Use this instead of the constructor.
+// Note that this class is const-only, which means that once it is
+// instantiated it can never be changed.
+TimeVaryingValueFunction::ConstPtr TimeVaryingValueFunction::
+Create(const std::string& directory, const Dynamics::ConstPtr& dynamics,
+       size_t x_dim, size_t u_dim, ValueFunctionId id) {
+  TimeVaryingValueFunction::ConstPtr ptr(
+    new TimeVaryingValueFunction(directory, dynamics, x_dim, u_dim, id));
+  return ptr;
+}
+
+// Constructor. Don't use this. Use the factory method instead.
+TimeVaryingValueFunction::
+TimeVaryingValueFunction(const std::string& directory,
+                         const Dynamics::ConstPtr& dynamics,
+                         size_t x_dim, size_t u_dim, ValueFunctionId id)
+  : ValueFunction(dynamics, x_dim, u_dim, id),
+    end_time_(0.0) {
+  // Extract a list of files from this directory.
+  std::vector<std::string> file_names;
+  const fs::path path(PRECOMPUTATION_DIR + directory);
+  if (fs::is_directory(path)) {
+    for (auto iter = fs::directory_iterator(path);
+         iter != fs::directory_iterator();
+         iter++) {
+      if (fs::is_regular_file(*iter) && iter->path().extension() == ".tvvf")
+        file_names.push_back(iter->path().filename().string());
+    }
+  }
+
+  if (file_names.size() == 0) {
+    ROS_ERROR("No valid time-varying files in this directory: %s.",
+              std::string(PRECOMPUTATION_DIR + directory).c_str());
+    initialized_ = false;
+    return;
+  }
+
+  // Load each subsystem from file.
+  for (const auto& file : file_names) {
+    subsystems_.push_back(TimeVaryingSubsystemValueFunction::Create(
+      PRECOMPUTATION_DIR + directory + file));
+    initialized_ &= subsystems_.back()->IsInitialized();
+  }
+
+  if (!initialized_)
+    return;
+
+  // Set max planner speed and final time, and check consistency.
+  end_time_ = subsystems_.front()->EndTime();
+  for (const auto& subsystem : subsystems_) {
+    if (std::abs(end_time_ - subsystem->EndTime()) > 1e-8) {
+      ROS_ERROR("Final time was not consistent across subsystems.");
+      initialized_ = false;
+      return;
+    }
+  }
+
+  for (size_t ii = 0; ii < 3; ii++) {
+    max_planner_speed_(ii) = subsystems_.front()->MaxPlannerSpeed(ii);
+
+    for (const auto& subsystem : subsystems_) {
+      if (std::abs(max_planner_speed_(ii) -
+                   subsystem->MaxPlannerSpeed(ii)) > 1e-8) {
+        ROS_ERROR("Max planner speed was not consistent across subsystems.");
+        initialized_ = false;
+        return;
+      }
+    }
+  }
+
+  // Check that all subsystem dimensions are mutually exclusive and
+  // cover the full state space.
+  std::unordered_set<size_t> dims;
+  for (size_t ii = 0; ii < x_dim_; ii++)
+    dims.insert(ii);
+
+  for (const auto& subsystem : subsystems_) {
+    for (size_t ii : subsystem->StateDimensions()) {
+      if (dims.count(ii) == 0) {
+        // Another subsystem already has this dimension.
+        ROS_ERROR("Multiple subsystems have dimension %zu.", ii);
+        initialized_ = false;
+        return;
+      }
+
+      // Remove this dimension from the set.
+      dims.erase(ii);
+    }
+  }
+
+  // Check if there are any dimensions remaining.
+  if (dims.size() > 0) {
+    ROS_ERROR("Not all dimensions are accounted for in TimeVaryingValueFunction.");
+    initialized_ = false;
+    return;
+  }
+
+  ROS_INFO("Loaded time-varying value function from %s: %f s horizon.",
+           directory.c_str(), end_time_);
+}
+
+// Values and gradients at the final slice.
+double TimeVaryingValueFunction::Value(const VectorXd& state) const {
+  return ValueAt(state, -1.0);
+}
+
+VectorXd TimeVaryingValueFunction::Gradient(const VectorXd& state) const {
+  return GradientAt(state, -1.0);
+}
+
+// Combine values of different subsystems at this time.
+double TimeVaryingValueFunction::
+ValueAt(const VectorXd& state, double time) const {
+  if (time < 0.0)
+    time = end_time_;
+
+  double max_value = -std::numeric_limits<double>::infinity();
+
+  for (const auto& subsystem : subsystems_)
+    max_value = std::max(max_value, subsystem->Value(state, time));
+
+  return max_value;
+}
+
+// Combine gradients from different subsystems at this time.
+VectorXd TimeVaryingValueFunction::
+GradientAt(const VectorXd& state, double time) const {
+  if (time < 0.0)
+    time = end_time_;
+
+  VectorXd gradient = VectorXd::Zero(state.size());
+
+  for (const auto& subsystem : subsystems_) {
+    const VectorXd subsystem_gradient = subsystem->Gradient(state, time);
+    const std::vector<size_t>& dims = subsystem->StateDimensions();
+
+    for (size_t ii = 0; ii < dims.size(); ii++) {
+      gradient(dims[ii]) = subsystem_gradient(ii);
+    }
+  }
+
+  return gradient;
+}
+
+// Optimal control from the gradient at this time.
+VectorXd TimeVaryingValueFunction::
+OptimalControlAt(const VectorXd& state, double time) const {
+  return dynamics_->OptimalControl(state, GradientAt(state, time));
+}
+
+// Get the worst-case tracking error bound in this spatial dimension.
+double TimeVaryingValueFunction::TrackingBound(size_t dimension) const {
+  return TrackingBoundAt(dimension, -1.0);
+}
+
+// Get the tracking error bound in this spatial dimension at the given time
+// since tracking began. A negative time asks for the worst case.
+double TimeVaryingValueFunction::
+TrackingBoundAt(size_t dimension, double time) const {
+  // Get corresponding full state dimension.
+  const size_t full_dim = dynamics_->SpatialDimension(dimension);
+
+  // Loop through all subsystems to find the one containing this dimension.
+  for (const auto& subsystem : subsystems_) {
+    const std::vector<size_t>& state_dims = subsystem->StateDimensions();
+
+    for (size_t ii = 0; ii < state_dims.size(); ii++) {
+      if (state_dims[ii] != full_dim)
+        continue;
+
+      return (time < 0.0) ? subsystem->MaxTrackingBound(ii) :
+        subsystem->TrackingBound(ii, time);
+    }
+  }
+
+  // Catch not found.
+  ROS_WARN("Could not find the tracking error bound in dimension %zu.",
+           dimension);
+
+  return std::numeric_limits<double>::infinity();
+}
+
+// Priority of the optimal control at the given state, using the final
+// time slice.
+double TimeVaryingValueFunction::Priority(const VectorXd& state) const {
+  return PriorityAt(state, -1.0);
+}
+
+// Priority of the optimal control at the given state and time.
+double TimeVaryingValueFunction::
+PriorityAt(const VectorXd& state, double time) const {
+  if (time < 0.0)
+    time = end_time_;
+
+  double priority = 0.0;
+
+  // Take the max priority among all subsystems.
+  for (const auto& subsystem : subsystems_)
+    priority = std::max(priority, subsystem->Priority(state, time));
+
+  return priority;
+}
+
+// Half-width of the zero level set in this spatial dimension, in the slice
+// at or before the given time since the first slice.
+double TimeVaryingValueFunction::
+LevelSetBoundAt(size_t dimension, double time) const {
+  size_t index = 0;
+  const TimeVaryingSubsystemValueFunction* subsystem =
+    FindSubsystem(dimension, index);
+  if (!subsystem)
+    return -1.0;
+
+  size_t slice = subsystem->NumSlices() - 1;
+  if (time >= 0.0) {
+    while (slice > 0 &&
+           subsystem->SliceTime(slice) - subsystem->StartTime() > time)
+      slice--;
+  }
+
+  return subsystem->LevelSetBound(index, slice);
+}
+
+// Earliest time since the first slice at which the zero level set covers an
+// incoming tracking error bound of the given half-width.
+double TimeVaryingValueFunction::
+SwitchingTime(size_t dimension, double incoming_bound) const {
+  size_t index = 0;
+  const TimeVaryingSubsystemValueFunction* subsystem =
+    FindSubsystem(dimension, index);
+  if (!subsystem)
+    return std::numeric_limits<double>::infinity();
+
+  // Reachable sets only grow with the horizon, so the level set bound is
+  // monotone in the slice and we can bisect for the first covering slice.
+  size_t lower = 0;
+  size_t upper = subsystem->NumSlices() - 1;
+  if (subsystem->LevelSetBound(index, upper) < incoming_bound)
+    return std::numeric_limits<double>::infinity();
+
+  while (lower < upper) {
+    const size_t middle = lower + (upper - lower) / 2;
+    if (subsystem->LevelSetBound(index, middle) >= incoming_bound)
+      upper = middle;
+    else
+      lower = middle + 1;
+  }
+
+  return subsystem->SliceTime(lower) - subsystem->StartTime();
+}
+
+// Subsystem containing this spatial dimension, and the dimension's index
+// within it.
+const TimeVaryingSubsystemValueFunction* TimeVaryingValueFunction::
+FindSubsystem(size_t dimension, size_t& index) const {
+  // Get corresponding full state dimension.
+  const size_t full_dim = dynamics_->SpatialDimension(dimension);
+
+  for (const auto& subsystem : subsystems_) {
+    const std::vector<size_t>& state_dims = subsystem->StateDimensions();
+
+    for (size_t ii = 0; ii < state_dims.size(); ii++) {
+      if (state_dims[ii] == full_dim) {
+        index = ii;
+        return subsystem.get();
+      }
+    }
+  }
+
+  ROS_WARN("Could not find the subsystem for dimension %zu.", dimension);
+  return nullptr;
+}
+
+} //\namespace meta
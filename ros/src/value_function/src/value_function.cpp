@@ -43,6 +43,7 @@
 #include <value_function/value_function.h>
 
 #include <boost/filesystem.hpp>
+#include <algorithm>
 
 namespace meta {
 
@@ -68,14 +69,19 @@ ValueFunction::ValueFunction(const std::string& directory,
     u_dim_(u_dim),
     dynamics_(dynamics),
     initialized_(true) {
-  // Extract a list of files from this directory.
+  // Extract a list of files from this directory. Subsystems are stored as
+  // full grids (.mat) or sparse grids (.sgvf).
   std::vector<std::string> file_names;
   const fs::path path(PRECOMPUTATION_DIR + directory);
-  for (auto iter = fs::directory_iterator(path);
-       iter != fs::directory_iterator();
-       iter++) {
-    if (fs::is_regular_file(*iter) && iter->path().extension() == ".mat")
-      file_names.push_back(iter->path().filename().string());
+  if (fs::is_directory(path)) {
+    for (auto iter = fs::directory_iterator(path);
+         iter != fs::directory_iterator();
+         iter++) {
+      if (fs::is_regular_file(*iter) &&
+          (iter->path().extension() == ".mat" ||
+           iter->path().extension() == ".sgvf"))
+        file_names.push_back(iter->path().filename().string());
+    }
   }
 
   if (file_names.size() == 0) {
@@ -141,6 +147,21 @@ ValueFunction::ValueFunction(const std::string& directory,
   }
 }
 
+// Number of queries which fell outside the grid in the given dimension of
+// the full state space. Always zero for value functions without a grid.
+size_t ValueFunction::OutOfGridCount(size_t dimension) const {
+  for (const auto& subsystem : subsystems_) {
+    const std::vector<size_t>& state_dims = subsystem->StateDimensions();
+
+    for (size_t ii = 0; ii < state_dims.size(); ii++) {
+      if (state_dims[ii] == dimension)
+        return subsystem->OutOfGridCount(ii);
+    }
+  }
+
+  return 0;
+}
+
 // Get velocity expansion in the subsystem containing the given spatial dim.
 double ValueFunction::VelocityExpansion(size_t dimension) const {
   ROS_ERROR("Unimplemented method VelocityExpansion.");
@@ -150,7 +171,6 @@ double ValueFunction::VelocityExpansion(size_t dimension) const {
 
 // Combine values of different subsystems.
 double ValueFunction::Value(const VectorXd& state) const {
-  ROS_ERROR("Calling ValueFunction::Value.");
   double max_value = -std::numeric_limits<double>::infinity();
 
   for (const auto& subsystem : subsystems_)
@@ -161,7 +181,6 @@ double ValueFunction::Value(const VectorXd& state) const {
 
 // Combine gradients from different subsystems.
 VectorXd ValueFunction::Gradient(const VectorXd& state) const {
-  ROS_ERROR("Calling ValueFunction::Gradient.");
   VectorXd gradient(state.size());
 
   for (const auto& subsystem : subsystems_) {
@@ -178,9 +197,6 @@ VectorXd ValueFunction::Gradient(const VectorXd& state) const {
 
 // Get the tracking error bound in this spatial dimension.
 double ValueFunction::TrackingBound(size_t dimension) const {
-  ROS_ERROR("Calling ValueFunction::TrackingBound.");
-  bool found = false;
-
   // Get corresponding full state dimension.
   const size_t full_dim = dynamics_->SpatialDimension(dimension);
 
@@ -207,37 +223,37 @@ double ValueFunction::TrackingBound(size_t dimension) const {
 double ValueFunction::
 SwitchingTrackingBound(
   size_t dimension, const ValueFunction::ConstPtr& value) const {
-  ROS_ERROR("Calling ValueFunction::SwitchingTrackingBound.");
-  // HACK! For now, just assume we have loaded the ValueFunction corresponding
-  // to the switching controller and take the regular tracking bound.
-  return TrackingBound(dimension);
+  // While switching, tracking error is only guaranteed to lie within the
+  // larger of the two bounds.
+  return std::max(TrackingBound(dimension), value->TrackingBound(dimension));
 }
 
-// Guaranteed distance in which a planner with the specified value function
-// can switch into this value function's safe set.
+// Guaranteed time in which a planner with the specified value function
+// can switch into this value function's tracking error bound. A value
+// function alone only guarantees this if the incoming bound is already
+// inside its own; otherwise it takes a switching grid (see
+// TimeVaryingValueFunction::SwitchingTime), so return an infinite time.
 double ValueFunction::
 GuaranteedSwitchingTime(
   size_t dimension, const ValueFunction::ConstPtr& incoming_value) const {
-  ROS_ERROR_THROTTLE(1.0, "Unimplemented method GuaranteedSwitchingTime.");
-  // HACK! Just returning a long time for now.
-  return 10.0;
+  if (incoming_value->TrackingBound(dimension) <= TrackingBound(dimension))
+    return 0.0;
+
+  return std::numeric_limits<double>::infinity();
 }
 
 // Guaranteed distance in which a planner with the specified value function
 // can switch into this value function's safe set.
 double ValueFunction::GuaranteedSwitchingDistance(
   size_t dimension, const ValueFunction::ConstPtr& incoming_value) const {
-  ROS_ERROR_THROTTLE(1.0, "Unimplemented method GuaranteedSwitchingDistance.");
-  // HACK! For now just return the tracking bound for this value function
-  // since this IS the switching value function.
-  return TrackingBound(dimension);
+  return MaxPlannerSpeed(dimension) *
+    GuaranteedSwitchingTime(dimension, incoming_value);
 }
 
 // Priority of the optimal control at the given state. This is a number
 // between 0 and 1, where 1 means the final control signal should be exactly
 // the optimal control signal computed by this value function.
 double ValueFunction::Priority(const VectorXd& state) const {
-  ROS_ERROR("Calling ValueFunction::Priority.");
   double priority = 0.0;
 
   // Take the max priority among all subsystems.
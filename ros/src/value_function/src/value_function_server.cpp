@@ -43,6 +43,12 @@
 
 #include <value_function/value_function_server.h>
 #include <utils/message_interfacing.h>
+#include <utils/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
 
 namespace meta {
 
@@ -69,50 +75,21 @@ bool ValueFunctionServer::Initialize(const ros::NodeHandle& n) {
   }
 
   // Set up dynamics.
-  NearHoverQuadNoYaw::ConstPtr dynamics =
-    NearHoverQuadNoYaw::Create(control_lower_vec, control_upper_vec);
-
-  // Create value functions.
-  if (numerical_mode_) {
-    for (size_t ii = 0; ii < value_dirs_.size(); ii++) {
-      const ValueFunction::ConstPtr value =
-        ValueFunction::Create(value_dirs_[ii], dynamics,
-                              state_dim_, control_dim_,
-                              static_cast<ValueFunctionId>(ii));
-
-      values_.push_back(value);
-    }
-  } else {
-    for (size_t ii = 0; ii < max_planner_speeds_.size(); ii++) {
-      // Generate inputs for AnalyticalPointMassValueFunction.
-      // SEMI-HACK! Manually feeding control/disturbance bounds.
-      const Vector3d max_planner_speed =
-        Vector3d::Constant(max_planner_speeds_[ii]);
-      const Vector3d max_velocity_disturbance =
-        Vector3d::Constant(max_velocity_disturbances_[ii]);
-      const Vector3d max_acceleration_disturbance =
-        Vector3d::Constant(max_acceleration_disturbances_[ii]);
-      const Vector3d velocity_expansion = Vector3d::Constant(0.1);
-
-      // Create analytical value function.
-      const AnalyticalPointMassValueFunction::ConstPtr value =
-        AnalyticalPointMassValueFunction::Create(max_planner_speed,
-                                                 max_velocity_disturbance,
-                                                 max_acceleration_disturbance,
-                                                 velocity_expansion,
-                                                 dynamics,
-                                                 static_cast<ValueFunctionId>(ii));
+  dynamics_ = NearHoverQuadNoYaw::Create(control_lower_vec, control_upper_vec);
 
-      values_.push_back(value);
-    }
-  }
-
-  // Make sure value functions were provided in pairs.
-  if (values_.size() % 2 != 0) {
-    ROS_ERROR("%s: Must provide value functions in pairs.", name_.c_str());
+  // Create value functions and precompute switching tables.
+  const ValueFunctionSet::ConstPtr set = LoadValueFunctionSet(n);
+  if (!set) {
+    ROS_ERROR("%s: Failed to load value functions.", name_.c_str());
     return false;
   }
 
+  std::atomic_store(&set_, set);
+
+  // Set up query statistics for all value functions. Reloads keep the number
+  // of value functions fixed, so statistics carry over across reloads.
+  stats_ = QueryStats::Create(set->values.size());
+
   initialized_ = true;
   return true;
 }
@@ -121,10 +98,16 @@ bool ValueFunctionServer::Initialize(const ros::NodeHandle& n) {
 bool ValueFunctionServer::OptimalControlCallback(
   value_function::OptimalControl::Request& req,
   value_function::OptimalControl::Response& res) {
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
   const VectorXd state = utils::Unpack(req.state);
-  const VectorXd control = values_[req.id]->OptimalControl(state);
+  const VectorXd control = set->values[req.id]->OptimalControlAt(state, req.time);
   res.control = utils::PackControl(control);
 
+  stats_->RecordQuery(req.id, QueryStats::OPTIMAL_CONTROL,
+                      (ros::WallTime::now() - start).toSec());
+
   return true;
 }
 
@@ -132,9 +115,15 @@ bool ValueFunctionServer::OptimalControlCallback(
 bool ValueFunctionServer::TrackingBoundCallback(
   value_function::TrackingBoundBox::Request& req,
   value_function::TrackingBoundBox::Response& res) {
-  res.x = values_[req.id]->TrackingBound(0);
-  res.y = values_[req.id]->TrackingBound(1);
-  res.z = values_[req.id]->TrackingBound(2);
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
+  res.x = set->values[req.id]->TrackingBoundAt(0, req.time);
+  res.y = set->values[req.id]->TrackingBoundAt(1, req.time);
+  res.z = set->values[req.id]->TrackingBoundAt(2, req.time);
+
+  stats_->RecordQuery(req.id, QueryStats::TRACKING_BOUND,
+                      (ros::WallTime::now() - start).toSec());
 
   return true;
 }
@@ -144,22 +133,24 @@ bool ValueFunctionServer::TrackingBoundCallback(
 bool ValueFunctionServer::SwitchingTrackingBoundCallback(
   value_function::SwitchingTrackingBoundBox::Request& req,
   value_function::SwitchingTrackingBoundBox::Response& res) {
-  // Check which mode we're in.
-  if (numerical_mode_) {
-    res.x = values_[req.to_id]->SwitchingTrackingBound(0, values_[req.from_id]);
-    res.y = values_[req.to_id]->SwitchingTrackingBound(1, values_[req.from_id]);
-    res.z = values_[req.to_id]->SwitchingTrackingBound(2, values_[req.from_id]);
-  } else {
-    const auto cast_to = std::static_pointer_cast<
-      const AnalyticalPointMassValueFunction>(values_[req.to_id]);
-    const auto cast_from = std::static_pointer_cast<
-      const AnalyticalPointMassValueFunction>(values_[req.from_id]);
-
-    res.x = cast_to->SwitchingTrackingBound(0, cast_from);
-    res.y = cast_to->SwitchingTrackingBound(1, cast_from);
-    res.z = cast_to->SwitchingTrackingBound(2, cast_from);
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
+  if (req.to_id >= set->values.size() || req.from_id >= set->values.size()) {
+    ROS_ERROR("%s: Invalid value function ID.", name_.c_str());
+    return false;
   }
 
+  res.x = set->switching_bound_table[
+    set->TableIndex(req.to_id, req.from_id, 0)];
+  res.y = set->switching_bound_table[
+    set->TableIndex(req.to_id, req.from_id, 1)];
+  res.z = set->switching_bound_table[
+    set->TableIndex(req.to_id, req.from_id, 2)];
+
+  stats_->RecordQuery(req.to_id, QueryStats::SWITCHING_TRACKING_BOUND,
+                      (ros::WallTime::now() - start).toSec());
+
   return true;
 }
 
@@ -168,22 +159,24 @@ bool ValueFunctionServer::SwitchingTrackingBoundCallback(
 bool ValueFunctionServer::GuaranteedSwitchingTimeCallback(
   value_function::GuaranteedSwitchingTime::Request& req,
   value_function::GuaranteedSwitchingTime::Response& res) {
-  // Check which mode we're in.
-  if (numerical_mode_) {
-    res.x = values_[req.to_id]->GuaranteedSwitchingTime(0, values_[req.from_id]);
-    res.y = values_[req.to_id]->GuaranteedSwitchingTime(1, values_[req.from_id]);
-    res.z = values_[req.to_id]->GuaranteedSwitchingTime(2, values_[req.from_id]);
-  } else {
-    const auto cast_to = std::static_pointer_cast<
-      const AnalyticalPointMassValueFunction>(values_[req.to_id]);
-    const auto cast_from = std::static_pointer_cast<
-      const AnalyticalPointMassValueFunction>(values_[req.from_id]);
-
-    res.x = cast_to->GuaranteedSwitchingTime(0, cast_from);
-    res.y = cast_to->GuaranteedSwitchingTime(1, cast_from);
-    res.z = cast_to->GuaranteedSwitchingTime(2, cast_from);
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
+  if (req.to_id >= set->values.size() || req.from_id >= set->values.size()) {
+    ROS_ERROR("%s: Invalid value function ID.", name_.c_str());
+    return false;
   }
 
+  res.x = set->switching_time_table[
+    set->TableIndex(req.to_id, req.from_id, 0)];
+  res.y = set->switching_time_table[
+    set->TableIndex(req.to_id, req.from_id, 1)];
+  res.z = set->switching_time_table[
+    set->TableIndex(req.to_id, req.from_id, 2)];
+
+  stats_->RecordQuery(req.to_id, QueryStats::SWITCHING_TIME,
+                      (ros::WallTime::now() - start).toSec());
+
   return true;
 }
 
@@ -192,22 +185,24 @@ bool ValueFunctionServer::GuaranteedSwitchingTimeCallback(
 bool ValueFunctionServer::GuaranteedSwitchingDistanceCallback(
   value_function::GuaranteedSwitchingDistance::Request& req,
   value_function::GuaranteedSwitchingDistance::Response& res) {
-  // Check which mode we're in.
-  if (numerical_mode_) {
-    res.x = values_[req.to_id]->GuaranteedSwitchingDistance(0, values_[req.from_id]);
-    res.y = values_[req.to_id]->GuaranteedSwitchingDistance(1, values_[req.from_id]);
-    res.z = values_[req.to_id]->GuaranteedSwitchingDistance(2, values_[req.from_id]);
-  } else {
-    const auto cast_to = std::static_pointer_cast<
-      const AnalyticalPointMassValueFunction>(values_[req.to_id]);
-    const auto cast_from = std::static_pointer_cast<
-      const AnalyticalPointMassValueFunction>(values_[req.from_id]);
-
-    res.x = cast_to->GuaranteedSwitchingDistance(0, cast_from);
-    res.y = cast_to->GuaranteedSwitchingDistance(1, cast_from);
-    res.z = cast_to->GuaranteedSwitchingDistance(2, cast_from);
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
+  if (req.to_id >= set->values.size() || req.from_id >= set->values.size()) {
+    ROS_ERROR("%s: Invalid value function ID.", name_.c_str());
+    return false;
   }
 
+  res.x = set->switching_distance_table[
+    set->TableIndex(req.to_id, req.from_id, 0)];
+  res.y = set->switching_distance_table[
+    set->TableIndex(req.to_id, req.from_id, 1)];
+  res.z = set->switching_distance_table[
+    set->TableIndex(req.to_id, req.from_id, 2)];
+
+  stats_->RecordQuery(req.to_id, QueryStats::SWITCHING_DISTANCE,
+                      (ros::WallTime::now() - start).toSec());
+
   return true;
 }
 
@@ -217,8 +212,16 @@ bool ValueFunctionServer::GuaranteedSwitchingDistanceCallback(
 bool ValueFunctionServer::PriorityCallback(
   value_function::Priority::Request& req,
   value_function::Priority::Response& res) {
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
   const VectorXd state = utils::Unpack(req.state);
-  res.priority = values_[req.id]->Priority(state);
+  res.priority = set->values[req.id]->PriorityAt(state, req.time);
+
+  stats_->RecordPriority(req.id, res.priority);
+  stats_->RecordQuery(req.id, QueryStats::PRIORITY,
+                      (ros::WallTime::now() - start).toSec());
+
   return true;
 }
 
@@ -226,9 +229,15 @@ bool ValueFunctionServer::PriorityCallback(
 bool ValueFunctionServer::MaxPlannerSpeedCallback(
   value_function::GeometricPlannerSpeed::Request& req,
   value_function::GeometricPlannerSpeed::Response& res) {
-  res.x = values_[req.id]->MaxPlannerSpeed(0);
-  res.y = values_[req.id]->MaxPlannerSpeed(1);
-  res.z = values_[req.id]->MaxPlannerSpeed(2);
+  const ros::WallTime start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
+  res.x = set->values[req.id]->MaxPlannerSpeed(0);
+  res.y = set->values[req.id]->MaxPlannerSpeed(1);
+  res.z = set->values[req.id]->MaxPlannerSpeed(2);
+  stats_->RecordQuery(req.id, QueryStats::MAX_PLANNER_SPEED,
+                      (ros::WallTime::now() - start).toSec());
+
   return true;
 }
 
@@ -237,40 +246,91 @@ bool ValueFunctionServer::MaxPlannerSpeedCallback(
 bool ValueFunctionServer::BestPossibleTimeCallback(
   value_function::GeometricPlannerTime::Request& req,
   value_function::GeometricPlannerTime::Response& res) {
+  const ros::WallTime query_start = ros::WallTime::now();
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
   const Vector3d start = utils::Unpack(req.start);
   const Vector3d stop = utils::Unpack(req.stop);
-  res.time = values_[req.id]->BestPossibleTime(start, stop);
+  res.time = set->values[req.id]->BestPossibleTime(start, stop);
+
+  stats_->RecordQuery(req.id, QueryStats::BEST_POSSIBLE_TIME,
+                      (ros::WallTime::now() - query_start).toSec());
 
   return true;
 }
 
-// Load parameters.
-bool ValueFunctionServer::LoadParameters(const ros::NodeHandle& n) {
-  ros::NodeHandle nl(n);
-
-  // Numerical mode flag and associated parameters for loading value functions.
-  if (!nl.getParam("numerical_mode", numerical_mode_)) return false;
-  if (!nl.getParam("planners/value_directories", value_dirs_)) return false;
-
-  if (value_dirs_.size() == 0) {
-    ROS_ERROR("%s: Must specify at least one value function directory.",
-              name_.c_str());
+// Re-read value function parameters and rebuild the value function set on
+// a background thread.
+bool ValueFunctionServer::ReloadCallback(
+  value_function::ReloadValueFunctions::Request& req,
+  value_function::ReloadValueFunctions::Response& res) {
+  if (!initialized_) {
+    ROS_ERROR("%s: Server was not initialized.", name_.c_str());
     return false;
   }
 
-  if (!nl.getParam("planners/max_speeds", max_planner_speeds_)) return false;
-  if (!nl.getParam("planners/max_velocity_disturbances",
-                   max_velocity_disturbances_)) return false;
-  if (!nl.getParam("planners/max_acceleration_disturbances",
-                   max_acceleration_disturbances_)) return false;
+  if (reloading_.exchange(true)) {
+    res.accepted = false;
+    res.message = "A reload is already in progress.";
+    return true;
+  }
 
-  if (max_planner_speeds_.size() != max_velocity_disturbances_.size() ||
-      max_planner_speeds_.size() != max_acceleration_disturbances_.size()) {
-    ROS_ERROR("%s: Must specify max speed/velocity/acceleration disturbances.",
+  // The previous reload thread has finished, since it clears 'reloading_'
+  // as its last action.
+  if (reload_thread_.joinable())
+    reload_thread_.join();
+
+  reload_thread_ = std::thread(&ValueFunctionServer::Reload, this);
+
+  res.accepted = true;
+  res.message = "Reloading value functions.";
+  return true;
+}
+
+// Body of the background reload thread.
+void ValueFunctionServer::Reload() {
+  const ros::WallTime start = ros::WallTime::now();
+  ROS_INFO("%s: Reloading value functions.", name_.c_str());
+
+  // An exception escaping this thread would terminate the server, so treat
+  // one like any other failure to load.
+  ValueFunctionSet::ConstPtr set;
+  try {
+    set = LoadValueFunctionSet(node_);
+  } catch (const std::exception& e) {
+    ROS_ERROR("%s: Exception while reloading: %s", name_.c_str(), e.what());
+    set = nullptr;
+  }
+
+  if (!set) {
+    ROS_ERROR("%s: Reload failed. Still serving the previous value functions.",
               name_.c_str());
-    return false;
+    reloading_ = false;
+    return;
   }
 
+  // Swap. Callbacks already holding the old set finish with it, and it is
+  // freed when the last of them returns.
+  std::atomic_store(&set_, set);
+  generation_++;
+
+  ROS_INFO("%s: Swapped in %zu value functions (generation %zu) after %f s.",
+           name_.c_str(), set->values.size(), generation_,
+           (ros::WallTime::now() - start).toSec());
+
+  // Tell clients to drop anything they have cached from the old set.
+  meta_planner_msgs::ValueFunctionsReloaded msg;
+  msg.generation = generation_;
+  msg.num_values = set->values.size();
+  reloaded_pub_.publish(msg);
+
+  reloading_ = false;
+}
+
+// Load parameters.
+bool ValueFunctionServer::LoadParameters(const ros::NodeHandle& n) {
+  ros::NodeHandle nl(n);
+
   // Dimensions and control bounds.
   int dimension = 1;
   if (!nl.getParam("control/dim", dimension)) return false;
@@ -303,6 +363,15 @@ bool ValueFunctionServer::LoadParameters(const ros::NodeHandle& n) {
                    max_planner_speed_name_)) return false;
   if (!nl.getParam("srv/best_possible_time",
                    best_possible_time_name_)) return false;
+  nl.param("srv/reload", reload_name_,
+           std::string("/reload_value_functions"));
+  nl.param("topics/reloaded", reloaded_topic_,
+           std::string("/value_functions_reloaded"));
+
+  // Diagnostics. A non-positive period disables publishing.
+  nl.param("diagnostics/period", diagnostics_period_, 1.0);
+  nl.param("topics/diagnostics", diagnostics_topic_,
+           std::string("/diagnostics"));
 
   return true;
 }
@@ -334,8 +403,471 @@ bool ValueFunctionServer::RegisterCallbacks(const ros::NodeHandle& n) {
   best_possible_time_srv_ = nl.advertiseService(
     best_possible_time_name_,
     &ValueFunctionServer::BestPossibleTimeCallback, this);
+  reload_srv_ = nl.advertiseService(
+    reload_name_, &ValueFunctionServer::ReloadCallback, this);
+
+  // Reload notifications are latched so that clients connecting later still
+  // learn the current generation.
+  reloaded_pub_ = nl.advertise<meta_planner_msgs::ValueFunctionsReloaded>(
+    reloaded_topic_.c_str(), 1, true);
+
+  // Keep a handle for re-reading parameters on reload.
+  node_ = nl;
+
+  // Diagnostics publisher and timer.
+  if (diagnostics_period_ > 0.0) {
+    diagnostics_pub_ = nl.advertise<diagnostic_msgs::DiagnosticArray>(
+      diagnostics_topic_.c_str(), 1, false);
+
+    diagnostics_timer_ = nl.createTimer(
+      ros::Duration(diagnostics_period_),
+      &ValueFunctionServer::DiagnosticsTimerCallback, this);
+  }
+
+  return true;
+}
+
+// Read value function parameters and build a new set from them.
+ValueFunctionServer::ValueFunctionSet::ConstPtr
+ValueFunctionServer::LoadValueFunctionSet(const ros::NodeHandle& n) const {
+  ros::NodeHandle nl(n);
+
+  // Numerical mode flag and associated parameters for both analytic
+  // and numerical modes.
+  bool numerical_mode = false;
+  bool surrogate_mode = false;
+  bool time_varying_mode = false;
+  std::vector<std::string> value_dirs;
+  std::vector<double> max_planner_speeds;
+  std::vector<double> max_velocity_disturbances;
+  std::vector<double> max_acceleration_disturbances;
+
+  if (!nl.getParam("numerical_mode", numerical_mode)) return nullptr;
+  nl.param("surrogate_mode", surrogate_mode, false);
+  nl.param("time_varying_mode", time_varying_mode, false);
+  if (surrogate_mode && time_varying_mode) {
+    ROS_ERROR("%s: Surrogate and time-varying modes are mutually exclusive.",
+              name_.c_str());
+    return nullptr;
+  }
+
+  if (!nl.getParam("planners/value_directories", value_dirs)) return nullptr;
+
+  if (value_dirs.size() == 0) {
+    ROS_ERROR("%s: Must specify at least one value function directory.",
+              name_.c_str());
+    return nullptr;
+  }
+
+  if (!nl.getParam("planners/max_speeds", max_planner_speeds))
+    return nullptr;
+  if (!nl.getParam("planners/max_velocity_disturbances",
+                   max_velocity_disturbances)) return nullptr;
+  if (!nl.getParam("planners/max_acceleration_disturbances",
+                   max_acceleration_disturbances)) return nullptr;
+
+  if (max_planner_speeds.size() != max_velocity_disturbances.size() ||
+      max_planner_speeds.size() != max_acceleration_disturbances.size()) {
+    ROS_ERROR("%s: Must specify max speed/velocity/acceleration disturbances.",
+              name_.c_str());
+    return nullptr;
+  }
+
+  std::shared_ptr<ValueFunctionSet> set(new ValueFunctionSet);
+  set->numerical_mode = numerical_mode;
+
+  // Create value functions.
+  if (numerical_mode) {
+    for (size_t ii = 0; ii < value_dirs.size(); ii++) {
+      // Surrogates replace the grids with fitted polynomials (see the
+      // surrogate_value_function_fitter executable). Time-varying value
+      // functions replace them with time-indexed slices (see the
+      // tv_value_function_converter executable).
+      const ValueFunction::ConstPtr value = CreateNumericalValueFunction(
+        value_dirs[ii], surrogate_mode, time_varying_mode, dynamics_,
+        state_dim_, control_dim_, static_cast<ValueFunctionId>(ii));
+      if (!value) {
+        ROS_ERROR("%s: Failed to load value function from %s.",
+                  name_.c_str(), value_dirs[ii].c_str());
+        return nullptr;
+      }
+
+      set->values.push_back(value);
+    }
+  } else {
+    for (size_t ii = 0; ii < max_planner_speeds.size(); ii++) {
+      // Generate inputs for AnalyticalPointMassValueFunction.
+      // SEMI-HACK! Manually feeding control/disturbance bounds.
+      const Vector3d max_planner_speed =
+        Vector3d::Constant(max_planner_speeds[ii]);
+      const Vector3d max_velocity_disturbance =
+        Vector3d::Constant(max_velocity_disturbances[ii]);
+      const Vector3d max_acceleration_disturbance =
+        Vector3d::Constant(max_acceleration_disturbances[ii]);
+      const Vector3d velocity_expansion = Vector3d::Constant(0.1);
+
+      // Create analytical value function.
+      const AnalyticalPointMassValueFunction::ConstPtr value =
+        AnalyticalPointMassValueFunction::Create(max_planner_speed,
+                                                 max_velocity_disturbance,
+                                                 max_acceleration_disturbance,
+                                                 velocity_expansion,
+                                                 dynamics_,
+                                                 static_cast<ValueFunctionId>(ii));
+
+      set->values.push_back(value);
+    }
+  }
+
+  // Make sure value functions were provided in pairs.
+  if (set->values.size() % 2 != 0) {
+    ROS_ERROR("%s: Must provide value functions in pairs.", name_.c_str());
+    return nullptr;
+  }
+
+  // Precompute switching tables, from the switching grids in numerical mode.
+  SwitchingGridMap grids;
+  if (numerical_mode)
+    grids = LoadSwitchingGrids(value_dirs);
+
+  BuildSwitchingTables(*set, value_dirs, grids);
+
+  if (!ValidateValueFunctionSet(*set))
+    return nullptr;
+
+  return set;
+}
+
+// Create a numerical value function from the given directory. Returns
+// null rather than throwing if it could not be loaded.
+ValueFunction::ConstPtr ValueFunctionServer::CreateNumericalValueFunction(
+  const std::string& directory, bool surrogate_mode, bool time_varying_mode,
+  const Dynamics::ConstPtr& dynamics, size_t x_dim, size_t u_dim,
+  ValueFunctionId id) {
+  ValueFunction::ConstPtr value;
+
+  try {
+    if (surrogate_mode)
+      value = SurrogateValueFunction::Create(
+        directory, dynamics, x_dim, u_dim, id);
+    else if (time_varying_mode)
+      value = TimeVaryingValueFunction::Create(
+        directory, dynamics, x_dim, u_dim, id);
+    else
+      value = ValueFunction::Create(directory, dynamics, x_dim, u_dim, id);
+  } catch (const std::exception& e) {
+    ROS_ERROR("Exception while loading value function from %s: %s",
+              directory.c_str(), e.what());
+    return nullptr;
+  }
+
+  if (!value->IsInitialized())
+    return nullptr;
+
+  return value;
+}
+
+// Parse a value directory into the planner speeds (in tenths) it tracks
+// from and to.
+bool ValueFunctionServer::ParseSpeeds(const std::string& directory,
+                                      int& from_speed, int& to_speed) {
+  // Only a trailing '/' may follow the pattern.
+  int consumed = -1;
+  const auto matched = [&directory, &consumed]() {
+    return consumed >= 0 &&
+      (static_cast<size_t>(consumed) == directory.size() ||
+       directory.substr(consumed) == "/");
+  };
+
+  if (std::sscanf(directory.c_str(), "speed_%d_tenths_to_%d_tenths%n",
+                  &from_speed, &to_speed, &consumed) == 2 && matched())
+    return true;
+
+  consumed = -1;
+  if (std::sscanf(directory.c_str(), "speed_%d_tenths%n",
+                  &from_speed, &consumed) == 1 && matched()) {
+    to_speed = from_speed;
+    return true;
+  }
+
+  return false;
+}
+
+// Load the switching grids between consecutive planner speeds among these
+// value directories.
+ValueFunctionServer::SwitchingGridMap ValueFunctionServer::
+LoadSwitchingGrids(const std::vector<std::string>& value_dirs) const {
+  std::vector<int> speeds;
+  for (const auto& directory : value_dirs) {
+    int from_speed = 0, to_speed = 0;
+    if (!ParseSpeeds(directory, from_speed, to_speed))
+      continue;
+
+    speeds.push_back(from_speed);
+    speeds.push_back(to_speed);
+  }
+
+  std::sort(speeds.begin(), speeds.end(), std::greater<int>());
+  speeds.erase(std::unique(speeds.begin(), speeds.end()), speeds.end());
+
+  // Grids hold every time slice of the backward reachable set, so they are
+  // always read as time-varying value functions (see
+  // tv_value_function_converter). They are only needed to build the tables.
+  SwitchingGridMap grids;
+  for (size_t ii = 0; ii + 1 < speeds.size(); ii++) {
+    const std::string directory = "speed_" + std::to_string(speeds[ii]) +
+      "_tenths_to_" + std::to_string(speeds[ii + 1]) + "_tenths/";
+    const ValueFunction::ConstPtr value = CreateNumericalValueFunction(
+      directory, false, true, dynamics_, state_dim_, control_dim_,
+      std::numeric_limits<ValueFunctionId>::max());
+    if (!value) {
+      ROS_WARN("%s: No switching grid in %s.", name_.c_str(),
+               directory.c_str());
+      continue;
+    }
+
+    SwitchingGrid& grid = grids[speeds[ii]];
+    grid.to_speed = speeds[ii + 1];
+    grid.value =
+      std::static_pointer_cast<const TimeVaryingValueFunction>(value);
+  }
+
+  return grids;
+}
+
+// Compute all-pairs switching bound/time/distance tables so that later
+// queries are a single lookup.
+void ValueFunctionServer::
+BuildSwitchingTables(ValueFunctionSet& set,
+                     const std::vector<std::string>& value_dirs,
+                     const SwitchingGridMap& grids) const {
+  const std::vector<ValueFunction::ConstPtr>& values = set.values;
+  const size_t num_values = values.size();
+  set.switching_bound_table.assign(num_values * num_values * 3, 0.0);
+  set.switching_time_table.assign(num_values * num_values * 3, 0.0);
+  set.switching_distance_table.assign(num_values * num_values * 3, 0.0);
+
+  const ros::WallTime start = ros::WallTime::now();
+
+  // Each (to, from) pair writes to its own table entries, so pairs can be
+  // computed in parallel without locking.
+  ThreadPool::Shared().ParallelFor(0, num_values * num_values, [&](size_t kk) {
+      const ValueFunctionId to = kk / num_values;
+      const ValueFunctionId from = kk % num_values;
+
+      for (size_t ii = 0; ii < 3; ii++) {
+        const size_t index = set.TableIndex(to, from, ii);
+
+        // Check which mode we're in.
+        if (set.numerical_mode) {
+          double bound = 0.0, time = 0.0;
+          if (!NumericalSwitching(*values[to], *values[from], value_dirs[to],
+                                  value_dirs[from], grids, ii, bound, time)) {
+            // Caught by validation, so the set is never served.
+            bound = std::numeric_limits<double>::infinity();
+            time = std::numeric_limits<double>::infinity();
+          }
+
+          set.switching_bound_table[index] = bound;
+          set.switching_time_table[index] = time;
+          set.switching_distance_table[index] =
+            values[to]->MaxPlannerSpeed(ii) * time;
+        } else {
+          const auto cast_to = std::static_pointer_cast<
+            const AnalyticalPointMassValueFunction>(values[to]);
+          const auto cast_from = std::static_pointer_cast<
+            const AnalyticalPointMassValueFunction>(values[from]);
+
+          set.switching_bound_table[index] =
+            cast_to->SwitchingTrackingBound(ii, cast_from);
+          set.switching_time_table[index] =
+            cast_to->GuaranteedSwitchingTime(ii, cast_from);
+          set.switching_distance_table[index] =
+            cast_to->GuaranteedSwitchingDistance(ii, cast_from);
+        }
+      }
+    });
+
+  ROS_INFO("%s: Built switching tables for %zu value functions in %f s.",
+           name_.c_str(), num_values,
+           (ros::WallTime::now() - start).toSec());
+}
+
+// Switching bound and time in one spatial dimension for a switch from the
+// 'from' value into the 'to' value.
+bool ValueFunctionServer::
+NumericalSwitching(const ValueFunction& to, const ValueFunction& from,
+                   const std::string& to_dir, const std::string& from_dir,
+                   const SwitchingGridMap& grids, size_t dimension,
+                   double& bound, double& time) const {
+  const double from_bound = from.TrackingBound(dimension);
+  const double to_bound = to.TrackingBound(dimension);
+
+  // Already inside, so no switching grid is needed.
+  if (from_bound <= to_bound) {
+    bound = to_bound;
+    time = 0.0;
+    return true;
+  }
+
+  int from_speed = 0, to_speed = 0, unused = 0;
+  if (!ParseSpeeds(from_dir, from_speed, unused) ||
+      !ParseSpeeds(to_dir, unused, to_speed) || from_speed <= to_speed) {
+    ROS_ERROR("%s: Cannot find switching grids from %s to %s.",
+              name_.c_str(), from_dir.c_str(), to_dir.c_str());
+    return false;
+  }
+
+  // Walk down the grids. While switching, the error stays inside the final
+  // (largest) level set of each grid; once a grid's switching time has
+  // passed, it is inside that grid's first level set, the slower planner's
+  // tracking error bound.
+  bound = from_bound;
+  time = 0.0;
+  double incoming_bound = from_bound;
+  for (int speed = from_speed; speed > to_speed; ) {
+    const auto iter = grids.find(speed);
+    if (iter == grids.end()) {
+      ROS_ERROR("%s: Missing switching grid from speed %d tenths.",
+                name_.c_str(), speed);
+      return false;
+    }
+
+    const TimeVaryingValueFunction& grid = *iter->second.value;
+    const double grid_time = grid.SwitchingTime(dimension, incoming_bound);
+    if (!std::isfinite(grid_time)) {
+      ROS_ERROR("%s: Switching grid from speed %d tenths does not cover "
+                "a bound of %f in dimension %zu.", name_.c_str(), speed,
+                incoming_bound, dimension);
+      return false;
+    }
+
+    bound = std::max(bound, grid.LevelSetBoundAt(dimension, -1.0));
+    time += grid_time;
+    incoming_bound = grid.LevelSetBoundAt(dimension, 0.0);
+    speed = iter->second.to_speed;
+  }
 
   return true;
 }
 
+// Check that a newly built set may be served.
+bool ValueFunctionServer::
+ValidateValueFunctionSet(const ValueFunctionSet& set) const {
+  if (set.values.empty() || set.values.size() % 2 != 0) {
+    ROS_ERROR("%s: Must provide value functions in pairs.", name_.c_str());
+    return false;
+  }
+
+  for (size_t ii = 0; ii < set.values.size(); ii++) {
+    if (!set.values[ii] || !set.values[ii]->IsInitialized()) {
+      ROS_ERROR("%s: Value function %zu was not initialized.",
+                name_.c_str(), ii);
+      return false;
+    }
+  }
+
+  // Clients map planners to value function IDs when they start up, so a
+  // reload may change the value functions but not how many there are.
+  const ValueFunctionSet::ConstPtr current = CurrentSet();
+  if (current && current->values.size() != set.values.size()) {
+    ROS_ERROR("%s: Reload would change the number of value functions "
+              "from %zu to %zu.", name_.c_str(), current->values.size(),
+              set.values.size());
+    return false;
+  }
+
+  for (size_t ii = 0; ii < set.switching_bound_table.size(); ii++) {
+    const double bound = set.switching_bound_table[ii];
+    const double time = set.switching_time_table[ii];
+    const double distance = set.switching_distance_table[ii];
+
+    if (!std::isfinite(bound) || !std::isfinite(time) ||
+        !std::isfinite(distance) ||
+        bound < 0.0 || time < 0.0 || distance < 0.0) {
+      ROS_ERROR("%s: Invalid switching table entry %zu "
+                "(bound %f, time %f, distance %f).", name_.c_str(), ii,
+                bound, time, distance);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Periodically publish query statistics as diagnostics.
+void ValueFunctionServer::DiagnosticsTimerCallback(const ros::TimerEvent& e) {
+  if (!initialized_)
+    return;
+
+  const ValueFunctionSet::ConstPtr set = CurrentSet();
+
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+
+  for (size_t ii = 0; ii < set->values.size(); ii++) {
+    const ValueFunctionId id = static_cast<ValueFunctionId>(ii);
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = name_ + "/value_" + std::to_string(ii);
+    status.hardware_id = name_;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = "OK";
+
+    diagnostic_msgs::KeyValue kv;
+
+    // Query counts and latencies (microseconds).
+    for (size_t jj = 0; jj < QueryStats::NUM_QUERY_TYPES; jj++) {
+      const QueryStats::QueryType type =
+        static_cast<QueryStats::QueryType>(jj);
+      const size_t count = stats_->NumQueries(id, type);
+      if (count == 0)
+        continue;
+
+      const std::string query = QueryStats::QueryName(type);
+
+      kv.key = query + "/count";
+      kv.value = std::to_string(count);
+      status.values.push_back(kv);
+
+      kv.key = query + "/mean_us";
+      kv.value = std::to_string(1e6 * stats_->MeanLatency(id, type));
+      status.values.push_back(kv);
+
+      kv.key = query + "/p99_us";
+      kv.value = std::to_string(1e6 * stats_->LatencyQuantile(id, type, 0.99));
+      status.values.push_back(kv);
+
+      kv.key = query + "/max_us";
+      kv.value = std::to_string(1e6 * stats_->MaxLatency(id, type));
+      status.values.push_back(kv);
+    }
+
+    // Out-of-grid counts per state dimension.
+    for (size_t jj = 0; jj < state_dim_; jj++) {
+      const size_t count = set->values[ii]->OutOfGridCount(jj);
+      if (count == 0)
+        continue;
+
+      kv.key = "out_of_grid/dim_" + std::to_string(jj);
+      kv.value = std::to_string(count);
+      status.values.push_back(kv);
+
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = "Queries outside of grid.";
+    }
+
+    // Priority distribution.
+    for (size_t jj = 0; jj < QueryStats::kNumPriorityBuckets; jj++) {
+      kv.key = "priority/bucket_" + std::to_string(jj);
+      kv.value = std::to_string(stats_->PriorityBucket(id, jj));
+      status.values.push_back(kv);
+    }
+
+    msg.status.push_back(status);
+  }
+
+  diagnostics_pub_.publish(msg);
+}
+
 } //\namespace meta
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the QueryStats class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/query_stats.h>
+
+#include <gtest/gtest.h>
+
+using namespace meta;
+
+// Test that queries are counted and binned by latency.
+TEST(QueryStats, TestLatency) {
+  const QueryStats::Ptr stats = QueryStats::Create(2);
+
+  // 0.5 us, 3 us, and 100 us.
+  stats->RecordQuery(1, QueryStats::PRIORITY, 0.5e-6);
+  stats->RecordQuery(1, QueryStats::PRIORITY, 3e-6);
+  stats->RecordQuery(1, QueryStats::PRIORITY, 100e-6);
+
+  EXPECT_EQ(stats->NumQueries(1, QueryStats::PRIORITY), 3);
+  EXPECT_EQ(stats->NumQueries(0, QueryStats::PRIORITY), 0);
+  EXPECT_EQ(stats->NumQueries(1, QueryStats::OPTIMAL_CONTROL), 0);
+
+  EXPECT_EQ(stats->LatencyBucket(1, QueryStats::PRIORITY, 0), 1);
+  EXPECT_EQ(stats->LatencyBucket(1, QueryStats::PRIORITY, 2), 1);
+  EXPECT_EQ(stats->LatencyBucket(1, QueryStats::PRIORITY, 7), 1);
+
+  EXPECT_NEAR(stats->MeanLatency(1, QueryStats::PRIORITY),
+              (0.5e-6 + 3e-6 + 100e-6) / 3.0, 1e-9);
+  EXPECT_NEAR(stats->MaxLatency(1, QueryStats::PRIORITY), 100e-6, 1e-9);
+  EXPECT_NEAR(stats->LatencyQuantile(1, QueryStats::PRIORITY, 0.5),
+              4e-6, 1e-12);
+
+  // Unknown IDs are ignored.
+  stats->RecordQuery(2, QueryStats::PRIORITY, 1.0);
+  EXPECT_EQ(stats->NumQueries(2, QueryStats::PRIORITY), 0);
+}
+
+// Test that priorities are binned into the right buckets.
+TEST(QueryStats, TestPriority) {
+  const QueryStats::Ptr stats = QueryStats::Create(1);
+
+  stats->RecordPriority(0, 0.0);
+  stats->RecordPriority(0, 0.55);
+  stats->RecordPriority(0, 1.0);
+  stats->RecordPriority(0, 2.0);
+
+  EXPECT_EQ(stats->PriorityBucket(0, 0), 1);
+  EXPECT_EQ(stats->PriorityBucket(0, 5), 1);
+  EXPECT_EQ(stats->PriorityBucket(0, QueryStats::kNumPriorityBuckets - 1), 2);
+}
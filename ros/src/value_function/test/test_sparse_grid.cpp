@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the SparseGrid class, and sparse grid subsystems in the
+// SubsystemValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/sparse_grid.h>
+#include <value_function/subsystem_value_function.h>
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <random>
+#include <set>
+#include <stdio.h>
+
+using namespace meta;
+
+// Interpolate f (with num_fields outputs) on a sparse grid.
+template <typename F>
+SparseGrid::ConstPtr Interpolate(size_t num_dims, size_t level,
+                                 size_t num_fields, const F& f) {
+  const std::vector<double> points = SparseGrid::Points(num_dims, level);
+  std::vector<double> values(points.size() / num_dims * num_fields);
+  for (size_t ii = 0; ii < points.size() / num_dims; ii++)
+    f(&points[ii * num_dims], &values[ii * num_fields]);
+
+  return SparseGrid::Interpolate(num_dims, level, num_fields, values);
+}
+
+// Test the layout of the grid points.
+TEST(SparseGrid, TestPoints) {
+  // Level vectors (1, 1), (1, 2), (1, 3), (2, 1), (2, 2), (3, 1).
+  EXPECT_EQ(SparseGrid::NumPoints(2, 3), 17);
+  EXPECT_EQ(SparseGrid::NumPoints(6, 8), 141569);
+  EXPECT_EQ(SparseGrid::NumPoints(0, 3), 0);
+
+  const std::vector<double> points = SparseGrid::Points(3, 5);
+  ASSERT_EQ(points.size(), 3 * SparseGrid::NumPoints(3, 5));
+
+  // The first point is the center, and all points are distinct and
+  // strictly inside the unit cube.
+  EXPECT_EQ(points[0], 0.5);
+  EXPECT_EQ(points[1], 0.5);
+  EXPECT_EQ(points[2], 0.5);
+
+  std::set< std::vector<double> > unique;
+  for (size_t ii = 0; ii < points.size(); ii += 3) {
+    for (size_t jj = 0; jj < 3; jj++) {
+      EXPECT_GT(points[ii + jj], 0.0);
+      EXPECT_LT(points[ii + jj], 1.0);
+    }
+
+    unique.insert(std::vector<double>(points.begin() + ii,
+                                      points.begin() + ii + 3));
+  }
+
+  EXPECT_EQ(unique.size(), points.size() / 3);
+}
+
+// Test that multilinear functions are represented exactly, everywhere in
+// the cube, and several fields are evaluated together.
+TEST(SparseGrid, TestMultilinear) {
+  const auto f = [](const double* z, double* out) {
+    out[0] = 1.0 + 2.0 * z[0] - z[1] + 0.5 * z[0] * z[2] -
+      3.0 * z[0] * z[1] * z[3];
+    out[1] = z[3] - 4.0 * z[1] * z[2];
+  };
+
+  const SparseGrid::ConstPtr grid = Interpolate(4, 5, 2, f);
+  ASSERT_TRUE(grid->IsInitialized());
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  for (size_t ii = 0; ii < 1000; ii++) {
+    double z[4], expected[2], actual[2];
+    for (size_t jj = 0; jj < 4; jj++)
+      z[jj] = unit(rng);
+
+    f(z, expected);
+    grid->Evaluate(z, actual);
+    EXPECT_NEAR(actual[0], expected[0], 1e-12);
+    EXPECT_NEAR(actual[1], expected[1], 1e-12);
+
+    // Just the first field.
+    actual[1] = 17.0;
+    grid->Evaluate(z, actual, 1);
+    EXPECT_NEAR(actual[0], expected[0], 1e-12);
+    EXPECT_EQ(actual[1], 17.0);
+  }
+
+  // Outside the cube, points are clamped.
+  const double outside[4] = { 1.5, -0.5, 0.25, 0.75 };
+  const double clamped[4] = { 1.0, 0.0, 0.25, 0.75 };
+  double expected[2], actual[2];
+  f(clamped, expected);
+  grid->Evaluate(outside, actual);
+  EXPECT_NEAR(actual[0], expected[0], 1e-12);
+}
+
+// Test that smooth functions are interpolated at the grid points, and that
+// the error decreases with the level.
+TEST(SparseGrid, TestConvergence) {
+  const auto f = [](const double* z, double* out) {
+    out[0] = std::sin(3.0 * z[0]) * std::cos(2.0 * z[1]) + z[2] * z[2];
+  };
+
+  const std::vector<double> points = SparseGrid::Points(3, 6);
+  const SparseGrid::ConstPtr fine = Interpolate(3, 6, 1, f);
+  const SparseGrid::ConstPtr coarse = Interpolate(3, 3, 1, f);
+  ASSERT_TRUE(fine->IsInitialized());
+  ASSERT_TRUE(coarse->IsInitialized());
+
+  for (size_t ii = 0; ii < points.size(); ii += 3) {
+    double expected, actual;
+    f(&points[ii], &expected);
+    fine->Evaluate(&points[ii], &actual);
+    EXPECT_NEAR(actual, expected, 1e-12);
+  }
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  double fine_error = 0.0;
+  double coarse_error = 0.0;
+  for (size_t ii = 0; ii < 1000; ii++) {
+    double z[3], expected, actual;
+    for (size_t jj = 0; jj < 3; jj++)
+      z[jj] = unit(rng);
+
+    f(z, &expected);
+    fine->Evaluate(z, &actual);
+    fine_error = std::max(fine_error, std::abs(actual - expected));
+    coarse->Evaluate(z, &actual);
+    coarse_error = std::max(coarse_error, std::abs(actual - expected));
+  }
+
+  EXPECT_LT(fine_error, 0.05);
+  EXPECT_LT(fine_error, 0.25 * coarse_error);
+}
+
+// Test that data of the wrong size is rejected.
+TEST(SparseGrid, TestBadData) {
+  const SparseGrid::ConstPtr grid =
+    SparseGrid::Create(2, 3, 1, std::vector<double>(16, 0.0));
+  EXPECT_FALSE(grid->IsInitialized());
+}
+
+// Test a sparse grid subsystem over [-2, 2] x [-1, 3] (subsystem dimensions
+// 0 and 2 of a 3D state), written and read back from file.
+TEST(SparseGrid, TestSubsystemValueFunction) {
+  const std::string file_name = "/tmp/test_sparse_grid.sgvf";
+  const std::vector<double> lower = { -2.0, -1.0 };
+  const std::vector<double> upper = { 2.0, 3.0 };
+
+  // Bilinear, so the gradient is represented exactly too.
+  const auto value = [](double x, double y) {
+    return 1.0 + 0.5 * x - y + 0.25 * x * y;
+  };
+
+  const auto f = [&](const double* z, double* out) {
+    const double x = lower[0] + 4.0 * z[0];
+    const double y = lower[1] + 4.0 * z[1];
+    out[0] = value(x, y);
+    out[1] = 0.5 + 0.25 * y;
+    out[2] = -1.0 + 0.25 * x;
+  };
+
+  const SparseGrid::ConstPtr grid = Interpolate(2, 4, 3, f);
+  ASSERT_TRUE(SubsystemValueFunction::SaveSparseGrid(
+    file_name, { 0, 2 }, { 0 }, lower, upper, std::vector<double>(3, 1.0),
+    0.0, 1.0, { 0.5, 0.25 }, *grid));
+
+  const SubsystemValueFunction::ConstPtr subsystem =
+    SubsystemValueFunction::Create(file_name);
+  ASSERT_TRUE(subsystem->IsInitialized());
+  EXPECT_TRUE(subsystem->IsSparse());
+  EXPECT_EQ(subsystem->StateDimensions()[1], 2);
+  EXPECT_EQ(subsystem->ControlDimensions()[0], 0);
+  EXPECT_NEAR(subsystem->TrackingBound(1), 0.25, 1e-12);
+  EXPECT_NEAR(subsystem->MaxPlannerSpeed(2), 1.0, 1e-12);
+
+  VectorXd state(3);
+  state << 0.33, 100.0, 1.7;
+  EXPECT_NEAR(subsystem->Value(state), value(0.33, 1.7), 1e-9);
+
+  VectorXd gradient = subsystem->Gradient(state);
+  EXPECT_NEAR(gradient(0), 0.5 + 0.25 * 1.7, 1e-9);
+  EXPECT_NEAR(gradient(1), -1.0 + 0.25 * 0.33, 1e-9);
+  EXPECT_EQ(subsystem->OutOfGridCount(0), 0);
+
+  // Off the grid in x: extrapolate along the edge gradient.
+  state << 3.0, 0.0, 1.0;
+  EXPECT_NEAR(subsystem->Value(state),
+              value(2.0, 1.0) + (0.5 + 0.25 * 1.0), 1e-9);
+  gradient = subsystem->Gradient(state);
+  EXPECT_NEAR(gradient(0), 0.5 + 0.25 * 1.0, 1e-9);
+  EXPECT_EQ(subsystem->OutOfGridCount(0), 2);
+  EXPECT_EQ(subsystem->OutOfGridCount(1), 0);
+
+  remove(file_name.c_str());
+}
+
+// Test that bad files are rejected.
+TEST(SparseGrid, TestBadFile) {
+  const SubsystemValueFunction::ConstPtr subsystem =
+    SubsystemValueFunction::Create("/tmp/does_not_exist.sgvf");
+  EXPECT_FALSE(subsystem->IsInitialized());
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the SurrogateSubsystemValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/surrogate_subsystem_value_function.h>
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+
+using namespace meta;
+
+// Fit a surrogate to voxel values f(center) on a 2D grid over
+// [-2, 2] x [-1, 3] (subsystem dimensions 0 and 2 of a 3D state).
+template <typename F>
+SurrogateSubsystemValueFunction::ConstPtr
+FitGrid(const std::string& file_name, const F& f, size_t cell_voxels,
+        double tolerance) {
+  const std::vector<size_t> x_dims = { 0, 2 };
+  const std::vector<size_t> u_dims(1, 0);
+  const std::vector<size_t> num_voxels = { 40, 32 };
+  const std::vector<double> lower = { -2.0, -1.0 };
+  const std::vector<double> upper = { 2.0, 3.0 };
+  const std::vector<double> speed(3, 1.0);
+  const std::vector<double> teb = { 0.5, 0.25 };
+
+  std::vector<double> data;
+  for (size_t ii = 0; ii < num_voxels[0]; ii++) {
+    for (size_t jj = 0; jj < num_voxels[1]; jj++) {
+      const double x = lower[0] + (ii + 0.5) * 0.1;
+      const double y = lower[1] + (jj + 0.5) * 0.125;
+      data.push_back(f(x, y));
+    }
+  }
+
+  EXPECT_TRUE(SurrogateSubsystemValueFunction::Fit(
+    file_name, x_dims, u_dims, num_voxels, lower, upper, speed,
+    0.0, 1.0, teb, data, std::vector<size_t>(2, cell_voxels), tolerance));
+
+  return SurrogateSubsystemValueFunction::Create(file_name);
+}
+
+// Test that a quadratic is represented exactly, with exact gradients and
+// linear extrapolation off the grid.
+TEST(SurrogateSubsystemValueFunction, TestQuadratic) {
+  const std::string file_name = "/tmp/test_surrogate_quadratic.svf";
+  const auto f = [](double x, double y) {
+    return 1.0 + 0.5 * x - y + x * x + 0.25 * x * y + 2.0 * y * y;
+  };
+
+  const SurrogateSubsystemValueFunction::ConstPtr value =
+    FitGrid(file_name, f, 8, 1.0);
+  ASSERT_TRUE(value->IsInitialized());
+  EXPECT_EQ(value->NumCells(), 20);
+  EXPECT_EQ(value->NumFallbackCells(), 0);
+  EXPECT_NEAR(value->TrackingBound(1), 0.25, 1e-12);
+
+  // Much smaller than the grid.
+  EXPECT_LT(value->MemoryBytes(), 40 * 32 * sizeof(double) / 4);
+
+  VectorXd state(3);
+  state << 0.33, 100.0, 1.7;
+  EXPECT_NEAR(value->Value(state), f(0.33, 1.7), 1e-9);
+
+  const VectorXd gradient = value->Gradient(state);
+  EXPECT_NEAR(gradient(0), 0.5 + 2.0 * 0.33 + 0.25 * 1.7, 1e-9);
+  EXPECT_NEAR(gradient(1), -1.0 + 0.25 * 0.33 + 4.0 * 1.7, 1e-9);
+
+  // Off the grid in x: extrapolate along the edge gradient.
+  state << 3.0, 0.0, 1.0;
+  const double edge_slope = 0.5 + 2.0 * 2.0 + 0.25 * 1.0;
+  EXPECT_NEAR(value->Value(state), f(2.0, 1.0) + edge_slope, 1e-9);
+
+  remove(file_name.c_str());
+}
+
+// Test that the certified bound holds against the grid interpolant, which
+// is what the surrogate falls back to when the tolerance is zero.
+TEST(SurrogateSubsystemValueFunction, TestErrorBound) {
+  const std::string grid_file = "/tmp/test_surrogate_grid.svf";
+  const std::string fit_file = "/tmp/test_surrogate_fit.svf";
+  const auto f = [](double x, double y) {
+    return std::sin(1.5 * x) + std::cos(y) + 0.1 * x * y;
+  };
+
+  const SurrogateSubsystemValueFunction::ConstPtr grid =
+    FitGrid(grid_file, f, 8, 0.0);
+  ASSERT_TRUE(grid->IsInitialized());
+  EXPECT_EQ(grid->NumFallbackCells(), grid->NumCells());
+
+  const SurrogateSubsystemValueFunction::ConstPtr fit =
+    FitGrid(fit_file, f, 8, 1.0);
+  ASSERT_TRUE(fit->IsInitialized());
+  EXPECT_EQ(fit->NumFallbackCells(), 0);
+  EXPECT_GT(fit->MaxErrorBound(), 0.0);
+
+  // Fallback reproduces voxel values exactly.
+  VectorXd state(3);
+  state << -2.0 + 13.5 * 0.1, 0.0, -1.0 + 7.5 * 0.125;
+  EXPECT_NEAR(grid->Value(state), f(state(0), state(2)), 1e-12);
+
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  for (size_t ii = 0; ii < 2000; ii++) {
+    state << -2.0 + 4.0 * unit(rng), 0.0, -1.0 + 4.0 * unit(rng);
+    EXPECT_LE(std::abs(fit->Value(state) - grid->Value(state)),
+              fit->MaxErrorBound() + 1e-12);
+  }
+
+  remove(grid_file.c_str());
+  remove(fit_file.c_str());
+}
+
+// Test that only cells exceeding the tolerance fall back to the grid.
+TEST(SurrogateSubsystemValueFunction, TestPartialFallback) {
+  const std::string file_name = "/tmp/test_surrogate_partial.svf";
+
+  // Smooth except for a kink along x = 1.
+  const auto f = [](double x, double y) {
+    return 0.2 * y + 5.0 * std::abs(x - 1.0);
+  };
+
+  const SurrogateSubsystemValueFunction::ConstPtr value =
+    FitGrid(file_name, f, 4, 1e-3);
+  ASSERT_TRUE(value->IsInitialized());
+  EXPECT_GT(value->NumFallbackCells(), 0);
+  EXPECT_LT(value->NumFallbackCells(), value->NumCells());
+  EXPECT_LE(value->MaxErrorBound(), 1e-3);
+
+  // Near the kink we get grid values back.
+  VectorXd state(3);
+  state << -2.0 + 29.5 * 0.1, 0.0, 1.0 + 0.0625;
+  EXPECT_NEAR(value->Value(state), f(state(0), state(2)), 1e-9);
+
+  remove(file_name.c_str());
+}
+
+// Test that bad files are rejected.
+TEST(SurrogateSubsystemValueFunction, TestBadFile) {
+  const SurrogateSubsystemValueFunction::ConstPtr value =
+    SurrogateSubsystemValueFunction::Create("/tmp/does_not_exist.svf");
+  EXPECT_FALSE(value->IsInitialized());
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2017, The Regents of the University of California (Regents).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *    3. Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Please contact the author(s) of this library if you have any questions.
+ * Authors: David Fridovich-Keil   ( dfk@eecs.berkeley.edu )
+ */
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Unit tests for the TimeVaryingSubsystemValueFunction class.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <value_function/time_varying_subsystem_value_function.h>
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdio.h>
+
+using namespace meta;
+
+// Test that values and tracking bounds are interpolated in time, and that
+// a file survives the write/map round trip.
+TEST(TimeVaryingSubsystemValueFunction, TestInterpolation) {
+  const std::string file_name = "/tmp/test_time_varying_value_function.tvvf";
+
+  // 1D grid over [0, 10) with 10 voxels, 3 slices at t = 0, 1, 3.
+  // Slice k has value (k + 1) * x at voxel centers.
+  const std::vector<size_t> x_dims(1, 1);
+  const std::vector<size_t> u_dims(1, 0);
+  const std::vector<size_t> num_voxels(1, 10);
+  const std::vector<double> lower(1, 0.0);
+  const std::vector<double> upper(1, 10.0);
+  const std::vector<double> speed(3, 1.0);
+
+  std::vector<double> times;
+  times.push_back(0.0);
+  times.push_back(1.0);
+  times.push_back(3.0);
+
+  std::vector<double> teb;
+  teb.push_back(1.0);
+  teb.push_back(2.0);
+  teb.push_back(4.0);
+
+  std::vector<double> data;
+  for (size_t kk = 0; kk < times.size(); kk++) {
+    for (size_t ii = 0; ii < num_voxels[0]; ii++)
+      data.push_back((kk + 1.0) * (ii + 0.5));
+  }
+
+  ASSERT_TRUE(TimeVaryingSubsystemValueFunction::Write(
+    file_name, x_dims, u_dims, num_voxels, lower, upper, speed,
+    0.0, 1.0, times, teb, data));
+
+  const TimeVaryingSubsystemValueFunction::ConstPtr value =
+    TimeVaryingSubsystemValueFunction::Create(file_name, 1);
+  ASSERT_TRUE(value->IsInitialized());
+  EXPECT_EQ(value->NumSlices(), 3);
+  EXPECT_EQ(value->StateDimensions()[0], 1);
+
+  // Full state is 2D; only dimension 1 is used.
+  VectorXd state(2);
+  state << 100.0, 4.5;
+
+  EXPECT_NEAR(value->Value(state, 0.0), 4.5, 1e-9);
+  EXPECT_NEAR(value->Value(state, 0.5), 1.5 * 4.5, 1e-9);
+  EXPECT_NEAR(value->Value(state, 2.0), 2.5 * 4.5, 1e-9);
+  EXPECT_NEAR(value->Value(state, 10.0), 3.0 * 4.5, 1e-9);
+  EXPECT_NEAR(value->Gradient(state, 1.0)(0), 2.0, 1e-9);
+
+  EXPECT_NEAR(value->TrackingBound(0, -1.0), 1.0, 1e-9);
+  EXPECT_NEAR(value->TrackingBound(0, 0.5), 1.5, 1e-9);
+  EXPECT_NEAR(value->TrackingBound(0, 2.0), 3.0, 1e-9);
+  EXPECT_NEAR(value->TrackingBound(0, 5.0), 4.0, 1e-9);
+  EXPECT_NEAR(value->MaxTrackingBound(0), 4.0, 1e-9);
+  EXPECT_NEAR(value->GridSpacing(0), 1.0, 1e-9);
+
+  remove(file_name.c_str());
+}
+
+// Test that level set bounds are read off each slice, out to voxel edges.
+TEST(TimeVaryingSubsystemValueFunction, TestLevelSetBound) {
+  const std::string file_name = "/tmp/test_level_set_bound.tvvf";
+
+  // 1D grid over [-5, 5) with 10 voxels, 4 slices at t = 0, 1, 2, 3.
+  // Slice k has value |x| - r_k at voxel centers.
+  const std::vector<size_t> x_dims(1, 0);
+  const std::vector<size_t> u_dims(1, 0);
+  const std::vector<size_t> num_voxels(1, 10);
+  const std::vector<double> lower(1, -5.0);
+  const std::vector<double> upper(1, 5.0);
+  const std::vector<double> speed(3, 1.0);
+  const double radii[] = { 0.2, 1.0, 2.0, 4.0 };
+
+  std::vector<double> times, teb, data;
+  for (size_t kk = 0; kk < 4; kk++) {
+    times.push_back(static_cast<double>(kk));
+    teb.push_back(radii[kk]);
+
+    for (size_t ii = 0; ii < num_voxels[0]; ii++)
+      data.push_back(std::abs(lower[0] + ii + 0.5) - radii[kk]);
+  }
+
+  ASSERT_TRUE(TimeVaryingSubsystemValueFunction::Write(
+    file_name, x_dims, u_dims, num_voxels, lower, upper, speed,
+    0.0, 1.0, times, teb, data));
+
+  const TimeVaryingSubsystemValueFunction::ConstPtr value =
+    TimeVaryingSubsystemValueFunction::Create(file_name);
+  ASSERT_TRUE(value->IsInitialized());
+
+  EXPECT_LT(value->LevelSetBound(0, 0), 0.0);
+  EXPECT_NEAR(value->LevelSetBound(0, 1), 1.0, 1e-9);
+  EXPECT_NEAR(value->LevelSetBound(0, 2), 2.0, 1e-9);
+  EXPECT_NEAR(value->LevelSetBound(0, 3), 4.0, 1e-9);
+  EXPECT_NEAR(value->SliceTime(2), 2.0, 1e-9);
+
+  remove(file_name.c_str());
+}
+
+// Test that bad files are rejected.
+TEST(TimeVaryingSubsystemValueFunction, TestBadFile) {
+  const TimeVaryingSubsystemValueFunction::ConstPtr value =
+    TimeVaryingSubsystemValueFunction::Create("/tmp/does_not_exist.tvvf");
+  EXPECT_FALSE(value->IsInitialized());
+}